@@ -0,0 +1,536 @@
+#include <atomic>
+#include <filesystem>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <pqrs/karabiner/driverkit/virtual_hid_device_driver.hpp>
+#include <pqrs/karabiner/driverkit/virtual_hid_device_service.hpp>
+#include <pqrs/local_datagram.hpp>
+#include <random>
+#include <sstream>
+#include <thread>
+
+// Usage:
+//
+//   virtual-hid-device-service-load-generator [options]
+//
+//   --clients N           The number of clients. (default: 4)
+//   --rate N              Target reports per second per client. (default: 1000)
+//   --duration N          Seconds. (default: 10)
+//   --pattern P           constant | bursty | poisson (default: constant)
+//   --burst-size N        Reports per burst in the bursty pattern. (default: 32)
+//   --mix K:C:P           Weights of keyboard, consumer and pointing reports. (default: 1:1:8)
+//   --initialize          Initialize the virtual keyboard and pointing device before the load.
+//   --latency             Record a request trace during the load and report the end-to-end latency.
+//
+// The generated reports are empty (no keys, no buttons, no motion) so that the load does not affect the user session.
+// Without `--initialize`, the reports are discarded in the server if the virtual devices are not initialized yet.
+
+namespace {
+std::atomic<bool> exit_flag(false);
+
+enum class load_pattern {
+  constant,
+  bursty,
+  poisson,
+};
+
+struct options final {
+  size_t clients = 4;
+  double rate = 1000;
+  std::chrono::seconds duration = std::chrono::seconds(10);
+  load_pattern pattern = load_pattern::constant;
+  size_t burst_size = 32;
+  std::vector<double> mix = {1, 1, 8};
+  bool initialize = false;
+  bool latency = false;
+};
+
+// `request::none` with this marker is sent first from each client in order to identify the client in the request trace.
+// (The server ignores `request::none`.)
+constexpr char marker[6] = {'K', 'V', 'H', 'D', 'L', 'G'};
+
+void usage(void) {
+  std::cerr << "Usage: virtual-hid-device-service-load-generator [--clients N] [--rate N] [--duration N]" << std::endl;
+  std::cerr << "         [--pattern constant|bursty|poisson] [--burst-size N] [--mix K:C:P]" << std::endl;
+  std::cerr << "         [--initialize] [--latency]" << std::endl;
+}
+
+std::optional<options> parse_options(int argc, const char* argv[]) {
+  options o;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string arg(argv[i]);
+    std::string value = i + 1 < argc ? argv[i + 1] : "";
+
+    try {
+      if (arg == "--clients") {
+        o.clients = std::stoul(value);
+        ++i;
+      } else if (arg == "--rate") {
+        o.rate = std::stod(value);
+        ++i;
+      } else if (arg == "--duration") {
+        o.duration = std::chrono::seconds(std::stoul(value));
+        ++i;
+      } else if (arg == "--pattern") {
+        if (value == "constant") {
+          o.pattern = load_pattern::constant;
+        } else if (value == "bursty") {
+          o.pattern = load_pattern::bursty;
+        } else if (value == "poisson") {
+          o.pattern = load_pattern::poisson;
+        } else {
+          return std::nullopt;
+        }
+        ++i;
+      } else if (arg == "--burst-size") {
+        o.burst_size = std::stoul(value);
+        ++i;
+      } else if (arg == "--mix") {
+        std::vector<double> mix;
+        std::stringstream ss(value);
+        std::string s;
+        while (std::getline(ss, s, ':')) {
+          mix.push_back(std::stod(s));
+        }
+        if (mix.size() != 3) {
+          return std::nullopt;
+        }
+        o.mix = mix;
+        ++i;
+      } else if (arg == "--initialize") {
+        o.initialize = true;
+      } else if (arg == "--latency") {
+        o.latency = true;
+      } else {
+        return std::nullopt;
+      }
+    } catch (std::exception&) {
+      return std::nullopt;
+    }
+  }
+
+  if (o.clients == 0 ||
+      o.rate <= 0 ||
+      o.burst_size == 0) {
+    return std::nullopt;
+  }
+
+  return o;
+}
+
+std::chrono::nanoseconds steady_clock_now(void) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch());
+}
+
+bool send_control_request(const std::vector<uint8_t>& buffer) {
+  pqrs::local_datagram::client client(pqrs::dispatcher::extra::get_shared_dispatcher(),
+                                      pqrs::karabiner::driverkit::virtual_hid_device_service::constants::server_socket_file_path.data(),
+                                      "/tmp/karabiner_driverkit_virtual_hid_device_service_load_generator_control.sock",
+                                      pqrs::karabiner::driverkit::virtual_hid_device_service::constants::local_datagram_buffer_size);
+
+  std::promise<void> processed;
+
+  client.connected.connect([&client, &processed, &buffer] {
+    client.async_send(buffer, [&processed] {
+      processed.set_value();
+    });
+  });
+
+  client.async_start();
+
+  return processed.get_future().wait_for(std::chrono::seconds(3)) == std::future_status::ready;
+}
+
+class load_client final {
+public:
+  load_client(size_t index,
+              const options& options) : index_(index),
+                                        options_(options),
+                                        connected_(false),
+                                        generated_count_(0),
+                                        processed_count_(0),
+                                        error_count_(0) {
+    std::filesystem::path client_socket_file_path("/tmp/karabiner_driverkit_virtual_hid_device_service_load_generator_" +
+                                                  std::to_string(index) +
+                                                  ".sock");
+
+    client_ = std::make_unique<pqrs::local_datagram::client>(
+        pqrs::dispatcher::extra::get_shared_dispatcher(),
+        pqrs::karabiner::driverkit::virtual_hid_device_service::constants::server_socket_file_path.data(),
+        client_socket_file_path,
+        pqrs::karabiner::driverkit::virtual_hid_device_service::constants::local_datagram_buffer_size);
+
+    client_->connected.connect([this] {
+      connected_ = true;
+    });
+    client_->connect_failed.connect([this](auto&& error_code) {
+      std::cerr << "client " << index_ << " connect_failed " << error_code << std::endl;
+    });
+    client_->error_occurred.connect([this](auto&& error_code) {
+      ++error_count_;
+    });
+
+    client_->async_start();
+  }
+
+  ~load_client(void) {
+    if (thread_.joinable()) {
+      thread_.join();
+    }
+
+    client_ = nullptr;
+  }
+
+  bool connected(void) const {
+    return connected_;
+  }
+
+  size_t get_generated_count(void) const {
+    return generated_count_;
+  }
+
+  size_t get_processed_count(void) const {
+    return processed_count_;
+  }
+
+  size_t get_error_count(void) const {
+    return error_count_;
+  }
+
+  pqrs::local_datagram::send_stall_statistics get_send_stall_statistics(void) const {
+    return client_->get_send_stall_statistics();
+  }
+
+  // Valid after `join`.
+  const std::vector<std::chrono::nanoseconds>& get_send_timestamps(void) const {
+    return send_timestamps_;
+  }
+
+  void send_marker(void) {
+    std::vector<uint8_t> buffer;
+    buffer.push_back(static_cast<uint8_t>(pqrs::karabiner::driverkit::virtual_hid_device_service::request::none));
+    std::copy(std::begin(marker), std::end(marker), std::back_inserter(buffer));
+    buffer.push_back(static_cast<uint8_t>((index_ >> 8) & 0xff));
+    buffer.push_back(static_cast<uint8_t>(index_ & 0xff));
+
+    client_->async_send(buffer);
+  }
+
+  void start(std::chrono::steady_clock::time_point start_time) {
+    thread_ = std::thread([this, start_time] {
+      run(start_time);
+    });
+  }
+
+  void join(void) {
+    if (thread_.joinable()) {
+      thread_.join();
+    }
+  }
+
+private:
+  void run(std::chrono::steady_clock::time_point start_time) {
+    std::mt19937 engine(static_cast<std::mt19937::result_type>(index_));
+    std::discrete_distribution<int> mix(std::begin(options_.mix), std::end(options_.mix));
+    std::exponential_distribution<double> poisson(options_.rate);
+
+    auto end_time = start_time + options_.duration;
+    auto interval = std::chrono::duration<double>(1.0 / options_.rate);
+    auto next_time = std::chrono::duration<double>(0);
+    size_t burst_index = 0;
+
+    if (options_.latency) {
+      send_timestamps_.reserve(static_cast<size_t>(options_.rate * options_.duration.count() * 1.1));
+    }
+
+    while (!exit_flag) {
+      auto t = start_time + std::chrono::duration_cast<std::chrono::steady_clock::duration>(next_time);
+      if (t >= end_time) {
+        break;
+      }
+
+      std::this_thread::sleep_until(t);
+
+      if (options_.latency) {
+        send_timestamps_.push_back(steady_clock_now());
+      }
+
+      switch (mix(engine)) {
+        case 0:
+          send<pqrs::karabiner::driverkit::virtual_hid_device_service::request::post_keyboard_input_report>();
+          break;
+        case 1:
+          send<pqrs::karabiner::driverkit::virtual_hid_device_service::request::post_consumer_input_report>();
+          break;
+        default:
+          send<pqrs::karabiner::driverkit::virtual_hid_device_service::request::post_pointing_input_report>();
+          break;
+      }
+
+      switch (options_.pattern) {
+        case load_pattern::constant:
+          next_time += interval;
+          break;
+
+        case load_pattern::bursty:
+          // Send `burst_size` reports back to back, then sleep to keep the average rate.
+          ++burst_index;
+          if (burst_index == options_.burst_size) {
+            burst_index = 0;
+            next_time += interval * static_cast<double>(options_.burst_size);
+          }
+          break;
+
+        case load_pattern::poisson:
+          next_time += std::chrono::duration<double>(poisson(engine));
+          break;
+      }
+    }
+  }
+
+  // Send an empty report.
+  template <pqrs::karabiner::driverkit::virtual_hid_device_service::request R>
+  void send(void) {
+    using namespace pqrs::karabiner::driverkit::virtual_hid_device_service;
+
+    auto buffer = request_schema::encode<R>(request_schema::payload_t<R>());
+
+    ++generated_count_;
+
+    client_->async_send(buffer, [this] {
+      ++processed_count_;
+    });
+  }
+
+  size_t index_;
+  const options& options_;
+  std::unique_ptr<pqrs::local_datagram::client> client_;
+  std::thread thread_;
+  std::atomic<bool> connected_;
+  std::atomic<size_t> generated_count_;
+  std::atomic<size_t> processed_count_;
+  std::atomic<size_t> error_count_;
+  std::vector<std::chrono::nanoseconds> send_timestamps_;
+};
+
+// Match the recorded requests with the send timestamps.
+// The requests of each client are matched in order.
+// Clients which lost requests are excluded since the order cannot be matched.
+void report_latency(const std::vector<std::unique_ptr<load_client>>& clients) {
+  pqrs::karabiner::driverkit::virtual_hid_device_service::request_trace::reader reader;
+  if (auto error_code = reader.open(pqrs::karabiner::driverkit::virtual_hid_device_service::constants::request_trace_file_path)) {
+    std::cerr << "failed to open the request trace: " << error_code.message() << std::endl;
+    return;
+  }
+
+  // sender_id -> client index
+  std::unordered_map<uint32_t, size_t> client_indices;
+  // client index -> received timestamps
+  std::vector<std::vector<std::chrono::nanoseconds>> received_timestamps(clients.size());
+
+  for (const auto& r : reader.get_records()) {
+    if (r.size == 1 + sizeof(marker) + 2 &&
+        r.data[0] == static_cast<uint8_t>(pqrs::karabiner::driverkit::virtual_hid_device_service::request::none) &&
+        memcmp(r.data + 1, marker, sizeof(marker)) == 0) {
+      size_t index = (r.data[1 + sizeof(marker)] << 8) | r.data[1 + sizeof(marker) + 1];
+      if (index < clients.size()) {
+        client_indices[r.sender_id] = index;
+      }
+      continue;
+    }
+
+    auto it = client_indices.find(r.sender_id);
+    if (it != std::end(client_indices)) {
+      received_timestamps[it->second].push_back(r.timestamp);
+    }
+  }
+
+  std::vector<std::chrono::nanoseconds> latencies;
+  size_t excluded_count = 0;
+
+  for (size_t i = 0; i < clients.size(); ++i) {
+    auto& sent = clients[i]->get_send_timestamps();
+    auto& received = received_timestamps[i];
+
+    if (sent.size() != received.size()) {
+      ++excluded_count;
+      continue;
+    }
+
+    for (size_t j = 0; j < sent.size(); ++j) {
+      latencies.push_back(received[j] - sent[j]);
+    }
+  }
+
+  if (excluded_count > 0) {
+    std::cout << "latency: " << excluded_count << " clients are excluded due to lost requests" << std::endl;
+  }
+
+  if (latencies.empty()) {
+    std::cout << "latency: no samples" << std::endl;
+    return;
+  }
+
+  std::sort(std::begin(latencies), std::end(latencies));
+
+  auto percentile = [&latencies](double p) {
+    auto index = static_cast<size_t>(p * (latencies.size() - 1));
+    return std::chrono::duration<double, std::micro>(latencies[index]).count();
+  };
+
+  std::cout << std::fixed << std::setprecision(1)
+            << "latency (us): p50 " << percentile(0.5)
+            << " p90 " << percentile(0.9)
+            << " p99 " << percentile(0.99)
+            << " p99.9 " << percentile(0.999)
+            << " max " << percentile(1.0)
+            << " (" << latencies.size() << " samples)" << std::endl;
+}
+} // namespace
+
+int main(int argc, const char* argv[]) {
+  using namespace pqrs::karabiner::driverkit::virtual_hid_device_service;
+
+  std::signal(SIGINT, [](int) {
+    exit_flag = true;
+  });
+
+  auto o = parse_options(argc, argv);
+  if (!o) {
+    usage();
+    return 1;
+  }
+
+  pqrs::dispatcher::extra::initialize_shared_dispatcher();
+
+  int result = 0;
+
+  {
+    std::vector<std::unique_ptr<load_client>> clients;
+    for (size_t i = 0; i < o->clients; ++i) {
+      clients.push_back(std::make_unique<load_client>(i, *o));
+    }
+
+    for (int i = 0; i < 30 && !exit_flag; ++i) {
+      if (std::all_of(std::begin(clients),
+                      std::end(clients),
+                      [](auto&& c) { return c->connected(); })) {
+        break;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+
+    if (o->initialize) {
+      send_control_request(request_schema::encode<request::virtual_hid_keyboard_initialize>(type_safe::get(pqrs::hid::country_code::us)));
+      send_control_request(request_schema::encode<request::virtual_hid_pointing_initialize>());
+
+      // Wait until the virtual devices are ready.
+      std::this_thread::sleep_for(std::chrono::seconds(2));
+    }
+
+    if (o->latency) {
+      if (!send_control_request(request_schema::encode<request::request_trace_start>())) {
+        std::cerr << "failed to start the request trace" << std::endl;
+        o->latency = false;
+      }
+    }
+
+    // Send markers one by one after the request trace is started.
+    for (auto&& c : clients) {
+      c->send_marker();
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    //
+    // Load
+    //
+
+    auto start_time = std::chrono::steady_clock::now();
+
+    for (auto&& c : clients) {
+      c->start(start_time);
+    }
+
+    for (auto&& c : clients) {
+      c->join();
+    }
+
+    auto generate_end_time = std::chrono::steady_clock::now();
+
+    // Wait until the send queues are flushed.
+    for (int i = 0; i < 50; ++i) {
+      if (std::all_of(std::begin(clients),
+                      std::end(clients),
+                      [](auto&& c) { return c->get_processed_count() + c->get_error_count() >= c->get_generated_count(); })) {
+        break;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+
+    if (o->latency) {
+      // Wait until the server handles the remaining requests.
+      std::this_thread::sleep_for(std::chrono::milliseconds(200));
+      send_control_request(request_schema::encode<request::request_trace_stop>());
+      std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    }
+
+    //
+    // Report
+    //
+
+    size_t generated = 0;
+    size_t processed = 0;
+    size_t errors = 0;
+    pqrs::local_datagram::send_stall_statistics stalls;
+    for (auto&& c : clients) {
+      generated += c->get_generated_count();
+      processed += c->get_processed_count();
+      errors += c->get_error_count();
+
+      auto s = c->get_send_stall_statistics();
+      stalls.no_buffer_space_count += s.no_buffer_space_count;
+      stalls.stall_count += s.stall_count;
+      for (size_t i = 0; i < stalls.histogram.size(); ++i) {
+        stalls.histogram[i] += s.histogram[i];
+      }
+    }
+
+    auto elapsed = std::chrono::duration<double>(generate_end_time - start_time).count();
+    auto target = o->rate * o->clients;
+
+    std::cout << std::fixed << std::setprecision(1)
+              << "target:     " << target << " reports/s" << std::endl
+              << "achieved:   " << processed / elapsed << " reports/s" << std::endl
+              << "generated:  " << generated << std::endl
+              << "sent:       " << processed << std::endl
+              << "dropped:    " << generated - std::min(generated, processed) << std::endl
+              << "errors:     " << errors << std::endl
+              << "stalls:     " << stalls.stall_count << " (no_buffer_space " << stalls.no_buffer_space_count << ")" << std::endl;
+
+    for (size_t i = 0; i < stalls.histogram.size(); ++i) {
+      if (stalls.histogram[i] > 0) {
+        if (i == 0) {
+          std::cout << "  < 1 ms: ";
+        } else {
+          std::cout << "  < " << (1 << i) << " ms: ";
+        }
+        std::cout << stalls.histogram[i] << std::endl;
+      }
+    }
+
+    if (o->latency) {
+      report_latency(clients);
+    }
+
+    if (errors > 0 || processed < generated) {
+      result = 1;
+    }
+  }
+
+  pqrs::dispatcher::extra::terminate_shared_dispatcher();
+
+  return result;
+}
@@ -0,0 +1,160 @@
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <filesystem>
+#include <iostream>
+#include <optional>
+#include <pqrs/karabiner/driverkit/virtual_hid_device_service.hpp>
+#include <string>
+#include <thread>
+
+// Usage:
+//
+//   virtual-hid-device-service-metrics [--watch milliseconds] [file]
+//
+// Prints the metrics page which is published by the running server.
+// The page is read from `constants::metrics_file_path` without any request to the server.
+// `--watch` prints the page repeatedly with the request rate in the interval.
+
+namespace {
+std::atomic<bool> exit_flag(false);
+
+using namespace pqrs::karabiner::driverkit::virtual_hid_device_service;
+
+void usage(void) {
+  std::cerr << "Usage:" << std::endl;
+  std::cerr << "  virtual-hid-device-service-metrics [--watch milliseconds] [file]" << std::endl;
+}
+
+const char* device_name(metrics::device device) {
+  switch (device) {
+    case metrics::device::virtual_hid_keyboard:
+      return "virtual_hid_keyboard";
+    case metrics::device::virtual_hid_pointing:
+      return "virtual_hid_pointing";
+    case metrics::device::virtual_hid_absolute_pointing:
+      return "virtual_hid_absolute_pointing";
+    case metrics::device::end_:
+      break;
+  }
+  return "";
+}
+
+const char* ready_name(int64_t ready) {
+  if (ready < 0) {
+    return "-";
+  }
+  return ready ? "true" : "false";
+}
+
+uint64_t total_received_requests(const metrics::server_metrics& m) {
+  uint64_t total = 0;
+  for (const auto& c : m.received_requests) {
+    total += c;
+  }
+  return total;
+}
+
+bool print(const metrics::page& page,
+           std::optional<uint64_t> previous_total,
+           std::chrono::milliseconds interval) {
+  auto server = page.server.load();
+  if (!server) {
+    std::cerr << "failed to read the server metrics" << std::endl;
+    return false;
+  }
+
+  auto total = total_received_requests(*server);
+
+  std::cout << "pid: " << page.pid << std::endl;
+  std::cout << "connected_clients: " << server->connected_clients << std::endl;
+  std::cout << "received_requests: " << total;
+  if (previous_total && interval.count() > 0) {
+    std::cout << " (" << (total - *previous_total) * 1000 / interval.count() << "/s)";
+  }
+  std::cout << std::endl;
+
+  for (size_t i = 0; i < server->received_requests.size(); ++i) {
+    if (server->received_requests[i] > 0) {
+      std::cout << "  request " << i << ": " << server->received_requests[i] << std::endl;
+    }
+  }
+  std::cout << "parse_errors: " << server->parse_errors << std::endl;
+
+  for (size_t i = 0; i < metrics::device_count; ++i) {
+    auto d = metrics::device(i);
+    auto& device_metrics = page.get_device_metrics(d);
+    auto report_queue = device_metrics.report_queue.load();
+    auto forwarding = device_metrics.forwarding.load();
+    if (!report_queue || !forwarding) {
+      std::cerr << "failed to read the " << device_name(d) << " metrics" << std::endl;
+      return false;
+    }
+
+    std::cout << device_name(d) << ":" << std::endl;
+    std::cout << "  ready: " << ready_name(server->device_ready[i]) << std::endl;
+    std::cout << "  queued_reports: " << report_queue->queued_reports << std::endl;
+    std::cout << "  dropped_reports: " << report_queue->dropped_reports << std::endl;
+    std::cout << "  forwarded_reports: " << forwarding->forwarded_reports << std::endl;
+    std::cout << "  backend_errors: " << forwarding->backend_errors << std::endl;
+    std::cout << "  queue_depth: " << forwarding->queue_depth
+              << " (max " << forwarding->max_queue_depth << ")" << std::endl;
+    std::cout << "  last_backend_call_latency: " << forwarding->last_backend_call_latency_nanoseconds / 1000.0 << " us" << std::endl;
+  }
+
+  return true;
+}
+} // namespace
+
+int main(int argc, const char* argv[]) {
+  std::signal(SIGINT, [](int) {
+    exit_flag = true;
+  });
+
+  std::filesystem::path file_path(constants::metrics_file_path);
+  std::optional<std::chrono::milliseconds> watch_interval;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string arg(argv[i]);
+
+    if (arg == "--watch" && i + 1 < argc) {
+      watch_interval = std::chrono::milliseconds(std::stoi(argv[++i]));
+      if (watch_interval->count() <= 0) {
+        usage();
+        return 1;
+      }
+    } else if (arg.size() > 0 && arg[0] == '-') {
+      usage();
+      return 1;
+    } else {
+      file_path = arg;
+    }
+  }
+
+  metrics::reader reader;
+  if (auto error_code = reader.open(file_path)) {
+    std::cerr << "failed to open " << file_path << ": " << error_code.message() << std::endl;
+    return 1;
+  }
+
+  if (!watch_interval) {
+    return print(reader.get_page(), std::nullopt, std::chrono::milliseconds(0)) ? 0 : 1;
+  }
+
+  std::optional<uint64_t> previous_total;
+
+  while (!exit_flag) {
+    if (!print(reader.get_page(), previous_total, *watch_interval)) {
+      return 1;
+    }
+    std::cout << std::endl;
+
+    if (auto server = reader.get_page().server.load()) {
+      previous_total = total_received_requests(*server);
+    }
+
+    std::this_thread::sleep_for(*watch_interval);
+  }
+
+  return 0;
+}
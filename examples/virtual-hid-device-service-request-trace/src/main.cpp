@@ -0,0 +1,216 @@
+#include <atomic>
+#include <filesystem>
+#include <iostream>
+#include <pqrs/karabiner/driverkit/virtual_hid_device_driver.hpp>
+#include <pqrs/karabiner/driverkit/virtual_hid_device_service.hpp>
+#include <pqrs/local_datagram.hpp>
+#include <thread>
+
+// Usage:
+//
+//   virtual-hid-device-service-request-trace start
+//   virtual-hid-device-service-request-trace stop
+//   virtual-hid-device-service-request-trace replay [--speed factor | --max-speed] [file]
+//
+// `start` and `stop` toggle recording in the running server.
+// The trace is written into `constants::request_trace_file_path`.
+//
+// `replay` sends the recorded requests to the server with the recorded inter-arrival times.
+// Each recorded sender is replayed from its own socket in order to preserve the per-sender ordering.
+
+namespace {
+std::atomic<bool> exit_flag(false);
+
+void usage(void) {
+  std::cerr << "Usage:" << std::endl;
+  std::cerr << "  virtual-hid-device-service-request-trace start" << std::endl;
+  std::cerr << "  virtual-hid-device-service-request-trace stop" << std::endl;
+  std::cerr << "  virtual-hid-device-service-request-trace replay [--speed factor | --max-speed] [file]" << std::endl;
+}
+
+int toggle(bool start) {
+  auto client = std::make_unique<pqrs::karabiner::driverkit::virtual_hid_device_service::client>(
+      "/tmp/karabiner_driverkit_virtual_hid_device_service_request_trace.sock");
+
+  std::atomic<bool> sent(false);
+
+  client->connected.connect([&client, &sent, start] {
+    if (start) {
+      client->async_request_trace_start();
+    } else {
+      client->async_request_trace_stop();
+    }
+    sent = true;
+  });
+  client->connect_failed.connect([](auto&& error_code) {
+    std::cerr << "connect_failed " << error_code << std::endl;
+  });
+
+  client->async_start();
+
+  for (int i = 0; i < 30 && !sent && !exit_flag; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  }
+
+  // Wait until the request is sent.
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  client = nullptr;
+
+  if (!sent) {
+    std::cerr << "failed to connect to the server" << std::endl;
+    return 1;
+  }
+
+  std::cout << (start ? "started: " : "stopped: ")
+            << pqrs::karabiner::driverkit::virtual_hid_device_service::constants::request_trace_file_path
+            << std::endl;
+  return 0;
+}
+
+int replay(const std::filesystem::path& file_path,
+           std::optional<double> speed) {
+  pqrs::karabiner::driverkit::virtual_hid_device_service::request_trace::reader reader;
+  if (auto error_code = reader.open(file_path)) {
+    std::cerr << "failed to open " << file_path << ": " << error_code.message() << std::endl;
+    return 1;
+  }
+
+  auto& records = reader.get_records();
+  if (records.empty()) {
+    std::cerr << "no records" << std::endl;
+    return 1;
+  }
+
+  //
+  // Create clients
+  //
+
+  std::vector<std::unique_ptr<pqrs::local_datagram::client>> clients;
+  std::atomic<size_t> connected_count(0);
+  std::atomic<size_t> error_count(0);
+
+  for (uint32_t i = 0; i < reader.sender_count(); ++i) {
+    std::filesystem::path client_socket_file_path("/tmp/karabiner_driverkit_virtual_hid_device_service_request_trace_" +
+                                                  std::to_string(i) +
+                                                  ".sock");
+
+    auto c = std::make_unique<pqrs::local_datagram::client>(
+        pqrs::dispatcher::extra::get_shared_dispatcher(),
+        pqrs::karabiner::driverkit::virtual_hid_device_service::constants::server_socket_file_path.data(),
+        client_socket_file_path,
+        pqrs::karabiner::driverkit::virtual_hid_device_service::constants::local_datagram_buffer_size);
+
+    c->connected.connect([&connected_count] {
+      ++connected_count;
+    });
+    c->connect_failed.connect([](auto&& error_code) {
+      std::cerr << "connect_failed " << error_code << std::endl;
+    });
+    c->error_occurred.connect([&error_count](auto&& error_code) {
+      ++error_count;
+    });
+
+    c->async_start();
+
+    clients.push_back(std::move(c));
+  }
+
+  for (int i = 0; i < 30 && connected_count < clients.size() && !exit_flag; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  }
+
+  if (connected_count < clients.size()) {
+    std::cerr << "failed to connect to the server" << std::endl;
+    return 1;
+  }
+
+  //
+  // Replay
+  //
+
+  auto first_timestamp = records.front().timestamp;
+  auto start_time = std::chrono::steady_clock::now();
+  size_t sent_count = 0;
+
+  for (const auto& r : records) {
+    if (exit_flag) {
+      break;
+    }
+
+    if (speed) {
+      auto offset = std::chrono::duration_cast<std::chrono::nanoseconds>((r.timestamp - first_timestamp) / *speed);
+      std::this_thread::sleep_until(start_time + offset);
+    }
+
+    clients[r.sender_id]->async_send(r.data, r.size);
+    ++sent_count;
+  }
+
+  auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start_time);
+  auto recorded = std::chrono::duration_cast<std::chrono::milliseconds>(records.back().timestamp - first_timestamp);
+
+  // Wait until the send queues are flushed.
+  std::this_thread::sleep_for(std::chrono::milliseconds(500));
+
+  clients.clear();
+
+  std::cout << "sent " << sent_count << " requests from " << reader.sender_count() << " senders" << std::endl;
+  std::cout << "elapsed " << elapsed.count() << " ms (recorded " << recorded.count() << " ms)" << std::endl;
+  std::cout << "errors " << error_count << std::endl;
+
+  return 0;
+}
+} // namespace
+
+int main(int argc, const char* argv[]) {
+  std::signal(SIGINT, [](int) {
+    exit_flag = true;
+  });
+
+  if (argc < 2) {
+    usage();
+    return 1;
+  }
+
+  std::string command(argv[1]);
+
+  std::filesystem::path file_path(pqrs::karabiner::driverkit::virtual_hid_device_service::constants::request_trace_file_path);
+  std::optional<double> speed = 1.0;
+
+  for (int i = 2; i < argc; ++i) {
+    std::string arg(argv[i]);
+
+    if (arg == "--speed" && i + 1 < argc) {
+      speed = std::stod(argv[++i]);
+      if (*speed <= 0) {
+        usage();
+        return 1;
+      }
+    } else if (arg == "--max-speed") {
+      speed = std::nullopt;
+    } else {
+      file_path = arg;
+    }
+  }
+
+  // Needed before using `pqrs::karabiner::driverkit::virtual_hid_device_service::client`.
+  pqrs::dispatcher::extra::initialize_shared_dispatcher();
+
+  int result = 1;
+
+  if (command == "start") {
+    result = toggle(true);
+  } else if (command == "stop") {
+    result = toggle(false);
+  } else if (command == "replay") {
+    result = replay(file_path, speed);
+  } else {
+    usage();
+  }
+
+  // Needed after using `pqrs::karabiner::driverkit::virtual_hid_device_service::client`.
+  pqrs::dispatcher::extra::terminate_shared_dispatcher();
+
+  return result;
+}
@@ -4,13 +4,24 @@
 // Distributed under the Boost Software License, Version 1.0.
 // (See https://www.boost.org/LICENSE_1_0.txt)
 
+#include "virtual_hid_device_driver/hid_descriptor.hpp"
+#include "virtual_hid_device_driver/hid_report/absolute_pointing_input.hpp"
+#include "virtual_hid_device_driver/hid_report/absolute_pointing_report_descriptor.hpp"
 #include "virtual_hid_device_driver/hid_report/apple_vendor_keyboard_input.hpp"
 #include "virtual_hid_device_driver/hid_report/apple_vendor_top_case_input.hpp"
 #include "virtual_hid_device_driver/hid_report/buttons.hpp"
 #include "virtual_hid_device_driver/hid_report/consumer_input.hpp"
+#include "virtual_hid_device_driver/hid_report/keyboard_bitmap_input.hpp"
 #include "virtual_hid_device_driver/hid_report/keyboard_input.hpp"
+#include "virtual_hid_device_driver/hid_report/keyboard_report_descriptor.hpp"
 #include "virtual_hid_device_driver/hid_report/keys.hpp"
+#include "virtual_hid_device_driver/hid_report/keys_bitmap.hpp"
 #include "virtual_hid_device_driver/hid_report/modifier.hpp"
 #include "virtual_hid_device_driver/hid_report/modifiers.hpp"
+#include "virtual_hid_device_driver/hid_report/pointing_high_resolution_input.hpp"
 #include "virtual_hid_device_driver/hid_report/pointing_input.hpp"
+#include "virtual_hid_device_driver/hid_report/pointing_report_descriptor.hpp"
+#include "virtual_hid_device_driver/hid_report/scroll_accumulator.hpp"
+#include "virtual_hid_device_driver/hid_report/wheel_resolution.hpp"
+#include "virtual_hid_device_driver/report_ring.hpp"
 #include "virtual_hid_device_driver/user_client_method.hpp"
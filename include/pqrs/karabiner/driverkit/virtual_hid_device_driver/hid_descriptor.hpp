@@ -0,0 +1,317 @@
+#pragma once
+
+// (C) Copyright Takayama Fumihiko 2020.
+// Distributed under the Boost Software License, Version 1.0.
+// (See https://www.boost.org/LICENSE_1_0.txt)
+
+#include <cstddef>
+#include <cstdint>
+
+namespace pqrs {
+namespace karabiner {
+namespace driverkit {
+namespace virtual_hid_device_driver {
+namespace hid_descriptor {
+
+//
+// A constexpr builder and parser of HID report descriptors (short items only).
+//
+// Data of items is encoded with the smallest size (1, 2 or 4 bytes).
+// Logical and physical extents are encoded as signed values, others as unsigned values.
+//
+
+enum class usage_page : uint32_t {
+  generic_desktop = 0x01,
+  keyboard_or_keypad = 0x07,
+  leds = 0x08,
+  button = 0x09,
+  consumer = 0x0c,
+  apple_vendor_top_case = 0xff,
+  apple_vendor = 0xff00,
+  apple_vendor_keyboard = 0xff01,
+};
+
+enum class collection_type : uint32_t {
+  physical = 0x00,
+  application = 0x01,
+  logical = 0x02,
+};
+
+enum class report_type {
+  input,
+  output,
+  feature,
+};
+
+// Flags of Input, Output and Feature items.
+namespace main_flag {
+constexpr uint32_t data = 0x00;
+constexpr uint32_t constant = 0x01;
+constexpr uint32_t array = 0x00;
+constexpr uint32_t variable = 0x02;
+constexpr uint32_t absolute = 0x00;
+constexpr uint32_t relative = 0x04;
+} // namespace main_flag
+
+namespace impl {
+enum class item_type : uint8_t {
+  main = 0,
+  global = 1,
+  local = 2,
+};
+
+namespace tag {
+// main
+constexpr uint8_t input = 0x8;
+constexpr uint8_t output = 0x9;
+constexpr uint8_t collection = 0xa;
+constexpr uint8_t feature = 0xb;
+constexpr uint8_t end_collection = 0xc;
+// global
+constexpr uint8_t usage_page = 0x0;
+constexpr uint8_t logical_minimum = 0x1;
+constexpr uint8_t logical_maximum = 0x2;
+constexpr uint8_t physical_minimum = 0x3;
+constexpr uint8_t physical_maximum = 0x4;
+constexpr uint8_t report_size = 0x7;
+constexpr uint8_t report_id = 0x8;
+constexpr uint8_t report_count = 0x9;
+constexpr uint8_t push = 0xa;
+constexpr uint8_t pop = 0xb;
+// local
+constexpr uint8_t usage = 0x0;
+constexpr uint8_t usage_minimum = 0x1;
+constexpr uint8_t usage_maximum = 0x2;
+} // namespace tag
+
+constexpr uint8_t prefix(uint8_t tag, item_type type, size_t data_size) {
+  uint8_t size_code = data_size == 4 ? 3 : static_cast<uint8_t>(data_size);
+  return static_cast<uint8_t>((tag << 4) | (static_cast<uint8_t>(type) << 2) | size_code);
+}
+} // namespace impl
+
+template <size_t Capacity>
+class descriptor final {
+public:
+  constexpr descriptor(void) : data_{},
+                               size_(0) {
+  }
+
+  constexpr const uint8_t* data(void) const {
+    return data_;
+  }
+
+  constexpr size_t size(void) const {
+    return size_;
+  }
+
+  constexpr uint8_t operator[](size_t index) const {
+    return data_[index];
+  }
+
+  //
+  // Main items
+  //
+
+  constexpr descriptor& input(uint32_t flags) {
+    return unsigned_item(impl::tag::input, impl::item_type::main, flags);
+  }
+
+  constexpr descriptor& output(uint32_t flags) {
+    return unsigned_item(impl::tag::output, impl::item_type::main, flags);
+  }
+
+  constexpr descriptor& feature(uint32_t flags) {
+    return unsigned_item(impl::tag::feature, impl::item_type::main, flags);
+  }
+
+  constexpr descriptor& collection(collection_type value) {
+    return unsigned_item(impl::tag::collection, impl::item_type::main, static_cast<uint32_t>(value));
+  }
+
+  constexpr descriptor& end_collection(void) {
+    return empty_item(impl::tag::end_collection, impl::item_type::main);
+  }
+
+  //
+  // Global items
+  //
+
+  constexpr descriptor& usage_page(hid_descriptor::usage_page value) {
+    return unsigned_item(impl::tag::usage_page, impl::item_type::global, static_cast<uint32_t>(value));
+  }
+
+  constexpr descriptor& logical_minimum(int32_t value) {
+    return signed_item(impl::tag::logical_minimum, impl::item_type::global, value);
+  }
+
+  constexpr descriptor& logical_maximum(int32_t value) {
+    return signed_item(impl::tag::logical_maximum, impl::item_type::global, value);
+  }
+
+  constexpr descriptor& physical_minimum(int32_t value) {
+    return signed_item(impl::tag::physical_minimum, impl::item_type::global, value);
+  }
+
+  constexpr descriptor& physical_maximum(int32_t value) {
+    return signed_item(impl::tag::physical_maximum, impl::item_type::global, value);
+  }
+
+  constexpr descriptor& report_size(uint32_t value) {
+    return unsigned_item(impl::tag::report_size, impl::item_type::global, value);
+  }
+
+  constexpr descriptor& report_id(uint8_t value) {
+    return unsigned_item(impl::tag::report_id, impl::item_type::global, value);
+  }
+
+  constexpr descriptor& report_count(uint32_t value) {
+    return unsigned_item(impl::tag::report_count, impl::item_type::global, value);
+  }
+
+  constexpr descriptor& push(void) {
+    return empty_item(impl::tag::push, impl::item_type::global);
+  }
+
+  constexpr descriptor& pop(void) {
+    return empty_item(impl::tag::pop, impl::item_type::global);
+  }
+
+  //
+  // Local items
+  //
+
+  constexpr descriptor& usage(uint32_t value) {
+    return unsigned_item(impl::tag::usage, impl::item_type::local, value);
+  }
+
+  constexpr descriptor& usage_minimum(uint32_t value) {
+    return unsigned_item(impl::tag::usage_minimum, impl::item_type::local, value);
+  }
+
+  constexpr descriptor& usage_maximum(uint32_t value) {
+    return unsigned_item(impl::tag::usage_maximum, impl::item_type::local, value);
+  }
+
+private:
+  constexpr void append(uint8_t value) {
+    // The constant evaluation fails if the descriptor exceeds `Capacity`.
+    data_[size_] = value;
+    ++size_;
+  }
+
+  constexpr descriptor& empty_item(uint8_t tag, impl::item_type type) {
+    append(impl::prefix(tag, type, 0));
+    return *this;
+  }
+
+  constexpr descriptor& data_item(uint8_t tag, impl::item_type type, uint32_t value, size_t data_size) {
+    append(impl::prefix(tag, type, data_size));
+    for (size_t i = 0; i < data_size; ++i) {
+      append(static_cast<uint8_t>((value >> (i * 8)) & 0xff));
+    }
+    return *this;
+  }
+
+  constexpr descriptor& unsigned_item(uint8_t tag, impl::item_type type, uint32_t value) {
+    size_t data_size = value <= 0xff ? 1 : value <= 0xffff ? 2 : 4;
+    return data_item(tag, type, value, data_size);
+  }
+
+  constexpr descriptor& signed_item(uint8_t tag, impl::item_type type, int32_t value) {
+    size_t data_size = (-128 <= value && value <= 127) ? 1 : (-32768 <= value && value <= 32767) ? 2 : 4;
+    return data_item(tag, type, static_cast<uint32_t>(value), data_size);
+  }
+
+  uint8_t data_[Capacity];
+  size_t size_;
+};
+
+//
+// Parser
+//
+
+// Returns the byte size of the report (including the report id byte if the descriptor uses report ids).
+// Returns 0 if the report does not exist.
+constexpr size_t report_byte_size(const uint8_t* data,
+                                  size_t size,
+                                  report_type type,
+                                  uint8_t report_id) {
+  struct global_state {
+    uint32_t report_size;
+    uint32_t report_count;
+    uint8_t report_id;
+  };
+
+  constexpr size_t stack_capacity = 8;
+  global_state stack[stack_capacity] = {};
+  size_t stack_size = 0;
+
+  global_state state = {};
+  size_t bits = 0;
+  bool found = false;
+
+  size_t i = 0;
+  while (i < size) {
+    auto prefix = data[i];
+    auto tag = static_cast<uint8_t>(prefix >> 4);
+    auto item_type = static_cast<impl::item_type>((prefix >> 2) & 0x3);
+    size_t data_size = (prefix & 0x3) == 3 ? 4 : (prefix & 0x3);
+
+    uint32_t value = 0;
+    for (size_t j = 0; j < data_size && i + 1 + j < size; ++j) {
+      value |= static_cast<uint32_t>(data[i + 1 + j]) << (j * 8);
+    }
+    i += 1 + data_size;
+
+    if (item_type == impl::item_type::main) {
+      if ((tag == impl::tag::input && type == report_type::input) ||
+          (tag == impl::tag::output && type == report_type::output) ||
+          (tag == impl::tag::feature && type == report_type::feature)) {
+        if (state.report_id == report_id) {
+          bits += static_cast<size_t>(state.report_size) * state.report_count;
+          found = true;
+        }
+      }
+    } else if (item_type == impl::item_type::global) {
+      switch (tag) {
+        case impl::tag::report_size:
+          state.report_size = value;
+          break;
+        case impl::tag::report_id:
+          state.report_id = static_cast<uint8_t>(value);
+          break;
+        case impl::tag::report_count:
+          state.report_count = value;
+          break;
+        case impl::tag::push:
+          stack[stack_size] = state;
+          ++stack_size;
+          break;
+        case impl::tag::pop:
+          --stack_size;
+          state = stack[stack_size];
+          break;
+      }
+    }
+  }
+
+  if (!found) {
+    return 0;
+  }
+
+  return (bits + 7) / 8 + (report_id != 0 ? 1 : 0);
+}
+
+template <size_t Capacity>
+constexpr size_t report_byte_size(const descriptor<Capacity>& d,
+                                  report_type type,
+                                  uint8_t report_id) {
+  return report_byte_size(d.data(), d.size(), type, report_id);
+}
+
+} // namespace hid_descriptor
+} // namespace virtual_hid_device_driver
+} // namespace driverkit
+} // namespace karabiner
+} // namespace pqrs
@@ -0,0 +1,35 @@
+#pragma once
+
+// (C) Copyright Takayama Fumihiko 2020.
+// Distributed under the Boost Software License, Version 1.0.
+// (See https://www.boost.org/LICENSE_1_0.txt)
+
+#include "buttons.hpp"
+#include <cstdint>
+
+namespace pqrs {
+namespace karabiner {
+namespace driverkit {
+namespace virtual_hid_device_driver {
+namespace hid_report {
+
+// The input report of the absolute pointing device.
+// `x` and `y` are positions in the screen which are normalized to 0-`maximum_position`.
+class __attribute__((packed)) absolute_pointing_input final {
+public:
+  static constexpr uint16_t maximum_position = 32767;
+
+  absolute_pointing_input(void) : buttons{}, x(0), y(0) {}
+  bool operator==(const absolute_pointing_input& other) const { return (memcmp(this, &other, sizeof(*this)) == 0); }
+  bool operator!=(const absolute_pointing_input& other) const { return !(*this == other); }
+
+  buttons buttons;
+  uint16_t x;
+  uint16_t y;
+};
+
+} // namespace hid_report
+} // namespace virtual_hid_device_driver
+} // namespace driverkit
+} // namespace karabiner
+} // namespace pqrs
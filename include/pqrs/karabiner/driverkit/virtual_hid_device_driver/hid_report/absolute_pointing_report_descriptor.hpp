@@ -0,0 +1,60 @@
+#pragma once
+
+// (C) Copyright Takayama Fumihiko 2020.
+// Distributed under the Boost Software License, Version 1.0.
+// (See https://www.boost.org/LICENSE_1_0.txt)
+
+#include "../hid_descriptor.hpp"
+#include "absolute_pointing_input.hpp"
+
+namespace pqrs {
+namespace karabiner {
+namespace driverkit {
+namespace virtual_hid_device_driver {
+namespace hid_report {
+
+// A tablet-style pointing device which reports absolute positions.
+// The absolute pointing device does not use report ids.
+constexpr auto absolute_pointing_report_descriptor = [] {
+  using namespace hid_descriptor;
+
+  descriptor<64> d;
+
+  d.usage_page(usage_page::generic_desktop)
+      .usage(0x02) // Mouse
+      .collection(collection_type::application)
+      /*  */.usage(0x01) // Pointer
+      /*  */.collection(collection_type::physical)
+      /*    */ // Buttons
+      /*    */.usage_page(usage_page::button)
+      /*    */.usage_minimum(1)
+      /*    */.usage_maximum(32)
+      /*    */.logical_minimum(0)
+      /*    */.logical_maximum(1)
+      /*    */.report_size(1)
+      /*    */.report_count(32)
+      /*    */.input(main_flag::data | main_flag::variable | main_flag::absolute)
+      /*    */ // X, Y
+      /*    */.usage_page(usage_page::generic_desktop)
+      /*    */.usage(0x30) // X
+      /*    */.usage(0x31) // Y
+      /*    */.logical_minimum(0)
+      /*    */.logical_maximum(absolute_pointing_input::maximum_position)
+      /*    */.report_size(16)
+      /*    */.report_count(2)
+      /*    */.input(main_flag::data | main_flag::variable | main_flag::absolute)
+      /*  */.end_collection()
+      .end_collection();
+
+  return d;
+}();
+
+static_assert(hid_descriptor::report_byte_size(absolute_pointing_report_descriptor,
+                                               hid_descriptor::report_type::input,
+                                               0) == sizeof(absolute_pointing_input));
+
+} // namespace hid_report
+} // namespace virtual_hid_device_driver
+} // namespace driverkit
+} // namespace karabiner
+} // namespace pqrs
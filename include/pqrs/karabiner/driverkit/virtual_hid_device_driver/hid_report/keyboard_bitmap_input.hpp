@@ -0,0 +1,36 @@
+#pragma once
+
+// (C) Copyright Takayama Fumihiko 2020.
+// Distributed under the Boost Software License, Version 1.0.
+// (See https://www.boost.org/LICENSE_1_0.txt)
+
+#include "keys_bitmap.hpp"
+#include "modifiers.hpp"
+#include <cstdint>
+
+namespace pqrs {
+namespace karabiner {
+namespace driverkit {
+namespace virtual_hid_device_driver {
+namespace hid_report {
+
+// An N-key rollover alternative of `keyboard_input`.
+class __attribute__((packed)) keyboard_bitmap_input final {
+public:
+  keyboard_bitmap_input(void) : report_id_(7) {}
+  bool operator==(const keyboard_bitmap_input& other) const { return (memcmp(this, &other, sizeof(*this)) == 0); }
+  bool operator!=(const keyboard_bitmap_input& other) const { return !(*this == other); }
+
+private:
+  uint8_t report_id_ __attribute__((unused));
+
+public:
+  modifiers modifiers;
+  keys_bitmap keys;
+};
+
+} // namespace hid_report
+} // namespace virtual_hid_device_driver
+} // namespace driverkit
+} // namespace karabiner
+} // namespace pqrs
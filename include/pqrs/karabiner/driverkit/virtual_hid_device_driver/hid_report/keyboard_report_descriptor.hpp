@@ -0,0 +1,180 @@
+#pragma once
+
+// (C) Copyright Takayama Fumihiko 2020.
+// Distributed under the Boost Software License, Version 1.0.
+// (See https://www.boost.org/LICENSE_1_0.txt)
+
+#include "../hid_descriptor.hpp"
+#include "apple_vendor_keyboard_input.hpp"
+#include "apple_vendor_top_case_input.hpp"
+#include "consumer_input.hpp"
+#include "keyboard_bitmap_input.hpp"
+#include "keyboard_input.hpp"
+
+namespace pqrs {
+namespace karabiner {
+namespace driverkit {
+namespace virtual_hid_device_driver {
+namespace hid_report {
+
+namespace keyboard_report_id {
+constexpr uint8_t keyboard_input = 1;
+constexpr uint8_t consumer_input = 2;
+constexpr uint8_t apple_vendor_top_case_input = 3;
+constexpr uint8_t apple_vendor_keyboard_input = 4;
+constexpr uint8_t led_output = 5;
+constexpr uint8_t led_input = 6;
+constexpr uint8_t keyboard_bitmap_input = 7;
+} // namespace keyboard_report_id
+
+constexpr auto keyboard_report_descriptor = [] {
+  using namespace hid_descriptor;
+
+  descriptor<256> d;
+
+  // keyboard_input
+  d.usage_page(usage_page::generic_desktop)
+      .usage(0x06) // Keyboard
+      .collection(collection_type::application)
+      /*  */.report_id(keyboard_report_id::keyboard_input)
+      /*  */.usage_page(usage_page::keyboard_or_keypad)
+      /*  */.usage_minimum(0xe0)
+      /*  */.usage_maximum(0xe7)
+      /*  */.logical_minimum(0)
+      /*  */.logical_maximum(1)
+      /*  */.report_size(1)
+      /*  */.report_count(8)
+      /*  */.input(main_flag::data | main_flag::variable | main_flag::absolute) // modifiers
+      /*  */.report_count(1)
+      /*  */.report_size(8)
+      /*  */.input(main_flag::constant) // reserved
+      /*  */.report_count(32)
+      /*  */.report_size(8)
+      /*  */.logical_minimum(0)
+      /*  */.logical_maximum(255)
+      /*  */.usage_page(usage_page::keyboard_or_keypad)
+      /*  */.usage_minimum(0)
+      /*  */.usage_maximum(255)
+      /*  */.input(main_flag::data | main_flag::array | main_flag::absolute) // keys
+      .end_collection();
+
+  // consumer_input
+  d.usage_page(usage_page::consumer)
+      .usage(0x01) // Consumer Control
+      .collection(collection_type::application)
+      /*  */.report_id(keyboard_report_id::consumer_input)
+      /*  */.usage_page(usage_page::consumer)
+      /*  */.report_count(32)
+      /*  */.report_size(8)
+      /*  */.logical_minimum(0)
+      /*  */.logical_maximum(255)
+      /*  */.usage_minimum(0)
+      /*  */.usage_maximum(255)
+      /*  */.input(main_flag::data | main_flag::array | main_flag::absolute)
+      .end_collection();
+
+  // apple_vendor_top_case_input
+  d.usage_page(usage_page::apple_vendor)
+      .usage(0x01) // kHIDUsage_AppleVendor_TopCase
+      .collection(collection_type::application)
+      /*  */.report_id(keyboard_report_id::apple_vendor_top_case_input)
+      /*  */.usage_page(usage_page::apple_vendor_top_case)
+      /*  */.report_count(32)
+      /*  */.report_size(8)
+      /*  */.logical_minimum(0)
+      /*  */.logical_maximum(255)
+      /*  */.usage_minimum(0)
+      /*  */.usage_maximum(255)
+      /*  */.input(main_flag::data | main_flag::array | main_flag::absolute)
+      .end_collection();
+
+  // apple_vendor_keyboard_input
+  d.usage_page(usage_page::apple_vendor)
+      .usage(0x06) // kHIDUsage_AppleVendor_Keyboard
+      .collection(collection_type::application)
+      /*  */.report_id(keyboard_report_id::apple_vendor_keyboard_input)
+      /*  */.usage_page(usage_page::apple_vendor_keyboard)
+      /*  */.report_count(32)
+      /*  */.report_size(8)
+      /*  */.logical_minimum(0)
+      /*  */.logical_maximum(255)
+      /*  */.usage_minimum(0)
+      /*  */.usage_maximum(255)
+      /*  */.input(main_flag::data | main_flag::array | main_flag::absolute)
+      .end_collection();
+
+  // LED (output)
+  d.usage_page(usage_page::generic_desktop)
+      .usage(0x06) // Keyboard
+      .collection(collection_type::application)
+      /*  */.report_id(keyboard_report_id::led_output)
+      /*  */.usage_page(usage_page::leds)
+      /*  */.report_count(2)
+      /*  */.report_size(1)
+      /*  */.usage_minimum(1) // Num Lock
+      /*  */.usage_maximum(2) // Caps Lock
+      /*  */.output(main_flag::data | main_flag::variable | main_flag::absolute)
+      /*  */.report_count(1)
+      /*  */.report_size(6)
+      /*  */.output(main_flag::constant)
+      .end_collection();
+
+  // LED (input)
+  d.usage_page(usage_page::generic_desktop)
+      .usage(0x06) // Keyboard
+      .collection(collection_type::application)
+      /*  */.report_id(keyboard_report_id::led_input)
+      /*  */.usage_page(usage_page::leds)
+      /*  */.report_count(2)
+      /*  */.report_size(1)
+      /*  */.usage_minimum(1) // Num Lock
+      /*  */.usage_maximum(2) // Caps Lock
+      /*  */.input(main_flag::data | main_flag::variable | main_flag::absolute)
+      /*  */.report_count(1)
+      /*  */.report_size(6)
+      /*  */.input(main_flag::constant)
+      .end_collection();
+
+  // keyboard_bitmap_input
+  d.usage_page(usage_page::generic_desktop)
+      .usage(0x06) // Keyboard
+      .collection(collection_type::application)
+      /*  */.report_id(keyboard_report_id::keyboard_bitmap_input)
+      /*  */.usage_page(usage_page::keyboard_or_keypad)
+      /*  */.usage_minimum(0xe0)
+      /*  */.usage_maximum(0xe7)
+      /*  */.logical_minimum(0)
+      /*  */.logical_maximum(1)
+      /*  */.report_size(1)
+      /*  */.report_count(8)
+      /*  */.input(main_flag::data | main_flag::variable | main_flag::absolute) // modifiers
+      /*  */.usage_minimum(0)
+      /*  */.usage_maximum(255)
+      /*  */.report_count(256)
+      /*  */.input(main_flag::data | main_flag::variable | main_flag::absolute) // keys
+      .end_collection();
+
+  return d;
+}();
+
+static_assert(hid_descriptor::report_byte_size(keyboard_report_descriptor,
+                                               hid_descriptor::report_type::input,
+                                               keyboard_report_id::keyboard_input) == sizeof(keyboard_input));
+static_assert(hid_descriptor::report_byte_size(keyboard_report_descriptor,
+                                               hid_descriptor::report_type::input,
+                                               keyboard_report_id::consumer_input) == sizeof(consumer_input));
+static_assert(hid_descriptor::report_byte_size(keyboard_report_descriptor,
+                                               hid_descriptor::report_type::input,
+                                               keyboard_report_id::apple_vendor_top_case_input) == sizeof(apple_vendor_top_case_input));
+static_assert(hid_descriptor::report_byte_size(keyboard_report_descriptor,
+                                               hid_descriptor::report_type::input,
+                                               keyboard_report_id::apple_vendor_keyboard_input) == sizeof(apple_vendor_keyboard_input));
+static_assert(hid_descriptor::report_byte_size(keyboard_report_descriptor,
+                                               hid_descriptor::report_type::input,
+                                               keyboard_report_id::keyboard_bitmap_input) == sizeof(keyboard_bitmap_input));
+
+} // namespace hid_report
+} // namespace virtual_hid_device_driver
+} // namespace driverkit
+} // namespace karabiner
+} // namespace pqrs
@@ -62,6 +62,16 @@ public:
     return false;
   }
 
+  // Returns true if all keys in `other` exist in this.
+  bool includes(const keys& other) const {
+    for (const auto& k : other.keys_) {
+      if (k != 0 && !exists(k)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
   size_t count(void) const {
     size_t result = 0;
     for (const auto& k : keys_) {
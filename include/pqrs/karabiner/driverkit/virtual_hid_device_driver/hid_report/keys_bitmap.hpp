@@ -0,0 +1,88 @@
+#pragma once
+
+// (C) Copyright Takayama Fumihiko 2020.
+// Distributed under the Boost Software License, Version 1.0.
+// (See https://www.boost.org/LICENSE_1_0.txt)
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace pqrs {
+namespace karabiner {
+namespace driverkit {
+namespace virtual_hid_device_driver {
+namespace hid_report {
+
+// A bitmap of usages (0x00 - 0xff).
+// Unlike `keys`, there is no limit of the number of pressed keys.
+class __attribute__((packed)) keys_bitmap final {
+public:
+  keys_bitmap(void) : bits_{} {}
+
+  const uint8_t (&get_raw_value(void) const)[32] {
+    return bits_;
+  }
+
+  bool empty(void) const {
+    for (const auto& b : bits_) {
+      if (b != 0) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  void clear(void) {
+    memset(bits_, 0, sizeof(bits_));
+  }
+
+  // Usage 0 (no event) is ignored.
+  void insert(uint8_t key) {
+    if (key != 0) {
+      bits_[key >> 3] |= mask(key);
+    }
+  }
+
+  void erase(uint8_t key) {
+    bits_[key >> 3] &= static_cast<uint8_t>(~mask(key));
+  }
+
+  bool exists(uint8_t key) const {
+    return key != 0 && (bits_[key >> 3] & mask(key)) != 0;
+  }
+
+  // Returns true if all keys in `other` exist in this.
+  bool includes(const keys_bitmap& other) const {
+    for (size_t i = 0; i < sizeof(bits_); ++i) {
+      if ((bits_[i] & other.bits_[i]) != other.bits_[i]) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  size_t count(void) const {
+    size_t result = 0;
+    for (const auto& b : bits_) {
+      result += __builtin_popcount(b);
+    }
+    return result;
+  }
+
+  bool operator==(const keys_bitmap& other) const { return (memcmp(this, &other, sizeof(*this)) == 0); }
+  bool operator!=(const keys_bitmap& other) const { return !(*this == other); }
+
+private:
+  static uint8_t mask(uint8_t key) {
+    return static_cast<uint8_t>(1 << (key & 0x7));
+  }
+
+  uint8_t bits_[32];
+};
+
+} // namespace hid_report
+} // namespace virtual_hid_device_driver
+} // namespace driverkit
+} // namespace karabiner
+} // namespace pqrs
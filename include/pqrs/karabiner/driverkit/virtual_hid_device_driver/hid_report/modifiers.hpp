@@ -41,6 +41,11 @@ public:
     return modifiers_ & static_cast<uint8_t>(value);
   }
 
+  // Returns true if all modifiers in `other` exist in this.
+  bool includes(const modifiers& other) const {
+    return (modifiers_ & other.modifiers_) == other.modifiers_;
+  }
+
   bool operator==(const modifiers& other) const { return (memcmp(this, &other, sizeof(*this)) == 0); }
   bool operator!=(const modifiers& other) const { return !(*this == other); }
 
@@ -0,0 +1,107 @@
+#pragma once
+
+// (C) Copyright Takayama Fumihiko 2020.
+// Distributed under the Boost Software License, Version 1.0.
+// (See https://www.boost.org/LICENSE_1_0.txt)
+
+#include "../hid_descriptor.hpp"
+#include "pointing_high_resolution_input.hpp"
+#include "wheel_resolution.hpp"
+
+namespace pqrs {
+namespace karabiner {
+namespace driverkit {
+namespace virtual_hid_device_driver {
+namespace hid_report {
+
+// The pointing device does not use report ids.
+// The input report is `pointing_high_resolution_input` and the feature report is `wheel_resolution_multiplier_feature`.
+// (The driver converts posted reports by `wheel_resolution`.)
+constexpr auto pointing_report_descriptor = [] {
+  using namespace hid_descriptor;
+
+  descriptor<128> d;
+
+  d.usage_page(usage_page::generic_desktop)
+      .usage(0x02) // Mouse
+      .collection(collection_type::application)
+      /*  */.usage(0x02) // Mouse
+      /*  */.collection(collection_type::logical)
+      /*    */.usage(0x01) // Pointer
+      /*    */.collection(collection_type::physical)
+      /*      */ // Buttons
+      /*      */.usage_page(usage_page::button)
+      /*      */.usage_minimum(1)
+      /*      */.usage_maximum(32)
+      /*      */.logical_minimum(0)
+      /*      */.logical_maximum(1)
+      /*      */.report_size(1)
+      /*      */.report_count(32)
+      /*      */.input(main_flag::data | main_flag::variable | main_flag::absolute)
+      /*      */ // X, Y
+      /*      */.usage_page(usage_page::generic_desktop)
+      /*      */.usage(0x30) // X
+      /*      */.usage(0x31) // Y
+      /*      */.logical_minimum(-127)
+      /*      */.logical_maximum(127)
+      /*      */.report_size(8)
+      /*      */.report_count(2)
+      /*      */.input(main_flag::data | main_flag::variable | main_flag::relative)
+      /*      */.collection(collection_type::logical)
+      /*        */ // Vertical wheel resolution multiplier
+      /*        */.usage(0x48) // Resolution Multiplier
+      /*        */.logical_minimum(0)
+      /*        */.logical_maximum(1)
+      /*        */.physical_minimum(1)
+      /*        */.physical_maximum(4)
+      /*        */.report_size(2)
+      /*        */.report_count(1)
+      /*        */.push()
+      /*        */.feature(main_flag::data | main_flag::variable | main_flag::absolute)
+      /*        */ // Vertical wheel
+      /*        */.usage(0x38) // Wheel
+      /*        */.logical_minimum(-32767)
+      /*        */.logical_maximum(32767)
+      /*        */.physical_minimum(0)
+      /*        */.physical_maximum(0)
+      /*        */.report_size(16)
+      /*        */.input(main_flag::data | main_flag::variable | main_flag::relative)
+      /*      */.end_collection()
+      /*      */.collection(collection_type::logical)
+      /*        */ // Horizontal wheel resolution multiplier
+      /*        */.usage(0x48) // Resolution Multiplier
+      /*        */.pop()
+      /*        */.feature(main_flag::data | main_flag::variable | main_flag::absolute)
+      /*        */ // Padding for Feature report
+      /*        */.physical_minimum(0)
+      /*        */.physical_maximum(0)
+      /*        */.report_size(4)
+      /*        */.feature(main_flag::constant | main_flag::variable | main_flag::absolute)
+      /*        */ // Horizontal wheel
+      /*        */.usage_page(usage_page::consumer)
+      /*        */.usage(0x238) // AC Pan
+      /*        */.logical_minimum(-32767)
+      /*        */.logical_maximum(32767)
+      /*        */.report_size(16)
+      /*        */.input(main_flag::data | main_flag::variable | main_flag::relative)
+      /*      */.end_collection()
+      /*    */.end_collection()
+      /*  */.end_collection()
+      .end_collection();
+
+  return d;
+}();
+
+static_assert(hid_descriptor::report_byte_size(pointing_report_descriptor,
+                                               hid_descriptor::report_type::input,
+                                               0) == sizeof(pointing_high_resolution_input));
+
+static_assert(hid_descriptor::report_byte_size(pointing_report_descriptor,
+                                               hid_descriptor::report_type::feature,
+                                               0) == sizeof(wheel_resolution_multiplier_feature));
+
+} // namespace hid_report
+} // namespace virtual_hid_device_driver
+} // namespace driverkit
+} // namespace karabiner
+} // namespace pqrs
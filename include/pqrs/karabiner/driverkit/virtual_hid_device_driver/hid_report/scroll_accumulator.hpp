@@ -0,0 +1,69 @@
+#pragma once
+
+// (C) Copyright Takayama Fumihiko 2020.
+// Distributed under the Boost Software License, Version 1.0.
+// (See https://www.boost.org/LICENSE_1_0.txt)
+
+#include "pointing_high_resolution_input.hpp"
+#include <cstdint>
+
+namespace pqrs {
+namespace karabiner {
+namespace driverkit {
+namespace virtual_hid_device_driver {
+namespace hid_report {
+
+// Accumulates fractional scroll amounts (in detents) for `pointing_high_resolution_input`.
+// The fraction which cannot be represented by `wheel_unit` is carried to the next report.
+//
+// Example:
+//   scroll_accumulator accumulator;
+//   accumulator.add(0.3, 0.0);
+//   pointing_high_resolution_input report;
+//   accumulator.apply(report);
+class scroll_accumulator final {
+public:
+  scroll_accumulator(void) : vertical_(0.0),
+                             horizontal_(0.0) {
+  }
+
+  void add(double vertical_detents, double horizontal_detents) {
+    vertical_ += vertical_detents * pointing_high_resolution_input::wheel_unit;
+    horizontal_ += horizontal_detents * pointing_high_resolution_input::wheel_unit;
+  }
+
+  // Returns false if there is no wheel value to post.
+  bool apply(pointing_high_resolution_input& report) {
+    report.vertical_wheel = take(vertical_);
+    report.horizontal_wheel = take(horizontal_);
+    return report.vertical_wheel != 0 || report.horizontal_wheel != 0;
+  }
+
+  void clear(void) {
+    vertical_ = 0.0;
+    horizontal_ = 0.0;
+  }
+
+private:
+  static int16_t take(double& value) {
+    double integral = value;
+    if (integral > 32767.0) {
+      integral = 32767.0;
+    } else if (integral < -32767.0) {
+      integral = -32767.0;
+    }
+
+    auto result = static_cast<int16_t>(integral);
+    value -= result;
+    return result;
+  }
+
+  double vertical_;
+  double horizontal_;
+};
+
+} // namespace hid_report
+} // namespace virtual_hid_device_driver
+} // namespace driverkit
+} // namespace karabiner
+} // namespace pqrs
@@ -0,0 +1,101 @@
+#pragma once
+
+// (C) Copyright Takayama Fumihiko 2020.
+// Distributed under the Boost Software License, Version 1.0.
+// (See https://www.boost.org/LICENSE_1_0.txt)
+
+#include "pointing_high_resolution_input.hpp"
+#include "pointing_input.hpp"
+#include <cstdint>
+
+namespace pqrs {
+namespace karabiner {
+namespace driverkit {
+namespace virtual_hid_device_driver {
+namespace hid_report {
+
+// The Resolution Multiplier feature report of the pointing device.
+// bits: 0b0000(horizontal)(vertical)
+class __attribute__((packed)) wheel_resolution_multiplier_feature final {
+public:
+  // The logical value 0-1 is mapped to the physical multiplier 1-4. (See `pointing_report_descriptor`.)
+  static constexpr int32_t minimum_multiplier = 1;
+  static constexpr int32_t maximum_multiplier = 4;
+
+  wheel_resolution_multiplier_feature(void) : value(0) {}
+  explicit wheel_resolution_multiplier_feature(uint8_t value) : value(value) {}
+
+  int32_t vertical_multiplier(void) const {
+    return multiplier(value & 0x3);
+  }
+
+  int32_t horizontal_multiplier(void) const {
+    return multiplier((value >> 2) & 0x3);
+  }
+
+  uint8_t value;
+
+private:
+  static int32_t multiplier(uint8_t logical_value) {
+    return logical_value == 0 ? minimum_multiplier : maximum_multiplier;
+  }
+};
+
+// Converts posted reports into the input report of the pointing device.
+// The wheel values of the device report are in 1/multiplier of a detent.
+class wheel_resolution final {
+public:
+  // The converted wheel values never overflow.
+  static_assert(wheel_resolution_multiplier_feature::maximum_multiplier <= pointing_high_resolution_input::wheel_unit);
+
+  wheel_resolution(void) : vertical_remainder_(0),
+                           horizontal_remainder_(0) {
+  }
+
+  const wheel_resolution_multiplier_feature& get_feature(void) const {
+    return feature_;
+  }
+
+  void set_feature(const wheel_resolution_multiplier_feature& value) {
+    feature_ = value;
+    vertical_remainder_ = 0;
+    horizontal_remainder_ = 0;
+  }
+
+  // The wheel values of `pointing_input` are detents.
+  pointing_high_resolution_input convert(const pointing_input& report) const {
+    pointing_high_resolution_input result;
+    result.buttons = report.buttons;
+    result.x = report.x;
+    result.y = report.y;
+    result.vertical_wheel = static_cast<int16_t>(static_cast<int8_t>(report.vertical_wheel) * feature_.vertical_multiplier());
+    result.horizontal_wheel = static_cast<int16_t>(static_cast<int8_t>(report.horizontal_wheel) * feature_.horizontal_multiplier());
+    return result;
+  }
+
+  // The fraction which cannot be represented by the current multiplier is carried to the next report.
+  pointing_high_resolution_input convert(const pointing_high_resolution_input& report) {
+    pointing_high_resolution_input result = report;
+    result.vertical_wheel = scale(report.vertical_wheel, feature_.vertical_multiplier(), vertical_remainder_);
+    result.horizontal_wheel = scale(report.horizontal_wheel, feature_.horizontal_multiplier(), horizontal_remainder_);
+    return result;
+  }
+
+private:
+  static int16_t scale(int16_t value, int32_t multiplier, int32_t& remainder) {
+    auto total = remainder + static_cast<int32_t>(value) * multiplier;
+    auto result = total / pointing_high_resolution_input::wheel_unit;
+    remainder = total % pointing_high_resolution_input::wheel_unit;
+    return static_cast<int16_t>(result);
+  }
+
+  wheel_resolution_multiplier_feature feature_;
+  int32_t vertical_remainder_;
+  int32_t horizontal_remainder_;
+};
+
+} // namespace hid_report
+} // namespace virtual_hid_device_driver
+} // namespace driverkit
+} // namespace karabiner
+} // namespace pqrs
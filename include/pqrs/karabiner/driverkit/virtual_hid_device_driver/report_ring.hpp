@@ -0,0 +1,290 @@
+#pragma once
+
+// (C) Copyright Takayama Fumihiko 2020.
+// Distributed under the Boost Software License, Version 1.0.
+// (See https://www.boost.org/LICENSE_1_0.txt)
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <type_traits>
+
+namespace pqrs {
+namespace karabiner {
+namespace driverkit {
+namespace virtual_hid_device_driver {
+namespace report_ring {
+
+//
+// A single-producer single-consumer report ring which is shared between the client (`io_service_client`) and the driver.
+//
+// The driver allocates a ring for each user client and the client maps it with `IOConnectMapMemory64` (`user_client_memory_type::report_ring`).
+// (Each virtual device has its own user client.)
+// The client pushes reports and rings the doorbell (`user_client_method::report_ring_doorbell`) once per batch,
+// and the driver drains all pushed reports in the doorbell call.
+//
+// The doorbell is rung only when `producer::publish` returns true.
+// The consumer clears `doorbell_pending` before draining so that a report pushed after the last pop rings the doorbell again.
+//
+// Overflow policy:
+// When the ring is full, the producer rings the doorbell regardless of `doorbell_pending` and retries once.
+// The report is dropped only if the ring is still full (e.g., the doorbell failed).
+//
+// The consumer does not trust the shared memory:
+// it keeps its own head, and skips entries which have an invalid size or a tail which is out of range.
+//
+
+constexpr uint32_t magic = 0x52484b56; // "VKHR"
+constexpr uint32_t version = 1;
+constexpr uint32_t capacity = 256;
+constexpr size_t max_report_size = 64;
+
+static_assert((capacity & (capacity - 1)) == 0, "capacity must be a power of two");
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "std::atomic<uint64_t> must be lock-free");
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "std::atomic<uint32_t> must be lock-free");
+
+struct entry final {
+  // `user_client_method`
+  uint32_t method;
+  uint32_t size;
+  uint8_t data[max_report_size];
+};
+
+struct layout final {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t capacity;
+  uint32_t entry_size;
+
+  // Written by the consumer.
+  alignas(64) std::atomic<uint64_t> head;
+  std::atomic<uint64_t> consumed_reports;
+  // Reports which are failed in the driver or skipped due to an invalid entry.
+  std::atomic<uint64_t> failed_reports;
+
+  // Written by the producer.
+  alignas(64) std::atomic<uint64_t> tail;
+  std::atomic<uint64_t> dropped_reports;
+
+  // Set by the producer, cleared by the consumer.
+  alignas(64) std::atomic<uint32_t> doorbell_pending;
+
+  alignas(64) entry entries[report_ring::capacity];
+
+  // `address` must be aligned to 64 bytes and have `sizeof(layout)` bytes.
+  static layout* initialize(void* address) {
+    auto l = new (address) layout();
+    l->magic = report_ring::magic;
+    l->version = report_ring::version;
+    l->capacity = report_ring::capacity;
+    l->entry_size = sizeof(entry);
+    l->head.store(0, std::memory_order_relaxed);
+    l->consumed_reports.store(0, std::memory_order_relaxed);
+    l->failed_reports.store(0, std::memory_order_relaxed);
+    l->tail.store(0, std::memory_order_relaxed);
+    l->dropped_reports.store(0, std::memory_order_relaxed);
+    l->doorbell_pending.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    return l;
+  }
+
+  // Returns nullptr if the memory is not a ring of this version.
+  static layout* validate(void* address, size_t size) {
+    if (!address || size < sizeof(layout)) {
+      return nullptr;
+    }
+
+    auto l = static_cast<layout*>(address);
+    if (l->magic != report_ring::magic ||
+        l->version != report_ring::version ||
+        l->capacity != report_ring::capacity ||
+        l->entry_size != sizeof(entry)) {
+      return nullptr;
+    }
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return l;
+  }
+};
+
+static_assert(std::is_standard_layout_v<layout>, "layout must be standard layout");
+
+enum class push_result {
+  pushed,
+  full,
+  invalid_size,
+};
+
+class producer final {
+public:
+  producer(void) : layout_(nullptr),
+                   tail_(0) {
+  }
+
+  producer(const producer&) = delete;
+
+  bool is_attached(void) const {
+    return layout_ != nullptr;
+  }
+
+  void attach(layout* l) {
+    layout_ = l;
+    tail_ = l ? l->tail.load(std::memory_order_relaxed) : 0;
+  }
+
+  void detach(void) {
+    attach(nullptr);
+  }
+
+  // Writes the report into the ring.
+  // The report is visible to the consumer after `publish`.
+  push_result push(uint32_t method,
+                   const void* report,
+                   size_t size) {
+    if (size > max_report_size) {
+      return push_result::invalid_size;
+    }
+
+    if (tail_ - layout_->head.load(std::memory_order_acquire) >= capacity) {
+      return push_result::full;
+    }
+
+    auto& e = layout_->entries[tail_ & (capacity - 1)];
+    e.method = method;
+    e.size = static_cast<uint32_t>(size);
+    if (size > 0) {
+      memcpy(e.data, report, size);
+    }
+
+    ++tail_;
+
+    return push_result::pushed;
+  }
+
+  // Publishes pushed reports.
+  // Returns true if the caller has to ring the doorbell.
+  bool publish(void) {
+    layout_->tail.store(tail_, std::memory_order_release);
+
+    // Pairs with the fence in `consumer::drain`.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    return layout_->doorbell_pending.exchange(1) == 0;
+  }
+
+  // Publishes pushed reports and rings the doorbell if needed.
+  // `doorbell` is a function which wakes the consumer and returns false on error.
+  template <typename Doorbell>
+  bool flush(Doorbell&& doorbell) {
+    if (publish()) {
+      return ring(doorbell);
+    }
+    return true;
+  }
+
+  // Pushes a report with the overflow policy.
+  template <typename Doorbell>
+  push_result push(uint32_t method,
+                   const void* report,
+                   size_t size,
+                   Doorbell&& doorbell) {
+    auto r = push(method, report, size);
+    if (r == push_result::full) {
+      publish();
+      ring(doorbell);
+
+      r = push(method, report, size);
+      if (r == push_result::full) {
+        layout_->dropped_reports.fetch_add(1, std::memory_order_relaxed);
+      }
+    }
+    return r;
+  }
+
+private:
+  template <typename Doorbell>
+  bool ring(Doorbell&& doorbell) {
+    if (doorbell()) {
+      return true;
+    }
+
+    // Allow the next `publish` to ring the doorbell again.
+    layout_->doorbell_pending.store(0);
+    return false;
+  }
+
+  layout* layout_;
+  uint64_t tail_;
+};
+
+// The zero-initialized state is detached so that it can be placed in a zero-filled driver instance variable.
+class consumer final {
+public:
+  bool is_attached(void) const {
+    return layout_ != nullptr;
+  }
+
+  void attach(layout* l) {
+    layout_ = l;
+    head_ = l ? l->head.load(std::memory_order_relaxed) : 0;
+  }
+
+  // Calls `function(uint32_t method, const uint8_t* data, size_t size)` for each published report,
+  // and returns the number of reports.
+  // `function` returns false if the report is failed.
+  template <typename Function>
+  size_t drain(Function&& function) {
+    // Clear the flag before popping so that a report published after the last pop rings the doorbell again.
+    layout_->doorbell_pending.store(0);
+
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    auto tail = layout_->tail.load(std::memory_order_acquire);
+    if (tail - head_ > capacity) {
+      // The tail is out of range. Discard the ring.
+      layout_->failed_reports.fetch_add(1, std::memory_order_relaxed);
+      head_ = tail;
+      layout_->head.store(head_, std::memory_order_release);
+      return 0;
+    }
+
+    size_t count = 0;
+    uint64_t failed = 0;
+
+    while (head_ != tail) {
+      // Copy the entry before validation because the producer can write the shared memory at any time.
+      entry e;
+      memcpy(&e, &(layout_->entries[head_ & (capacity - 1)]), sizeof(e));
+
+      if (e.size > max_report_size ||
+          !function(e.method, static_cast<const uint8_t*>(e.data), static_cast<size_t>(e.size))) {
+        ++failed;
+      }
+
+      ++head_;
+      ++count;
+      layout_->head.store(head_, std::memory_order_release);
+    }
+
+    layout_->consumed_reports.fetch_add(count, std::memory_order_relaxed);
+    if (failed > 0) {
+      layout_->failed_reports.fetch_add(failed, std::memory_order_relaxed);
+    }
+
+    return count;
+  }
+
+private:
+  layout* layout_;
+  uint64_t head_;
+};
+
+static_assert(std::is_trivially_default_constructible_v<consumer>, "consumer must be trivially default constructible");
+
+} // namespace report_ring
+} // namespace virtual_hid_device_driver
+} // namespace driverkit
+} // namespace karabiner
+} // namespace pqrs
@@ -28,6 +28,34 @@ enum class user_client_method {
   virtual_hid_pointing_ready,
   virtual_hid_pointing_post_report,
   virtual_hid_pointing_reset,
+
+  //
+  // absolute pointing
+  //
+
+  virtual_hid_absolute_pointing_initialize,
+  virtual_hid_absolute_pointing_ready,
+  virtual_hid_absolute_pointing_post_report,
+  virtual_hid_absolute_pointing_reset,
+
+  //
+  // report ring
+  //
+
+  report_ring_doorbell,
+
+  //
+  // terminate
+  // (Virtual devices are also terminated when the connection is closed.)
+  //
+
+  virtual_hid_keyboard_terminate,
+  virtual_hid_pointing_terminate,
+  virtual_hid_absolute_pointing_terminate,
+};
+
+enum class user_client_memory_type {
+  report_ring,
 };
 } // namespace virtual_hid_device_driver
 } // namespace driverkit
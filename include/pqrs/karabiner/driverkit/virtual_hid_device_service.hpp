@@ -6,6 +6,18 @@
 
 #include "virtual_hid_device_service/client.hpp"
 #include "virtual_hid_device_service/constants.hpp"
+#include "virtual_hid_device_service/device_lifecycle.hpp"
+#include "virtual_hid_device_service/direct_client.hpp"
+#include "virtual_hid_device_service/flow_control.hpp"
+#include "virtual_hid_device_service/forwarding_queue.hpp"
+#include "virtual_hid_device_service/hid_names.hpp"
+#include "virtual_hid_device_service/metrics.hpp"
+#include "virtual_hid_device_service/perfect_hash.hpp"
+#include "virtual_hid_device_service/pointing_motion.hpp"
 #include "virtual_hid_device_service/request.hpp"
+#include "virtual_hid_device_service/request_schema.hpp"
+#include "virtual_hid_device_service/request_trace.hpp"
 #include "virtual_hid_device_service/response.hpp"
+#include "virtual_hid_device_service/session_state.hpp"
+#include "virtual_hid_device_service/text_input.hpp"
 #include "virtual_hid_device_service/utility.hpp"
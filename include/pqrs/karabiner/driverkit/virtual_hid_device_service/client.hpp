@@ -5,11 +5,22 @@
 // (See https://www.boost.org/LICENSE_1_0.txt)
 
 #include "constants.hpp"
+#include "flow_control.hpp"
 #include "request.hpp"
+#include "request_schema.hpp"
 #include "response.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <future>
+#include <mutex>
 #include <pqrs/dispatcher.hpp>
 #include <pqrs/hid.hpp>
 #include <pqrs/local_datagram.hpp>
+#include <string_view>
+#include <tuple>
+#include <unordered_map>
 
 namespace pqrs {
 namespace karabiner {
@@ -27,17 +38,74 @@ public:
   nod::signal<void(bool)> driver_version_matched_response;
   nod::signal<void(bool)> virtual_hid_keyboard_ready_response;
   nod::signal<void(bool)> virtual_hid_pointing_ready_response;
+  nod::signal<void(bool)> virtual_hid_absolute_pointing_ready_response;
+  // Requests which are dropped by the send queue (e.g., pointing motion while the server is stalled).
+  nod::signal<void(request)> request_dropped;
+  // The cumulative sequence of completed reports when the flow control is enabled.
+  nod::signal<void(uint64_t)> reports_completed;
+  // The result of each `request::post_text` (mapped characters, unmapped characters).
+  // Unmapped characters are truncated to `max_reported_unmapped_characters`.
+  nod::signal<void(uint32_t, const std::vector<post_text_unmapped_character>&)> post_text_response;
 
   // Methods
 
-  client(const std::string& client_socket_file_path) : dispatcher_client(),
-                                                       client_socket_file_path_(client_socket_file_path) {
+  client(const std::string& client_socket_file_path,
+         const std::string& server_socket_file_path = std::string(constants::server_socket_file_path)) : dispatcher_client(),
+                                                                                                         client_socket_file_path_(client_socket_file_path),
+                                                                                                         server_socket_file_path_(server_socket_file_path),
+                                                                                                         flow_control_enabled_(false),
+                                                                                                         flow_control_connected_(false),
+                                                                                                         flow_control_window_(constants::flow_control_initial_credits),
+                                                                                                         send_queue_dropped_count_(0),
+                                                                                                         send_queue_hard_capacity_dropped_count_(0),
+                                                                                                         last_correlation_id_(0) {
   }
 
   virtual ~client(void) {
     detach_from_dispatcher([this] {
       client_ = nullptr;
     });
+
+    // The dispatcher thread does not touch `pending_queries_` after `detach_from_dispatcher`.
+    for (auto&& [correlation_id, q] : pending_queries_) {
+      q.promise->set_value(std::nullopt);
+    }
+    pending_queries_.clear();
+  }
+
+  // Reports are sent with sequence numbers and the server acknowledges them after the backend call.
+  // Reports are numbered 1, 2, 3, ... in the order of `async_post_report` calls,
+  // and they are held in the client until the server grants credits.
+  // Reports are never coalesced or dropped in this mode.
+  //
+  // You have to call `set_flow_control_enabled` before `async_start`.
+  void set_flow_control_enabled(bool value) {
+    flow_control_enabled_ = value;
+  }
+
+  flow_control::window get_flow_control_window(void) const {
+    std::lock_guard<std::mutex> lock(flow_control_window_mutex_);
+
+    return flow_control_window_;
+  }
+
+  // The number of reports which are waiting for credits.
+  size_t get_flow_control_pending_count(void) const {
+    std::lock_guard<std::mutex> lock(flow_control_window_mutex_);
+
+    return flow_control_pending_.size();
+  }
+
+  // The number of requests which are dropped by the send queue.
+  // The count includes `get_send_queue_hard_capacity_dropped_count`.
+  size_t get_send_queue_dropped_count(void) const {
+    return send_queue_dropped_count_;
+  }
+
+  // The number of requests which are dropped because the send queue reaches `constants::local_datagram_send_queue_hard_capacity`.
+  // Keyboard reports and pointing reports which change buttons are dropped only in this case.
+  size_t get_send_queue_hard_capacity_dropped_count(void) const {
+    return send_queue_hard_capacity_dropped_count_;
   }
 
   void async_start(void) {
@@ -57,80 +125,218 @@ public:
   void async_stop(void) {
     enqueue_to_dispatcher([this] {
       client_ = nullptr;
+
+      for (auto&& [correlation_id, q] : pending_queries_) {
+        q.promise->set_value(std::nullopt);
+      }
+      pending_queries_.clear();
     });
   }
 
   void async_driver_loaded(void) {
-    async_send(request::driver_loaded);
+    async_send<request::driver_loaded>();
   }
 
   void async_driver_version_matched(void) {
-    async_send(request::driver_version_matched);
+    async_send<request::driver_version_matched>();
+  }
+
+  //
+  // Queries
+  //
+  // The response is correlated with the request by a correlation id.
+  // The future is set to std::nullopt when the response is not received within `timeout`
+  // (e.g., the server is not running), or when the client is stopped.
+  // The corresponding `*_response` signal is also called when the response is received.
+  //
+
+  std::future<std::optional<bool>> query_driver_loaded(std::chrono::milliseconds timeout) {
+    return query<request::driver_loaded>(response::driver_loaded_result, timeout);
+  }
+
+  std::future<std::optional<bool>> query_driver_version_matched(std::chrono::milliseconds timeout) {
+    return query<request::driver_version_matched>(response::driver_version_matched_result, timeout);
+  }
+
+  std::future<std::optional<bool>> query_virtual_hid_keyboard_ready(std::chrono::milliseconds timeout) {
+    return query<request::virtual_hid_keyboard_ready>(response::virtual_hid_keyboard_ready_result, timeout);
+  }
+
+  std::future<std::optional<bool>> query_virtual_hid_pointing_ready(std::chrono::milliseconds timeout) {
+    return query<request::virtual_hid_pointing_ready>(response::virtual_hid_pointing_ready_result, timeout);
+  }
+
+  std::future<std::optional<bool>> query_virtual_hid_absolute_pointing_ready(std::chrono::milliseconds timeout) {
+    return query<request::virtual_hid_absolute_pointing_ready>(response::virtual_hid_absolute_pointing_ready_result, timeout);
   }
 
   void async_virtual_hid_keyboard_initialize(hid::country_code::value_t country_code) {
-    async_send(request::virtual_hid_keyboard_initialize, country_code);
+    async_send<request::virtual_hid_keyboard_initialize>(type_safe::get(country_code));
   }
 
   void async_virtual_hid_keyboard_terminate(void) {
-    async_send(request::virtual_hid_keyboard_terminate);
+    async_send<request::virtual_hid_keyboard_terminate>();
   }
 
   void async_virtual_hid_keyboard_ready(void) {
-    async_send(request::virtual_hid_keyboard_ready);
+    async_send<request::virtual_hid_keyboard_ready>();
   }
 
   void async_virtual_hid_keyboard_reset(void) {
-    async_send(request::virtual_hid_keyboard_reset);
+    async_send<request::virtual_hid_keyboard_reset>();
   }
 
   void async_virtual_hid_pointing_initialize(void) {
-    async_send(request::virtual_hid_pointing_initialize);
+    async_send<request::virtual_hid_pointing_initialize>();
   }
 
   void async_virtual_hid_pointing_terminate(void) {
-    async_send(request::virtual_hid_pointing_terminate);
+    async_send<request::virtual_hid_pointing_terminate>();
   }
 
   void async_virtual_hid_pointing_ready(void) {
-    async_send(request::virtual_hid_pointing_ready);
+    async_send<request::virtual_hid_pointing_ready>();
   }
 
   void async_virtual_hid_pointing_reset(void) {
-    async_send(request::virtual_hid_pointing_reset);
+    async_send<request::virtual_hid_pointing_reset>();
+  }
+
+  void async_virtual_hid_absolute_pointing_initialize(void) {
+    async_send<request::virtual_hid_absolute_pointing_initialize>();
+  }
+
+  void async_virtual_hid_absolute_pointing_terminate(void) {
+    async_send<request::virtual_hid_absolute_pointing_terminate>();
+  }
+
+  void async_virtual_hid_absolute_pointing_ready(void) {
+    async_send<request::virtual_hid_absolute_pointing_ready>();
+  }
+
+  void async_virtual_hid_absolute_pointing_reset(void) {
+    async_send<request::virtual_hid_absolute_pointing_reset>();
   }
 
   void async_post_report(const virtual_hid_device_driver::hid_report::keyboard_input& report) {
-    async_send(request::post_keyboard_input_report, report);
+    async_send_report<request::post_keyboard_input_report>(report);
+  }
+
+  void async_post_report(const virtual_hid_device_driver::hid_report::keyboard_bitmap_input& report) {
+    async_send_report<request::post_keyboard_bitmap_input_report>(report);
   }
 
   void async_post_report(const virtual_hid_device_driver::hid_report::consumer_input& report) {
-    async_send(request::post_consumer_input_report, report);
+    async_send_report<request::post_consumer_input_report>(report);
   }
 
   void async_post_report(const virtual_hid_device_driver::hid_report::apple_vendor_keyboard_input& report) {
-    async_send(request::post_apple_vendor_keyboard_input_report, report);
+    async_send_report<request::post_apple_vendor_keyboard_input_report>(report);
   }
 
   void async_post_report(const virtual_hid_device_driver::hid_report::apple_vendor_top_case_input& report) {
-    async_send(request::post_apple_vendor_top_case_input_report, report);
+    async_send_report<request::post_apple_vendor_top_case_input_report>(report);
   }
 
   void async_post_report(const virtual_hid_device_driver::hid_report::pointing_input& report) {
-    async_send(request::post_pointing_input_report, report);
+    async_send_pointing_report<request::post_pointing_input_report>(report);
+  }
+
+  // Use `hid_report::scroll_accumulator` to make wheel values from fractional scroll amounts.
+  void async_post_report(const virtual_hid_device_driver::hid_report::pointing_high_resolution_input& report) {
+    async_send_pointing_report<request::post_pointing_high_resolution_input_report>(report);
+  }
+
+  void async_post_report(const virtual_hid_device_driver::hid_report::absolute_pointing_input& report) {
+    enqueue_to_dispatcher([this, report] {
+      if (flow_control_enabled_) {
+        send_sequenced<request::post_absolute_pointing_input_report>(report);
+        return;
+      }
+
+      // Reports which change buttons are never dropped.
+      // Motion-only reports replace the queued one while the server is stalled since only the latest position matters.
+      auto policy = local_datagram::send_policy::never_drop(static_cast<uint32_t>(request::post_absolute_pointing_input_report));
+      if (last_absolute_pointing_input_buttons_ == report.buttons) {
+        policy = local_datagram::send_policy::coalesce(static_cast<uint32_t>(request::post_absolute_pointing_input_report),
+                                                       merge_absolute_pointing_input);
+      }
+      last_absolute_pointing_input_buttons_ = report.buttons;
+
+      send<request::post_absolute_pointing_input_report>(report, policy);
+    });
+  }
+
+  // The server generates the intermediate reports of `motion`.
+  // A new motion supersedes the running one.
+  void async_post_pointing_motion(const pointing_motion& motion) {
+    async_send<request::post_pointing_motion>(motion);
+  }
+
+  void async_cancel_pointing_motion(void) {
+    async_send<request::cancel_pointing_motion>();
+  }
+
+  // The server expands `text` (UTF-8) into keyboard reports with the layout of the country code of the virtual keyboard.
+  // Texts longer than `request_schema::max_text_size` are split at character boundaries,
+  // and `post_text_response` is called for each part.
+  void async_post_text(const std::string& text) {
+    enqueue_to_dispatcher([this, text] {
+      std::string_view rest(text);
+      do {
+        auto size = std::min(rest.size(), request_schema::max_text_size);
+        if (size < rest.size()) {
+          // Do not split a UTF-8 sequence.
+          while (size > 0 && (static_cast<uint8_t>(rest[size]) & 0xc0) == 0x80) {
+            --size;
+          }
+          if (size == 0) {
+            size = request_schema::max_text_size;
+          }
+        }
+
+        auto message = request_schema::encode_text<request::post_text>(rest.substr(0, size));
+        if (flow_control_enabled_) {
+          send_sequenced_message(message);
+        } else if (client_) {
+          client_->async_send(message);
+        }
+
+        rest.remove_prefix(size);
+      } while (!rest.empty());
+    });
+  }
+
+  // Start recording received requests into `constants::request_trace_file_path`.
+  void async_request_trace_start(void) {
+    async_send<request::request_trace_start>();
+  }
+
+  void async_request_trace_stop(void) {
+    async_send<request::request_trace_stop>();
   }
 
 private:
   void create_client(void) {
+    flow_control_connected_ = false;
+
     client_ = std::make_unique<local_datagram::client>(weak_dispatcher_,
-                                                       constants::server_socket_file_path.data(),
+                                                       server_socket_file_path_,
                                                        client_socket_file_path_,
                                                        constants::local_datagram_buffer_size);
+    // `server_check` is used only with servers which do not provide the connection monitor.
+    client_->set_connection_monitor_enabled(true);
     client_->set_server_check_interval(std::chrono::milliseconds(3000));
     client_->set_reconnect_interval(std::chrono::milliseconds(1000));
+    client_->set_send_queue_capacity(constants::local_datagram_send_queue_capacity);
+    client_->set_send_queue_hard_capacity(constants::local_datagram_send_queue_hard_capacity);
 
     client_->connected.connect([this] {
       enqueue_to_dispatcher([this] {
+        if (flow_control_enabled_) {
+          restart_flow_control();
+        }
+
         connected();
       });
     });
@@ -143,9 +349,12 @@ private:
 
     client_->closed.connect([this] {
       enqueue_to_dispatcher([this] {
+        flow_control_connected_ = false;
+
         closed();
         virtual_hid_keyboard_ready_response(false);
         virtual_hid_pointing_ready_response(false);
+        virtual_hid_absolute_pointing_ready_response(false);
       });
     });
 
@@ -155,83 +364,497 @@ private:
       });
     });
 
+    client_->send_entry_dropped.connect([this](auto&& policy) {
+      ++send_queue_dropped_count_;
+      if (!policy.droppable()) {
+        ++send_queue_hard_capacity_dropped_count_;
+      }
+
+      auto r = request(policy.get_key());
+      if (r == request::none) {
+        // The entry is not a report (e.g., a query).
+        return;
+      }
+
+      enqueue_to_dispatcher([this, r] {
+        request_dropped(r);
+      });
+    });
+
     client_->received.connect([this](auto&& buffer, auto&& sender_endpoint) {
       if (buffer) {
         if (buffer->empty()) {
           return;
         }
 
-        auto p = &((*buffer)[0]);
-        auto size = buffer->size();
-
-        auto r = response(*p);
-        ++p;
-        --size;
-
-        switch (r) {
-          case response::none:
-            break;
-
-          case response::driver_loaded_result:
-            if (size == 1) {
-              driver_loaded_response(*p);
-            }
-            break;
-
-          case response::driver_version_matched_result:
-            if (size == 1) {
-              driver_version_matched_response(*p);
-            }
-            break;
-
-          case response::virtual_hid_keyboard_ready_result:
-            if (size == 1) {
-              virtual_hid_keyboard_ready_response(*p);
-            }
-            break;
-
-          case response::virtual_hid_pointing_ready_result:
-            if (size == 1) {
-              virtual_hid_pointing_ready_response(*p);
-            }
-            break;
+        handle_response(&((*buffer)[0]), buffer->size(), std::nullopt);
+      }
+    });
+  }
+
+  // This method is executed in the dispatcher thread.
+  void handle_response(const uint8_t* p,
+                       size_t size,
+                       std::optional<uint64_t> correlation_id) {
+    auto r = response(*p);
+    ++p;
+    --size;
+
+    std::optional<bool> result;
+
+    switch (r) {
+      case response::none:
+        break;
+
+      case response::driver_loaded_result:
+        if (size == 1) {
+          result = *p;
+          driver_loaded_response(*p);
+        }
+        break;
+
+      case response::driver_version_matched_result:
+        if (size == 1) {
+          result = *p;
+          driver_version_matched_response(*p);
+        }
+        break;
+
+      case response::virtual_hid_keyboard_ready_result:
+        if (size == 1) {
+          result = *p;
+          virtual_hid_keyboard_ready_response(*p);
+        }
+        break;
+
+      case response::virtual_hid_pointing_ready_result:
+        if (size == 1) {
+          result = *p;
+          virtual_hid_pointing_ready_response(*p);
+        }
+        break;
+
+      case response::virtual_hid_absolute_pointing_ready_result:
+        if (size == 1) {
+          result = *p;
+          virtual_hid_absolute_pointing_ready_response(*p);
+        }
+        break;
+
+      case response::report_ack:
+        if (size == sizeof(report_ack_payload)) {
+          report_ack_payload ack;
+          memcpy(&ack, p, sizeof(ack));
+          handle_report_ack(ack);
+        }
+        break;
+
+      case response::post_text_result:
+        if (size >= sizeof(post_text_result_payload) &&
+            (size - sizeof(post_text_result_payload)) % sizeof(post_text_unmapped_character) == 0) {
+          post_text_result_payload payload;
+          memcpy(&payload, p, sizeof(payload));
+
+          std::vector<post_text_unmapped_character> unmapped_characters((size - sizeof(payload)) / sizeof(post_text_unmapped_character));
+          if (!unmapped_characters.empty()) {
+            memcpy(unmapped_characters.data(), p + sizeof(payload), unmapped_characters.size() * sizeof(post_text_unmapped_character));
+          }
+
+          post_text_response(payload.mapped_characters, unmapped_characters);
         }
+        break;
+
+      case response::correlated_result:
+        // Nested correlated results are ignored.
+        if (size > sizeof(uint64_t) && !correlation_id) {
+          uint64_t id;
+          memcpy(&id, p, sizeof(id));
+          handle_response(p + sizeof(id), size - sizeof(id), id);
+        }
+        break;
+    }
+
+    if (correlation_id && result) {
+      enqueue_to_dispatcher([this, correlation_id, r, result] {
+        complete_query(*correlation_id, r, result);
+      });
+    }
+  }
+
+  // This method is executed in the dispatcher thread.
+  void complete_query(uint64_t correlation_id,
+                      std::optional<response> r,
+                      std::optional<bool> result) {
+    auto it = pending_queries_.find(correlation_id);
+    if (it == std::end(pending_queries_)) {
+      // Already timed out.
+      return;
+    }
+
+    // `r == std::nullopt` means timeout.
+    if (r && *r != it->second.expected_response) {
+      return;
+    }
+
+    it->second.promise->set_value(result);
+    pending_queries_.erase(it);
+  }
+
+  template <request R>
+  std::future<std::optional<bool>> query(response expected_response,
+                                         std::chrono::milliseconds timeout) {
+    auto promise = std::make_shared<query_promise>();
+    auto future = promise->get_future();
+
+    enqueue_to_dispatcher([this, expected_response, timeout, promise] {
+      if (!client_) {
+        promise->set_value(std::nullopt);
+        return;
       }
+
+      auto correlation_id = ++last_correlation_id_;
+      pending_queries_.emplace(correlation_id, pending_query{expected_response, promise});
+
+      client_->async_send(request_schema::encode_correlated<R>(correlation_id));
+
+      enqueue_to_dispatcher(
+          [this, correlation_id] {
+            complete_query(correlation_id, std::nullopt, std::nullopt);
+          },
+          when_now() + timeout);
     });
+
+    return future;
   }
 
-  void async_send(request r) {
-    enqueue_to_dispatcher([this, r] {
+  template <request R>
+  void async_send(void) {
+    enqueue_to_dispatcher([this] {
       if (client_) {
-        uint8_t buffer[] = {
-            static_cast<std::underlying_type<request>::type>(r),
-        };
-        client_->async_send(buffer, sizeof(buffer));
+        client_->async_send(request_schema::encode<R>());
       }
     });
   }
 
-  template <typename T>
-  void async_send(request r, const T& data) {
-    enqueue_to_dispatcher([this, r, data] {
+  template <request R>
+  void async_send(const request_schema::payload_t<R>& payload) {
+    enqueue_to_dispatcher([this, payload] {
       if (client_) {
-        std::vector<uint8_t> buffer;
-        append_data(buffer, r);
-        append_data(buffer, data);
-        client_->async_send(buffer);
+        client_->async_send(request_schema::encode<R>(payload));
+      }
+    });
+  }
+
+  template <request R>
+  void async_send_report(const request_schema::payload_t<R>& report) {
+    enqueue_to_dispatcher([this, report] {
+      if (flow_control_enabled_) {
+        send_sequenced<R>(report);
+        return;
+      }
+
+      // Reports which release keys are never dropped.
+      // Reports which only press more keys replace the queued one while the server is stalled.
+      auto& last_key_state = std::get<request_schema::payload_t<R>>(last_key_states_);
+      auto policy = local_datagram::send_policy::never_drop(static_cast<uint32_t>(R));
+      if (includes_key_state(report, last_key_state)) {
+        policy = local_datagram::send_policy::coalesce_never_drop(static_cast<uint32_t>(R),
+                                                                  merge_key_state<R>);
+      }
+      last_key_state = report;
+
+      send<R>(report, policy);
+    });
+  }
+
+  // This method is executed in the dispatcher thread.
+  template <request R>
+  void send_sequenced(const request_schema::payload_t<R>& report) {
+    {
+      std::lock_guard<std::mutex> lock(flow_control_window_mutex_);
+
+      auto sequence = flow_control_window_.make_sequence();
+      flow_control_pending_.push_back(request_schema::encode_sequenced<R>(sequence, report));
+    }
+
+    flush_flow_control_pending();
+  }
+
+  // This method is executed in the dispatcher thread.
+  void send_sequenced_message(const std::vector<uint8_t>& message) {
+    {
+      std::lock_guard<std::mutex> lock(flow_control_window_mutex_);
+
+      auto sequence = flow_control_window_.make_sequence();
+      flow_control_pending_.push_back(request_schema::encode_sequenced_message(sequence, message));
+    }
+
+    flush_flow_control_pending();
+  }
+
+  // This method is executed in the dispatcher thread.
+  void flush_flow_control_pending(void) {
+    if (!client_ || !flow_control_connected_) {
+      return;
+    }
+
+    std::lock_guard<std::mutex> lock(flow_control_window_mutex_);
+
+    while (!flow_control_pending_.empty() &&
+           flow_control_window_.acquire()) {
+      client_->async_send(flow_control_pending_.front());
+      flow_control_pending_.pop_front();
+    }
+  }
+
+  // This method is executed in the dispatcher thread.
+  void handle_report_ack(const report_ack_payload& ack) {
+    bool advanced = false;
+
+    {
+      std::lock_guard<std::mutex> lock(flow_control_window_mutex_);
+
+      advanced = flow_control_window_.ack(ack.sequence, ack.credits);
+    }
+
+    flush_flow_control_pending();
+
+    if (advanced) {
+      reports_completed(ack.sequence);
+    }
+  }
+
+  // This method is executed in the dispatcher thread.
+  void restart_flow_control(void) {
+    bool advanced = false;
+    uint64_t completed_sequence = 0;
+
+    {
+      std::lock_guard<std::mutex> lock(flow_control_window_mutex_);
+
+      advanced = flow_control_window_.restart(constants::flow_control_initial_credits);
+      completed_sequence = flow_control_window_.get_completed_sequence();
+    }
+
+    flow_control_connected_ = true;
+    flush_flow_control_pending();
+
+    if (advanced) {
+      reports_completed(completed_sequence);
+    }
+  }
+
+  // This method is executed in the dispatcher thread.
+  template <request R>
+  void send(const request_schema::payload_t<R>& payload, const local_datagram::send_policy& policy) {
+    if (client_) {
+      client_->async_send(request_schema::encode<R>(payload), policy);
+    }
+  }
+
+  template <request R>
+  void async_send_pointing_report(const request_schema::payload_t<R>& report) {
+    enqueue_to_dispatcher([this, report] {
+      if (flow_control_enabled_) {
+        send_sequenced<R>(report);
+        return;
       }
+
+      // Reports which change buttons are never dropped.
+      // Motion-only reports are coalesced while the server is stalled.
+      auto policy = local_datagram::send_policy::never_drop(static_cast<uint32_t>(R));
+      if (last_pointing_input_buttons_ == report.buttons) {
+        policy = local_datagram::send_policy::coalesce(static_cast<uint32_t>(R),
+                                                       merge_pointing_input<R>);
+      }
+      last_pointing_input_buttons_ = report.buttons;
+
+      send<R>(report, policy);
     });
   }
 
+  // Merge the relative motion of pointing reports which have the same buttons.
+  // This method is executed in the local_datagram thread.
+  template <request R>
+  static bool merge_pointing_input(uint8_t* queued_data,
+                                   size_t queued_length,
+                                   const uint8_t* new_data,
+                                   size_t new_length) {
+    using pointing_input = request_schema::payload_t<R>;
+
+    // The data starts with `request`.
+    constexpr auto message_size = request_schema::message_size<R>;
+    if (queued_length != message_size ||
+        new_length != message_size) {
+      return false;
+    }
+
+    pointing_input queued;
+    pointing_input report;
+    memcpy(&queued, queued_data + 1, sizeof(queued));
+    memcpy(&report, new_data + 1, sizeof(report));
+
+    if (!(queued.buttons == report.buttons)) {
+      return false;
+    }
+
+    // Wheel values of `pointing_input` are int8_t stored in uint8_t.
+    auto add = [](auto value, auto delta) {
+      using T = decltype(value);
+      using signed_t = std::make_signed_t<T>;
+      constexpr int32_t limit = std::is_same_v<signed_t, int8_t> ? 127 : 32767;
+
+      auto sum = static_cast<int32_t>(static_cast<signed_t>(value)) + static_cast<signed_t>(delta);
+      if (sum < -limit || limit < sum) {
+        return std::optional<T>();
+      }
+      return std::optional<T>(static_cast<T>(sum));
+    };
+
+    auto x = add(queued.x, report.x);
+    auto y = add(queued.y, report.y);
+    auto vertical_wheel = add(queued.vertical_wheel, report.vertical_wheel);
+    auto horizontal_wheel = add(queued.horizontal_wheel, report.horizontal_wheel);
+    if (!x || !y || !vertical_wheel || !horizontal_wheel) {
+      return false;
+    }
+
+    queued.x = *x;
+    queued.y = *y;
+    queued.vertical_wheel = *vertical_wheel;
+    queued.horizontal_wheel = *horizontal_wheel;
+
+    memcpy(queued_data + 1, &queued, sizeof(queued));
+    return true;
+  }
+
+  // Returns true if all keys (and modifiers) in `other` are pressed in `key_state`.
   template <typename T>
-  void append_data(std::vector<uint8_t>& buffer, const T& data) const {
-    auto size = buffer.size();
-    buffer.resize(size + sizeof(data));
-    *(reinterpret_cast<T*>(&(buffer[size]))) = data;
+  static bool includes_key_state(const T& key_state, const T& other) {
+    if constexpr (std::is_same_v<T, virtual_hid_device_driver::hid_report::keyboard_input> ||
+                  std::is_same_v<T, virtual_hid_device_driver::hid_report::keyboard_bitmap_input>) {
+      if (!key_state.modifiers.includes(other.modifiers)) {
+        return false;
+      }
+    }
+
+    return key_state.keys.includes(other.keys);
+  }
+
+  // Replace the queued key state with the new one if the new one does not release any keys.
+  // This method is executed in the local_datagram thread.
+  template <request R>
+  static bool merge_key_state(uint8_t* queued_data,
+                              size_t queued_length,
+                              const uint8_t* new_data,
+                              size_t new_length) {
+    using key_state = request_schema::payload_t<R>;
+
+    // The data starts with `request`.
+    constexpr auto message_size = request_schema::message_size<R>;
+    if (queued_length != message_size ||
+        new_length != message_size) {
+      return false;
+    }
+
+    key_state queued;
+    key_state report;
+    memcpy(&queued, queued_data + 1, sizeof(queued));
+    memcpy(&report, new_data + 1, sizeof(report));
+
+    if (!includes_key_state(report, queued)) {
+      return false;
+    }
+
+    memcpy(queued_data + 1, &report, sizeof(report));
+    return true;
+  }
+
+  // This method is executed in the local_datagram thread.
+  static bool merge_absolute_pointing_input(uint8_t* queued_data,
+                                            size_t queued_length,
+                                            const uint8_t* new_data,
+                                            size_t new_length) {
+    using absolute_pointing_input = virtual_hid_device_driver::hid_report::absolute_pointing_input;
+
+    // The data starts with `request`.
+    constexpr auto message_size = request_schema::message_size<request::post_absolute_pointing_input_report>;
+    if (queued_length != message_size ||
+        new_length != message_size) {
+      return false;
+    }
+
+    absolute_pointing_input queued;
+    absolute_pointing_input report;
+    memcpy(&queued, queued_data + 1, sizeof(queued));
+    memcpy(&report, new_data + 1, sizeof(report));
+
+    if (!(queued.buttons == report.buttons)) {
+      return false;
+    }
+
+    memcpy(queued_data + 1, &report, sizeof(report));
+    return true;
   }
 
   std::string client_socket_file_path_;
+  std::string server_socket_file_path_;
   std::unique_ptr<local_datagram::client> client_;
+  virtual_hid_device_driver::hid_report::buttons last_pointing_input_buttons_;
+  virtual_hid_device_driver::hid_report::buttons last_absolute_pointing_input_buttons_;
+  std::tuple<virtual_hid_device_driver::hid_report::keyboard_input,
+             virtual_hid_device_driver::hid_report::keyboard_bitmap_input,
+             virtual_hid_device_driver::hid_report::consumer_input,
+             virtual_hid_device_driver::hid_report::apple_vendor_keyboard_input,
+             virtual_hid_device_driver::hid_report::apple_vendor_top_case_input>
+      last_key_states_;
+
+  // The value is set to std::nullopt if the promise is destroyed without a value.
+  // (e.g., the client is destroyed before the query is sent.)
+  class query_promise final {
+  public:
+    query_promise(void) : satisfied_(false) {
+    }
+
+    ~query_promise(void) {
+      set_value(std::nullopt);
+    }
+
+    std::future<std::optional<bool>> get_future(void) {
+      return promise_.get_future();
+    }
+
+    void set_value(std::optional<bool> value) {
+      if (!satisfied_) {
+        satisfied_ = true;
+        promise_.set_value(value);
+      }
+    }
+
+  private:
+    std::promise<std::optional<bool>> promise_;
+    bool satisfied_;
+  };
+
+  struct pending_query final {
+    response expected_response;
+    std::shared_ptr<query_promise> promise;
+  };
+
+  bool flow_control_enabled_;
+  // Updated in the dispatcher thread.
+  bool flow_control_connected_;
+  mutable std::mutex flow_control_window_mutex_;
+  flow_control::window flow_control_window_;
+  // Encoded sequenced requests which are waiting for credits.
+  std::deque<std::vector<uint8_t>> flow_control_pending_;
+
+  std::atomic<size_t> send_queue_dropped_count_;
+  std::atomic<size_t> send_queue_hard_capacity_dropped_count_;
+
+  // Updated in the dispatcher thread.
+  uint64_t last_correlation_id_;
+  std::unordered_map<uint64_t, pending_query> pending_queries_;
 };
 } // namespace virtual_hid_device_service
 } // namespace driverkit
@@ -4,6 +4,7 @@
 // Distributed under the Boost Software License, Version 1.0.
 // (See https://www.boost.org/LICENSE_1_0.txt)
 
+#include <cstdint>
 #include <string_view>
 
 namespace pqrs {
@@ -13,7 +14,18 @@ namespace virtual_hid_device_service {
 namespace constants {
 constexpr std::string_view rootonly_directory = "/Library/Application Support/org.pqrs/tmp/rootonly";
 constexpr std::string_view server_socket_file_path = "/Library/Application Support/org.pqrs/tmp/rootonly/virtual_hid_device_service_server.v2.sock";
+constexpr std::string_view request_trace_file_path = "/Library/Application Support/org.pqrs/tmp/rootonly/virtual_hid_device_service_request_trace.bin";
+constexpr std::string_view session_state_file_path = "/Library/Application Support/org.pqrs/tmp/rootonly/virtual_hid_device_service_session_state.bin";
+// The metrics page is placed outside `rootonly_directory` so that non-root tools can read it.
+constexpr std::string_view metrics_file_path = "/Library/Application Support/org.pqrs/tmp/virtual_hid_device_service_metrics.bin";
 constexpr std::size_t local_datagram_buffer_size = 1024;
+// Droppable entries (e.g., pointing motion) are dropped when the client send queue is full.
+constexpr std::size_t local_datagram_send_queue_capacity = 256;
+// All entries including keyboard reports are dropped from the oldest when the client send queue reaches the hard capacity.
+constexpr std::size_t local_datagram_send_queue_hard_capacity = 1024;
+// Credits of sequenced requests which a client can use before the first `response::report_ack`.
+constexpr uint32_t flow_control_initial_credits = 32;
+constexpr uint32_t flow_control_max_credits = 256;
 } // namespace constants
 } // namespace virtual_hid_device_service
 } // namespace driverkit
@@ -0,0 +1,214 @@
+#pragma once
+
+// (C) Copyright Takayama Fumihiko 2020.
+// Distributed under the Boost Software License, Version 1.0.
+// (See https://www.boost.org/LICENSE_1_0.txt)
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace pqrs {
+namespace karabiner {
+namespace driverkit {
+namespace virtual_hid_device_service {
+namespace device_lifecycle {
+
+//
+// The lifecycle of a virtual device in the server.
+//
+// A virtual device is created by `virtual_hid_*_initialize` and terminated by `virtual_hid_*_terminate`.
+// With `options::lazy_creation`, the first report creates the virtual device.
+// Reports which are received until the virtual device becomes ready are held in order, and they are posted when it becomes ready.
+// With `options::idle_timeout`, the virtual device is terminated when it receives no report for the timeout while no client is active.
+// A client is active while it is connected to the connection monitor or it sent a request within the timeout (`client_activity`).
+//
+
+struct options final {
+  bool lazy_creation = false;
+  // 0 disables the idle teardown.
+  std::chrono::milliseconds idle_timeout = std::chrono::milliseconds(0);
+  // Reports which are held while the virtual device is being created.
+  // Reports are dropped when it is full.
+  size_t max_pending_reports = 256;
+};
+
+enum class report_action {
+  // The virtual device is not initialized. (`lazy_creation` is disabled.)
+  drop,
+  // Create the virtual device and call `push_pending_report`.
+  create,
+  // The virtual device is being created. Call `push_pending_report`.
+  hold,
+  // Post the report.
+  post,
+};
+
+template <typename T>
+class device final {
+public:
+  using time_point = std::chrono::steady_clock::time_point;
+
+  explicit device(const options& options) : options_(options),
+                                            initialized_(false),
+                                            creating_(false) {
+  }
+
+  bool get_initialized(void) const {
+    return initialized_;
+  }
+
+  // The virtual device is created by a report and it is not ready yet.
+  bool get_creating(void) const {
+    return creating_;
+  }
+
+  size_t get_pending_report_count(void) const {
+    return pending_reports_.size();
+  }
+
+  // `virtual_hid_*_initialize`
+  void initialize(time_point now) {
+    initialized_ = true;
+    last_activity_ = now;
+  }
+
+  // Calls `function(T&&)` for each held report so that the caller can discard it.
+  template <typename Function>
+  void terminate(Function&& function) {
+    initialized_ = false;
+    creating_ = false;
+
+    auto reports = std::move(pending_reports_);
+    pending_reports_.clear();
+    for (auto&& r : reports) {
+      function(std::move(r));
+    }
+  }
+
+  void touch(time_point now) {
+    last_activity_ = now;
+  }
+
+  report_action receive_report(time_point now) {
+    if (!initialized_) {
+      if (!options_.lazy_creation) {
+        return report_action::drop;
+      }
+
+      initialized_ = true;
+      creating_ = true;
+      last_activity_ = now;
+      return report_action::create;
+    }
+
+    last_activity_ = now;
+
+    return creating_ ? report_action::hold : report_action::post;
+  }
+
+  // Returns false if the report is dropped.
+  bool push_pending_report(T&& report) {
+    if (pending_reports_.size() >= options_.max_pending_reports) {
+      return false;
+    }
+
+    pending_reports_.push_back(std::move(report));
+    return true;
+  }
+
+  // Calls `function(T&&)` for each held report in order.
+  template <typename Function>
+  void ready(Function&& function) {
+    if (!creating_) {
+      return;
+    }
+
+    creating_ = false;
+
+    // `function` may not call `push_pending_report` because `creating_` is already false.
+    auto reports = std::move(pending_reports_);
+    pending_reports_.clear();
+    for (auto&& r : reports) {
+      function(std::move(r));
+    }
+  }
+
+  bool idle(time_point now,
+            uint64_t active_clients) const {
+    return initialized_ &&
+           options_.idle_timeout > std::chrono::milliseconds(0) &&
+           active_clients == 0 &&
+           now - last_activity_ >= options_.idle_timeout;
+  }
+
+private:
+  options options_;
+  bool initialized_;
+  bool creating_;
+  time_point last_activity_;
+  std::deque<T> pending_reports_;
+};
+
+// Tracks clients which sent a request recently.
+// Clients which are not connected to the connection monitor (e.g., `direct_client` and older clients) are counted by their requests.
+//
+// The time of a client is updated at most once per half of the timeout,
+// so a client is counted for at least a half of the timeout after its last request.
+class client_activity final {
+public:
+  using time_point = std::chrono::steady_clock::time_point;
+
+  // 0 disables the tracking.
+  explicit client_activity(std::chrono::milliseconds timeout) : timeout_(timeout) {
+  }
+
+  bool enabled(void) const {
+    return timeout_ > std::chrono::milliseconds(0);
+  }
+
+  // `sender` is the endpoint path of the client. (It is empty if the client socket is not bound.)
+  void touch(std::string_view sender,
+             time_point now) {
+    if (!enabled()) {
+      return;
+    }
+
+    auto it = last_requests_.find(sender);
+    if (it == std::end(last_requests_)) {
+      last_requests_.emplace(sender, now);
+    } else if (now - it->second >= timeout_ / 2) {
+      it->second = now;
+    }
+  }
+
+  // Forgets clients which sent no request for the timeout, and returns the number of the rest.
+  size_t count(time_point now) {
+    for (auto it = std::begin(last_requests_); it != std::end(last_requests_);) {
+      if (now - it->second >= timeout_) {
+        it = last_requests_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+
+    return last_requests_.size();
+  }
+
+private:
+  std::chrono::milliseconds timeout_;
+  // `std::less<>` finds `sender` without a copy.
+  std::map<std::string, time_point, std::less<>> last_requests_;
+};
+
+} // namespace device_lifecycle
+} // namespace virtual_hid_device_service
+} // namespace driverkit
+} // namespace karabiner
+} // namespace pqrs
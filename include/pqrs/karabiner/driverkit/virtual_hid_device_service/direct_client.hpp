@@ -0,0 +1,379 @@
+#pragma once
+
+// (C) Copyright Takayama Fumihiko 2020.
+// Distributed under the Boost Software License, Version 1.0.
+// (See https://www.boost.org/LICENSE_1_0.txt)
+
+#include "constants.hpp"
+#include "request.hpp"
+#include "request_schema.hpp"
+#include "response.hpp"
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <optional>
+#include <poll.h>
+#include <pqrs/hid.hpp>
+#include <string>
+#include <string_view>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <system_error>
+#include <unistd.h>
+
+namespace pqrs {
+namespace karabiner {
+namespace driverkit {
+namespace virtual_hid_device_service {
+
+// A minimal client which sends requests with a non-blocking `send` in the calling thread.
+// It has no background threads and does not use `pqrs::dispatcher` or asio.
+// The wire format is the same as `client`.
+// (Datagrams of `pqrs::local_datagram` start with the entry type byte (`user_data`) in both directions.)
+//
+// Requests are not queued.
+// Methods return an error (e.g., `std::errc::no_buffer_space`, `std::errc::operation_would_block`) when the server socket buffer is full,
+// and the caller decides whether to retry or drop the request.
+//
+// `direct_client` is not thread-safe.
+class direct_client final {
+public:
+  // `client_socket_file_path` is required for queries. (The server sends responses to the path.)
+  // Requests other than queries can be sent with an empty path.
+  direct_client(const std::string& client_socket_file_path,
+                const std::string& server_socket_file_path = std::string(constants::server_socket_file_path)) : client_socket_file_path_(client_socket_file_path),
+                                                                                                                server_socket_file_path_(server_socket_file_path),
+                                                                                                                fd_(-1),
+                                                                                                                bound_(false),
+                                                                                                                last_correlation_id_(0) {
+  }
+
+  direct_client(const direct_client&) = delete;
+
+  ~direct_client(void) {
+    close();
+  }
+
+  bool is_open(void) const {
+    return fd_ >= 0;
+  }
+
+  // `open` is called automatically by the first request.
+  std::error_code open(void) {
+    close();
+
+    fd_ = socket(AF_UNIX, SOCK_DGRAM, 0);
+    if (fd_ < 0) {
+      return std::error_code(errno, std::generic_category());
+    }
+
+    auto flags = fcntl(fd_, F_GETFL, 0);
+    if (flags < 0 ||
+        fcntl(fd_, F_SETFL, flags | O_NONBLOCK) < 0 ||
+        fcntl(fd_, F_SETFD, FD_CLOEXEC) < 0) {
+      auto error_code = std::error_code(errno, std::generic_category());
+      close();
+      return error_code;
+    }
+
+    if (!client_socket_file_path_.empty()) {
+      sockaddr_un address;
+      if (auto error_code = make_address(client_socket_file_path_, address)) {
+        close();
+        return error_code;
+      }
+
+      unlink(client_socket_file_path_.c_str());
+
+      if (bind(fd_, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+        auto error_code = std::error_code(errno, std::generic_category());
+        close();
+        return error_code;
+      }
+
+      bound_ = true;
+    }
+
+    if (auto error_code = connect()) {
+      close();
+      return error_code;
+    }
+
+    return std::error_code();
+  }
+
+  void close(void) {
+    if (fd_ >= 0) {
+      ::close(fd_);
+      fd_ = -1;
+    }
+
+    if (bound_) {
+      unlink(client_socket_file_path_.c_str());
+      bound_ = false;
+    }
+  }
+
+  //
+  // Virtual devices
+  //
+
+  std::error_code virtual_hid_keyboard_initialize(hid::country_code::value_t country_code) {
+    return send<request::virtual_hid_keyboard_initialize>(type_safe::get(country_code));
+  }
+
+  std::error_code virtual_hid_keyboard_terminate(void) {
+    return send<request::virtual_hid_keyboard_terminate>();
+  }
+
+  std::error_code virtual_hid_keyboard_reset(void) {
+    return send<request::virtual_hid_keyboard_reset>();
+  }
+
+  std::error_code virtual_hid_pointing_initialize(void) {
+    return send<request::virtual_hid_pointing_initialize>();
+  }
+
+  std::error_code virtual_hid_pointing_terminate(void) {
+    return send<request::virtual_hid_pointing_terminate>();
+  }
+
+  std::error_code virtual_hid_pointing_reset(void) {
+    return send<request::virtual_hid_pointing_reset>();
+  }
+
+  std::error_code virtual_hid_absolute_pointing_initialize(void) {
+    return send<request::virtual_hid_absolute_pointing_initialize>();
+  }
+
+  std::error_code virtual_hid_absolute_pointing_terminate(void) {
+    return send<request::virtual_hid_absolute_pointing_terminate>();
+  }
+
+  std::error_code virtual_hid_absolute_pointing_reset(void) {
+    return send<request::virtual_hid_absolute_pointing_reset>();
+  }
+
+  //
+  // Reports
+  //
+
+  std::error_code post_report(const virtual_hid_device_driver::hid_report::keyboard_input& report) {
+    return send<request::post_keyboard_input_report>(report);
+  }
+
+  std::error_code post_report(const virtual_hid_device_driver::hid_report::keyboard_bitmap_input& report) {
+    return send<request::post_keyboard_bitmap_input_report>(report);
+  }
+
+  std::error_code post_report(const virtual_hid_device_driver::hid_report::consumer_input& report) {
+    return send<request::post_consumer_input_report>(report);
+  }
+
+  std::error_code post_report(const virtual_hid_device_driver::hid_report::apple_vendor_keyboard_input& report) {
+    return send<request::post_apple_vendor_keyboard_input_report>(report);
+  }
+
+  std::error_code post_report(const virtual_hid_device_driver::hid_report::apple_vendor_top_case_input& report) {
+    return send<request::post_apple_vendor_top_case_input_report>(report);
+  }
+
+  std::error_code post_report(const virtual_hid_device_driver::hid_report::pointing_input& report) {
+    return send<request::post_pointing_input_report>(report);
+  }
+
+  std::error_code post_report(const virtual_hid_device_driver::hid_report::pointing_high_resolution_input& report) {
+    return send<request::post_pointing_high_resolution_input_report>(report);
+  }
+
+  std::error_code post_report(const virtual_hid_device_driver::hid_report::absolute_pointing_input& report) {
+    return send<request::post_absolute_pointing_input_report>(report);
+  }
+
+  // `text` must not be longer than `request_schema::max_text_size`.
+  // The result (`response::post_text_result`) is discarded by `direct_client`.
+  std::error_code post_text(std::string_view text) {
+    if (text.size() > request_schema::max_text_size) {
+      return std::make_error_code(std::errc::message_size);
+    }
+
+    auto buffer = request_schema::encode_text<request::post_text>(text);
+    return send(buffer.data(), buffer.size());
+  }
+
+  //
+  // Queries
+  //
+  // These methods block the calling thread until the response is received or `timeout` passes.
+  // They return std::nullopt on timeout or error.
+  //
+
+  std::optional<bool> driver_loaded(std::chrono::milliseconds timeout) {
+    return query<request::driver_loaded>(response::driver_loaded_result, timeout);
+  }
+
+  std::optional<bool> driver_version_matched(std::chrono::milliseconds timeout) {
+    return query<request::driver_version_matched>(response::driver_version_matched_result, timeout);
+  }
+
+  std::optional<bool> virtual_hid_keyboard_ready(std::chrono::milliseconds timeout) {
+    return query<request::virtual_hid_keyboard_ready>(response::virtual_hid_keyboard_ready_result, timeout);
+  }
+
+  std::optional<bool> virtual_hid_pointing_ready(std::chrono::milliseconds timeout) {
+    return query<request::virtual_hid_pointing_ready>(response::virtual_hid_pointing_ready_result, timeout);
+  }
+
+  std::optional<bool> virtual_hid_absolute_pointing_ready(std::chrono::milliseconds timeout) {
+    return query<request::virtual_hid_absolute_pointing_ready>(response::virtual_hid_absolute_pointing_ready_result, timeout);
+  }
+
+private:
+  // `pqrs::local_datagram::impl::send_entry::type::user_data`
+  static constexpr uint8_t user_data_type = 1;
+
+  static std::error_code make_address(const std::string& path, sockaddr_un& address) {
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+
+    if (path.size() >= sizeof(address.sun_path)) {
+      return std::make_error_code(std::errc::filename_too_long);
+    }
+
+    memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    return std::error_code();
+  }
+
+  std::error_code connect(void) {
+    sockaddr_un address;
+    if (auto error_code = make_address(server_socket_file_path_, address)) {
+      return error_code;
+    }
+
+    if (::connect(fd_, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+      return std::error_code(errno, std::generic_category());
+    }
+
+    return std::error_code();
+  }
+
+  template <request R>
+  std::error_code send(void) {
+    auto buffer = request_schema::encode_array<R>();
+    return send(buffer.data(), buffer.size());
+  }
+
+  template <request R>
+  std::error_code send(const request_schema::payload_t<R>& payload) {
+    auto buffer = request_schema::encode_array<R>(payload);
+    return send(buffer.data(), buffer.size());
+  }
+
+  std::error_code send(const uint8_t* buffer, size_t size) {
+    if (fd_ < 0) {
+      if (auto error_code = open()) {
+        return error_code;
+      }
+    }
+
+    if (send_user_data(buffer, size)) {
+      return std::error_code();
+    }
+
+    auto e = errno;
+
+    // Reconnect once if the server is restarted. (The socket file is recreated.)
+    if (e == ECONNREFUSED ||
+        e == ENOTCONN ||
+        e == ENOENT) {
+      if (!connect() &&
+          send_user_data(buffer, size)) {
+        return std::error_code();
+      }
+      e = errno;
+    }
+
+    return std::error_code(e, std::generic_category());
+  }
+
+  bool send_user_data(const uint8_t* buffer, size_t size) {
+    auto type = user_data_type;
+
+    iovec iov[2];
+    iov[0].iov_base = &type;
+    iov[0].iov_len = sizeof(type);
+    iov[1].iov_base = const_cast<uint8_t*>(buffer);
+    iov[1].iov_len = size;
+
+    msghdr message;
+    memset(&message, 0, sizeof(message));
+    message.msg_iov = iov;
+    message.msg_iovlen = 2;
+
+    return sendmsg(fd_, &message, 0) >= 0;
+  }
+
+  template <request R>
+  std::optional<bool> query(response expected_response,
+                            std::chrono::milliseconds timeout) {
+    if (client_socket_file_path_.empty()) {
+      return std::nullopt;
+    }
+
+    auto correlation_id = ++last_correlation_id_;
+    auto buffer = request_schema::encode_correlated<R>(correlation_id);
+    if (send(buffer.data(), buffer.size())) {
+      return std::nullopt;
+    }
+
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+
+    while (true) {
+      auto now = std::chrono::steady_clock::now();
+      if (now >= deadline) {
+        return std::nullopt;
+      }
+
+      pollfd p{fd_, POLLIN, 0};
+      auto milliseconds = std::chrono::ceil<std::chrono::milliseconds>(deadline - now).count();
+      auto n = poll(&p, 1, static_cast<int>(milliseconds));
+      if (n < 0 && errno != EINTR) {
+        return std::nullopt;
+      }
+
+      // Drain received datagrams. Responses of other requests (e.g., timed out queries) are discarded.
+      while (true) {
+        uint8_t response_buffer[64];
+        auto size = recv(fd_, response_buffer, sizeof(response_buffer), MSG_DONTWAIT);
+        if (size < 0) {
+          break;
+        }
+
+        // uint8_t user_data_type, uint8_t response::correlated_result, uint64_t correlation_id, uint8_t response, uint8_t result
+        if (size == 2 + sizeof(uint64_t) + 2 &&
+            response_buffer[0] == user_data_type &&
+            response_buffer[1] == static_cast<uint8_t>(response::correlated_result) &&
+            response_buffer[2 + sizeof(uint64_t)] == static_cast<uint8_t>(expected_response)) {
+          uint64_t id;
+          memcpy(&id, response_buffer + 2, sizeof(id));
+          if (id == correlation_id) {
+            return response_buffer[2 + sizeof(uint64_t) + 1] != 0;
+          }
+        }
+      }
+    }
+  }
+
+  std::string client_socket_file_path_;
+  std::string server_socket_file_path_;
+  int fd_;
+  bool bound_;
+  uint64_t last_correlation_id_;
+};
+
+} // namespace virtual_hid_device_service
+} // namespace driverkit
+} // namespace karabiner
+} // namespace pqrs
@@ -0,0 +1,174 @@
+#pragma once
+
+// (C) Copyright Takayama Fumihiko 2020.
+// Distributed under the Boost Software License, Version 1.0.
+// (See https://www.boost.org/LICENSE_1_0.txt)
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <set>
+
+namespace pqrs {
+namespace karabiner {
+namespace driverkit {
+namespace virtual_hid_device_service {
+namespace flow_control {
+
+//
+// Flow control of sequenced requests (`request::sequenced_request`)
+//
+// The client numbers reports 1, 2, 3, ... and sends a report only if its sequence <= the credit limit.
+// The server returns `response::report_ack` with the cumulative completed sequence after the backend call,
+// and grants credits which reflect its report queue depth.
+//
+
+// Tracks the cumulative completed sequence of a client in the server.
+// Reports of different virtual devices are completed out of order in their forwarding threads.
+// Sequences which are never received (e.g., lost datagrams, reports sent before reconnection) are treated as completed.
+class completion_tracker final {
+public:
+  completion_tracker(void) : received_sequence_(0) {
+  }
+
+  uint64_t get_received_sequence(void) const {
+    return received_sequence_;
+  }
+
+  uint64_t get_completed_sequence(void) const {
+    if (pending_.empty()) {
+      return received_sequence_;
+    }
+    return *std::begin(pending_) - 1;
+  }
+
+  size_t get_pending_count(void) const {
+    return pending_.size();
+  }
+
+  // Sequences have to be received in ascending order.
+  // Returns false if the sequence is already received.
+  bool receive(uint64_t sequence) {
+    if (sequence <= received_sequence_) {
+      return false;
+    }
+
+    received_sequence_ = sequence;
+    pending_.insert(sequence);
+    return true;
+  }
+
+  // Returns true if the completed sequence is advanced.
+  bool complete(uint64_t sequence) {
+    auto completed_sequence = get_completed_sequence();
+    pending_.erase(sequence);
+    return get_completed_sequence() != completed_sequence;
+  }
+
+private:
+  uint64_t received_sequence_;
+  std::set<uint64_t> pending_;
+};
+
+// The free space of the report queue is shared by the clients.
+// At least one credit is granted so that a client can always make progress.
+inline uint32_t make_credits(size_t queue_capacity,
+                             size_t queue_size,
+                             size_t client_count,
+                             uint32_t max_credits) {
+  auto free = queue_capacity > queue_size ? queue_capacity - queue_size : 0;
+  auto credits = free / std::max(client_count, static_cast<size_t>(1));
+  return static_cast<uint32_t>(std::clamp(credits,
+                                          static_cast<size_t>(1),
+                                          static_cast<size_t>(std::max(max_credits, static_cast<uint32_t>(1)))));
+}
+
+// The send window of a client.
+class window final {
+public:
+  window(uint32_t initial_credits) : last_sequence_(0),
+                                     sent_sequence_(0),
+                                     completed_sequence_(0),
+                                     credit_limit_(initial_credits) {
+  }
+
+  // The sequence of the last posted report.
+  uint64_t get_last_sequence(void) const {
+    return last_sequence_;
+  }
+
+  // The sequence of the last report which is passed to the socket.
+  uint64_t get_sent_sequence(void) const {
+    return sent_sequence_;
+  }
+
+  uint64_t get_completed_sequence(void) const {
+    return completed_sequence_;
+  }
+
+  uint64_t get_credit_limit(void) const {
+    return credit_limit_;
+  }
+
+  // The number of reports which are sent and not completed.
+  uint64_t get_in_flight(void) const {
+    return sent_sequence_ - completed_sequence_;
+  }
+
+  uint64_t make_sequence(void) {
+    return ++last_sequence_;
+  }
+
+  // Returns true if the next report (`sent_sequence + 1`) can be sent.
+  // The caller has to send it when true is returned.
+  bool acquire(void) {
+    if (sent_sequence_ < last_sequence_ &&
+        sent_sequence_ < credit_limit_) {
+      ++sent_sequence_;
+      return true;
+    }
+    return false;
+  }
+
+  // Returns true if the completed sequence is advanced.
+  bool ack(uint64_t sequence, uint32_t credits) {
+    // Ignore acks of reports which are not sent (e.g., acks for the previous connection).
+    if (sequence > sent_sequence_) {
+      return false;
+    }
+
+    credit_limit_ = sequence + credits;
+
+    if (sequence <= completed_sequence_) {
+      return false;
+    }
+
+    completed_sequence_ = sequence;
+    return true;
+  }
+
+  // Reports in flight are treated as completed because they may be lost when the connection is closed.
+  // Returns true if the completed sequence is advanced.
+  bool restart(uint32_t initial_credits) {
+    credit_limit_ = sent_sequence_ + initial_credits;
+
+    if (completed_sequence_ == sent_sequence_) {
+      return false;
+    }
+
+    completed_sequence_ = sent_sequence_;
+    return true;
+  }
+
+private:
+  uint64_t last_sequence_;
+  uint64_t sent_sequence_;
+  uint64_t completed_sequence_;
+  uint64_t credit_limit_;
+};
+
+} // namespace flow_control
+} // namespace virtual_hid_device_service
+} // namespace driverkit
+} // namespace karabiner
+} // namespace pqrs
@@ -0,0 +1,109 @@
+#pragma once
+
+// (C) Copyright Takayama Fumihiko 2020.
+// Distributed under the Boost Software License, Version 1.0.
+// (See https://www.boost.org/LICENSE_1_0.txt)
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace pqrs {
+namespace karabiner {
+namespace driverkit {
+namespace virtual_hid_device_service {
+
+//
+// A bounded lock-free single-producer single-consumer queue which hands reports to a forwarding thread.
+//
+// The producer calls `push` and schedules `drain` on the forwarding thread only when `push` returns `push_result::pushed_and_wake`.
+// Thus, the producer enqueues at most one drain task while the consumer is busy.
+//
+
+enum class push_result {
+  pushed,
+  pushed_and_wake,
+  full,
+};
+
+template <typename T, size_t Capacity>
+class forwarding_queue final {
+public:
+  static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+  forwarding_queue(void) : head_(0),
+                           tail_(0),
+                           drain_scheduled_(false) {
+  }
+
+  forwarding_queue(const forwarding_queue&) = delete;
+
+  static constexpr size_t capacity(void) {
+    return Capacity;
+  }
+
+  // This method is executed in the producer thread.
+  push_result push(const T& value) {
+    auto tail = tail_.load(std::memory_order_relaxed);
+    if (tail - head_.load(std::memory_order_acquire) == Capacity) {
+      return push_result::full;
+    }
+
+    buffer_[tail & (Capacity - 1)] = value;
+    tail_.store(tail + 1, std::memory_order_release);
+
+    // Pairs with the fence in `drain`.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    if (drain_scheduled_.exchange(true)) {
+      return push_result::pushed;
+    }
+    return push_result::pushed_and_wake;
+  }
+
+  // This method is executed in the consumer thread.
+  // Calls `function(const T&)` for each queued value and returns the number of values.
+  template <typename Function>
+  size_t drain(Function&& function) {
+    // Clear the flag before popping so that a value pushed after the last `pop` wakes the consumer again.
+    drain_scheduled_.store(false);
+
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    size_t count = 0;
+    T value;
+    while (pop(value)) {
+      function(value);
+      ++count;
+    }
+    return count;
+  }
+
+  // The value is approximate if it is called while the other thread is running.
+  size_t size(void) const {
+    return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+  }
+
+private:
+  bool pop(T& value) {
+    auto head = head_.load(std::memory_order_relaxed);
+    if (head == tail_.load(std::memory_order_acquire)) {
+      return false;
+    }
+
+    value = buffer_[head & (Capacity - 1)];
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Separate cache lines for the producer and the consumer.
+  alignas(64) std::atomic<size_t> head_;
+  alignas(64) std::atomic<size_t> tail_;
+  alignas(64) std::atomic<bool> drain_scheduled_;
+  std::array<T, Capacity> buffer_;
+};
+
+} // namespace virtual_hid_device_service
+} // namespace driverkit
+} // namespace karabiner
+} // namespace pqrs
@@ -0,0 +1,395 @@
+#pragma once
+
+// (C) Copyright Takayama Fumihiko 2020.
+// Distributed under the Boost Software License, Version 1.0.
+// (See https://www.boost.org/LICENSE_1_0.txt)
+
+// Generated by scripts/make-hid-name-entries.py. Do not edit.
+
+#include "../virtual_hid_device_driver/hid_report/modifier.hpp"
+#include <array>
+#include <pqrs/hid.hpp>
+#include <string_view>
+
+namespace pqrs {
+namespace karabiner {
+namespace driverkit {
+namespace virtual_hid_device_service {
+namespace hid_names {
+
+struct usage_page_name_entry final {
+  hid::usage_page::value_t usage_page;
+  std::string_view name;
+  // false if the entry is an alias of the previous entry.
+  bool canonical;
+};
+
+struct usage_name_entry final {
+  hid::usage_page::value_t usage_page;
+  hid::usage::value_t usage;
+  std::string_view name;
+  // false if the entry is an alias of the previous entry.
+  bool canonical;
+};
+
+struct modifier_name_entry final {
+  virtual_hid_device_driver::hid_report::modifier modifier;
+  std::string_view name;
+};
+
+constexpr std::array<usage_page_name_entry, 37> usage_page_name_entries = {{
+    {hid::usage_page::undefined, "undefined", true},
+    {hid::usage_page::generic_desktop, "generic_desktop", true},
+    {hid::usage_page::simulation, "simulation", true},
+    {hid::usage_page::vr, "vr", true},
+    {hid::usage_page::sport, "sport", true},
+    {hid::usage_page::game, "game", true},
+    {hid::usage_page::generic_device_controls, "generic_device_controls", true},
+    {hid::usage_page::keyboard_or_keypad, "keyboard_or_keypad", true},
+    {hid::usage_page::leds, "leds", true},
+    {hid::usage_page::button, "button", true},
+    {hid::usage_page::ordinal, "ordinal", true},
+    {hid::usage_page::telephony, "telephony", true},
+    {hid::usage_page::consumer, "consumer", true},
+    {hid::usage_page::digitizer, "digitizer", true},
+    {hid::usage_page::pid, "pid", true},
+    {hid::usage_page::unicode, "unicode", true},
+    {hid::usage_page::alphanumeric_display, "alphanumeric_display", true},
+    {hid::usage_page::apple_vendor, "apple_vendor", true},
+    {hid::usage_page::apple_vendor_keyboard, "apple_vendor_keyboard", true},
+    {hid::usage_page::apple_vendor_mouse, "apple_vendor_mouse", true},
+    {hid::usage_page::apple_vendor_accelerometer, "apple_vendor_accelerometer", true},
+    {hid::usage_page::apple_vendor_ambient_light_sensor, "apple_vendor_ambient_light_sensor", true},
+    {hid::usage_page::apple_vendor_temperature_sensor, "apple_vendor_temperature_sensor", true},
+    {hid::usage_page::apple_vendor_headset, "apple_vendor_headset", true},
+    {hid::usage_page::apple_vendor_power_sensor, "apple_vendor_power_sensor", true},
+    {hid::usage_page::apple_vendor_smart_cover, "apple_vendor_smart_cover", true},
+    {hid::usage_page::apple_vendor_platinum, "apple_vendor_platinum", true},
+    {hid::usage_page::apple_vendor_lisa, "apple_vendor_lisa", true},
+    {hid::usage_page::apple_vendor_motion, "apple_vendor_motion", true},
+    {hid::usage_page::apple_vendor_battery, "apple_vendor_battery", true},
+    {hid::usage_page::apple_vendor_ir_remote, "apple_vendor_ir_remote", true},
+    {hid::usage_page::apple_vendor_debug, "apple_vendor_debug", true},
+    {hid::usage_page::apple_vendor_ir_interface, "apple_vendor_ir_interface", true},
+    {hid::usage_page::apple_vendor_filtered_event, "apple_vendor_filtered_event", true},
+    {hid::usage_page::apple_vendor_multitouch, "apple_vendor_multitouch", true},
+    {hid::usage_page::apple_vendor_display, "apple_vendor_display", true},
+    {hid::usage_page::apple_vendor_top_case, "apple_vendor_top_case", true},
+}};
+
+constexpr std::array<usage_name_entry, 297> usage_name_entries = {{
+    {hid::usage_page::generic_desktop, hid::usage::generic_desktop::undefined, "undefined", true},
+    {hid::usage_page::generic_desktop, hid::usage::generic_desktop::pointer, "pointer", true},
+    {hid::usage_page::generic_desktop, hid::usage::generic_desktop::mouse, "mouse", true},
+    {hid::usage_page::generic_desktop, hid::usage::generic_desktop::joystick, "joystick", true},
+    {hid::usage_page::generic_desktop, hid::usage::generic_desktop::game_pad, "game_pad", true},
+    {hid::usage_page::generic_desktop, hid::usage::generic_desktop::keyboard, "keyboard", true},
+    {hid::usage_page::generic_desktop, hid::usage::generic_desktop::keypad, "keypad", true},
+    {hid::usage_page::generic_desktop, hid::usage::generic_desktop::multi_axis_controller, "multi_axis_controller", true},
+    {hid::usage_page::generic_desktop, hid::usage::generic_desktop::tablet_pc_system_controls, "tablet_pc_system_controls", true},
+    {hid::usage_page::generic_desktop, hid::usage::generic_desktop::x, "x", true},
+    {hid::usage_page::generic_desktop, hid::usage::generic_desktop::y, "y", true},
+    {hid::usage_page::generic_desktop, hid::usage::generic_desktop::z, "z", true},
+    {hid::usage_page::generic_desktop, hid::usage::generic_desktop::rx, "rx", true},
+    {hid::usage_page::generic_desktop, hid::usage::generic_desktop::ry, "ry", true},
+    {hid::usage_page::generic_desktop, hid::usage::generic_desktop::rz, "rz", true},
+    {hid::usage_page::generic_desktop, hid::usage::generic_desktop::slider, "slider", true},
+    {hid::usage_page::generic_desktop, hid::usage::generic_desktop::dial, "dial", true},
+    {hid::usage_page::generic_desktop, hid::usage::generic_desktop::wheel, "wheel", true},
+    {hid::usage_page::generic_desktop, hid::usage::generic_desktop::hat_switch, "hat_switch", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::error_rollover, "error_rollover", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::post_fail, "post_fail", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::error_undefined, "error_undefined", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_a, "keyboard_a", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_b, "keyboard_b", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_c, "keyboard_c", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_d, "keyboard_d", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_e, "keyboard_e", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_f, "keyboard_f", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_g, "keyboard_g", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_h, "keyboard_h", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_i, "keyboard_i", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_j, "keyboard_j", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_k, "keyboard_k", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_l, "keyboard_l", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_m, "keyboard_m", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_n, "keyboard_n", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_o, "keyboard_o", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_p, "keyboard_p", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_q, "keyboard_q", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_r, "keyboard_r", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_s, "keyboard_s", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_t, "keyboard_t", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_u, "keyboard_u", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_v, "keyboard_v", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_w, "keyboard_w", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_x, "keyboard_x", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_y, "keyboard_y", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_z, "keyboard_z", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_1, "keyboard_1", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_2, "keyboard_2", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_3, "keyboard_3", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_4, "keyboard_4", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_5, "keyboard_5", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_6, "keyboard_6", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_7, "keyboard_7", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_8, "keyboard_8", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_9, "keyboard_9", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_0, "keyboard_0", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_return_or_enter, "keyboard_return_or_enter", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_escape, "keyboard_escape", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_delete_or_backspace, "keyboard_delete_or_backspace", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_tab, "keyboard_tab", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_spacebar, "keyboard_spacebar", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_hyphen, "keyboard_hyphen", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_equal_sign, "keyboard_equal_sign", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_open_bracket, "keyboard_open_bracket", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_close_bracket, "keyboard_close_bracket", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_backslash, "keyboard_backslash", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_non_us_pound, "keyboard_non_us_pound", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_semicolon, "keyboard_semicolon", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_quote, "keyboard_quote", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_grave_accent_and_tilde, "keyboard_grave_accent_and_tilde", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_comma, "keyboard_comma", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_period, "keyboard_period", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_slash, "keyboard_slash", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_caps_lock, "keyboard_caps_lock", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_f1, "keyboard_f1", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_f2, "keyboard_f2", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_f3, "keyboard_f3", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_f4, "keyboard_f4", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_f5, "keyboard_f5", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_f6, "keyboard_f6", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_f7, "keyboard_f7", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_f8, "keyboard_f8", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_f9, "keyboard_f9", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_f10, "keyboard_f10", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_f11, "keyboard_f11", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_f12, "keyboard_f12", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_print_screen, "keyboard_print_screen", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_scroll_lock, "keyboard_scroll_lock", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_pause, "keyboard_pause", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_insert, "keyboard_insert", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_home, "keyboard_home", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_page_up, "keyboard_page_up", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_delete_forward, "keyboard_delete_forward", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_end, "keyboard_end", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_page_down, "keyboard_page_down", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_right_arrow, "keyboard_right_arrow", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_left_arrow, "keyboard_left_arrow", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_down_arrow, "keyboard_down_arrow", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_up_arrow, "keyboard_up_arrow", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keypad_num_lock, "keypad_num_lock", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keypad_slash, "keypad_slash", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keypad_asterisk, "keypad_asterisk", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keypad_hyphen, "keypad_hyphen", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keypad_plus, "keypad_plus", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keypad_enter, "keypad_enter", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keypad_1, "keypad_1", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keypad_2, "keypad_2", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keypad_3, "keypad_3", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keypad_4, "keypad_4", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keypad_5, "keypad_5", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keypad_6, "keypad_6", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keypad_7, "keypad_7", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keypad_8, "keypad_8", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keypad_9, "keypad_9", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keypad_0, "keypad_0", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keypad_period, "keypad_period", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_non_us_backslash, "keyboard_non_us_backslash", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_application, "keyboard_application", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_power, "keyboard_power", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keypad_equal_sign, "keypad_equal_sign", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_f13, "keyboard_f13", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_f14, "keyboard_f14", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_f15, "keyboard_f15", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_f16, "keyboard_f16", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_f17, "keyboard_f17", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_f18, "keyboard_f18", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_f19, "keyboard_f19", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_f20, "keyboard_f20", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_f21, "keyboard_f21", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_f22, "keyboard_f22", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_f23, "keyboard_f23", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_f24, "keyboard_f24", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_execute, "keyboard_execute", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_help, "keyboard_help", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_menu, "keyboard_menu", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_select, "keyboard_select", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_stop, "keyboard_stop", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_again, "keyboard_again", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_undo, "keyboard_undo", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_cut, "keyboard_cut", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_copy, "keyboard_copy", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_paste, "keyboard_paste", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_find, "keyboard_find", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_mute, "keyboard_mute", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_volume_up, "keyboard_volume_up", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_volume_down, "keyboard_volume_down", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_locking_caps_lock, "keyboard_locking_caps_lock", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_locking_num_lock, "keyboard_locking_num_lock", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_locking_scroll_lock, "keyboard_locking_scroll_lock", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keypad_comma, "keypad_comma", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keypad_equal_sign_as400, "keypad_equal_sign_as400", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_international1, "keyboard_international1", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_international2, "keyboard_international2", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_international3, "keyboard_international3", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_international4, "keyboard_international4", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_international5, "keyboard_international5", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_international6, "keyboard_international6", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_international7, "keyboard_international7", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_international8, "keyboard_international8", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_international9, "keyboard_international9", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_lang1, "keyboard_lang1", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_lang2, "keyboard_lang2", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_lang3, "keyboard_lang3", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_lang4, "keyboard_lang4", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_lang5, "keyboard_lang5", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_lang6, "keyboard_lang6", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_lang7, "keyboard_lang7", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_lang8, "keyboard_lang8", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_lang9, "keyboard_lang9", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_alternate_erase, "keyboard_alternate_erase", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_sys_req_or_attention, "keyboard_sys_req_or_attention", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_cancel, "keyboard_cancel", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_clear, "keyboard_clear", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_prior, "keyboard_prior", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_return, "keyboard_return", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_separator, "keyboard_separator", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_out, "keyboard_out", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_oper, "keyboard_oper", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_clear_or_again, "keyboard_clear_or_again", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_cr_sel_or_props, "keyboard_cr_sel_or_props", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_ex_sel, "keyboard_ex_sel", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_left_control, "keyboard_left_control", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_left_shift, "keyboard_left_shift", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_left_alt, "keyboard_left_alt", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_left_gui, "keyboard_left_gui", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_right_control, "keyboard_right_control", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_right_shift, "keyboard_right_shift", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_right_alt, "keyboard_right_alt", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::keyboard_right_gui, "keyboard_right_gui", true},
+    {hid::usage_page::keyboard_or_keypad, hid::usage::keyboard_or_keypad::reserved, "reserved", true},
+    {hid::usage_page::leds, hid::usage::led::undefined, "undefined", true},
+    {hid::usage_page::leds, hid::usage::led::num_lock, "num_lock", true},
+    {hid::usage_page::leds, hid::usage::led::caps_lock, "caps_lock", true},
+    {hid::usage_page::leds, hid::usage::led::scroll_lock, "scroll_lock", true},
+    {hid::usage_page::button, hid::usage::button::button_1, "button_1", true},
+    {hid::usage_page::button, hid::usage::button::button_2, "button_2", true},
+    {hid::usage_page::button, hid::usage::button::button_3, "button_3", true},
+    {hid::usage_page::button, hid::usage::button::button_4, "button_4", true},
+    {hid::usage_page::button, hid::usage::button::button_5, "button_5", true},
+    {hid::usage_page::button, hid::usage::button::button_6, "button_6", true},
+    {hid::usage_page::button, hid::usage::button::button_7, "button_7", true},
+    {hid::usage_page::button, hid::usage::button::button_8, "button_8", true},
+    {hid::usage_page::button, hid::usage::button::button_9, "button_9", true},
+    {hid::usage_page::button, hid::usage::button::button_10, "button_10", true},
+    {hid::usage_page::button, hid::usage::button::button_11, "button_11", true},
+    {hid::usage_page::button, hid::usage::button::button_12, "button_12", true},
+    {hid::usage_page::button, hid::usage::button::button_13, "button_13", true},
+    {hid::usage_page::button, hid::usage::button::button_14, "button_14", true},
+    {hid::usage_page::button, hid::usage::button::button_15, "button_15", true},
+    {hid::usage_page::button, hid::usage::button::button_16, "button_16", true},
+    {hid::usage_page::button, hid::usage::button::button_17, "button_17", true},
+    {hid::usage_page::button, hid::usage::button::button_18, "button_18", true},
+    {hid::usage_page::button, hid::usage::button::button_19, "button_19", true},
+    {hid::usage_page::button, hid::usage::button::button_20, "button_20", true},
+    {hid::usage_page::button, hid::usage::button::button_21, "button_21", true},
+    {hid::usage_page::button, hid::usage::button::button_22, "button_22", true},
+    {hid::usage_page::button, hid::usage::button::button_23, "button_23", true},
+    {hid::usage_page::button, hid::usage::button::button_24, "button_24", true},
+    {hid::usage_page::button, hid::usage::button::button_25, "button_25", true},
+    {hid::usage_page::button, hid::usage::button::button_26, "button_26", true},
+    {hid::usage_page::button, hid::usage::button::button_27, "button_27", true},
+    {hid::usage_page::button, hid::usage::button::button_28, "button_28", true},
+    {hid::usage_page::button, hid::usage::button::button_29, "button_29", true},
+    {hid::usage_page::button, hid::usage::button::button_30, "button_30", true},
+    {hid::usage_page::button, hid::usage::button::button_31, "button_31", true},
+    {hid::usage_page::button, hid::usage::button::button_32, "button_32", true},
+    {hid::usage_page::consumer, hid::usage::consumer::consumer_control, "consumer_control", true},
+    {hid::usage_page::consumer, hid::usage::consumer::power, "power", true},
+    {hid::usage_page::consumer, hid::usage::consumer::display_brightness_increment, "display_brightness_increment", true},
+    {hid::usage_page::consumer, hid::usage::consumer::display_brightness_decrement, "display_brightness_decrement", true},
+    {hid::usage_page::consumer, hid::usage::consumer::fast_forward, "fast_forward", true},
+    {hid::usage_page::consumer, hid::usage::consumer::rewind, "rewind", true},
+    {hid::usage_page::consumer, hid::usage::consumer::scan_next_track, "scan_next_track", true},
+    {hid::usage_page::consumer, hid::usage::consumer::scan_previous_track, "scan_previous_track", true},
+    {hid::usage_page::consumer, hid::usage::consumer::eject, "eject", true},
+    {hid::usage_page::consumer, hid::usage::consumer::play_or_pause, "play_or_pause", true},
+    {hid::usage_page::consumer, hid::usage::consumer::voice_command, "voice_command", true},
+    {hid::usage_page::consumer, hid::usage::consumer::mute, "mute", true},
+    {hid::usage_page::consumer, hid::usage::consumer::volume_increment, "volume_increment", true},
+    {hid::usage_page::consumer, hid::usage::consumer::volume_decrement, "volume_decrement", true},
+    {hid::usage_page::consumer, hid::usage::consumer::ac_pan, "ac_pan", true},
+    {hid::usage_page::apple_vendor, hid::usage::apple_vendor::top_case, "top_case", true},
+    {hid::usage_page::apple_vendor, hid::usage::apple_vendor::display, "display", true},
+    {hid::usage_page::apple_vendor, hid::usage::apple_vendor::accelerometer, "accelerometer", true},
+    {hid::usage_page::apple_vendor, hid::usage::apple_vendor::ambient_light_sensor, "ambient_light_sensor", true},
+    {hid::usage_page::apple_vendor, hid::usage::apple_vendor::temperature_sensor, "temperature_sensor", true},
+    {hid::usage_page::apple_vendor, hid::usage::apple_vendor::keyboard, "keyboard", true},
+    {hid::usage_page::apple_vendor, hid::usage::apple_vendor::headset, "headset", true},
+    {hid::usage_page::apple_vendor, hid::usage::apple_vendor::proximity_sensor, "proximity_sensor", true},
+    {hid::usage_page::apple_vendor, hid::usage::apple_vendor::gyro, "gyro", true},
+    {hid::usage_page::apple_vendor, hid::usage::apple_vendor::compass, "compass", true},
+    {hid::usage_page::apple_vendor, hid::usage::apple_vendor::device_management, "device_management", true},
+    {hid::usage_page::apple_vendor, hid::usage::apple_vendor::trackpad, "trackpad", true},
+    {hid::usage_page::apple_vendor, hid::usage::apple_vendor::top_case_reserved, "top_case_reserved", true},
+    {hid::usage_page::apple_vendor, hid::usage::apple_vendor::motion, "motion", true},
+    {hid::usage_page::apple_vendor, hid::usage::apple_vendor::keyboard_backlight, "keyboard_backlight", true},
+    {hid::usage_page::apple_vendor, hid::usage::apple_vendor::device_motion_lite, "device_motion_lite", true},
+    {hid::usage_page::apple_vendor, hid::usage::apple_vendor::force, "force", true},
+    {hid::usage_page::apple_vendor, hid::usage::apple_vendor::bluetooth_radio, "bluetooth_radio", true},
+    {hid::usage_page::apple_vendor, hid::usage::apple_vendor::orb, "orb", true},
+    {hid::usage_page::apple_vendor, hid::usage::apple_vendor::accessory_battery, "accessory_battery", true},
+    {hid::usage_page::apple_vendor, hid::usage::apple_vendor::humidity, "humidity", true},
+    {hid::usage_page::apple_vendor, hid::usage::apple_vendor::hid_event_relay, "hid_event_relay", true},
+    {hid::usage_page::apple_vendor, hid::usage::apple_vendor::nx_event, "nx_event", true},
+    {hid::usage_page::apple_vendor, hid::usage::apple_vendor::nx_event_translated, "nx_event_translated", true},
+    {hid::usage_page::apple_vendor, hid::usage::apple_vendor::nx_event_diagnostic, "nx_event_diagnostic", true},
+    {hid::usage_page::apple_vendor, hid::usage::apple_vendor::homer, "homer", true},
+    {hid::usage_page::apple_vendor, hid::usage::apple_vendor::color, "color", true},
+    {hid::usage_page::apple_vendor, hid::usage::apple_vendor::accessibility, "accessibility", true},
+    {hid::usage_page::apple_vendor_keyboard, hid::usage::apple_vendor_keyboard::spotlight, "spotlight", true},
+    {hid::usage_page::apple_vendor_keyboard, hid::usage::apple_vendor_keyboard::dashboard, "dashboard", true},
+    {hid::usage_page::apple_vendor_keyboard, hid::usage::apple_vendor_keyboard::function, "function", true},
+    {hid::usage_page::apple_vendor_keyboard, hid::usage::apple_vendor_keyboard::launchpad, "launchpad", true},
+    {hid::usage_page::apple_vendor_keyboard, hid::usage::apple_vendor_keyboard::reserved, "reserved", true},
+    {hid::usage_page::apple_vendor_keyboard, hid::usage::apple_vendor_keyboard::caps_lock_delay_enable, "caps_lock_delay_enable", true},
+    {hid::usage_page::apple_vendor_keyboard, hid::usage::apple_vendor_keyboard::power_state, "power_state", true},
+    {hid::usage_page::apple_vendor_keyboard, hid::usage::apple_vendor_keyboard::expose_all, "expose_all", true},
+    {hid::usage_page::apple_vendor_keyboard, hid::usage::apple_vendor_keyboard::expose_desktop, "expose_desktop", true},
+    {hid::usage_page::apple_vendor_keyboard, hid::usage::apple_vendor_keyboard::brightness_up, "brightness_up", true},
+    {hid::usage_page::apple_vendor_keyboard, hid::usage::apple_vendor_keyboard::brightness_down, "brightness_down", true},
+    {hid::usage_page::apple_vendor_keyboard, hid::usage::apple_vendor_keyboard::language, "language", true},
+    {hid::usage_page::apple_vendor_multitouch, hid::usage::apple_vendor_multitouch::power_off, "power_off", true},
+    {hid::usage_page::apple_vendor_multitouch, hid::usage::apple_vendor_multitouch::device_ready, "device_ready", true},
+    {hid::usage_page::apple_vendor_multitouch, hid::usage::apple_vendor_multitouch::external_message, "external_message", true},
+    {hid::usage_page::apple_vendor_multitouch, hid::usage::apple_vendor_multitouch::will_power_on, "will_power_on", true},
+    {hid::usage_page::apple_vendor_multitouch, hid::usage::apple_vendor_multitouch::touch_cancel, "touch_cancel", true},
+    {hid::usage_page::apple_vendor_top_case, hid::usage::apple_vendor_top_case::keyboard_fn, "keyboard_fn", true},
+    {hid::usage_page::apple_vendor_top_case, hid::usage::apple_vendor_top_case::brightness_up, "brightness_up", true},
+    {hid::usage_page::apple_vendor_top_case, hid::usage::apple_vendor_top_case::brightness_down, "brightness_down", true},
+    {hid::usage_page::apple_vendor_top_case, hid::usage::apple_vendor_top_case::video_mirror, "video_mirror", true},
+    {hid::usage_page::apple_vendor_top_case, hid::usage::apple_vendor_top_case::illumination_toggle, "illumination_toggle", true},
+    {hid::usage_page::apple_vendor_top_case, hid::usage::apple_vendor_top_case::illumination_up, "illumination_up", true},
+    {hid::usage_page::apple_vendor_top_case, hid::usage::apple_vendor_top_case::illumination_down, "illumination_down", true},
+    {hid::usage_page::apple_vendor_top_case, hid::usage::apple_vendor_top_case::clamshell_latched, "clamshell_latched", true},
+    {hid::usage_page::apple_vendor_top_case, hid::usage::apple_vendor_top_case::reserved_mouse_data, "reserved_mouse_data", true},
+}};
+
+constexpr std::array<modifier_name_entry, 8> modifier_name_entries = {{
+    {virtual_hid_device_driver::hid_report::modifier::left_control, "left_control"},
+    {virtual_hid_device_driver::hid_report::modifier::left_shift, "left_shift"},
+    {virtual_hid_device_driver::hid_report::modifier::left_option, "left_option"},
+    {virtual_hid_device_driver::hid_report::modifier::left_command, "left_command"},
+    {virtual_hid_device_driver::hid_report::modifier::right_control, "right_control"},
+    {virtual_hid_device_driver::hid_report::modifier::right_shift, "right_shift"},
+    {virtual_hid_device_driver::hid_report::modifier::right_option, "right_option"},
+    {virtual_hid_device_driver::hid_report::modifier::right_command, "right_command"},
+}};
+
+} // namespace hid_names
+} // namespace virtual_hid_device_service
+} // namespace driverkit
+} // namespace karabiner
+} // namespace pqrs
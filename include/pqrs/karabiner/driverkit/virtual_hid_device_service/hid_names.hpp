@@ -0,0 +1,141 @@
+#pragma once
+
+// (C) Copyright Takayama Fumihiko 2020.
+// Distributed under the Boost Software License, Version 1.0.
+// (See https://www.boost.org/LICENSE_1_0.txt)
+
+#include "hid_name_entries.hpp"
+#include "perfect_hash.hpp"
+#include <optional>
+#include <string_view>
+
+namespace pqrs {
+namespace karabiner {
+namespace driverkit {
+namespace virtual_hid_device_service {
+namespace hid_names {
+
+//
+// Lookups between names (e.g., "keyboard_up_arrow", "left_control") and values of
+// `pqrs::hid::usage_page`, `pqrs::hid::usage` and `hid_report::modifier`.
+//
+// The tables are perfect hash tables which are built at compile time from `hid_name_entries.hpp`,
+// so there is no construction cost at runtime.
+// Usage names are unique within a usage page.
+//
+
+namespace impl {
+constexpr uint64_t hash_usage_page(hid::usage_page::value_t usage_page) {
+  return perfect_hash::hash(static_cast<uint64_t>(type_safe::get(usage_page)));
+}
+
+constexpr uint64_t hash_usage_name(hid::usage_page::value_t usage_page, std::string_view name) {
+  return perfect_hash::hash(name, hash_usage_page(usage_page));
+}
+
+constexpr uint64_t hash_usage(hid::usage_page::value_t usage_page, hid::usage::value_t usage) {
+  return perfect_hash::hash(static_cast<uint64_t>(type_safe::get(usage)), hash_usage_page(usage_page));
+}
+
+constexpr uint64_t hash_modifier(virtual_hid_device_driver::hid_report::modifier modifier) {
+  return perfect_hash::hash(static_cast<uint64_t>(modifier));
+}
+
+constexpr auto usage_pages_by_name = perfect_hash::make_table(
+    usage_page_name_entries,
+    [](auto&& e) { return perfect_hash::hash(e.name); },
+    [](auto&&) { return true; });
+
+constexpr auto usage_page_names = perfect_hash::make_table(
+    usage_page_name_entries,
+    [](auto&& e) { return hash_usage_page(e.usage_page); },
+    [](auto&& e) { return e.canonical; });
+
+constexpr auto usages_by_name = perfect_hash::make_table(
+    usage_name_entries,
+    [](auto&& e) { return hash_usage_name(e.usage_page, e.name); },
+    [](auto&&) { return true; });
+
+constexpr auto usage_names = perfect_hash::make_table(
+    usage_name_entries,
+    [](auto&& e) { return hash_usage(e.usage_page, e.usage); },
+    [](auto&& e) { return e.canonical; });
+
+constexpr auto modifiers_by_name = perfect_hash::make_table(
+    modifier_name_entries,
+    [](auto&& e) { return perfect_hash::hash(e.name); },
+    [](auto&&) { return true; });
+
+constexpr auto modifier_names = perfect_hash::make_table(
+    modifier_name_entries,
+    [](auto&& e) { return hash_modifier(e.modifier); },
+    [](auto&&) { return true; });
+} // namespace impl
+
+constexpr std::optional<hid::usage_page::value_t> find_usage_page(std::string_view name) {
+  if (auto i = impl::usage_pages_by_name.find(perfect_hash::hash(name))) {
+    auto&& e = usage_page_name_entries[*i];
+    if (e.name == name) {
+      return e.usage_page;
+    }
+  }
+  return std::nullopt;
+}
+
+constexpr std::optional<std::string_view> find_usage_page_name(hid::usage_page::value_t usage_page) {
+  if (auto i = impl::usage_page_names.find(impl::hash_usage_page(usage_page))) {
+    auto&& e = usage_page_name_entries[*i];
+    if (e.usage_page == usage_page) {
+      return e.name;
+    }
+  }
+  return std::nullopt;
+}
+
+constexpr std::optional<hid::usage::value_t> find_usage(hid::usage_page::value_t usage_page,
+                                                        std::string_view name) {
+  if (auto i = impl::usages_by_name.find(impl::hash_usage_name(usage_page, name))) {
+    auto&& e = usage_name_entries[*i];
+    if (e.usage_page == usage_page && e.name == name) {
+      return e.usage;
+    }
+  }
+  return std::nullopt;
+}
+
+constexpr std::optional<std::string_view> find_usage_name(hid::usage_page::value_t usage_page,
+                                                          hid::usage::value_t usage) {
+  if (auto i = impl::usage_names.find(impl::hash_usage(usage_page, usage))) {
+    auto&& e = usage_name_entries[*i];
+    if (e.usage_page == usage_page && e.usage == usage) {
+      return e.name;
+    }
+  }
+  return std::nullopt;
+}
+
+constexpr std::optional<virtual_hid_device_driver::hid_report::modifier> find_modifier(std::string_view name) {
+  if (auto i = impl::modifiers_by_name.find(perfect_hash::hash(name))) {
+    auto&& e = modifier_name_entries[*i];
+    if (e.name == name) {
+      return e.modifier;
+    }
+  }
+  return std::nullopt;
+}
+
+constexpr std::optional<std::string_view> find_modifier_name(virtual_hid_device_driver::hid_report::modifier modifier) {
+  if (auto i = impl::modifier_names.find(impl::hash_modifier(modifier))) {
+    auto&& e = modifier_name_entries[*i];
+    if (e.modifier == modifier) {
+      return e.name;
+    }
+  }
+  return std::nullopt;
+}
+
+} // namespace hid_names
+} // namespace virtual_hid_device_service
+} // namespace driverkit
+} // namespace karabiner
+} // namespace pqrs
@@ -0,0 +1,323 @@
+#pragma once
+
+// (C) Copyright Takayama Fumihiko 2020.
+// Distributed under the Boost Software License, Version 1.0.
+// (See https://www.boost.org/LICENSE_1_0.txt)
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <memory>
+#include <new>
+#include <optional>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <system_error>
+#include <type_traits>
+#include <unistd.h>
+
+namespace pqrs {
+namespace karabiner {
+namespace driverkit {
+namespace virtual_hid_device_service {
+namespace metrics {
+
+//
+// The server publishes counters and gauges in a memory-mapped file.
+// External tools map the file read-only and read it without any request to the server.
+// The file is readable by all users and writable only by the owner (the server).
+//
+// Each section is written by a single thread and protected by a seqlock.
+// Writers never wait for readers, and readers never write to the page.
+//
+
+constexpr char magic[8] = {'K', 'V', 'H', 'D', 'M', 'T', 'R', 'C'};
+constexpr uint32_t version = 1;
+
+// A single-writer seqlock which can be placed in shared memory.
+template <typename T>
+class seqlock final {
+public:
+  static_assert(std::is_trivially_copyable_v<T>, "T must be trivially copyable");
+  static_assert(sizeof(T) % sizeof(uint64_t) == 0, "The size of T must be a multiple of 8");
+  static_assert(std::atomic<uint64_t>::is_always_lock_free, "std::atomic<uint64_t> must be lock-free");
+
+  seqlock(void) : sequence_(0) {
+    for (auto&& w : words_) {
+      w.store(0, std::memory_order_relaxed);
+    }
+  }
+
+  seqlock(const seqlock&) = delete;
+
+  // This method must be called from the writer thread only.
+  void store(const T& value) {
+    std::array<uint64_t, word_count> words;
+    memcpy(words.data(), &value, sizeof(T));
+
+    auto s = sequence_.load(std::memory_order_relaxed);
+    sequence_.store(s + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    for (size_t i = 0; i < word_count; ++i) {
+      words_[i].store(words[i], std::memory_order_relaxed);
+    }
+
+    sequence_.store(s + 2, std::memory_order_release);
+  }
+
+  // Returns std::nullopt if a consistent value is not read in `max_retries` (e.g., the writer is terminated while writing).
+  std::optional<T> load(int max_retries = 10000) const {
+    for (int retry = 0; retry < max_retries; ++retry) {
+      auto s1 = sequence_.load(std::memory_order_acquire);
+      if (s1 & 1) {
+        continue;
+      }
+
+      std::array<uint64_t, word_count> words;
+      for (size_t i = 0; i < word_count; ++i) {
+        words[i] = words_[i].load(std::memory_order_relaxed);
+      }
+
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (sequence_.load(std::memory_order_relaxed) == s1) {
+        T value;
+        memcpy(&value, words.data(), sizeof(T));
+        return value;
+      }
+    }
+
+    return std::nullopt;
+  }
+
+private:
+  static constexpr size_t word_count = sizeof(T) / sizeof(uint64_t);
+
+  std::atomic<uint64_t> sequence_;
+  std::array<std::atomic<uint64_t>, word_count> words_;
+};
+
+enum class device : uint8_t {
+  virtual_hid_keyboard,
+  virtual_hid_pointing,
+  virtual_hid_absolute_pointing,
+  end_,
+};
+
+constexpr size_t device_count = static_cast<size_t>(device::end_);
+
+// Written in the server dispatcher thread.
+struct server_metrics final {
+  // Indexed by `request`.
+  std::array<uint64_t, 64> received_requests;
+  uint64_t parse_errors;
+  uint64_t connected_clients;
+  // Indexed by `device`.
+  // -1: not initialized or unknown, 0: not ready, 1: ready
+  std::array<int64_t, device_count> device_ready;
+};
+
+// Written in the thread which posts reports to `io_service_client` (the server dispatcher thread).
+struct report_queue_metrics final {
+  uint64_t queued_reports;
+  // Reports which are dropped because the report queue is full.
+  uint64_t dropped_reports;
+};
+
+// Written in the forwarding thread of the device.
+struct forwarding_metrics final {
+  uint64_t forwarded_reports;
+  uint64_t backend_errors;
+  // The number of queued reports when the forwarding thread starts draining.
+  uint64_t queue_depth;
+  uint64_t max_queue_depth;
+  uint64_t last_backend_call_latency_nanoseconds;
+};
+
+struct device_metrics final {
+  seqlock<report_queue_metrics> report_queue;
+  seqlock<forwarding_metrics> forwarding;
+};
+
+struct page final {
+  char magic[8];
+  uint32_t version;
+  uint32_t size;
+  uint64_t pid;
+
+  seqlock<server_metrics> server;
+  std::array<device_metrics, device_count> devices;
+
+  device_metrics& get_device_metrics(device d) {
+    return devices[static_cast<size_t>(d)];
+  }
+
+  const device_metrics& get_device_metrics(device d) const {
+    return devices[static_cast<size_t>(d)];
+  }
+};
+
+static_assert(std::is_standard_layout_v<page>, "page must be standard layout");
+
+class writer final {
+public:
+  writer(const writer&) = delete;
+
+  writer(void) : fd_(-1),
+                 page_(nullptr) {
+  }
+
+  ~writer(void) {
+    close();
+  }
+
+  bool is_open(void) const {
+    return page_ != nullptr;
+  }
+
+  std::error_code open(const std::filesystem::path& file_path) {
+    close();
+
+    fd_ = ::open(file_path.c_str(), O_RDWR | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+    if (fd_ < 0) {
+      return std::error_code(errno, std::generic_category());
+    }
+
+    // Set the mode regardless of umask and the mode of the existing file.
+    if (fchmod(fd_, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH) != 0) {
+      auto error_code = std::error_code(errno, std::generic_category());
+      close();
+      return error_code;
+    }
+
+    if (ftruncate(fd_, static_cast<off_t>(sizeof(page))) != 0) {
+      auto error_code = std::error_code(errno, std::generic_category());
+      close();
+      return error_code;
+    }
+
+    auto a = mmap(nullptr, sizeof(page), PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (a == MAP_FAILED) {
+      auto error_code = std::error_code(errno, std::generic_category());
+      close();
+      return error_code;
+    }
+
+    page_ = new (a) page();
+    page_->version = version;
+    page_->size = sizeof(page);
+    page_->pid = static_cast<uint64_t>(getpid());
+
+    // Readers treat the page as valid after `magic` is written.
+    std::atomic_thread_fence(std::memory_order_release);
+    memcpy(page_->magic, magic, sizeof(magic));
+
+    return std::error_code();
+  }
+
+  void close(void) {
+    if (page_) {
+      page_->~page();
+      munmap(page_, sizeof(page));
+      page_ = nullptr;
+    }
+
+    if (fd_ >= 0) {
+      ::close(fd_);
+      fd_ = -1;
+    }
+  }
+
+  // Returns an in-process page if the file is not opened so that writers do not have to check `is_open`.
+  page& get_page(void) {
+    if (page_) {
+      return *page_;
+    }
+
+    if (!fallback_page_) {
+      fallback_page_ = std::make_unique<page>();
+    }
+    return *fallback_page_;
+  }
+
+private:
+  int fd_;
+  page* page_;
+  std::unique_ptr<page> fallback_page_;
+};
+
+class reader final {
+public:
+  reader(const reader&) = delete;
+
+  reader(void) : page_(nullptr) {
+  }
+
+  ~reader(void) {
+    close();
+  }
+
+  std::error_code open(const std::filesystem::path& file_path) {
+    close();
+
+    auto fd = ::open(file_path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      return std::error_code(errno, std::generic_category());
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+      auto error_code = std::error_code(errno, std::generic_category());
+      ::close(fd);
+      return error_code;
+    }
+
+    if (st.st_size < static_cast<off_t>(sizeof(page))) {
+      ::close(fd);
+      return std::make_error_code(std::errc::invalid_argument);
+    }
+
+    auto a = mmap(nullptr, sizeof(page), PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (a == MAP_FAILED) {
+      return std::error_code(errno, std::generic_category());
+    }
+
+    page_ = static_cast<const page*>(a);
+
+    if (memcmp(page_->magic, magic, sizeof(magic)) != 0 ||
+        page_->version != version ||
+        page_->size != sizeof(page)) {
+      close();
+      return std::make_error_code(std::errc::invalid_argument);
+    }
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+
+    return std::error_code();
+  }
+
+  void close(void) {
+    if (page_) {
+      munmap(const_cast<page*>(page_), sizeof(page));
+      page_ = nullptr;
+    }
+  }
+
+  // `open` must be succeeded before calling this method.
+  const page& get_page(void) const {
+    return *page_;
+  }
+
+private:
+  const page* page_;
+};
+
+} // namespace metrics
+} // namespace virtual_hid_device_service
+} // namespace driverkit
+} // namespace karabiner
+} // namespace pqrs
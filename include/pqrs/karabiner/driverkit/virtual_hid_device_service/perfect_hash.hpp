@@ -0,0 +1,228 @@
+#pragma once
+
+// (C) Copyright Takayama Fumihiko 2020.
+// Distributed under the Boost Software License, Version 1.0.
+// (See https://www.boost.org/LICENSE_1_0.txt)
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+
+namespace pqrs {
+namespace karabiner {
+namespace driverkit {
+namespace virtual_hid_device_service {
+namespace perfect_hash {
+
+//
+// A perfect hash table which is built at compile time (hash and displace).
+//
+// Keys are hashed into 64-bit values by the caller.
+// Each key is placed into a bucket by its hash, and each bucket has a displacement (pilot)
+// which maps all keys of the bucket into distinct free slots.
+// A lookup is a hash mixing, a bucket read, a slot read and a key comparison by the caller.
+//
+// The build fails at compile time if the hashes are not distinct.
+//
+
+constexpr uint64_t default_seed = 0xcbf29ce484222325;
+
+namespace impl {
+// Loads `size` (<= 8) bytes as a little-endian integer.
+constexpr uint64_t load(std::string_view value, size_t offset, size_t size) {
+  uint64_t word = 0;
+
+  if (!__builtin_is_constant_evaluated()) {
+    static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "little-endian is required");
+    memcpy(&word, value.data() + offset, size);
+    return word;
+  }
+
+  for (size_t i = 0; i < size; ++i) {
+    word |= static_cast<uint64_t>(static_cast<uint8_t>(value[offset + i])) << (i * 8);
+  }
+  return word;
+}
+
+constexpr uint64_t step(uint64_t h, uint64_t word) {
+  h = (h ^ word) * 0x9e3779b97f4a7c15;
+  return h ^ (h >> 32);
+}
+} // namespace impl
+
+// Hashes 8 bytes per step. (The final mixing is done by `table`.)
+constexpr uint64_t hash(std::string_view value, uint64_t h = default_seed) {
+  auto size = value.size();
+
+  size_t i = 0;
+  for (; i + 8 <= size; i += 8) {
+    h = impl::step(h, impl::load(value, i, 8));
+  }
+
+  if (i < size) {
+    // The last 8 bytes overlap the previous word if the value is longer than 8 bytes.
+    h = size >= 8 ? impl::step(h, impl::load(value, size - 8, 8))
+                  : impl::step(h, impl::load(value, 0, size));
+  }
+
+  return h ^ size;
+}
+
+constexpr uint64_t hash(uint64_t value, uint64_t h = default_seed) {
+  return impl::step(h, value);
+}
+
+// splitmix64 finalizer
+constexpr uint64_t mix(uint64_t h, uint64_t seed) {
+  h ^= seed * 0x9e3779b97f4a7c15;
+  h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9;
+  h = (h ^ (h >> 27)) * 0x94d049bb133111eb;
+  return h ^ (h >> 31);
+}
+
+constexpr size_t log2_ceil(size_t value) {
+  size_t result = 0;
+  while ((static_cast<size_t>(1) << result) < value) {
+    ++result;
+  }
+  return result;
+}
+
+template <size_t N>
+class table final {
+public:
+  static_assert(N > 0 && N < 0xffff, "N is out of range");
+
+  static constexpr size_t slot_bits = log2_ceil(N * 2);
+  static constexpr size_t slot_count = static_cast<size_t>(1) << slot_bits;
+  static constexpr size_t bucket_count = (N + 1) / 2;
+
+  // `hashes[i]` is the hash of the i-th key.
+  // `enabled[i] == false` excludes the i-th key (e.g., an alias of another key).
+  constexpr table(const std::array<uint64_t, N>& hashes,
+                  const std::array<bool, N>& enabled) : pilots_{},
+                                                        slots_{} {
+    // Group keys by bucket (counting sort).
+
+    std::array<size_t, bucket_count + 1> offsets{};
+    for (size_t i = 0; i < N; ++i) {
+      if (enabled[i]) {
+        ++offsets[get_bucket(mix(hashes[i], 0)) + 1];
+      }
+    }
+
+    size_t max_bucket_size = 0;
+    for (size_t b = 0; b < bucket_count; ++b) {
+      max_bucket_size = offsets[b + 1] > max_bucket_size ? offsets[b + 1] : max_bucket_size;
+      offsets[b + 1] += offsets[b];
+    }
+
+    std::array<uint64_t, N> bucket_hashes{};
+    std::array<uint16_t, N> bucket_indices{};
+    std::array<size_t, bucket_count> positions{};
+    for (size_t i = 0; i < N; ++i) {
+      if (enabled[i]) {
+        auto h = mix(hashes[i], 0);
+        auto b = get_bucket(h);
+        auto p = offsets[b] + positions[b]++;
+        bucket_hashes[p] = h;
+        bucket_indices[p] = static_cast<uint16_t>(i);
+      }
+    }
+
+    // Place larger buckets first.
+
+    for (size_t size = max_bucket_size; size > 0; --size) {
+      for (size_t b = 0; b < bucket_count; ++b) {
+        if (offsets[b + 1] - offsets[b] == size) {
+          place_bucket(bucket_hashes, bucket_indices, offsets[b], size, b);
+        }
+      }
+    }
+  }
+
+  // Returns the index of the key which may have `hash`.
+  // The caller has to compare the key because a hash of an unknown key also returns an index.
+  constexpr std::optional<size_t> find(uint64_t hash) const {
+    auto h = mix(hash, 0);
+    auto index = slots_[get_slot(h, pilots_[get_bucket(h)])];
+    if (index == 0) {
+      return std::nullopt;
+    }
+    return index - 1;
+  }
+
+private:
+  // `h` is a mixed hash.
+  static constexpr size_t get_bucket(uint64_t h) {
+    return static_cast<size_t>(((h >> 32) * bucket_count) >> 32);
+  }
+
+  // `h` is a mixed hash and `pilot` is a mixed pilot.
+  // (Multiplicative hashing. The high bits depend on all bits of `h ^ pilot`.)
+  static constexpr size_t get_slot(uint64_t h, uint64_t pilot) {
+    return static_cast<size_t>(((h ^ pilot) * 0x9e3779b97f4a7c15) >> (64 - slot_bits));
+  }
+
+  constexpr void place_bucket(const std::array<uint64_t, N>& bucket_hashes,
+                              const std::array<uint16_t, N>& bucket_indices,
+                              size_t offset,
+                              size_t size,
+                              size_t bucket) {
+    for (uint64_t p = 0; p <= 0xffff; ++p) {
+      auto pilot = mix(p, 1);
+      bool ok = true;
+
+      for (size_t i = offset; i < offset + size && ok; ++i) {
+        auto slot = get_slot(bucket_hashes[i], pilot);
+        if (slots_[slot] != 0) {
+          ok = false;
+        }
+        for (size_t j = offset; j < i && ok; ++j) {
+          if (get_slot(bucket_hashes[j], pilot) == slot) {
+            ok = false;
+          }
+        }
+      }
+
+      if (ok) {
+        pilots_[bucket] = pilot;
+        for (size_t i = offset; i < offset + size; ++i) {
+          slots_[get_slot(bucket_hashes[i], pilot)] = static_cast<uint16_t>(bucket_indices[i] + 1);
+        }
+        return;
+      }
+    }
+
+    throw std::logic_error("perfect_hash::table: keys are not distinct");
+  }
+
+  // Mixed pilots
+  std::array<uint64_t, bucket_count> pilots_;
+  // The index of the key + 1. (0 is an empty slot.)
+  std::array<uint16_t, slot_count> slots_;
+};
+
+// Builds a table from `entries` with `hash_function(entry)` and `enabled_function(entry)`.
+template <typename T, size_t N, typename HashFunction, typename EnabledFunction>
+constexpr table<N> make_table(const std::array<T, N>& entries,
+                              HashFunction hash_function,
+                              EnabledFunction enabled_function) {
+  std::array<uint64_t, N> hashes{};
+  std::array<bool, N> enabled{};
+  for (size_t i = 0; i < N; ++i) {
+    hashes[i] = hash_function(entries[i]);
+    enabled[i] = enabled_function(entries[i]);
+  }
+  return table<N>(hashes, enabled);
+}
+
+} // namespace perfect_hash
+} // namespace virtual_hid_device_service
+} // namespace driverkit
+} // namespace karabiner
+} // namespace pqrs
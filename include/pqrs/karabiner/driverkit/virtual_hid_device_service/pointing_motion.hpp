@@ -0,0 +1,148 @@
+#pragma once
+
+// (C) Copyright Takayama Fumihiko 2020.
+// Distributed under the Boost Software License, Version 1.0.
+// (See https://www.boost.org/LICENSE_1_0.txt)
+
+#include "../virtual_hid_device_driver/hid_report/buttons.hpp"
+#include "../virtual_hid_device_driver/hid_report/pointing_high_resolution_input.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+namespace pqrs {
+namespace karabiner {
+namespace driverkit {
+namespace virtual_hid_device_service {
+
+//
+// A motion or scroll curve which is expanded into pointing reports by the server.
+//
+
+enum class motion_easing : uint8_t {
+  linear,
+  ease_in,     // cubic
+  ease_out,    // cubic (e.g., momentum scrolling)
+  ease_in_out, // cubic
+};
+
+class __attribute__((packed)) pointing_motion final {
+public:
+  pointing_motion(void) : buttons{},
+                          x(0),
+                          y(0),
+                          vertical_wheel(0),
+                          horizontal_wheel(0),
+                          duration_milliseconds(0),
+                          interval_milliseconds(8),
+                          easing(motion_easing::linear) {
+  }
+
+  // The buttons of all reports.
+  virtual_hid_device_driver::hid_report::buttons buttons;
+  // Total deltas.
+  int32_t x;
+  int32_t y;
+  // Total wheel deltas in 1/`pointing_high_resolution_input::wheel_unit` of a detent.
+  int32_t vertical_wheel;
+  int32_t horizontal_wheel;
+  uint32_t duration_milliseconds;
+  // The output rate.
+  uint32_t interval_milliseconds;
+  motion_easing easing;
+};
+
+// Generates `pointing_high_resolution_input` reports of `pointing_motion`.
+// X and Y are quantized to the int8 range of the report and the rounding error and the overflow are carried to the next report.
+// Extra reports are appended if the remaining deltas do not fit the int8 range at the end of the curve.
+class motion_synthesizer final {
+public:
+  motion_synthesizer(const pointing_motion& motion) : motion_(motion),
+                                                      steps_(1),
+                                                      current_step_(0),
+                                                      emitted_{} {
+    auto interval = get_interval_milliseconds();
+    if (motion.duration_milliseconds > interval) {
+      steps_ = (motion.duration_milliseconds + interval - 1) / interval;
+    }
+  }
+
+  uint32_t get_interval_milliseconds(void) const {
+    return std::max(motion_.interval_milliseconds, static_cast<uint32_t>(1));
+  }
+
+  uint32_t get_steps(void) const {
+    return steps_;
+  }
+
+  bool finished(void) const {
+    return current_step_ >= steps_ &&
+           emitted_[axis_x] == motion_.x &&
+           emitted_[axis_y] == motion_.y &&
+           emitted_[axis_vertical_wheel] == motion_.vertical_wheel &&
+           emitted_[axis_horizontal_wheel] == motion_.horizontal_wheel;
+  }
+
+  virtual_hid_device_driver::hid_report::pointing_high_resolution_input next(void) {
+    if (current_step_ < steps_) {
+      ++current_step_;
+    }
+
+    auto progress = ease(static_cast<double>(current_step_) / steps_);
+
+    virtual_hid_device_driver::hid_report::pointing_high_resolution_input report;
+    report.buttons = motion_.buttons;
+    report.x = static_cast<uint8_t>(static_cast<int8_t>(take(axis_x, motion_.x, progress, 127)));
+    report.y = static_cast<uint8_t>(static_cast<int8_t>(take(axis_y, motion_.y, progress, 127)));
+    report.vertical_wheel = static_cast<int16_t>(take(axis_vertical_wheel, motion_.vertical_wheel, progress, 32767));
+    report.horizontal_wheel = static_cast<int16_t>(take(axis_horizontal_wheel, motion_.horizontal_wheel, progress, 32767));
+    return report;
+  }
+
+private:
+  enum axis {
+    axis_x,
+    axis_y,
+    axis_vertical_wheel,
+    axis_horizontal_wheel,
+    axis_count,
+  };
+
+  double ease(double t) const {
+    switch (motion_.easing) {
+      case motion_easing::linear:
+        return t;
+      case motion_easing::ease_in:
+        return t * t * t;
+      case motion_easing::ease_out: {
+        auto u = 1.0 - t;
+        return 1.0 - u * u * u;
+      }
+      case motion_easing::ease_in_out:
+        if (t < 0.5) {
+          return 4.0 * t * t * t;
+        } else {
+          auto u = -2.0 * t + 2.0;
+          return 1.0 - u * u * u / 2.0;
+        }
+    }
+    return t;
+  }
+
+  int32_t take(axis a, int32_t total, double progress, int32_t limit) {
+    auto target = static_cast<int64_t>(std::llround(total * progress));
+    auto delta = std::clamp<int64_t>(target - emitted_[a], -limit, limit);
+    emitted_[a] += delta;
+    return static_cast<int32_t>(delta);
+  }
+
+  pointing_motion motion_;
+  uint32_t steps_;
+  uint32_t current_step_;
+  int64_t emitted_[axis_count];
+};
+
+} // namespace virtual_hid_device_service
+} // namespace driverkit
+} // namespace karabiner
+} // namespace pqrs
@@ -27,6 +27,20 @@ enum class request : uint8_t {
   post_apple_vendor_keyboard_input_report,
   post_apple_vendor_top_case_input_report,
   post_pointing_input_report,
+  request_trace_start,
+  request_trace_stop,
+  post_keyboard_bitmap_input_report,
+  post_pointing_high_resolution_input_report,
+  virtual_hid_absolute_pointing_initialize,
+  virtual_hid_absolute_pointing_terminate,
+  virtual_hid_absolute_pointing_ready,
+  virtual_hid_absolute_pointing_reset,
+  post_absolute_pointing_input_report,
+  post_pointing_motion,
+  cancel_pointing_motion,
+  sequenced_request,
+  correlated_request,
+  post_text,
 };
 } // namespace virtual_hid_device_service
 } // namespace driverkit
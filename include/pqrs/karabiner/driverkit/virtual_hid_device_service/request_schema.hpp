@@ -0,0 +1,393 @@
+#pragma once
+
+// (C) Copyright Takayama Fumihiko 2020.
+// Distributed under the Boost Software License, Version 1.0.
+// (See https://www.boost.org/LICENSE_1_0.txt)
+
+#include "../virtual_hid_device_driver/hid_report/absolute_pointing_input.hpp"
+#include "../virtual_hid_device_driver/hid_report/apple_vendor_keyboard_input.hpp"
+#include "../virtual_hid_device_driver/hid_report/apple_vendor_top_case_input.hpp"
+#include "../virtual_hid_device_driver/hid_report/consumer_input.hpp"
+#include "../virtual_hid_device_driver/hid_report/keyboard_bitmap_input.hpp"
+#include "../virtual_hid_device_driver/hid_report/keyboard_input.hpp"
+#include "../virtual_hid_device_driver/hid_report/pointing_high_resolution_input.hpp"
+#include "../virtual_hid_device_driver/hid_report/pointing_input.hpp"
+#include "constants.hpp"
+#include "pointing_motion.hpp"
+#include "request.hpp"
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace pqrs {
+namespace karabiner {
+namespace driverkit {
+namespace virtual_hid_device_service {
+namespace request_schema {
+
+//
+// Wire format: uint8_t request, payload_t<request>
+//
+// The client encoders and the server decoder are generated from `payload`.
+//
+// `request::sequenced_request` wraps another message with a sequence number:
+// uint8_t request::sequenced_request, uint64_t sequence, uint8_t request, payload_t<request>
+//
+// `request::correlated_request` wraps another message with a correlation id in the same layout.
+// The server wraps the response with the correlation id. (See `response::correlated_result`.)
+//
+// `request::post_text` has a variable-length UTF-8 text (up to `max_text_size` bytes):
+// uint8_t request::post_text, char text[]
+//
+
+// The request has no payload.
+struct no_payload final {};
+
+// The request has arbitrary bytes which are ignored by the server. (e.g., markers of tools)
+struct ignored_payload final {};
+
+// The request wraps another message.
+// `message` points into the decoded buffer.
+struct sequenced_payload final {
+  uint64_t sequence;
+  const uint8_t* message;
+  size_t message_size;
+};
+
+struct correlated_payload final {
+  uint64_t correlation_id;
+  const uint8_t* message;
+  size_t message_size;
+};
+
+// The request has a variable-length text.
+// `text` points into the decoded buffer.
+struct text_payload final {
+  const char* text;
+  size_t text_size;
+};
+
+template <request R>
+struct payload final {
+  using type = no_payload;
+};
+
+template <>
+struct payload<request::none> final {
+  using type = ignored_payload;
+};
+
+template <>
+struct payload<request::virtual_hid_keyboard_initialize> final {
+  // The value of `pqrs::hid::country_code::value_t`.
+  using type = uint64_t;
+};
+
+template <>
+struct payload<request::post_keyboard_input_report> final {
+  using type = virtual_hid_device_driver::hid_report::keyboard_input;
+};
+
+template <>
+struct payload<request::post_consumer_input_report> final {
+  using type = virtual_hid_device_driver::hid_report::consumer_input;
+};
+
+template <>
+struct payload<request::post_apple_vendor_keyboard_input_report> final {
+  using type = virtual_hid_device_driver::hid_report::apple_vendor_keyboard_input;
+};
+
+template <>
+struct payload<request::post_apple_vendor_top_case_input_report> final {
+  using type = virtual_hid_device_driver::hid_report::apple_vendor_top_case_input;
+};
+
+template <>
+struct payload<request::post_pointing_input_report> final {
+  using type = virtual_hid_device_driver::hid_report::pointing_input;
+};
+
+template <>
+struct payload<request::post_keyboard_bitmap_input_report> final {
+  using type = virtual_hid_device_driver::hid_report::keyboard_bitmap_input;
+};
+
+template <>
+struct payload<request::post_pointing_high_resolution_input_report> final {
+  using type = virtual_hid_device_driver::hid_report::pointing_high_resolution_input;
+};
+
+template <>
+struct payload<request::post_absolute_pointing_input_report> final {
+  using type = virtual_hid_device_driver::hid_report::absolute_pointing_input;
+};
+
+template <>
+struct payload<request::post_pointing_motion> final {
+  using type = pointing_motion;
+};
+
+template <>
+struct payload<request::sequenced_request> final {
+  using type = sequenced_payload;
+};
+
+template <>
+struct payload<request::correlated_request> final {
+  using type = correlated_payload;
+};
+
+template <>
+struct payload<request::post_text> final {
+  using type = text_payload;
+};
+
+template <request R>
+using payload_t = typename payload<R>::type;
+
+template <request R>
+constexpr bool is_sequenced = std::is_same_v<payload_t<R>, sequenced_payload>;
+
+template <request R>
+constexpr bool is_correlated = std::is_same_v<payload_t<R>, correlated_payload>;
+
+// The request wraps another message.
+template <request R>
+constexpr bool is_wrapped = is_sequenced<R> || is_correlated<R>;
+
+template <request R>
+constexpr bool is_text = std::is_same_v<payload_t<R>, text_payload>;
+
+// The request has a fixed-size payload.
+template <request R>
+constexpr bool has_payload = !std::is_same_v<payload_t<R>, no_payload> &&
+                             !std::is_same_v<payload_t<R>, ignored_payload> &&
+                             !is_wrapped<R> &&
+                             !is_text<R>;
+
+template <request R>
+constexpr size_t payload_size = has_payload<R> ? sizeof(payload_t<R>) : 0;
+
+template <request R>
+constexpr size_t message_size = 1 + payload_size<R>;
+
+// Update when a request is appended.
+constexpr request last_request = request::post_text;
+constexpr size_t request_count = static_cast<size_t>(last_request) + 1;
+
+//
+// Compile-time checks
+//
+
+template <request R>
+constexpr bool valid_payload(void) {
+  static_assert(std::is_trivially_copyable_v<payload_t<R>>,
+                "payload must be trivially copyable");
+  static_assert(message_size<R> <= constants::local_datagram_buffer_size,
+                "payload exceeds local_datagram_buffer_size");
+  return true;
+}
+
+template <size_t... I>
+constexpr bool valid_payloads(std::index_sequence<I...>) {
+  return (valid_payload<static_cast<request>(I)>() && ...);
+}
+
+static_assert(valid_payloads(std::make_index_sequence<request_count>()));
+
+//
+// Encoder
+//
+
+template <request R>
+std::vector<uint8_t> encode(void) {
+  static_assert(!has_payload<R> && !is_wrapped<R> && !is_text<R>, "payload is required");
+
+  return std::vector<uint8_t>{
+      static_cast<std::underlying_type_t<request>>(R),
+  };
+}
+
+template <request R>
+std::vector<uint8_t> encode(const payload_t<R>& payload) {
+  static_assert(has_payload<R>, "the request has no payload");
+
+  std::vector<uint8_t> buffer(message_size<R>);
+  buffer[0] = static_cast<std::underlying_type_t<request>>(R);
+  memcpy(&(buffer[1]), &payload, sizeof(payload));
+  return buffer;
+}
+
+// `encode_array` encodes into a fixed-size array without heap allocation.
+
+template <request R>
+std::array<uint8_t, message_size<R>> encode_array(void) {
+  static_assert(!has_payload<R> && !is_wrapped<R> && !is_text<R>, "payload is required");
+
+  return std::array<uint8_t, message_size<R>>{
+      static_cast<std::underlying_type_t<request>>(R),
+  };
+}
+
+template <request R>
+std::array<uint8_t, message_size<R>> encode_array(const payload_t<R>& payload) {
+  static_assert(has_payload<R>, "the request has no payload");
+
+  std::array<uint8_t, message_size<R>> buffer;
+  buffer[0] = static_cast<std::underlying_type_t<request>>(R);
+  memcpy(&(buffer[1]), &payload, sizeof(payload));
+  return buffer;
+}
+
+constexpr size_t sequenced_header_size = 1 + sizeof(uint64_t);
+
+// The text fits a sequenced message.
+constexpr size_t max_text_size = constants::local_datagram_buffer_size - sequenced_header_size - 1;
+
+// `text` must not be longer than `max_text_size`.
+template <request R>
+std::vector<uint8_t> encode_text(std::string_view text) {
+  static_assert(is_text<R>, "the request has no text");
+
+  std::vector<uint8_t> buffer(1 + text.size());
+  buffer[0] = static_cast<std::underlying_type_t<request>>(R);
+  if (!text.empty()) {
+    memcpy(&(buffer[1]), text.data(), text.size());
+  }
+  return buffer;
+}
+
+template <request R>
+std::vector<uint8_t> encode_sequenced(uint64_t sequence) {
+  static_assert(!has_payload<R> && !is_wrapped<R> && !is_text<R>, "payload is required");
+
+  std::vector<uint8_t> buffer(sequenced_header_size + message_size<R>);
+  buffer[0] = static_cast<std::underlying_type_t<request>>(request::sequenced_request);
+  memcpy(&(buffer[1]), &sequence, sizeof(sequence));
+  buffer[sequenced_header_size] = static_cast<std::underlying_type_t<request>>(R);
+  return buffer;
+}
+
+template <request R>
+std::vector<uint8_t> encode_sequenced(uint64_t sequence, const payload_t<R>& payload) {
+  static_assert(has_payload<R>, "the request has no payload");
+
+  std::vector<uint8_t> buffer(sequenced_header_size + message_size<R>);
+  buffer[0] = static_cast<std::underlying_type_t<request>>(request::sequenced_request);
+  memcpy(&(buffer[1]), &sequence, sizeof(sequence));
+  buffer[sequenced_header_size] = static_cast<std::underlying_type_t<request>>(R);
+  memcpy(&(buffer[sequenced_header_size + 1]), &payload, sizeof(payload));
+  return buffer;
+}
+
+// Wraps an encoded message. (e.g., `encode_text`)
+inline std::vector<uint8_t> encode_sequenced_message(uint64_t sequence, const std::vector<uint8_t>& message) {
+  std::vector<uint8_t> buffer(sequenced_header_size + message.size());
+  buffer[0] = static_cast<std::underlying_type_t<request>>(request::sequenced_request);
+  memcpy(&(buffer[1]), &sequence, sizeof(sequence));
+  if (!message.empty()) {
+    memcpy(&(buffer[sequenced_header_size]), message.data(), message.size());
+  }
+  return buffer;
+}
+
+constexpr size_t correlated_header_size = 1 + sizeof(uint64_t);
+
+template <request R>
+std::vector<uint8_t> encode_correlated(uint64_t correlation_id) {
+  static_assert(!has_payload<R> && !is_wrapped<R> && !is_text<R>, "payload is required");
+
+  std::vector<uint8_t> buffer(correlated_header_size + message_size<R>);
+  buffer[0] = static_cast<std::underlying_type_t<request>>(request::correlated_request);
+  memcpy(&(buffer[1]), &correlation_id, sizeof(correlation_id));
+  buffer[correlated_header_size] = static_cast<std::underlying_type_t<request>>(R);
+  return buffer;
+}
+
+//
+// Decoder
+//
+
+enum class decode_result {
+  ok,
+  empty,
+  unknown_request,
+  size_mismatch,
+};
+
+namespace impl {
+template <request R, typename Handler>
+bool decode(Handler& handler, const uint8_t* p, size_t size) {
+  using T = payload_t<R>;
+
+  if constexpr (std::is_same_v<T, ignored_payload>) {
+    handler(std::integral_constant<request, R>(), T());
+  } else if constexpr (is_wrapped<R>) {
+    // The wrapped message is decoded by the handler.
+    if (size < sizeof(uint64_t) + 1) {
+      return false;
+    }
+    uint64_t value;
+    memcpy(&value, p, sizeof(value));
+    handler(std::integral_constant<request, R>(), T{value, p + sizeof(uint64_t), size - sizeof(uint64_t)});
+  } else if constexpr (is_text<R>) {
+    if (size > max_text_size) {
+      return false;
+    }
+    handler(std::integral_constant<request, R>(), T{reinterpret_cast<const char*>(p), size});
+  } else if constexpr (std::is_same_v<T, no_payload>) {
+    if (size != 0) {
+      return false;
+    }
+    handler(std::integral_constant<request, R>(), T());
+  } else {
+    if (size != sizeof(T)) {
+      return false;
+    }
+    T payload;
+    memcpy(&payload, p, sizeof(T));
+    handler(std::integral_constant<request, R>(), payload);
+  }
+  return true;
+}
+
+template <typename Handler, size_t... I>
+constexpr auto make_jump_table(std::index_sequence<I...>) {
+  return std::array<bool (*)(Handler&, const uint8_t*, size_t), sizeof...(I)>{{
+      &decode<static_cast<request>(I), Handler>...,
+  }};
+}
+} // namespace impl
+
+// `handler` is called as `handler(std::integral_constant<request, R>, const payload_t<R>&)`.
+template <typename Handler>
+decode_result decode(const uint8_t* buffer, size_t size, Handler&& handler) {
+  using handler_t = std::remove_reference_t<Handler>;
+  static constexpr auto jump_table = impl::make_jump_table<handler_t>(std::make_index_sequence<request_count>());
+
+  if (size == 0) {
+    return decode_result::empty;
+  }
+
+  auto index = static_cast<size_t>(buffer[0]);
+  if (index >= request_count) {
+    return decode_result::unknown_request;
+  }
+
+  if (!jump_table[index](handler, buffer + 1, size - 1)) {
+    return decode_result::size_mismatch;
+  }
+
+  return decode_result::ok;
+}
+
+} // namespace request_schema
+} // namespace virtual_hid_device_service
+} // namespace driverkit
+} // namespace karabiner
+} // namespace pqrs
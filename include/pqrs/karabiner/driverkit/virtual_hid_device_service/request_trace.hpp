@@ -0,0 +1,313 @@
+#pragma once
+
+// (C) Copyright Takayama Fumihiko 2020.
+// Distributed under the Boost Software License, Version 1.0.
+// (See https://www.boost.org/LICENSE_1_0.txt)
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <system_error>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+
+namespace pqrs {
+namespace karabiner {
+namespace driverkit {
+namespace virtual_hid_device_service {
+namespace request_trace {
+
+//
+// Trace file layout
+//
+// file_header
+// record_header, uint8_t[record_header::size]
+// record_header, uint8_t[record_header::size]
+// ...
+//
+// `file_header::end_offset` is updated after each record is written.
+// Bytes after `end_offset` are preallocated space and must be ignored.
+//
+
+constexpr char magic[8] = {'K', 'V', 'H', 'D', 'T', 'R', 'C', '\0'};
+constexpr uint32_t version = 1;
+
+struct __attribute__((packed)) file_header final {
+  char magic[8];
+  uint32_t version;
+  uint32_t reserved;
+  uint64_t end_offset;
+};
+
+struct __attribute__((packed)) record_header final {
+  // Nanoseconds of `std::chrono::steady_clock`.
+  uint64_t timestamp;
+  // Senders are numbered in order of appearance.
+  uint32_t sender_id;
+  uint32_t size;
+};
+
+struct record final {
+  std::chrono::nanoseconds timestamp;
+  uint32_t sender_id;
+  const uint8_t* data;
+  size_t size;
+};
+
+class writer final {
+public:
+  writer(const writer&) = delete;
+
+  writer(size_t chunk_size = 1024 * 1024) : chunk_size_(chunk_size),
+                                            fd_(-1),
+                                            address_(nullptr),
+                                            mapped_size_(0) {
+  }
+
+  ~writer(void) {
+    close();
+  }
+
+  bool is_open(void) const {
+    return address_ != nullptr;
+  }
+
+  std::error_code open(const std::filesystem::path& file_path) {
+    close();
+
+    fd_ = ::open(file_path.c_str(), O_RDWR | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
+    if (fd_ < 0) {
+      return std::error_code(errno, std::generic_category());
+    }
+
+    if (auto error_code = remap(chunk_size_)) {
+      close();
+      return error_code;
+    }
+
+    auto h = header();
+    memcpy(h->magic, magic, sizeof(magic));
+    h->version = version;
+    h->reserved = 0;
+    h->end_offset = sizeof(file_header);
+
+    return std::error_code();
+  }
+
+  void close(void) {
+    uint64_t end_offset = 0;
+
+    if (address_) {
+      end_offset = header()->end_offset;
+
+      munmap(address_, mapped_size_);
+      address_ = nullptr;
+      mapped_size_ = 0;
+    }
+
+    if (fd_ >= 0) {
+      // Remove the preallocated space.
+      if (end_offset > 0) {
+        if (ftruncate(fd_, static_cast<off_t>(end_offset)) != 0) {
+          // The trace is still readable because `file_header::end_offset` is valid.
+        }
+      }
+
+      ::close(fd_);
+      fd_ = -1;
+    }
+
+    sender_ids_.clear();
+  }
+
+  std::error_code append(std::chrono::nanoseconds timestamp,
+                         const std::string& sender,
+                         const uint8_t* p,
+                         size_t size) {
+    if (!address_) {
+      return std::make_error_code(std::errc::bad_file_descriptor);
+    }
+
+    auto offset = header()->end_offset;
+    auto new_end_offset = offset + sizeof(record_header) + size;
+
+    if (new_end_offset > mapped_size_) {
+      auto new_size = std::max(mapped_size_ * 2, static_cast<size_t>(new_end_offset));
+      if (auto error_code = remap(new_size)) {
+        return error_code;
+      }
+    }
+
+    record_header rh;
+    rh.timestamp = static_cast<uint64_t>(timestamp.count());
+    rh.sender_id = get_sender_id(sender);
+    rh.size = static_cast<uint32_t>(size);
+
+    memcpy(address_ + offset, &rh, sizeof(rh));
+    if (p && size > 0) {
+      memcpy(address_ + offset + sizeof(rh), p, size);
+    }
+
+    header()->end_offset = new_end_offset;
+
+    return std::error_code();
+  }
+
+private:
+  file_header* header(void) const {
+    return reinterpret_cast<file_header*>(address_);
+  }
+
+  std::error_code remap(size_t size) {
+    if (ftruncate(fd_, static_cast<off_t>(size)) != 0) {
+      return std::error_code(errno, std::generic_category());
+    }
+
+    if (address_) {
+      munmap(address_, mapped_size_);
+      address_ = nullptr;
+      mapped_size_ = 0;
+    }
+
+    auto a = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (a == MAP_FAILED) {
+      return std::error_code(errno, std::generic_category());
+    }
+
+    address_ = static_cast<uint8_t*>(a);
+    mapped_size_ = size;
+
+    return std::error_code();
+  }
+
+  uint32_t get_sender_id(const std::string& sender) {
+    auto it = sender_ids_.find(sender);
+    if (it != std::end(sender_ids_)) {
+      return it->second;
+    }
+
+    auto id = static_cast<uint32_t>(sender_ids_.size());
+    sender_ids_[sender] = id;
+    return id;
+  }
+
+  size_t chunk_size_;
+  int fd_;
+  uint8_t* address_;
+  size_t mapped_size_;
+  std::unordered_map<std::string, uint32_t> sender_ids_;
+};
+
+class reader final {
+public:
+  reader(const reader&) = delete;
+
+  reader(void) : address_(nullptr),
+                 mapped_size_(0) {
+  }
+
+  ~reader(void) {
+    close();
+  }
+
+  std::error_code open(const std::filesystem::path& file_path) {
+    close();
+
+    auto fd = ::open(file_path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      return std::error_code(errno, std::generic_category());
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+      auto error_code = std::error_code(errno, std::generic_category());
+      ::close(fd);
+      return error_code;
+    }
+
+    if (static_cast<size_t>(st.st_size) < sizeof(file_header)) {
+      ::close(fd);
+      return std::make_error_code(std::errc::invalid_argument);
+    }
+
+    auto a = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (a == MAP_FAILED) {
+      return std::error_code(errno, std::generic_category());
+    }
+
+    address_ = static_cast<const uint8_t*>(a);
+    mapped_size_ = st.st_size;
+
+    auto h = reinterpret_cast<const file_header*>(address_);
+    if (memcmp(h->magic, magic, sizeof(magic)) != 0 ||
+        h->version != version ||
+        h->end_offset > mapped_size_) {
+      close();
+      return std::make_error_code(std::errc::invalid_argument);
+    }
+
+    size_t offset = sizeof(file_header);
+    while (offset + sizeof(record_header) <= h->end_offset) {
+      record_header rh;
+      memcpy(&rh, address_ + offset, sizeof(rh));
+      offset += sizeof(rh);
+
+      if (offset + rh.size > h->end_offset) {
+        break;
+      }
+
+      records_.push_back(record{
+          std::chrono::nanoseconds(rh.timestamp),
+          rh.sender_id,
+          address_ + offset,
+          rh.size,
+      });
+
+      offset += rh.size;
+    }
+
+    return std::error_code();
+  }
+
+  void close(void) {
+    records_.clear();
+
+    if (address_) {
+      munmap(const_cast<uint8_t*>(address_), mapped_size_);
+      address_ = nullptr;
+      mapped_size_ = 0;
+    }
+  }
+
+  // The returned records are valid until `close`.
+  const std::vector<record>& get_records(void) const {
+    return records_;
+  }
+
+  uint32_t sender_count(void) const {
+    uint32_t result = 0;
+    for (const auto& r : records_) {
+      result = std::max(result, r.sender_id + 1);
+    }
+    return result;
+  }
+
+private:
+  const uint8_t* address_;
+  size_t mapped_size_;
+  std::vector<record> records_;
+};
+
+} // namespace request_trace
+} // namespace virtual_hid_device_service
+} // namespace driverkit
+} // namespace karabiner
+} // namespace pqrs
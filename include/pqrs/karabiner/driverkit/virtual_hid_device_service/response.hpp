@@ -4,6 +4,8 @@
 // Distributed under the Boost Software License, Version 1.0.
 // (See https://www.boost.org/LICENSE_1_0.txt)
 
+#include <cstddef>
+#include <cstdint>
 #include <string_view>
 
 namespace pqrs {
@@ -16,7 +18,41 @@ enum class response : uint8_t {
   driver_version_matched_result,
   virtual_hid_keyboard_ready_result,
   virtual_hid_pointing_ready_result,
+  virtual_hid_absolute_pointing_ready_result,
+  report_ack,
+  // The response of `request::correlated_request`:
+  // uint8_t response::correlated_result, uint64_t correlation_id, uint8_t response, ...
+  correlated_result,
+  // The response of `request::post_text`:
+  // uint8_t response::post_text_result, post_text_result_payload, post_text_unmapped_character[]
+  post_text_result,
 };
+
+// The payload of `response::report_ack`.
+struct __attribute__((packed)) report_ack_payload final {
+  // All sequenced requests whose sequence <= `sequence` are completed.
+  uint64_t sequence;
+  // The client can send sequenced requests whose sequence <= `sequence + credits`.
+  uint32_t credits;
+};
+
+// The payload of `response::post_text_result`.
+struct __attribute__((packed)) post_text_result_payload final {
+  // The number of characters which are typed.
+  uint32_t mapped_characters;
+  // The number of characters which cannot be typed with the keyboard layout.
+  // Only the first `max_reported_unmapped_characters` characters follow the payload.
+  uint32_t unmapped_characters;
+};
+
+struct __attribute__((packed)) post_text_unmapped_character final {
+  // The byte offset in the UTF-8 text.
+  uint32_t offset;
+  // The code point. (U+FFFD for invalid UTF-8 sequences)
+  uint32_t character;
+};
+
+constexpr size_t max_reported_unmapped_characters = 64;
 } // namespace virtual_hid_device_service
 } // namespace driverkit
 } // namespace karabiner
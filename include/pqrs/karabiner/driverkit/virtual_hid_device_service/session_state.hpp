@@ -0,0 +1,129 @@
+#pragma once
+
+// (C) Copyright Takayama Fumihiko 2020.
+// Distributed under the Boost Software License, Version 1.0.
+// (See https://www.boost.org/LICENSE_1_0.txt)
+
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <optional>
+#include <sys/stat.h>
+#include <system_error>
+#include <unistd.h>
+
+namespace pqrs {
+namespace karabiner {
+namespace driverkit {
+namespace virtual_hid_device_service {
+namespace session_state {
+
+//
+// The virtual devices which are initialized by clients.
+// The server saves it whenever it is changed and restores the devices at startup.
+//
+
+constexpr char magic[8] = {'K', 'V', 'H', 'D', 'S', 'E', 'S', '\0'};
+constexpr uint32_t version = 1;
+
+struct __attribute__((packed)) file_body final {
+  char magic[8];
+  uint32_t version;
+  uint8_t virtual_hid_keyboard_initialized;
+  uint8_t virtual_hid_pointing_initialized;
+  uint8_t virtual_hid_absolute_pointing_initialized;
+  uint8_t reserved;
+  uint64_t virtual_hid_keyboard_country_code;
+};
+
+struct state final {
+  // The value of `pqrs::hid::country_code::value_t`.
+  // std::nullopt means the keyboard is not initialized.
+  std::optional<uint64_t> virtual_hid_keyboard_country_code;
+  bool virtual_hid_pointing_initialized = false;
+  bool virtual_hid_absolute_pointing_initialized = false;
+
+  bool operator==(const state& other) const {
+    return virtual_hid_keyboard_country_code == other.virtual_hid_keyboard_country_code &&
+           virtual_hid_pointing_initialized == other.virtual_hid_pointing_initialized &&
+           virtual_hid_absolute_pointing_initialized == other.virtual_hid_absolute_pointing_initialized;
+  }
+
+  bool operator!=(const state& other) const {
+    return !(*this == other);
+  }
+};
+
+// Write to a temporary file and rename it in order to avoid a partially written file.
+inline std::error_code save(const std::filesystem::path& file_path,
+                            const state& s) {
+  file_body body;
+  memset(&body, 0, sizeof(body));
+  memcpy(body.magic, magic, sizeof(magic));
+  body.version = version;
+  body.virtual_hid_keyboard_initialized = s.virtual_hid_keyboard_country_code != std::nullopt;
+  body.virtual_hid_pointing_initialized = s.virtual_hid_pointing_initialized;
+  body.virtual_hid_absolute_pointing_initialized = s.virtual_hid_absolute_pointing_initialized;
+  body.virtual_hid_keyboard_country_code = s.virtual_hid_keyboard_country_code.value_or(0);
+
+  auto tmp_file_path = file_path;
+  tmp_file_path += ".tmp";
+
+  auto fd = ::open(tmp_file_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
+  if (fd < 0) {
+    return std::error_code(errno, std::generic_category());
+  }
+
+  std::error_code error_code;
+  if (::write(fd, &body, sizeof(body)) != static_cast<ssize_t>(sizeof(body))) {
+    error_code = std::error_code(errno ? errno : EIO, std::generic_category());
+  } else if (::fsync(fd) != 0) {
+    error_code = std::error_code(errno, std::generic_category());
+  }
+
+  ::close(fd);
+
+  if (!error_code) {
+    std::filesystem::rename(tmp_file_path, file_path, error_code);
+  }
+
+  if (error_code) {
+    std::error_code e;
+    std::filesystem::remove(tmp_file_path, e);
+  }
+
+  return error_code;
+}
+
+// Returns std::nullopt if the file does not exist or is broken.
+inline std::optional<state> load(const std::filesystem::path& file_path) {
+  auto fd = ::open(file_path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return std::nullopt;
+  }
+
+  file_body body;
+  auto n = ::read(fd, &body, sizeof(body));
+  ::close(fd);
+
+  if (n != static_cast<ssize_t>(sizeof(body)) ||
+      memcmp(body.magic, magic, sizeof(magic)) != 0 ||
+      body.version != version) {
+    return std::nullopt;
+  }
+
+  state result;
+  if (body.virtual_hid_keyboard_initialized) {
+    result.virtual_hid_keyboard_country_code = static_cast<uint64_t>(body.virtual_hid_keyboard_country_code);
+  }
+  result.virtual_hid_pointing_initialized = body.virtual_hid_pointing_initialized;
+  result.virtual_hid_absolute_pointing_initialized = body.virtual_hid_absolute_pointing_initialized;
+  return result;
+}
+
+} // namespace session_state
+} // namespace virtual_hid_device_service
+} // namespace driverkit
+} // namespace karabiner
+} // namespace pqrs
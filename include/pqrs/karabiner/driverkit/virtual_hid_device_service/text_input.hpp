@@ -0,0 +1,412 @@
+#pragma once
+
+// (C) Copyright Takayama Fumihiko 2020.
+// Distributed under the Boost Software License, Version 1.0.
+// (See https://www.boost.org/LICENSE_1_0.txt)
+
+#include "../virtual_hid_device_driver/hid_report/keyboard_input.hpp"
+#include "../virtual_hid_device_driver/hid_report/modifier.hpp"
+#include "perfect_hash.hpp"
+#include "response.hpp"
+#include <array>
+#include <cstdint>
+#include <pqrs/hid.hpp>
+#include <string_view>
+#include <vector>
+
+namespace pqrs {
+namespace karabiner {
+namespace driverkit {
+namespace virtual_hid_device_service {
+namespace text_input {
+
+//
+// Expands a UTF-8 text into keyboard reports. (`request::post_text`)
+//
+// Characters are mapped to a usage and modifiers with a per-layout table which is built at compile time.
+// The layout is chosen by the country code of the virtual keyboard,
+// and the table assumes that the input source matches the layout (e.g., "U.S.", "German", "Japanese - Romaji").
+// Dead keys and input methods are not supported.
+//
+
+enum class layout {
+  us,
+  german,
+  japanese,
+};
+
+// Country codes without a table use the US layout.
+constexpr layout find_layout(hid::country_code::value_t country_code) {
+  if (country_code == hid::country_code::german) {
+    return layout::german;
+  }
+  if (country_code == hid::country_code::japan) {
+    return layout::japanese;
+  }
+  return layout::us;
+}
+
+struct character_entry final {
+  char32_t character;
+  // A usage of `usage_page::keyboard_or_keypad`.
+  uint8_t usage;
+  // `hid_report::modifier` bits.
+  uint8_t modifiers;
+};
+
+namespace impl {
+constexpr uint8_t none = 0;
+constexpr uint8_t shift = static_cast<uint8_t>(virtual_hid_device_driver::hid_report::modifier::left_shift);
+constexpr uint8_t option = static_cast<uint8_t>(virtual_hid_device_driver::hid_report::modifier::left_option);
+
+constexpr uint8_t get_usage(hid::usage::value_t usage) {
+  return static_cast<uint8_t>(type_safe::get(usage));
+}
+
+// Letters, digits, space, tab and return, which are shared by all layouts.
+// `qwertz` swaps Y and Z.
+constexpr std::array<character_entry, 65> make_common_entries(bool qwertz) {
+  std::array<character_entry, 65> entries{};
+  size_t i = 0;
+
+  for (char32_t c = 0; c < 26; ++c) {
+    auto usage = static_cast<uint8_t>(get_usage(hid::usage::keyboard_or_keypad::keyboard_a) + c);
+    if (qwertz && c == U'y' - U'a') {
+      usage = get_usage(hid::usage::keyboard_or_keypad::keyboard_z);
+    } else if (qwertz && c == U'z' - U'a') {
+      usage = get_usage(hid::usage::keyboard_or_keypad::keyboard_y);
+    }
+
+    entries[i++] = {U'a' + c, usage, none};
+    entries[i++] = {U'A' + c, usage, shift};
+  }
+
+  // keyboard_1 ... keyboard_9, keyboard_0
+  for (char32_t c = 0; c < 10; ++c) {
+    entries[i++] = {c == 9 ? U'0' : U'1' + c,
+                    static_cast<uint8_t>(get_usage(hid::usage::keyboard_or_keypad::keyboard_1) + c),
+                    none};
+  }
+
+  entries[i++] = {U' ', get_usage(hid::usage::keyboard_or_keypad::keyboard_spacebar), none};
+  entries[i++] = {U'\t', get_usage(hid::usage::keyboard_or_keypad::keyboard_tab), none};
+  entries[i++] = {U'\n', get_usage(hid::usage::keyboard_or_keypad::keyboard_return_or_enter), none};
+
+  return entries;
+}
+
+// Maps a key of the number row to the usage.
+constexpr uint8_t digit(int number) {
+  return static_cast<uint8_t>(get_usage(hid::usage::keyboard_or_keypad::keyboard_1) + (number == 0 ? 9 : number - 1));
+}
+
+template <size_t N, size_t M>
+constexpr std::array<character_entry, N + M> concat(const std::array<character_entry, N>& a,
+                                                    const std::array<character_entry, M>& b) {
+  std::array<character_entry, N + M> entries{};
+  for (size_t i = 0; i < N; ++i) {
+    entries[i] = a[i];
+  }
+  for (size_t i = 0; i < M; ++i) {
+    entries[N + i] = b[i];
+  }
+  return entries;
+}
+
+namespace kb = hid::usage::keyboard_or_keypad;
+
+constexpr std::array<character_entry, 32> us_symbol_entries{{
+    {U'!', digit(1), shift},
+    {U'@', digit(2), shift},
+    {U'#', digit(3), shift},
+    {U'$', digit(4), shift},
+    {U'%', digit(5), shift},
+    {U'^', digit(6), shift},
+    {U'&', digit(7), shift},
+    {U'*', digit(8), shift},
+    {U'(', digit(9), shift},
+    {U')', digit(0), shift},
+    {U'-', get_usage(kb::keyboard_hyphen), none},
+    {U'_', get_usage(kb::keyboard_hyphen), shift},
+    {U'=', get_usage(kb::keyboard_equal_sign), none},
+    {U'+', get_usage(kb::keyboard_equal_sign), shift},
+    {U'[', get_usage(kb::keyboard_open_bracket), none},
+    {U'{', get_usage(kb::keyboard_open_bracket), shift},
+    {U']', get_usage(kb::keyboard_close_bracket), none},
+    {U'}', get_usage(kb::keyboard_close_bracket), shift},
+    {U'\\', get_usage(kb::keyboard_backslash), none},
+    {U'|', get_usage(kb::keyboard_backslash), shift},
+    {U';', get_usage(kb::keyboard_semicolon), none},
+    {U':', get_usage(kb::keyboard_semicolon), shift},
+    {U'\'', get_usage(kb::keyboard_quote), none},
+    {U'"', get_usage(kb::keyboard_quote), shift},
+    {U'`', get_usage(kb::keyboard_grave_accent_and_tilde), none},
+    {U'~', get_usage(kb::keyboard_grave_accent_and_tilde), shift},
+    {U',', get_usage(kb::keyboard_comma), none},
+    {U'<', get_usage(kb::keyboard_comma), shift},
+    {U'.', get_usage(kb::keyboard_period), none},
+    {U'>', get_usage(kb::keyboard_period), shift},
+    {U'/', get_usage(kb::keyboard_slash), none},
+    {U'?', get_usage(kb::keyboard_slash), shift},
+}};
+
+// Keys whose characters depend on the keyboard type (e.g., `<` on ISO keyboards) are omitted.
+constexpr std::array<character_entry, 36> german_symbol_entries{{
+    {U'!', digit(1), shift},
+    {U'"', digit(2), shift},
+    {U'\u00a7', digit(3), shift}, // §
+    {U'$', digit(4), shift},
+    {U'%', digit(5), shift},
+    {U'&', digit(6), shift},
+    {U'/', digit(7), shift},
+    {U'(', digit(8), shift},
+    {U')', digit(9), shift},
+    {U'=', digit(0), shift},
+    {U'\u00df', get_usage(kb::keyboard_hyphen), none}, // ß
+    {U'?', get_usage(kb::keyboard_hyphen), shift},
+    {U'\u00fc', get_usage(kb::keyboard_open_bracket), none},  // ü
+    {U'\u00dc', get_usage(kb::keyboard_open_bracket), shift}, // Ü
+    {U'+', get_usage(kb::keyboard_close_bracket), none},
+    {U'*', get_usage(kb::keyboard_close_bracket), shift},
+    {U'#', get_usage(kb::keyboard_backslash), none},
+    {U'\'', get_usage(kb::keyboard_backslash), shift},
+    {U'\u00f6', get_usage(kb::keyboard_semicolon), none},  // ö
+    {U'\u00d6', get_usage(kb::keyboard_semicolon), shift}, // Ö
+    {U'\u00e4', get_usage(kb::keyboard_quote), none},      // ä
+    {U'\u00c4', get_usage(kb::keyboard_quote), shift},     // Ä
+    {U',', get_usage(kb::keyboard_comma), none},
+    {U';', get_usage(kb::keyboard_comma), shift},
+    {U'.', get_usage(kb::keyboard_period), none},
+    {U':', get_usage(kb::keyboard_period), shift},
+    {U'-', get_usage(kb::keyboard_slash), none},
+    {U'_', get_usage(kb::keyboard_slash), shift},
+    {U'@', get_usage(kb::keyboard_l), option},
+    {U'\u20ac', get_usage(kb::keyboard_e), option}, // €
+    {U'[', digit(5), option},
+    {U']', digit(6), option},
+    {U'|', digit(7), option},
+    {U'\\', digit(7), static_cast<uint8_t>(shift | option)},
+    {U'{', digit(8), option},
+    {U'}', digit(9), option},
+}};
+
+constexpr std::array<character_entry, 33> japanese_symbol_entries{{
+    {U'!', digit(1), shift},
+    {U'"', digit(2), shift},
+    {U'#', digit(3), shift},
+    {U'$', digit(4), shift},
+    {U'%', digit(5), shift},
+    {U'&', digit(6), shift},
+    {U'\'', digit(7), shift},
+    {U'(', digit(8), shift},
+    {U')', digit(9), shift},
+    {U'-', get_usage(kb::keyboard_hyphen), none},
+    {U'=', get_usage(kb::keyboard_hyphen), shift},
+    {U'^', get_usage(kb::keyboard_equal_sign), none},
+    {U'~', get_usage(kb::keyboard_equal_sign), shift},
+    {U'\u00a5', get_usage(kb::keyboard_international3), none}, // ¥
+    {U'|', get_usage(kb::keyboard_international3), shift},
+    {U'\\', get_usage(kb::keyboard_international3), option},
+    {U'@', get_usage(kb::keyboard_open_bracket), none},
+    {U'`', get_usage(kb::keyboard_open_bracket), shift},
+    {U'[', get_usage(kb::keyboard_close_bracket), none},
+    {U'{', get_usage(kb::keyboard_close_bracket), shift},
+    {U']', get_usage(kb::keyboard_backslash), none},
+    {U'}', get_usage(kb::keyboard_backslash), shift},
+    {U';', get_usage(kb::keyboard_semicolon), none},
+    {U'+', get_usage(kb::keyboard_semicolon), shift},
+    {U':', get_usage(kb::keyboard_quote), none},
+    {U'*', get_usage(kb::keyboard_quote), shift},
+    {U',', get_usage(kb::keyboard_comma), none},
+    {U'<', get_usage(kb::keyboard_comma), shift},
+    {U'.', get_usage(kb::keyboard_period), none},
+    {U'>', get_usage(kb::keyboard_period), shift},
+    {U'/', get_usage(kb::keyboard_slash), none},
+    {U'?', get_usage(kb::keyboard_slash), shift},
+    {U'_', get_usage(kb::keyboard_international1), none},
+}};
+
+constexpr auto us_entries = concat(make_common_entries(false), us_symbol_entries);
+constexpr auto german_entries = concat(make_common_entries(true), german_symbol_entries);
+constexpr auto japanese_entries = concat(make_common_entries(false), japanese_symbol_entries);
+
+constexpr uint64_t hash_character(char32_t character) {
+  return perfect_hash::hash(static_cast<uint64_t>(character));
+}
+
+template <size_t N>
+constexpr auto make_table(const std::array<character_entry, N>& entries) {
+  return perfect_hash::make_table(
+      entries,
+      [](auto&& e) { return hash_character(e.character); },
+      [](auto&&) { return true; });
+}
+
+constexpr auto us_table = make_table(us_entries);
+constexpr auto german_table = make_table(german_entries);
+constexpr auto japanese_table = make_table(japanese_entries);
+
+template <typename Table, size_t N>
+constexpr const character_entry* find(const Table& table,
+                                      const std::array<character_entry, N>& entries,
+                                      char32_t character) {
+  if (auto i = table.find(hash_character(character))) {
+    auto&& e = entries[*i];
+    if (e.character == character) {
+      return &e;
+    }
+  }
+  return nullptr;
+}
+} // namespace impl
+
+// Returns nullptr if the character cannot be typed with the layout.
+constexpr const character_entry* find_character(layout l, char32_t character) {
+  switch (l) {
+    case layout::us:
+      return impl::find(impl::us_table, impl::us_entries, character);
+    case layout::german:
+      return impl::find(impl::german_table, impl::german_entries, character);
+    case layout::japanese:
+      return impl::find(impl::japanese_table, impl::japanese_entries, character);
+  }
+  return nullptr;
+}
+
+constexpr char32_t replacement_character = U'\ufffd';
+
+// Calls `function(char32_t character, size_t offset)` for each character of `text`.
+// Each byte of an invalid sequence (e.g., overlong forms, surrogates) is passed as `replacement_character`.
+template <typename Function>
+void decode_utf8(std::string_view text, Function&& function) {
+  size_t i = 0;
+  while (i < text.size()) {
+    auto offset = i;
+    auto b = static_cast<uint8_t>(text[i]);
+
+    if (b < 0x80) {
+      function(static_cast<char32_t>(b), offset);
+      ++i;
+      continue;
+    }
+
+    size_t length = 0;
+    char32_t character = 0;
+    char32_t min = 0;
+    if ((b & 0xe0) == 0xc0) {
+      length = 2;
+      character = b & 0x1f;
+      min = 0x80;
+    } else if ((b & 0xf0) == 0xe0) {
+      length = 3;
+      character = b & 0x0f;
+      min = 0x800;
+    } else if ((b & 0xf8) == 0xf0) {
+      length = 4;
+      character = b & 0x07;
+      min = 0x10000;
+    }
+
+    bool valid = length > 0 && i + length <= text.size();
+    for (size_t j = 1; valid && j < length; ++j) {
+      auto c = static_cast<uint8_t>(text[i + j]);
+      if ((c & 0xc0) != 0x80) {
+        valid = false;
+      }
+      character = (character << 6) | (c & 0x3f);
+    }
+
+    if (valid &&
+        character >= min &&
+        character <= 0x10ffff &&
+        !(0xd800 <= character && character <= 0xdfff)) {
+      function(character, offset);
+      i += length;
+    } else {
+      function(replacement_character, offset);
+      ++i;
+    }
+  }
+}
+
+// Generates `keyboard_input` reports of a text.
+// Each character is a key down report and a key up report.
+// Modifiers are kept pressed while the following characters use the same modifiers,
+// and they are released by the last report.
+// A modifier change is sent as a modifier-only report before the key down.
+//
+// Each report replaces the whole keyboard input state (`keyboard_input` report).
+class text_synthesizer final {
+public:
+  text_synthesizer(layout l, std::string_view text) : index_(0),
+                                                      key_down_(false),
+                                                      modifiers_(0) {
+    decode_utf8(text, [this, l](auto&& character, auto&& offset) {
+      if (auto e = find_character(l, character)) {
+        keystrokes_.push_back(*e);
+      } else {
+        unmapped_characters_.push_back({static_cast<uint32_t>(offset),
+                                        static_cast<uint32_t>(character)});
+      }
+    });
+  }
+
+  size_t get_mapped_characters(void) const {
+    return keystrokes_.size();
+  }
+
+  const std::vector<post_text_unmapped_character>& get_unmapped_characters(void) const {
+    return unmapped_characters_;
+  }
+
+  bool finished(void) const {
+    return index_ >= keystrokes_.size() &&
+           modifiers_ == 0;
+  }
+
+  virtual_hid_device_driver::hid_report::keyboard_input next(void) {
+    virtual_hid_device_driver::hid_report::keyboard_input report;
+
+    if (index_ < keystrokes_.size()) {
+      const auto& k = keystrokes_[index_];
+
+      if (!key_down_) {
+        if (modifiers_ != k.modifiers) {
+          // Change modifiers in a separate report before the key down.
+          modifiers_ = k.modifiers;
+        } else {
+          report.keys.insert(k.usage);
+          key_down_ = true;
+        }
+      } else {
+        key_down_ = false;
+        ++index_;
+      }
+    } else {
+      // Release modifiers.
+      modifiers_ = 0;
+    }
+
+    for (int i = 0; i < 8; ++i) {
+      if (modifiers_ & (1 << i)) {
+        report.modifiers.insert(virtual_hid_device_driver::hid_report::modifier(1 << i));
+      }
+    }
+
+    return report;
+  }
+
+private:
+  std::vector<character_entry> keystrokes_;
+  std::vector<post_text_unmapped_character> unmapped_characters_;
+  size_t index_;
+  bool key_down_;
+  // The modifiers of the last report.
+  uint8_t modifiers_;
+};
+
+} // namespace text_input
+} // namespace virtual_hid_device_service
+} // namespace driverkit
+} // namespace karabiner
+} // namespace pqrs
@@ -0,0 +1,145 @@
+#!/usr/bin/python3
+
+# Generate include/pqrs/karabiner/driverkit/virtual_hid_device_service/hid_name_entries.hpp
+# from the vendored pqrs/hid headers and hid_report/modifier.hpp.
+
+import re
+from pathlib import Path
+
+topDirectory = Path(__file__).resolve(True).parents[1]
+hidDirectory = topDirectory.joinpath('src/Client/vendor/cget/pkg/pqrs-org__cpp-hid/install/include/pqrs/hid')
+modifierFilePath = topDirectory.joinpath('include/pqrs/karabiner/driverkit/virtual_hid_device_driver/hid_report/modifier.hpp')
+outputFilePath = topDirectory.joinpath('include/pqrs/karabiner/driverkit/virtual_hid_device_service/hid_name_entries.hpp')
+
+valuePattern = re.compile(r'^constexpr value_t (\w+)\((0x[0-9a-fA-F]+)\);')
+
+#
+# usage_page
+#
+
+usagePages = []
+with hidDirectory.joinpath('usage_page.hpp').open() as f:
+    for line in f:
+        m = valuePattern.match(line)
+        if m:
+            usagePages.append((m.group(1), int(m.group(2), 16)))
+
+#
+# usage
+#
+# Usages are grouped by `// usage_page::xxx` comments.
+#
+
+usages = []
+with hidDirectory.joinpath('usage.hpp').open() as f:
+    usagePage = None
+    namespace = None
+    for line in f:
+        m = re.match(r'^// usage_page::(\w+)', line)
+        if m:
+            usagePage = m.group(1)
+            continue
+
+        m = re.match(r'^namespace (\w+) \{', line)
+        if m:
+            namespace = m.group(1)
+            continue
+
+        m = valuePattern.match(line)
+        if m and usagePage:
+            usages.append((usagePage, namespace, m.group(1), int(m.group(2), 16)))
+
+#
+# modifier
+#
+
+modifiers = []
+with modifierFilePath.open() as f:
+    for line in f:
+        m = re.match(r'^  (\w+) = ', line)
+        if m:
+            modifiers.append(m.group(1))
+
+#
+# Output
+#
+
+def canonical(values):
+    # The first name of each value is used for the reverse lookup.
+    seen = set()
+    result = []
+    for v in values:
+        result.append('true' if v not in seen else 'false')
+        seen.add(v)
+    return result
+
+
+lines = []
+lines.append('#pragma once')
+lines.append('')
+lines.append('// (C) Copyright Takayama Fumihiko 2020.')
+lines.append('// Distributed under the Boost Software License, Version 1.0.')
+lines.append('// (See https://www.boost.org/LICENSE_1_0.txt)')
+lines.append('')
+lines.append('// Generated by scripts/make-hid-name-entries.py. Do not edit.')
+lines.append('')
+lines.append('#include "../virtual_hid_device_driver/hid_report/modifier.hpp"')
+lines.append('#include <array>')
+lines.append('#include <pqrs/hid.hpp>')
+lines.append('#include <string_view>')
+lines.append('')
+lines.append('namespace pqrs {')
+lines.append('namespace karabiner {')
+lines.append('namespace driverkit {')
+lines.append('namespace virtual_hid_device_service {')
+lines.append('namespace hid_names {')
+lines.append('')
+lines.append('struct usage_page_name_entry final {')
+lines.append('  hid::usage_page::value_t usage_page;')
+lines.append('  std::string_view name;')
+lines.append('  // false if the entry is an alias of the previous entry.')
+lines.append('  bool canonical;')
+lines.append('};')
+lines.append('')
+lines.append('struct usage_name_entry final {')
+lines.append('  hid::usage_page::value_t usage_page;')
+lines.append('  hid::usage::value_t usage;')
+lines.append('  std::string_view name;')
+lines.append('  // false if the entry is an alias of the previous entry.')
+lines.append('  bool canonical;')
+lines.append('};')
+lines.append('')
+lines.append('struct modifier_name_entry final {')
+lines.append('  virtual_hid_device_driver::hid_report::modifier modifier;')
+lines.append('  std::string_view name;')
+lines.append('};')
+lines.append('')
+
+lines.append('constexpr std::array<usage_page_name_entry, {0}> usage_page_name_entries = {{{{'.format(len(usagePages)))
+for (name, value), c in zip(usagePages, canonical([v for _, v in usagePages])):
+    lines.append('    {{hid::usage_page::{0}, "{0}", {1}}},'.format(name, c))
+lines.append('}};')
+lines.append('')
+
+lines.append('constexpr std::array<usage_name_entry, {0}> usage_name_entries = {{{{'.format(len(usages)))
+for (usagePage, namespace, name, value), c in zip(usages, canonical([(p, v) for p, _, _, v in usages])):
+    lines.append('    {{hid::usage_page::{0}, hid::usage::{1}::{2}, "{2}", {3}}},'.format(usagePage, namespace, name, c))
+lines.append('}};')
+lines.append('')
+
+lines.append('constexpr std::array<modifier_name_entry, {0}> modifier_name_entries = {{{{'.format(len(modifiers)))
+for name in modifiers:
+    lines.append('    {{virtual_hid_device_driver::hid_report::modifier::{0}, "{0}"}},'.format(name))
+lines.append('}};')
+lines.append('')
+
+lines.append('} // namespace hid_names')
+lines.append('} // namespace virtual_hid_device_service')
+lines.append('} // namespace driverkit')
+lines.append('} // namespace karabiner')
+lines.append('} // namespace pqrs')
+
+with outputFilePath.open('w') as f:
+    f.write('\n'.join(lines) + '\n')
+
+print('Update ' + str(outputFilePath))
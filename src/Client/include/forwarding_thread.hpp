@@ -0,0 +1,55 @@
+#pragma once
+
+#include "logger.hpp"
+#include <pqrs/dispatcher.hpp>
+#include <pthread.h>
+#include <pthread/qos.h>
+#include <string>
+
+// A dispatcher which owns a dedicated thread for a virtual device.
+// Reports of a virtual device are forwarded to the driver in the thread so that a slow IOKit call of a device does not delay other devices.
+class forwarding_thread final {
+public:
+  struct options final {
+    qos_class_t qos_class = QOS_CLASS_USER_INTERACTIVE;
+    // -15 ... 0
+    int relative_priority = 0;
+  };
+
+  forwarding_thread(const std::string& name,
+                    const options& options) : time_source_(std::make_shared<pqrs::dispatcher::hardware_time_source>()),
+                                              dispatcher_(std::make_shared<pqrs::dispatcher::dispatcher>(time_source_)) {
+    // Set the thread attributes in the dispatcher thread.
+
+    auto object_id = pqrs::dispatcher::make_new_object_id();
+    auto wait = pqrs::make_thread_wait();
+
+    dispatcher_->attach(object_id);
+    dispatcher_->enqueue(object_id, [name, options, wait] {
+      pthread_setname_np(name.c_str());
+
+      if (auto error = pthread_set_qos_class_self_np(options.qos_class, options.relative_priority)) {
+        logger::get_logger()->error("forwarding_thread {0}: pthread_set_qos_class_self_np error: {1}",
+                                    name,
+                                    error);
+      }
+
+      wait->notify();
+    });
+    wait->wait_notice();
+    dispatcher_->detach(object_id);
+  }
+
+  ~forwarding_thread(void) {
+    // All dispatcher_clients in the thread have to be detached before the termination.
+    dispatcher_->terminate();
+  }
+
+  std::weak_ptr<pqrs::dispatcher::dispatcher> get_weak_dispatcher(void) const {
+    return dispatcher_;
+  }
+
+private:
+  std::shared_ptr<pqrs::dispatcher::time_source> time_source_;
+  std::shared_ptr<pqrs::dispatcher::dispatcher> dispatcher_;
+};
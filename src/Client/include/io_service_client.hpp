@@ -3,26 +3,64 @@
 #include "logger.hpp"
 #include "version.hpp"
 #include <IOKit/IOKitLib.h>
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <chrono>
+#include <mutex>
 #include <nod/nod.hpp>
 #include <optional>
 #include <os/log.h>
 #include <pqrs/dispatcher.hpp>
 #include <pqrs/hid.hpp>
 #include <pqrs/karabiner/driverkit/virtual_hid_device_driver.hpp>
+#include <pqrs/karabiner/driverkit/virtual_hid_device_service.hpp>
 #include <pqrs/osx/iokit_return.hpp>
 #include <pqrs/osx/iokit_service_monitor.hpp>
-
+#include <vector>
+
+// A client of the driver which serves all virtual devices.
+// The connection of `io_service_client` is used to check the driver version.
+//
+// Each virtual device has its own connection (user client), report queue, report ring and forwarding thread
+// so that a slow call of a device does not delay other devices.
+// (The driver runs the methods of a user client one at a time in the dispatch queue of the user client.)
+// The connection of a virtual device is opened when the device is initialized and closed when it is terminated.
 class io_service_client final : public pqrs::dispatcher::extra::dispatcher_client {
 public:
-  // Signals (invoked from the dispatcher thread)
+  using device = pqrs::karabiner::driverkit::virtual_hid_device_service::metrics::device;
+
+  // Identifies a sequenced report of a client of the server.
+  // `sender_id == 0` means the report is not sequenced.
+  struct report_tag final {
+    uint32_t sender_id = 0;
+    uint64_t sequence = 0;
+  };
+
+  // Signals
 
+  // Invoked from the thread of `weak_dispatcher`.
   nod::signal<void(void)> opened;
   nod::signal<void(void)> closed;
+  // Sequenced reports which are passed to the driver (including errors).
+  // Invoked from the forwarding thread of the device.
+  nod::signal<void(const std::vector<report_tag>&)> reports_completed;
 
   // Methods
 
-  io_service_client(void) : dispatcher_client() {
+  // The connection is managed in the thread of `weak_dispatcher`.
+  // Reports of each device are forwarded in the thread of `forwarding_dispatchers` (indexed by `device`).
+  // `metrics` must be alive until `io_service_client` is destructed.
+  io_service_client(std::weak_ptr<pqrs::dispatcher::dispatcher> weak_dispatcher,
+                    const std::array<std::weak_ptr<pqrs::dispatcher::dispatcher>, pqrs::karabiner::driverkit::virtual_hid_device_service::metrics::device_count>& forwarding_dispatchers,
+                    pqrs::karabiner::driverkit::virtual_hid_device_service::metrics::page* metrics = nullptr) : dispatcher_client(weak_dispatcher),
+                                                                                                                driver_version_matched_(false),
+                                                                                                                metrics_(metrics) {
+    for (size_t i = 0; i < forwarders_.size(); ++i) {
+      forwarders_[i] = std::make_unique<device_forwarder>(forwarding_dispatchers[i],
+                                                          *this,
+                                                          device(i));
+    }
   }
 
   ~io_service_client(void) {
@@ -31,6 +69,11 @@ public:
 
       service_monitor_ = nullptr;
     });
+
+    // Forwarders complete sequenced reports which are not forwarded.
+    for (auto&& f : forwarders_) {
+      f = nullptr;
+    }
   }
 
   bool driver_loaded(void) const {
@@ -39,35 +82,32 @@ public:
     return driver_version_ != std::nullopt;
   }
 
+  // This method is called for each driver call in the forwarding threads.
+  // (The result is cached when the driver version is changed.)
   bool driver_version_matched(void) const {
-    std::lock_guard<std::mutex> lock(driver_version_mutex_);
+    return driver_version_matched_.load(std::memory_order_relaxed);
+  }
 
-    if (driver_version_ == DRIVER_VERSION_NUMBER) {
-      return true;
-    } else {
-      if (driver_version_) {
-        logger::get_logger()->warn("driver_version_ is mismatched: client expected: {0}, actual dext: {1}",
-                                   DRIVER_VERSION_NUMBER,
-                                   *driver_version_);
-      } else {
-        logger::get_logger()->warn("driver_version_ is mismatched: client expected: {0}, actual dext: std::nullopt",
-                                   DRIVER_VERSION_NUMBER);
-      }
+  // The capacity of the report queue of each device.
+  static constexpr size_t report_queue_capacity(void) {
+    return device_forwarder::report_queue_capacity();
+  }
 
-      return false;
-    }
+  // The value is approximate.
+  size_t get_report_queue_size(device d) const {
+    return get_forwarder(d).get_report_queue_size();
   }
 
   std::optional<bool> get_virtual_hid_keyboard_ready(void) const {
-    std::lock_guard<std::mutex> lock(virtual_hid_keyboard_ready_mutex_);
-
-    return virtual_hid_keyboard_ready_;
+    return get_forwarder(device::virtual_hid_keyboard).get_ready();
   }
 
   std::optional<bool> get_virtual_hid_pointing_ready(void) const {
-    std::lock_guard<std::mutex> lock(virtual_hid_pointing_ready_mutex_);
+    return get_forwarder(device::virtual_hid_pointing).get_ready();
+  }
 
-    return virtual_hid_pointing_ready_;
+  std::optional<bool> get_virtual_hid_absolute_pointing_ready(void) const {
+    return get_forwarder(device::virtual_hid_absolute_pointing).get_ready();
   }
 
   void async_start(void) {
@@ -102,148 +142,760 @@ public:
   void async_virtual_hid_keyboard_initialize(pqrs::hid::country_code::value_t country_code) const {
     logger::get_logger()->info("io_service_client::{0}", __func__);
 
-    enqueue_to_dispatcher([this, country_code] {
-      std::array<uint64_t, 1> input = {type_safe::get(country_code)};
+    get_forwarder(device::virtual_hid_keyboard).async_initialize(pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method::virtual_hid_keyboard_initialize,
+                                                                 {type_safe::get(country_code)},
+                                                                 "virtual_hid_keyboard_initialize");
+  }
 
-      auto r = call_scalar_method(pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method::virtual_hid_keyboard_initialize,
-                                  input.data(),
-                                  input.size());
+  // Reports which are posted before the termination are forwarded before it.
+  void async_virtual_hid_keyboard_terminate(void) const {
+    logger::get_logger()->info("io_service_client::{0}", __func__);
 
-      if (!r) {
-        logger::get_logger()->error("virtual_hid_keyboard_initialize error: {0}", r.to_string());
-      }
-    });
+    get_forwarder(device::virtual_hid_keyboard).async_terminate(pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method::virtual_hid_keyboard_terminate,
+                                                                "virtual_hid_keyboard_terminate");
   }
 
-  void async_virtual_hid_keyboard_ready(void) {
-    enqueue_to_dispatcher([this] {
-      auto ready = call_ready(pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method::virtual_hid_keyboard_ready);
-
-      enqueue_to_dispatcher([this, ready] {
-        set_virtual_hid_keyboard_ready(ready);
-      });
-    });
+  void async_virtual_hid_keyboard_ready(void) const {
+    get_forwarder(device::virtual_hid_keyboard).async_ready(pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method::virtual_hid_keyboard_ready);
   }
 
+  // The reset is forwarded in order with reports.
   void async_virtual_hid_keyboard_reset(void) const {
-    enqueue_to_dispatcher([this] {
-      auto r = call(pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method::virtual_hid_keyboard_reset);
-
-      if (!r) {
-        logger::get_logger()->error("virtual_hid_keyboard_reset error: {0}", r.to_string());
-      }
-    });
+    push_report(pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method::virtual_hid_keyboard_reset,
+                nullptr,
+                0,
+                "virtual_hid_keyboard_reset");
   }
 
   void async_virtual_hid_pointing_initialize(void) const {
     logger::get_logger()->info("io_service_client::{0}", __func__);
 
-    enqueue_to_dispatcher([this] {
-      auto r = call(pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method::virtual_hid_pointing_initialize);
-
-      if (!r) {
-        logger::get_logger()->error("virtual_hid_pointing_initialize error: {0}", r.to_string());
-      }
-    });
+    get_forwarder(device::virtual_hid_pointing).async_initialize(pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method::virtual_hid_pointing_initialize,
+                                                                 {},
+                                                                 "virtual_hid_pointing_initialize");
   }
 
-  void async_virtual_hid_pointing_ready(void) {
-    enqueue_to_dispatcher([this] {
-      auto ready = call_ready(pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method::virtual_hid_pointing_ready);
+  // Reports which are posted before the termination are forwarded before it.
+  void async_virtual_hid_pointing_terminate(void) const {
+    logger::get_logger()->info("io_service_client::{0}", __func__);
 
-      enqueue_to_dispatcher([this, ready] {
-        set_virtual_hid_pointing_ready(ready);
-      });
-    });
+    get_forwarder(device::virtual_hid_pointing).async_terminate(pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method::virtual_hid_pointing_terminate,
+                                                                "virtual_hid_pointing_terminate");
+  }
+
+  void async_virtual_hid_pointing_ready(void) const {
+    get_forwarder(device::virtual_hid_pointing).async_ready(pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method::virtual_hid_pointing_ready);
   }
 
+  // The reset is forwarded in order with reports.
   void async_virtual_hid_pointing_reset(void) const {
-    enqueue_to_dispatcher([this] {
-      auto r = call(pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method::virtual_hid_pointing_reset);
+    push_report(pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method::virtual_hid_pointing_reset,
+                nullptr,
+                0,
+                "virtual_hid_pointing_reset");
+  }
 
-      if (!r) {
-        logger::get_logger()->error("virtual_hid_pointing_reset error: {0}", r.to_string());
-      }
-    });
+  void async_virtual_hid_absolute_pointing_initialize(void) const {
+    logger::get_logger()->info("io_service_client::{0}", __func__);
+
+    get_forwarder(device::virtual_hid_absolute_pointing).async_initialize(pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method::virtual_hid_absolute_pointing_initialize,
+                                                                          {},
+                                                                          "virtual_hid_absolute_pointing_initialize");
   }
 
-  void async_post_report(const pqrs::karabiner::driverkit::virtual_hid_device_driver::hid_report::keyboard_input& report) const {
-    enqueue_to_dispatcher([this, report] {
-      auto r = post_report(
-          pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method::virtual_hid_keyboard_post_report,
-          &report,
-          sizeof(report));
+  // Reports which are posted before the termination are forwarded before it.
+  void async_virtual_hid_absolute_pointing_terminate(void) const {
+    logger::get_logger()->info("io_service_client::{0}", __func__);
 
-      if (!r) {
-        logger::get_logger()->error("virtual_hid_keyboard_post_report(keyboard_input) error: {0}", r.to_string());
-      }
-    });
+    get_forwarder(device::virtual_hid_absolute_pointing).async_terminate(pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method::virtual_hid_absolute_pointing_terminate,
+                                                                         "virtual_hid_absolute_pointing_terminate");
   }
 
-  void async_post_report(const pqrs::karabiner::driverkit::virtual_hid_device_driver::hid_report::consumer_input& report) const {
-    enqueue_to_dispatcher([this, report] {
-      auto r = post_report(
-          pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method::virtual_hid_keyboard_post_report,
-          &report,
-          sizeof(report));
+  void async_virtual_hid_absolute_pointing_ready(void) const {
+    get_forwarder(device::virtual_hid_absolute_pointing).async_ready(pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method::virtual_hid_absolute_pointing_ready);
+  }
 
-      if (!r) {
-        logger::get_logger()->error("virtual_hid_keyboard_post_report(consumer_input) error: {0}", r.to_string());
-      }
-    });
+  // The reset is forwarded in order with reports.
+  void async_virtual_hid_absolute_pointing_reset(void) const {
+    push_report(pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method::virtual_hid_absolute_pointing_reset,
+                nullptr,
+                0,
+                "virtual_hid_absolute_pointing_reset");
   }
 
-  void async_post_report(const pqrs::karabiner::driverkit::virtual_hid_device_driver::hid_report::apple_vendor_keyboard_input& report) const {
-    enqueue_to_dispatcher([this, report] {
-      auto r = post_report(
-          pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method::virtual_hid_keyboard_post_report,
-          &report,
-          sizeof(report));
+  // Returns false if the report is dropped.
+  bool async_post_report(const pqrs::karabiner::driverkit::virtual_hid_device_driver::hid_report::keyboard_input& report,
+                         report_tag tag = report_tag()) const {
+    return push_report(pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method::virtual_hid_keyboard_post_report,
+                       report,
+                       "virtual_hid_keyboard_post_report(keyboard_input)",
+                       tag);
+  }
 
-      if (!r) {
-        logger::get_logger()->error("virtual_hid_keyboard_post_report(apple_vendor_keyboard_input) error: {0}", r.to_string());
-      }
-    });
+  // Returns false if the report is dropped.
+  bool async_post_report(const pqrs::karabiner::driverkit::virtual_hid_device_driver::hid_report::keyboard_bitmap_input& report,
+                         report_tag tag = report_tag()) const {
+    return push_report(pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method::virtual_hid_keyboard_post_report,
+                       report,
+                       "virtual_hid_keyboard_post_report(keyboard_bitmap_input)",
+                       tag);
   }
 
-  void async_post_report(const pqrs::karabiner::driverkit::virtual_hid_device_driver::hid_report::apple_vendor_top_case_input& report) const {
-    enqueue_to_dispatcher([this, report] {
-      auto r = post_report(
-          pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method::virtual_hid_keyboard_post_report,
-          &report,
-          sizeof(report));
+  // Returns false if the report is dropped.
+  bool async_post_report(const pqrs::karabiner::driverkit::virtual_hid_device_driver::hid_report::consumer_input& report,
+                         report_tag tag = report_tag()) const {
+    return push_report(pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method::virtual_hid_keyboard_post_report,
+                       report,
+                       "virtual_hid_keyboard_post_report(consumer_input)",
+                       tag);
+  }
+
+  // Returns false if the report is dropped.
+  bool async_post_report(const pqrs::karabiner::driverkit::virtual_hid_device_driver::hid_report::apple_vendor_keyboard_input& report,
+                         report_tag tag = report_tag()) const {
+    return push_report(pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method::virtual_hid_keyboard_post_report,
+                       report,
+                       "virtual_hid_keyboard_post_report(apple_vendor_keyboard_input)",
+                       tag);
+  }
+
+  // Returns false if the report is dropped.
+  bool async_post_report(const pqrs::karabiner::driverkit::virtual_hid_device_driver::hid_report::apple_vendor_top_case_input& report,
+                         report_tag tag = report_tag()) const {
+    return push_report(pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method::virtual_hid_keyboard_post_report,
+                       report,
+                       "virtual_hid_keyboard_post_report(apple_vendor_top_case_input)",
+                       tag);
+  }
+
+  // Returns false if the report is dropped.
+  bool async_post_report(const pqrs::karabiner::driverkit::virtual_hid_device_driver::hid_report::pointing_input& report,
+                         report_tag tag = report_tag()) const {
+    return push_report(pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method::virtual_hid_pointing_post_report,
+                       report,
+                       "virtual_hid_pointing_post_report(pointing_input)",
+                       tag);
+  }
+
+  // Returns false if the report is dropped.
+  bool async_post_report(const pqrs::karabiner::driverkit::virtual_hid_device_driver::hid_report::pointing_high_resolution_input& report,
+                         report_tag tag = report_tag()) const {
+    return push_report(pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method::virtual_hid_pointing_post_report,
+                       report,
+                       "virtual_hid_pointing_post_report(pointing_high_resolution_input)",
+                       tag);
+  }
+
+  // Returns false if the report is dropped.
+  bool async_post_report(const pqrs::karabiner::driverkit::virtual_hid_device_driver::hid_report::absolute_pointing_input& report,
+                         report_tag tag = report_tag()) const {
+    return push_report(pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method::virtual_hid_absolute_pointing_post_report,
+                       report,
+                       "virtual_hid_absolute_pointing_post_report(absolute_pointing_input)",
+                       tag);
+  }
+
+private:
+  struct report_entry final {
+    pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method user_client_method;
+    // A string literal for the log.
+    const char* name;
+    report_tag tag;
+    uint8_t size;
+    std::array<uint8_t, 64> data;
+  };
+
+  // The connection, the report queue, the report ring and the ready state of a virtual device.
+  // The connection is used only in the thread of `weak_dispatcher`.
+  class device_forwarder final : public pqrs::dispatcher::extra::dispatcher_client {
+  public:
+    device_forwarder(std::weak_ptr<pqrs::dispatcher::dispatcher> weak_dispatcher,
+                     const io_service_client& client,
+                     device d) : dispatcher_client(weak_dispatcher),
+                                 client_(client),
+                                 device_(d),
+                                 generation_(0),
+                                 ready_generation_(0),
+                                 report_queue_metrics_{},
+                                 forwarding_metrics_{},
+                                 report_ring_address_(0),
+                                 report_ring_layout_(nullptr),
+                                 report_ring_failed_reports_(0) {
+      // Continue the counters of the previous io_service_client.
+      if (client_.metrics_) {
+        auto& m = client_.metrics_->get_device_metrics(device_);
+        if (auto v = m.report_queue.load()) {
+          report_queue_metrics_ = *v;
+        }
+        if (auto v = m.forwarding.load()) {
+          forwarding_metrics_ = *v;
+        }
+      }
+    }
+
+    ~device_forwarder(void) {
+      detach_from_dispatcher([this] {
+        // Complete sequenced reports which are not forwarded so that clients do not wait for them.
+        report_queue_.drain([this](auto&& entry) {
+          if (entry.tag.sender_id != 0) {
+            completed_report_tags_.push_back(entry.tag);
+          }
+        });
+
+        complete_report_tags();
+
+        close_connection();
+      });
+    }
+
+    static constexpr size_t report_queue_capacity(void) {
+      return decltype(report_queue_)::capacity();
+    }
+
+    // The value is approximate.
+    size_t get_report_queue_size(void) const {
+      return report_queue_.size();
+    }
+
+    // Returns std::nullopt until a ready poll which is requested after the last initialize or terminate is completed.
+    std::optional<bool> get_ready(void) const {
+      std::lock_guard<std::mutex> lock(ready_mutex_);
+
+      if (ready_generation_ != generation_) {
+        return std::nullopt;
+      }
+
+      return ready_;
+    }
+
+    // Called before the device is initialized or terminated.
+    void invalidate_ready(void) const {
+      std::lock_guard<std::mutex> lock(ready_mutex_);
+
+      ++generation_;
+    }
+
+    void reset_ready(void) const {
+      std::lock_guard<std::mutex> lock(ready_mutex_);
+
+      set_ready(std::nullopt, generation_);
+    }
+
+    // The connection is opened before the device is initialized.
+    void async_initialize(pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method user_client_method,
+                          const std::vector<uint64_t>& input,
+                          const char* name) const {
+      invalidate_ready();
+
+      enqueue_to_dispatcher([this, user_client_method, input, name] {
+        open_connection();
+
+        auto r = call_scalar_method(user_client_method,
+                                    input.data(),
+                                    static_cast<uint32_t>(input.size()));
+
+        if (!r) {
+          logger::get_logger()->error("{0} error: {1}", name, r.to_string());
+        }
+      });
+    }
+
+    // The connection is closed after the device is terminated.
+    void async_terminate(pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method user_client_method,
+                         const char* name) const {
+      invalidate_ready();
+
+      enqueue_to_dispatcher([this, user_client_method, name] {
+        // Forward queued reports before the termination.
+        drain_report_queue();
+
+        if (connection_) {
+          auto r = call(user_client_method);
+
+          if (!r) {
+            logger::get_logger()->error("{0} error: {1}", name, r.to_string());
+          }
+
+          close_connection();
+        }
+      });
+    }
+
+    // Called when the driver service is changed or terminated.
+    void async_close_connection(void) const {
+      enqueue_to_dispatcher([this] {
+        close_connection();
+      });
+    }
+
+    // The result is set in the same task as the driver call
+    // so that `close_connection` or a later initialize or terminate is not overwritten by a stale result.
+    void async_ready(pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method user_client_method) const {
+      uint64_t generation;
+      {
+        std::lock_guard<std::mutex> lock(ready_mutex_);
+
+        generation = generation_;
+      }
+
+      enqueue_to_dispatcher([this, user_client_method, generation] {
+        auto ready = call_ready(user_client_method);
+
+        std::lock_guard<std::mutex> ready_lock(ready_mutex_);
+
+        set_ready(ready, generation);
+      });
+    }
+
+    // This method is executed in the producer thread of `report_queue_`.
+    // Returns false if the report queue is full.
+    bool push_report(const report_entry& e) const {
+      bool pushed = true;
+
+      switch (report_queue_.push(e)) {
+        case pqrs::karabiner::driverkit::virtual_hid_device_service::push_result::pushed:
+          ++report_queue_metrics_.queued_reports;
+          break;
+
+        case pqrs::karabiner::driverkit::virtual_hid_device_service::push_result::pushed_and_wake:
+          ++report_queue_metrics_.queued_reports;
+          enqueue_to_dispatcher([this] {
+            drain_report_queue();
+          });
+          break;
+
+        case pqrs::karabiner::driverkit::virtual_hid_device_service::push_result::full:
+          ++report_queue_metrics_.dropped_reports;
+          logger::get_rate_limited_logger()->error("{0} error: report queue is full", e.name);
+          pushed = false;
+          break;
+      }
+
+      if (client_.metrics_) {
+        client_.metrics_->get_device_metrics(device_).report_queue.store(report_queue_metrics_);
+      }
+
+      return pushed;
+    }
+
+  private:
+    // This method is executed in the dispatcher thread.
+    void open_connection(void) const {
+      if (connection_) {
+        return;
+      }
+
+      auto s = client_.get_service();
+      if (!s) {
+        return;
+      }
+
+      io_connect_t c;
+      pqrs::osx::iokit_return r = IOServiceOpen(*s, mach_task_self(), 0, &c);
 
       if (!r) {
-        logger::get_logger()->error("virtual_hid_keyboard_post_report(apple_vendor_top_case_input) error: {0}", r.to_string());
+        logger::get_logger()->error("io_service_client {0} IOServiceOpen error: {1}", get_device_name(), r.to_string());
+        return;
       }
-    });
-  }
 
-  void async_post_report(const pqrs::karabiner::driverkit::virtual_hid_device_driver::hid_report::pointing_input& report) const {
-    enqueue_to_dispatcher([this, report] {
-      auto r = post_report(
-          pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method::virtual_hid_pointing_post_report,
-          &report,
-          sizeof(report));
+      connection_ = pqrs::osx::iokit_object_ptr(c);
 
+      if (client_.driver_version_matched()) {
+        map_report_ring();
+      }
+    }
+
+    // This method is executed in the dispatcher thread.
+    void close_connection(void) const {
+      if (connection_) {
+        unmap_report_ring();
+
+        IOServiceClose(*connection_);
+        connection_.reset();
+      }
+    }
+
+    // This method is executed in the dispatcher thread.
+    // Reports are posted with `IOConnectCallStructMethod` one by one if the report ring is not available.
+    void map_report_ring(void) const {
+      mach_vm_address_t address = 0;
+      mach_vm_size_t size = 0;
+      pqrs::osx::iokit_return r = IOConnectMapMemory64(*connection_,
+                                                       static_cast<uint32_t>(pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_memory_type::report_ring),
+                                                       mach_task_self(),
+                                                       &address,
+                                                       &size,
+                                                       kIOMapAnywhere);
       if (!r) {
-        logger::get_logger()->error("virtual_hid_pointing_post_report(pointing_input) error: {0}", r.to_string());
+        logger::get_logger()->warn("io_service_client {0} IOConnectMapMemory64 error: {1}", get_device_name(), r.to_string());
+        return;
       }
-    });
+
+      report_ring_address_ = address;
+
+      auto l = pqrs::karabiner::driverkit::virtual_hid_device_driver::report_ring::layout::validate(reinterpret_cast<void*>(address),
+                                                                                                    static_cast<size_t>(size));
+      if (!l) {
+        logger::get_logger()->warn("io_service_client {0} report ring is invalid", get_device_name());
+        unmap_report_ring();
+        return;
+      }
+
+      report_ring_layout_ = l;
+      report_ring_failed_reports_ = l->failed_reports.load(std::memory_order_relaxed);
+      report_ring_producer_.attach(l);
+
+      logger::get_logger()->info("io_service_client {0} report ring is mapped", get_device_name());
+    }
+
+    // This method is executed in the dispatcher thread.
+    void unmap_report_ring(void) const {
+      report_ring_producer_.detach();
+      report_ring_layout_ = nullptr;
+
+      if (report_ring_address_ && connection_) {
+        IOConnectUnmapMemory64(*connection_,
+                               static_cast<uint32_t>(pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_memory_type::report_ring),
+                               mach_task_self(),
+                               report_ring_address_);
+      }
+      report_ring_address_ = 0;
+    }
+
+    // `ready_mutex_` has to be locked by the caller.
+    // `generation` is `generation_` when the value is requested.
+    void set_ready(std::optional<bool> value,
+                   uint64_t generation) const {
+      ready_generation_ = generation;
+
+      if (ready_ != value) {
+        ready_ = value;
+
+        logger::get_logger()->info(
+            "{0} ready is changed: {1}",
+            get_device_name(),
+            value ? (*value ? "true" : "false") : "std::nullopt");
+      }
+    }
+
+    const char* get_device_name(void) const {
+      switch (device_) {
+        case device::virtual_hid_pointing:
+          return "virtual_hid_pointing";
+        case device::virtual_hid_absolute_pointing:
+          return "virtual_hid_absolute_pointing";
+        default:
+          return "virtual_hid_keyboard";
+      }
+    }
+
+    // This method is executed in the dispatcher thread.
+    void drain_report_queue(void) const {
+      auto depth = report_queue_.size();
+      forwarding_metrics_.queue_depth = depth;
+      forwarding_metrics_.max_queue_depth = std::max(forwarding_metrics_.max_queue_depth, static_cast<uint64_t>(depth));
+
+      if (report_ring_producer_.is_attached()) {
+        drain_report_queue_to_report_ring();
+        return;
+      }
+
+      report_queue_.drain([this](auto&& entry) {
+        auto start = std::chrono::steady_clock::now();
+
+        auto r = post_report(entry.user_client_method,
+                             entry.size > 0 ? entry.data.data() : nullptr,
+                             entry.size);
+
+        forwarding_metrics_.last_backend_call_latency_nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                                                        std::chrono::steady_clock::now() - start)
+                                                                        .count();
+
+        if (r) {
+          ++forwarding_metrics_.forwarded_reports;
+        } else {
+          ++forwarding_metrics_.backend_errors;
+          logger::get_rate_limited_logger()->error("{0} error: {1}", entry.name, r.to_string());
+        }
+
+        if (entry.tag.sender_id != 0) {
+          completed_report_tags_.push_back(entry.tag);
+        }
+      });
+
+      complete_report_tags();
+
+      // Publish once per drain in order to keep the forwarding loop cheap.
+      publish_forwarding_metrics();
+    }
+
+    // This method is executed in the dispatcher thread.
+    // Reports are written into the report ring of the device and the driver is called once per batch.
+    void drain_report_queue_to_report_ring(void) const {
+      // Reports which are pushed into the ring and not consumed by a successful doorbell yet.
+      uint64_t unconsumed_count = 0;
+
+      auto doorbell = [this, &unconsumed_count] {
+        auto start = std::chrono::steady_clock::now();
+
+        auto r = call(pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method::report_ring_doorbell);
+
+        forwarding_metrics_.last_backend_call_latency_nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                                                        std::chrono::steady_clock::now() - start)
+                                                                        .count();
+
+        if (r) {
+          // The driver drains all published reports in the doorbell call.
+          forwarding_metrics_.forwarded_reports += unconsumed_count;
+          unconsumed_count = 0;
+        } else {
+          logger::get_rate_limited_logger()->error("{0} report_ring_doorbell error: {1}", get_device_name(), r.to_string());
+        }
+
+        return static_cast<bool>(r);
+      };
+
+      report_queue_.drain([this, &unconsumed_count, &doorbell](auto&& entry) {
+        auto r = report_ring_producer_.push(static_cast<uint32_t>(entry.user_client_method),
+                                            entry.data.data(),
+                                            entry.size,
+                                            doorbell);
+
+        if (r == pqrs::karabiner::driverkit::virtual_hid_device_driver::report_ring::push_result::pushed) {
+          ++unconsumed_count;
+        } else {
+          ++forwarding_metrics_.backend_errors;
+          logger::get_rate_limited_logger()->error("{0} error: report ring is full", entry.name);
+        }
+
+        if (entry.tag.sender_id != 0) {
+          completed_report_tags_.push_back(entry.tag);
+        }
+      });
+
+      // `flush` returns true without the doorbell if the doorbell is already pending.
+      if (report_ring_producer_.flush(doorbell)) {
+        forwarding_metrics_.forwarded_reports += unconsumed_count;
+      } else {
+        // The driver did not receive the reports in this call.
+        // (Tags are completed in order not to stall sequenced senders, as with reports which are dropped.)
+        forwarding_metrics_.backend_errors += unconsumed_count;
+      }
+
+      // Count reports which are failed in the driver.
+      if (auto l = report_ring_layout_) {
+        auto failed_reports = l->failed_reports.load(std::memory_order_relaxed);
+        if (failed_reports > report_ring_failed_reports_) {
+          forwarding_metrics_.backend_errors += failed_reports - report_ring_failed_reports_;
+          report_ring_failed_reports_ = failed_reports;
+        }
+      }
+
+      complete_report_tags();
+
+      publish_forwarding_metrics();
+    }
+
+    // This method is executed in the dispatcher thread.
+    void complete_report_tags(void) const {
+      if (!completed_report_tags_.empty()) {
+        client_.reports_completed(completed_report_tags_);
+        completed_report_tags_.clear();
+      }
+    }
+
+    // This method is executed in the dispatcher thread.
+    void publish_forwarding_metrics(void) const {
+      if (client_.metrics_) {
+        client_.metrics_->get_device_metrics(device_).forwarding.store(forwarding_metrics_);
+      }
+    }
+
+    // This method is executed in the dispatcher thread.
+    pqrs::osx::iokit_return call(pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method user_client_method) const {
+      if (!connection_) {
+        return kIOReturnNotOpen;
+      }
+
+      if (!client_.driver_version_matched()) {
+        return kIOReturnError;
+      }
+
+      return IOConnectCallStructMethod(*connection_,
+                                       static_cast<uint32_t>(user_client_method),
+                                       nullptr,
+                                       0,
+                                       nullptr,
+                                       0);
+    }
+
+    // This method is executed in the dispatcher thread.
+    pqrs::osx::iokit_return call_scalar_method(pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method user_client_method,
+                                               const uint64_t* input,
+                                               uint32_t input_count) const {
+      if (!connection_) {
+        return kIOReturnNotOpen;
+      }
+
+      if (!client_.driver_version_matched()) {
+        return kIOReturnError;
+      }
+
+      return IOConnectCallScalarMethod(*connection_,
+                                       static_cast<uint32_t>(user_client_method),
+                                       input,
+                                       input_count,
+                                       nullptr,
+                                       0);
+    }
+
+    // This method is executed in the dispatcher thread.
+    std::optional<bool> call_ready(pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method user_client_method) const {
+      if (!connection_) {
+        return std::nullopt;
+      }
+
+      if (!client_.driver_version_matched()) {
+        return std::nullopt;
+      }
+
+      uint64_t output[1] = {0};
+      uint32_t output_count = 1;
+      auto kr = IOConnectCallScalarMethod(*connection_,
+                                          static_cast<uint32_t>(user_client_method),
+                                          nullptr,
+                                          0,
+                                          output,
+                                          &output_count);
+
+      if (kr != kIOReturnSuccess) {
+        return std::nullopt;
+      }
+
+      return static_cast<bool>(output[0]);
+    }
+
+    // This method is executed in the dispatcher thread.
+    pqrs::osx::iokit_return post_report(pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method user_client_method,
+                                        const void* report,
+                                        size_t report_size) const {
+      if (!connection_) {
+        return kIOReturnNotOpen;
+      }
+
+      if (!client_.driver_version_matched()) {
+        return kIOReturnError;
+      }
+
+      return IOConnectCallStructMethod(*connection_,
+                                       static_cast<uint32_t>(user_client_method),
+                                       report,
+                                       report_size,
+                                       nullptr,
+                                       0);
+    }
+
+    const io_service_client& client_;
+    device device_;
+
+    // The connection of the virtual device.
+    mutable pqrs::osx::iokit_object_ptr connection_;
+
+    mutable std::mutex ready_mutex_;
+    mutable std::optional<bool> ready_;
+    // Incremented when the device is initialized or terminated.
+    mutable uint64_t generation_;
+    // `generation_` when `ready_` is requested.
+    mutable uint64_t ready_generation_;
+
+    // The producer is the thread which calls `async_post_report` (the server dispatcher thread).
+    // The consumer is the dispatcher thread of `device_forwarder`.
+    mutable pqrs::karabiner::driverkit::virtual_hid_device_service::forwarding_queue<report_entry, 512> report_queue_;
+
+    // Updated in the producer thread of `report_queue_`.
+    mutable pqrs::karabiner::driverkit::virtual_hid_device_service::metrics::report_queue_metrics report_queue_metrics_;
+    // Updated in the dispatcher thread.
+    mutable pqrs::karabiner::driverkit::virtual_hid_device_service::metrics::forwarding_metrics forwarding_metrics_;
+    // Updated in the dispatcher thread.
+    mutable std::vector<report_tag> completed_report_tags_;
+
+    // The report ring which is mapped from the user client of the device.
+    mutable mach_vm_address_t report_ring_address_;
+    mutable pqrs::karabiner::driverkit::virtual_hid_device_driver::report_ring::layout* report_ring_layout_;
+    mutable pqrs::karabiner::driverkit::virtual_hid_device_driver::report_ring::producer report_ring_producer_;
+    // `layout::failed_reports` which is already counted in `forwarding_metrics_`.
+    mutable uint64_t report_ring_failed_reports_;
+  };
+
+  static device get_device(pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method user_client_method) {
+    using method = pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method;
+
+    switch (user_client_method) {
+      case method::virtual_hid_pointing_post_report:
+      case method::virtual_hid_pointing_reset:
+        return device::virtual_hid_pointing;
+
+      case method::virtual_hid_absolute_pointing_post_report:
+      case method::virtual_hid_absolute_pointing_reset:
+        return device::virtual_hid_absolute_pointing;
+
+      default:
+        return device::virtual_hid_keyboard;
+    }
+  }
+
+  const device_forwarder& get_forwarder(device d) const {
+    return *(forwarders_[static_cast<size_t>(d)]);
+  }
+
+  template <typename T>
+  bool push_report(pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method user_client_method,
+                   const T& report,
+                   const char* name,
+                   report_tag tag) const {
+    static_assert(sizeof(T) <= std::tuple_size<decltype(report_entry::data)>::value, "report_entry::data is too small");
+
+    return push_report(user_client_method, &report, sizeof(report), name, tag);
+  }
+
+  // This method is executed in the producer thread of the report queues.
+  // Returns false if the report queue is full.
+  bool push_report(pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method user_client_method,
+                   const void* report,
+                   size_t report_size,
+                   const char* name,
+                   report_tag tag = report_tag()) const {
+    report_entry e;
+    e.user_client_method = user_client_method;
+    e.name = name;
+    e.tag = tag;
+    e.size = static_cast<uint8_t>(report_size);
+    if (report_size > 0) {
+      memcpy(e.data.data(), report, report_size);
+    }
+
+    return get_forwarder(get_device(user_client_method)).push_report(e);
   }
 
-private:
   // This method is executed in the dispatcher thread.
   void set_driver_version(std::optional<uint64_t> value) {
     std::lock_guard<std::mutex> lock(driver_version_mutex_);
 
     if (driver_version_ != value) {
       driver_version_ = value;
+      driver_version_matched_.store(value == DRIVER_VERSION_NUMBER, std::memory_order_relaxed);
 
       if (value) {
         logger::get_logger()->info(
             "driver_version_ is changed: {0}",
             *value);
+
+        if (*value != DRIVER_VERSION_NUMBER) {
+          logger::get_logger()->warn(
+              "driver_version_ is mismatched: client expected: {0}, actual dext: {1}",
+              DRIVER_VERSION_NUMBER,
+              *value);
+        }
       } else {
         logger::get_logger()->info(
             "driver_version_ is changed: std::nullopt");
@@ -251,29 +903,23 @@ private:
     }
   }
 
-  // This method is executed in the dispatcher thread.
-  void set_virtual_hid_keyboard_ready(std::optional<bool> value) {
-    std::lock_guard<std::mutex> lock(virtual_hid_keyboard_ready_mutex_);
-
-    if (virtual_hid_keyboard_ready_ != value) {
-      virtual_hid_keyboard_ready_ = value;
+  pqrs::osx::iokit_object_ptr get_service(void) const {
+    std::lock_guard<std::mutex> lock(service_mutex_);
 
-      logger::get_logger()->info(
-          "virtual_hid_keyboard_ready_ is changed: {0}",
-          value ? (*value ? "true" : "false") : "std::nullopt");
-    }
+    return service_;
   }
 
   // This method is executed in the dispatcher thread.
-  void set_virtual_hid_pointing_ready(std::optional<bool> value) {
-    std::lock_guard<std::mutex> lock(virtual_hid_pointing_ready_mutex_);
+  void set_service(pqrs::osx::iokit_object_ptr value) {
+    std::lock_guard<std::mutex> lock(service_mutex_);
 
-    if (virtual_hid_pointing_ready_ != value) {
-      virtual_hid_pointing_ready_ = value;
+    service_ = value;
+  }
 
-      logger::get_logger()->info(
-          "virtual_hid_pointing_ready_ is changed: {0}",
-          value ? (*value ? "true" : "false") : "std::nullopt");
+  // This method is executed in the dispatcher thread.
+  void reset_ready(void) {
+    for (auto&& f : forwarders_) {
+      f->reset_ready();
     }
   }
 
@@ -284,13 +930,12 @@ private:
     }
 
     set_driver_version(std::nullopt);
-    set_virtual_hid_keyboard_ready(std::nullopt);
-    set_virtual_hid_pointing_ready(std::nullopt);
+    reset_ready();
 
-    service_ = s;
+    set_service(s);
 
     io_connect_t c;
-    pqrs::osx::iokit_return r = IOServiceOpen(*service_, mach_task_self(), 0, &c);
+    pqrs::osx::iokit_return r = IOServiceOpen(*s, mach_task_self(), 0, &c);
 
     if (!r) {
       logger::get_logger()->error("io_service_client IOServiceOpen error: {0}", r.to_string());
@@ -321,6 +966,11 @@ private:
 
   // This method is executed in the dispatcher thread.
   void close_connection(void) {
+    // Connections of virtual devices are closed in the forwarding threads.
+    for (auto&& f : forwarders_) {
+      f->async_close_connection();
+    }
+
     if (connection_) {
       IOServiceClose(*connection_);
       connection_.reset();
@@ -332,11 +982,10 @@ private:
       });
     }
 
-    service_.reset();
+    set_service(pqrs::osx::iokit_object_ptr());
 
     set_driver_version(std::nullopt);
-    set_virtual_hid_keyboard_ready(std::nullopt);
-    set_virtual_hid_pointing_ready(std::nullopt);
+    reset_ready();
   }
 
   // This method is executed in the dispatcher thread.
@@ -363,100 +1012,23 @@ private:
     return output[0];
   }
 
-  // This method is executed in the dispatcher thread.
-  pqrs::osx::iokit_return call(pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method user_client_method) const {
-    if (!connection_) {
-      return kIOReturnNotOpen;
-    }
-
-    if (!driver_version_matched()) {
-      return kIOReturnError;
-    }
-
-    return IOConnectCallStructMethod(*connection_,
-                                     static_cast<uint32_t>(user_client_method),
-                                     nullptr,
-                                     0,
-                                     nullptr,
-                                     0);
-  }
-
-  // This method is executed in the dispatcher thread.
-  pqrs::osx::iokit_return call_scalar_method(pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method user_client_method,
-                                             const uint64_t* input,
-                                             uint32_t input_count) const {
-    if (!connection_) {
-      return kIOReturnNotOpen;
-    }
-
-    if (!driver_version_matched()) {
-      return kIOReturnError;
-    }
-
-    return IOConnectCallScalarMethod(*connection_,
-                                     static_cast<uint32_t>(user_client_method),
-                                     input,
-                                     input_count,
-                                     nullptr,
-                                     0);
-  }
-
-  // This method is executed in the dispatcher thread.
-  std::optional<bool> call_ready(pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method user_client_method) const {
-    if (!connection_) {
-      return std::nullopt;
-    }
-
-    if (!driver_version_matched()) {
-      return std::nullopt;
-    }
-
-    uint64_t output[1] = {0};
-    uint32_t output_count = 1;
-    auto kr = IOConnectCallScalarMethod(*connection_,
-                                        static_cast<uint32_t>(user_client_method),
-                                        nullptr,
-                                        0,
-                                        output,
-                                        &output_count);
-
-    if (kr != kIOReturnSuccess) {
-      return std::nullopt;
-    }
-
-    return static_cast<bool>(output[0]);
-  }
-
-  // This method is executed in the dispatcher thread.
-  pqrs::osx::iokit_return post_report(pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method user_client_method,
-                                      const void* report,
-                                      size_t report_size) const {
-    if (!connection_) {
-      return kIOReturnNotOpen;
-    }
-
-    if (!driver_version_matched()) {
-      return kIOReturnError;
-    }
-
-    return IOConnectCallStructMethod(*connection_,
-                                     static_cast<uint32_t>(user_client_method),
-                                     report,
-                                     report_size,
-                                     nullptr,
-                                     0);
-  }
-
   std::unique_ptr<pqrs::osx::iokit_service_monitor> service_monitor_;
+
+  // `service_` is set in the dispatcher thread and used in the forwarding threads to open connections of virtual devices.
+  mutable std::mutex service_mutex_;
   pqrs::osx::iokit_object_ptr service_;
+
+  // The connection which is used to check the driver version.
   pqrs::osx::iokit_object_ptr connection_;
 
   mutable std::mutex driver_version_mutex_;
   std::optional<uint64_t> driver_version_;
+  // `driver_version_ == DRIVER_VERSION_NUMBER`
+  std::atomic<bool> driver_version_matched_;
 
-  mutable std::mutex virtual_hid_keyboard_ready_mutex_;
-  std::optional<bool> virtual_hid_keyboard_ready_;
+  // The values are published into `metrics_`.
+  pqrs::karabiner::driverkit::virtual_hid_device_service::metrics::page* metrics_;
 
-  mutable std::mutex virtual_hid_pointing_ready_mutex_;
-  std::optional<bool> virtual_hid_pointing_ready_;
+  // Indexed by `device`.
+  std::array<std::unique_ptr<device_forwarder>, pqrs::karabiner::driverkit::virtual_hid_device_service::metrics::device_count> forwarders_;
 };
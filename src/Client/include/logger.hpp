@@ -1,30 +1,33 @@
 #pragma once
 
+#include "rate_limited_logger.hpp"
+#include <atomic>
 #include <filesystem>
 #include <pqrs/spdlog.hpp>
 #include <spdlog/async.h>
 #include <spdlog/sinks/rotating_file_sink.h>
 #include <spdlog/sinks/stdout_sinks.h>
+#include <spdlog/spdlog.h>
 
 class logger final {
 public:
-  static std::shared_ptr<spdlog::logger> get_logger(void) {
-    std::lock_guard<std::mutex> guard(mutex_);
-
-    if (logger_) {
-      return logger_;
+  // `get_logger` is called on hot paths.
+  // Thus, it loads the published pointer without a mutex and a shared_ptr copy.
+  // (Published loggers are kept alive until the process exits.)
+  static spdlog::logger* get_logger(void) {
+    if (auto l = logger_.load(std::memory_order_acquire)) {
+      return l;
     }
 
-    //
-    // Fallback
-    //
+    return get_fallback_entry().logger.get();
+  }
 
-    static std::shared_ptr<spdlog::logger> stdout_logger;
-    if (!stdout_logger) {
-      stdout_logger = pqrs::spdlog::factory::make_stdout_logger_mt("client");
+  static rate_limited_logger* get_rate_limited_logger(void) {
+    if (auto l = rate_limited_logger_.load(std::memory_order_acquire)) {
+      return l;
     }
 
-    return stdout_logger;
+    return get_fallback_entry().rate_limited_logger.get();
   }
 
   static void set_async_rotating_logger(const std::string& logger_name,
@@ -36,15 +39,41 @@ public:
                                                                   256 * 1024,
                                                                   3);
     if (l) {
-      l->flush_on(spdlog::level::info);
+      // Flush the log file periodically instead of `flush_on(spdlog::level::info)`
+      // in order to avoid a disk flush per message under an error storm.
+      l->flush_on(spdlog::level::critical);
+      spdlog::flush_every(std::chrono::seconds(1));
+
       l->set_pattern(pqrs::spdlog::get_pattern());
 
+      auto e = std::make_unique<entry>(l);
+
       std::lock_guard<std::mutex> guard(mutex_);
-      logger_ = l;
+
+      logger_.store(e->logger.get(), std::memory_order_release);
+      rate_limited_logger_.store(e->rate_limited_logger.get(), std::memory_order_release);
+
+      entries_.push_back(std::move(e));
     }
   }
 
 private:
+  struct entry final {
+    entry(std::shared_ptr<spdlog::logger> l) : logger(l),
+                                               rate_limited_logger(std::make_unique<::rate_limited_logger>(l)) {
+    }
+
+    std::shared_ptr<spdlog::logger> logger;
+    std::unique_ptr<::rate_limited_logger> rate_limited_logger;
+  };
+
+  static entry& get_fallback_entry(void) {
+    static entry e(pqrs::spdlog::factory::make_stdout_logger_mt("client"));
+    return e;
+  }
+
   static inline std::mutex mutex_;
-  static inline std::shared_ptr<spdlog::logger> logger_;
+  static inline std::vector<std::unique_ptr<entry>> entries_;
+  static inline std::atomic<spdlog::logger*> logger_{nullptr};
+  static inline std::atomic<::rate_limited_logger*> rate_limited_logger_{nullptr};
 };
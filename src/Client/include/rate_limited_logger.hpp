@@ -0,0 +1,191 @@
+#pragma once
+
+#include <chrono>
+#include <map>
+#include <optional>
+#include <pqrs/dispatcher.hpp>
+#include <pqrs/spdlog.hpp>
+#include <spdlog/fmt/fmt.h>
+#include <tuple>
+#include <vector>
+
+// `rate_limited_logger` is used for messages which might be repeated on hot paths (e.g., per-report errors).
+//
+// Messages are limited per call site (the format string and the source location).
+// The first occurrence in an interval is formatted and logged.
+// The following occurrences are counted without formatting and "N similar messages suppressed" summaries are emitted when the interval is expired.
+
+class rate_limited_logger final : public pqrs::dispatcher::extra::dispatcher_client {
+public:
+  // The source location is filled at the call site by the implicit conversion from the format string.
+  class call_site final {
+  public:
+    call_site(const char* format,
+              const char* file = __builtin_FILE(),
+              unsigned int line = __builtin_LINE()) : format_(format),
+                                                      file_(file),
+                                                      line_(line) {
+    }
+
+    const char* get_format(void) const {
+      return format_;
+    }
+
+    bool operator<(const call_site& other) const {
+      return std::tie(format_, file_, line_) < std::tie(other.format_, other.file_, other.line_);
+    }
+
+  private:
+    const char* format_;
+    const char* file_;
+    unsigned int line_;
+  };
+
+  rate_limited_logger(const rate_limited_logger&) = delete;
+
+  rate_limited_logger(std::weak_ptr<spdlog::logger> weak_logger,
+                      std::chrono::milliseconds interval = std::chrono::milliseconds(5000),
+                      size_t max_call_site_count = 256) : dispatcher_client(),
+                                                          weak_logger_(weak_logger),
+                                                          interval_(interval),
+                                                          max_call_site_count_(max_call_site_count),
+                                                          interval_start_(std::chrono::steady_clock::now()),
+                                                          overflow_count_(0),
+                                                          timer_(*this) {
+    timer_.start(
+        [this] {
+          flush();
+        },
+        interval_);
+  }
+
+  ~rate_limited_logger(void) {
+    detach_from_dispatcher([this] {
+      timer_.stop();
+    });
+  }
+
+  template <typename... Args>
+  void warn(call_site site, const Args&... args) {
+    log(spdlog::level::warn, site, args...);
+  }
+
+  template <typename... Args>
+  void error(call_site site, const Args&... args) {
+    log(spdlog::level::err, site, args...);
+  }
+
+  // Emit summaries of suppressed messages if the interval is expired.
+  void flush(void) {
+    std::vector<summary> summaries;
+    size_t overflow_count = 0;
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+
+      if (!expire(std::chrono::steady_clock::now(), summaries, overflow_count)) {
+        return;
+      }
+    }
+
+    emit(summaries, overflow_count);
+  }
+
+private:
+  struct entry final {
+    spdlog::level::level_enum level;
+    // The first message in the interval.
+    std::string message;
+    size_t count;
+  };
+
+  struct summary final {
+    spdlog::level::level_enum level;
+    std::string message;
+    size_t suppressed_count;
+  };
+
+  template <typename... Args>
+  void log(spdlog::level::level_enum level,
+           call_site site,
+           const Args&... args) {
+    std::vector<summary> summaries;
+    size_t overflow_count = 0;
+    std::optional<std::string> message;
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+
+      expire(std::chrono::steady_clock::now(), summaries, overflow_count);
+
+      auto it = entries_.find(site);
+      if (it != std::end(entries_)) {
+        ++(it->second.count);
+      } else if (entries_.size() >= max_call_site_count_) {
+        ++overflow_count_;
+      } else {
+        // Format only the first occurrence.
+        message = fmt::format(site.get_format(), args...);
+        entries_.emplace(site, entry{level, *message, 1});
+      }
+    }
+
+    emit(summaries, overflow_count);
+
+    if (message) {
+      if (auto logger = weak_logger_.lock()) {
+        logger->log(level, *message);
+      }
+    }
+  }
+
+  // This method must be called with `mutex_`.
+  bool expire(std::chrono::steady_clock::time_point now,
+              std::vector<summary>& summaries,
+              size_t& overflow_count) {
+    if (now - interval_start_ < interval_) {
+      return false;
+    }
+
+    for (const auto& [site, e] : entries_) {
+      if (e.count > 1) {
+        summaries.push_back(summary{e.level, e.message, e.count - 1});
+      }
+    }
+    overflow_count = overflow_count_;
+
+    entries_.clear();
+    overflow_count_ = 0;
+    interval_start_ = now;
+
+    return true;
+  }
+
+  void emit(const std::vector<summary>& summaries,
+            size_t overflow_count) const {
+    if (summaries.empty() && overflow_count == 0) {
+      return;
+    }
+
+    if (auto logger = weak_logger_.lock()) {
+      for (const auto& s : summaries) {
+        logger->log(s.level, "{0} similar messages suppressed: {1}", s.suppressed_count, s.message);
+      }
+
+      if (overflow_count > 0) {
+        logger->warn("{0} messages suppressed", overflow_count);
+      }
+    }
+  }
+
+  std::weak_ptr<spdlog::logger> weak_logger_;
+  std::chrono::milliseconds interval_;
+  size_t max_call_site_count_;
+
+  std::chrono::steady_clock::time_point interval_start_;
+  std::map<call_site, entry> entries_;
+  size_t overflow_count_;
+  mutable std::mutex mutex_;
+
+  pqrs::dispatcher::extra::timer timer_;
+};
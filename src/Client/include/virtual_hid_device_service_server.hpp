@@ -1,7 +1,14 @@
 #pragma once
 
+#include "forwarding_thread.hpp"
 #include "logger.hpp"
+#include <array>
+#include <deque>
 #include <filesystem>
+#include <functional>
+#include <optional>
+#include <string>
+#include <unordered_map>
 #include <pqrs/dispatcher.hpp>
 #include <pqrs/karabiner/driverkit/virtual_hid_device_driver.hpp>
 #include <pqrs/karabiner/driverkit/virtual_hid_device_service.hpp>
@@ -9,30 +16,53 @@
 
 class virtual_hid_device_service_server final : public pqrs::dispatcher::extra::dispatcher_client {
 public:
-  virtual_hid_device_service_server(void) : dispatcher_client(),
-                                            ready_timer_(*this) {
+  virtual_hid_device_service_server(const forwarding_thread::options& forwarding_thread_options,
+                                    const pqrs::karabiner::driverkit::virtual_hid_device_service::device_lifecycle::options& device_lifecycle_options) : dispatcher_client(),
+                                                                                                                                                         virtual_hid_keyboard_forwarding_thread_("virtual_hid_keyboard", forwarding_thread_options),
+                                                                                                                                                         virtual_hid_pointing_forwarding_thread_("virtual_hid_pointing", forwarding_thread_options),
+                                                                                                                                                         virtual_hid_absolute_pointing_forwarding_thread_("virtual_hid_absolute_pointing", forwarding_thread_options),
+                                                                                                                                                         virtual_hid_keyboard_country_code_(pqrs::hid::country_code::not_supported),
+                                                                                                                                                         virtual_hid_keyboard_(device_lifecycle_options),
+                                                                                                                                                         virtual_hid_pointing_(device_lifecycle_options),
+                                                                                                                                                         virtual_hid_absolute_pointing_(device_lifecycle_options),
+                                                                                                                                                         client_activity_(device_lifecycle_options.idle_timeout),
+                                                                                                                                                         last_sequenced_sender_id_(0),
+                                                                                                                                                         sequenced_sender_activity_(0),
+                                                                                                                                                         server_metrics_{},
+                                                                                                                                                         ready_timer_(*this),
+                                                                                                                                                         creation_timer_(*this),
+                                                                                                                                                         pointing_motion_timer_(*this),
+                                                                                                                                                         text_input_timer_(*this) {
     //
     // Preparation
     //
 
     create_rootonly_directory();
+    open_metrics();
 
     //
     // Creation
     //
 
+    // Restore the virtual devices before `server_` receives requests.
+    enqueue_to_dispatcher([this] {
+      restore_session_state();
+    });
+
+    create_io_service_client();
     create_server();
-    create_nop_io_service_client();
 
     ready_timer_.start(
         [this] {
-          if (virtual_hid_keyboard_io_service_client_) {
-            virtual_hid_keyboard_io_service_client_->async_virtual_hid_keyboard_ready();
+          for (const auto& d : all_devices) {
+            if (get_virtual_hid_device(d).get_initialized()) {
+              async_virtual_hid_device_ready(d);
+            }
           }
 
-          if (virtual_hid_pointing_io_service_client_) {
-            virtual_hid_pointing_io_service_client_->async_virtual_hid_pointing_ready();
-          }
+          terminate_idle_virtual_hid_devices();
+
+          publish_device_ready();
         },
         std::chrono::milliseconds(1000));
 
@@ -42,17 +72,47 @@ public:
   virtual ~virtual_hid_device_service_server(void) {
     detach_from_dispatcher([this] {
       ready_timer_.stop();
+      creation_timer_.stop();
+      pointing_motion_timer_.stop();
+      text_input_timer_.stop();
 
       server_ = nullptr;
-      nop_io_service_client_ = nullptr;
-      virtual_hid_keyboard_io_service_client_ = nullptr;
-      virtual_hid_pointing_io_service_client_ = nullptr;
+      request_trace_writer_ = nullptr;
+      io_service_client_ = nullptr;
     });
 
     logger::get_logger()->info("virtual_hid_device_service_server is terminated");
   }
 
 private:
+  using device = pqrs::karabiner::driverkit::virtual_hid_device_service::metrics::device;
+
+  // A report which is held while the virtual device is being created.
+  struct pending_report final {
+    io_service_client::report_tag tag;
+    // Returns false if the report queue is full.
+    std::function<bool(io_service_client::report_tag)> post;
+  };
+
+  using virtual_hid_device = pqrs::karabiner::driverkit::virtual_hid_device_service::device_lifecycle::device<pending_report>;
+
+  static constexpr std::array<device, 3> all_devices{
+      device::virtual_hid_keyboard,
+      device::virtual_hid_pointing,
+      device::virtual_hid_absolute_pointing,
+  };
+
+  // A client which sends `request::sequenced_request`.
+  struct sequenced_sender final {
+    uint32_t id;
+    std::shared_ptr<asio::local::datagram_protocol::endpoint> endpoint;
+    pqrs::karabiner::driverkit::virtual_hid_device_service::flow_control::completion_tracker tracker;
+    uint64_t activity;
+  };
+
+  static constexpr size_t max_sequenced_sender_count = 32;
+  static constexpr size_t max_text_input_held_reports = 256;
+
   void create_rootonly_directory(void) const {
     std::error_code error_code;
     std::filesystem::create_directories(
@@ -79,18 +139,37 @@ private:
     }
   }
 
+  // This method is only called in the constructor.
+  void open_metrics(void) {
+    auto file_path = pqrs::karabiner::driverkit::virtual_hid_device_service::constants::metrics_file_path;
+    if (auto error_code = metrics_writer_.open(file_path)) {
+      // Counters are written into an in-process page.
+      logger::get_logger()->error("virtual_hid_device_service_server: metrics open error: {0}",
+                                  error_code.message());
+    }
+
+    server_metrics_.device_ready.fill(-1);
+    metrics_writer_.get_page().server.store(server_metrics_);
+  }
+
   void set_server_socket_file_permissions(void) const {
-    std::error_code error_code;
-    std::filesystem::permissions(
-        pqrs::karabiner::driverkit::virtual_hid_device_service::constants::server_socket_file_path,
-        std::filesystem::perms::owner_read | std::filesystem::perms::owner_write,
-        error_code);
-    if (error_code) {
-      logger::get_logger()->error(
-          "virtual_hid_device_service_server::{0} permissions error: {1}",
-          __func__,
-          error_code.message());
-      return;
+    std::string server_socket_file_path(pqrs::karabiner::driverkit::virtual_hid_device_service::constants::server_socket_file_path);
+
+    for (const auto& path : {
+             server_socket_file_path,
+             pqrs::local_datagram::server::connection_monitor_socket_file_path(server_socket_file_path),
+         }) {
+      std::error_code error_code;
+      std::filesystem::permissions(
+          path,
+          std::filesystem::perms::owner_read | std::filesystem::perms::owner_write,
+          error_code);
+      if (error_code) {
+        logger::get_logger()->error(
+            "virtual_hid_device_service_server::{0} permissions error: {1}",
+            __func__,
+            error_code.message());
+      }
     }
   }
 
@@ -101,6 +180,7 @@ private:
         pqrs::karabiner::driverkit::virtual_hid_device_service::constants::local_datagram_buffer_size);
     server_->set_server_check_interval(std::chrono::milliseconds(3000));
     server_->set_reconnect_interval(std::chrono::milliseconds(1000));
+    server_->set_connection_monitor_enabled(true);
 
     server_->bound.connect([this] {
       logger::get_logger()->info("virtual_hid_device_service_server: bound");
@@ -117,160 +197,485 @@ private:
       logger::get_logger()->info("virtual_hid_device_service_server: closed");
     });
 
+    server_->connection_monitor_peer_count_changed.connect([this](auto&& count) {
+      server_metrics_.connected_clients = count;
+      metrics_writer_.get_page().server.store(server_metrics_);
+    });
+
     server_->received.connect([this](auto&& buffer, auto&& sender_endpoint) {
       if (buffer) {
         if (buffer->empty()) {
           return;
         }
 
-        auto p = &((*buffer)[0]);
-        auto size = buffer->size();
+        if (client_activity_.enabled()) {
+          client_activity_.touch(sender_endpoint ? sender_endpoint->path() : "",
+                                 std::chrono::steady_clock::now());
+        }
 
-        auto request = pqrs::karabiner::driverkit::virtual_hid_device_service::request(*p);
-        ++p;
-        --size;
+        if (request_trace_writer_) {
+          append_request_trace(*buffer, sender_endpoint);
+        }
 
-        switch (request) {
-          case pqrs::karabiner::driverkit::virtual_hid_device_service::request::none:
-            break;
+        auto result = pqrs::karabiner::driverkit::virtual_hid_device_service::request_schema::decode(
+            buffer->data(),
+            buffer->size(),
+            [this, &sender_endpoint](auto r, auto&& payload) {
+              handle_request(r, payload, sender_endpoint);
+            });
 
-          case pqrs::karabiner::driverkit::virtual_hid_device_service::request::driver_loaded:
-            async_send_driver_loaded_result(sender_endpoint);
-            break;
+        if (result == pqrs::karabiner::driverkit::virtual_hid_device_service::request_schema::decode_result::size_mismatch) {
+          logger::get_rate_limited_logger()->warn("virtual_hid_device_service_server: received: buffer size error (request: {0})",
+                                                  (*buffer)[0]);
+        }
 
-          case pqrs::karabiner::driverkit::virtual_hid_device_service::request::driver_version_matched:
-            async_send_driver_version_matched_result(sender_endpoint);
-            break;
+        update_received_metrics((*buffer)[0], result);
+      }
+    });
 
-          case pqrs::karabiner::driverkit::virtual_hid_device_service::request::virtual_hid_keyboard_initialize: {
-            if (sizeof(pqrs::hid::country_code::value_t) != size) {
-              logger::get_logger()->warn("virtual_hid_device_service_server: received: virtual_hid_keyboard_initialize buffer size error");
-              return;
-            }
+    server_->async_start();
+  }
 
-            auto country_code = *(reinterpret_cast<pqrs::hid::country_code::value_t*>(p));
+  // This method is executed in the dispatcher thread.
+  template <pqrs::karabiner::driverkit::virtual_hid_device_service::request R>
+  void handle_request(std::integral_constant<pqrs::karabiner::driverkit::virtual_hid_device_service::request, R>,
+                      const pqrs::karabiner::driverkit::virtual_hid_device_service::request_schema::payload_t<R>& payload,
+                      std::shared_ptr<asio::local::datagram_protocol::endpoint> sender_endpoint) {
+    using request = pqrs::karabiner::driverkit::virtual_hid_device_service::request;
 
-            if (virtual_hid_keyboard_country_code_ != country_code) {
-              virtual_hid_keyboard_country_code_ = country_code;
+    if constexpr (R == request::none) {
+      // Do nothing
 
-              virtual_hid_keyboard_io_service_client_ = nullptr;
-            }
+    } else if constexpr (R == request::driver_loaded) {
+      async_send_driver_loaded_result(sender_endpoint);
 
-            if (!virtual_hid_keyboard_io_service_client_) {
-              create_virtual_hid_keyboard_io_service_client(country_code);
-            }
-            break;
-          }
+    } else if constexpr (R == request::driver_version_matched) {
+      async_send_driver_version_matched_result(sender_endpoint);
 
-          case pqrs::karabiner::driverkit::virtual_hid_device_service::request::virtual_hid_keyboard_terminate:
-            virtual_hid_keyboard_io_service_client_ = nullptr;
-            virtual_hid_keyboard_country_code_ = std::nullopt;
-            break;
-
-          case pqrs::karabiner::driverkit::virtual_hid_device_service::request::virtual_hid_keyboard_ready:
-            async_send_ready_result(
-                pqrs::karabiner::driverkit::virtual_hid_device_service::response::virtual_hid_keyboard_ready_result,
-                virtual_hid_keyboard_io_service_client_ ? virtual_hid_keyboard_io_service_client_->get_virtual_hid_keyboard_ready() : false,
-                sender_endpoint);
-            break;
-
-          case pqrs::karabiner::driverkit::virtual_hid_device_service::request::virtual_hid_keyboard_reset:
-            if (virtual_hid_keyboard_io_service_client_) {
-              virtual_hid_keyboard_io_service_client_->async_virtual_hid_keyboard_reset();
-            }
-            break;
+    } else if constexpr (R == request::virtual_hid_keyboard_initialize) {
+      auto country_code = pqrs::hid::country_code::value_t(payload);
 
-          case pqrs::karabiner::driverkit::virtual_hid_device_service::request::virtual_hid_pointing_initialize:
-            if (!virtual_hid_pointing_io_service_client_) {
-              create_virtual_hid_pointing_io_service_client();
-            }
-            break;
-
-          case pqrs::karabiner::driverkit::virtual_hid_device_service::request::virtual_hid_pointing_terminate:
-            virtual_hid_pointing_io_service_client_ = nullptr;
-            break;
-
-          case pqrs::karabiner::driverkit::virtual_hid_device_service::request::virtual_hid_pointing_ready:
-            async_send_ready_result(
-                pqrs::karabiner::driverkit::virtual_hid_device_service::response::virtual_hid_pointing_ready_result,
-                virtual_hid_pointing_io_service_client_ ? virtual_hid_pointing_io_service_client_->get_virtual_hid_pointing_ready() : false,
-                sender_endpoint);
-            break;
-
-          case pqrs::karabiner::driverkit::virtual_hid_device_service::request::virtual_hid_pointing_reset:
-            if (virtual_hid_pointing_io_service_client_) {
-              virtual_hid_pointing_io_service_client_->async_virtual_hid_pointing_reset();
-            }
-            break;
-
-          case pqrs::karabiner::driverkit::virtual_hid_device_service::request::post_keyboard_input_report:
-            async_post_report<pqrs::karabiner::driverkit::virtual_hid_device_driver::hid_report::keyboard_input>(
-                virtual_hid_keyboard_io_service_client_,
-                p,
-                size);
-            break;
-
-          case pqrs::karabiner::driverkit::virtual_hid_device_service::request::post_consumer_input_report:
-            async_post_report<pqrs::karabiner::driverkit::virtual_hid_device_driver::hid_report::consumer_input>(
-                virtual_hid_keyboard_io_service_client_,
-                p,
-                size);
-            break;
-
-          case pqrs::karabiner::driverkit::virtual_hid_device_service::request::post_apple_vendor_keyboard_input_report:
-            async_post_report<pqrs::karabiner::driverkit::virtual_hid_device_driver::hid_report::apple_vendor_keyboard_input>(
-                virtual_hid_keyboard_io_service_client_,
-                p,
-                size);
-            break;
-
-          case pqrs::karabiner::driverkit::virtual_hid_device_service::request::post_apple_vendor_top_case_input_report:
-            async_post_report<pqrs::karabiner::driverkit::virtual_hid_device_driver::hid_report::apple_vendor_top_case_input>(
-                virtual_hid_keyboard_io_service_client_,
-                p,
-                size);
-            break;
-
-          case pqrs::karabiner::driverkit::virtual_hid_device_service::request::post_pointing_input_report:
-            async_post_report<pqrs::karabiner::driverkit::virtual_hid_device_driver::hid_report::pointing_input>(
-                virtual_hid_pointing_io_service_client_,
-                p,
-                size);
-            break;
+      if (!virtual_hid_keyboard_.get_initialized() ||
+          virtual_hid_keyboard_country_code_ != country_code) {
+        if (virtual_hid_keyboard_.get_initialized()) {
+          // The country code is read when the keyboard is created.
+          io_service_client_->async_virtual_hid_keyboard_terminate();
         }
+
+        virtual_hid_keyboard_country_code_ = country_code;
+        io_service_client_->async_virtual_hid_keyboard_initialize(country_code);
       }
-    });
 
-    server_->async_start();
+      virtual_hid_keyboard_.initialize(std::chrono::steady_clock::now());
+
+      save_session_state();
+
+    } else if constexpr (R == request::virtual_hid_keyboard_terminate) {
+      terminate_virtual_hid_device(device::virtual_hid_keyboard);
+
+      save_session_state();
+
+    } else if constexpr (R == request::virtual_hid_keyboard_ready) {
+      async_send_ready_result(
+          pqrs::karabiner::driverkit::virtual_hid_device_service::response::virtual_hid_keyboard_ready_result,
+          get_virtual_hid_device_ready(device::virtual_hid_keyboard),
+          sender_endpoint);
+
+    } else if constexpr (R == request::virtual_hid_keyboard_reset) {
+      if (virtual_hid_keyboard_.get_initialized()) {
+        io_service_client_->async_virtual_hid_keyboard_reset();
+      }
+
+    } else if constexpr (R == request::virtual_hid_pointing_initialize) {
+      initialize_virtual_hid_device(device::virtual_hid_pointing);
+
+      save_session_state();
+
+    } else if constexpr (R == request::virtual_hid_pointing_terminate) {
+      terminate_virtual_hid_device(device::virtual_hid_pointing);
+
+      save_session_state();
+
+    } else if constexpr (R == request::virtual_hid_pointing_ready) {
+      async_send_ready_result(
+          pqrs::karabiner::driverkit::virtual_hid_device_service::response::virtual_hid_pointing_ready_result,
+          get_virtual_hid_device_ready(device::virtual_hid_pointing),
+          sender_endpoint);
+
+    } else if constexpr (R == request::virtual_hid_pointing_reset) {
+      if (virtual_hid_pointing_.get_initialized()) {
+        io_service_client_->async_virtual_hid_pointing_reset();
+      }
+
+    } else if constexpr (R == request::virtual_hid_absolute_pointing_initialize) {
+      initialize_virtual_hid_device(device::virtual_hid_absolute_pointing);
+
+      save_session_state();
+
+    } else if constexpr (R == request::virtual_hid_absolute_pointing_terminate) {
+      terminate_virtual_hid_device(device::virtual_hid_absolute_pointing);
+
+      save_session_state();
+
+    } else if constexpr (R == request::virtual_hid_absolute_pointing_ready) {
+      async_send_ready_result(
+          pqrs::karabiner::driverkit::virtual_hid_device_service::response::virtual_hid_absolute_pointing_ready_result,
+          get_virtual_hid_device_ready(device::virtual_hid_absolute_pointing),
+          sender_endpoint);
+
+    } else if constexpr (R == request::virtual_hid_absolute_pointing_reset) {
+      if (virtual_hid_absolute_pointing_.get_initialized()) {
+        io_service_client_->async_virtual_hid_absolute_pointing_reset();
+      }
+
+    } else if constexpr (R == request::post_keyboard_input_report) {
+      if (text_synthesizers_.empty()) {
+        async_post_report(device::virtual_hid_keyboard, payload);
+      } else {
+        hold_keyboard_input_report(payload);
+      }
+
+    } else if constexpr (R == request::post_keyboard_bitmap_input_report ||
+                         R == request::post_consumer_input_report ||
+                         R == request::post_apple_vendor_keyboard_input_report ||
+                         R == request::post_apple_vendor_top_case_input_report) {
+      async_post_report(device::virtual_hid_keyboard, payload);
+
+    } else if constexpr (R == request::post_pointing_input_report ||
+                         R == request::post_pointing_high_resolution_input_report) {
+      async_post_report(device::virtual_hid_pointing, payload);
+
+    } else if constexpr (R == request::post_absolute_pointing_input_report) {
+      async_post_report(device::virtual_hid_absolute_pointing, payload);
+
+    } else if constexpr (R == request::post_pointing_motion) {
+      start_pointing_motion(payload);
+
+    } else if constexpr (R == request::cancel_pointing_motion) {
+      stop_pointing_motion();
+
+    } else if constexpr (R == request::request_trace_start) {
+      start_request_trace();
+
+    } else if constexpr (R == request::request_trace_stop) {
+      stop_request_trace();
+
+    } else if constexpr (R == request::sequenced_request) {
+      handle_sequenced_request(payload, sender_endpoint);
+
+    } else if constexpr (R == request::correlated_request) {
+      handle_correlated_request(payload, sender_endpoint);
+
+    } else if constexpr (R == request::post_text) {
+      start_text_input(payload, sender_endpoint);
+
+    } else {
+      static_assert(R == request::none, "unhandled request");
+    }
   }
 
   // This method is only called in the constructor.
-  void create_nop_io_service_client(void) {
-    nop_io_service_client_ = std::make_unique<io_service_client>();
+  void create_io_service_client(void) {
+    io_service_client_ = std::make_unique<io_service_client>(weak_dispatcher_,
+                                                             std::array<std::weak_ptr<pqrs::dispatcher::dispatcher>, pqrs::karabiner::driverkit::virtual_hid_device_service::metrics::device_count>{
+                                                                 virtual_hid_keyboard_forwarding_thread_.get_weak_dispatcher(),
+                                                                 virtual_hid_pointing_forwarding_thread_.get_weak_dispatcher(),
+                                                                 virtual_hid_absolute_pointing_forwarding_thread_.get_weak_dispatcher(),
+                                                             },
+                                                             &(metrics_writer_.get_page()));
 
-    nop_io_service_client_->async_start();
+    // `opened` is invoked in the dispatcher thread.
+    // Virtual devices are created again when the driver is restarted.
+    io_service_client_->opened.connect([this] {
+      enqueue_to_dispatcher([this] {
+        initialize_virtual_hid_devices();
+      });
+    });
+
+    // `reports_completed` is invoked in the forwarding threads.
+    io_service_client_->reports_completed.connect([this](auto&& tags) {
+      enqueue_to_dispatcher([this, tags] {
+        complete_sequenced_reports(tags);
+      });
+    });
+
+    io_service_client_->async_start();
   }
 
   // This method is executed in the dispatcher thread.
-  void create_virtual_hid_keyboard_io_service_client(pqrs::hid::country_code::value_t country_code) {
-    virtual_hid_keyboard_io_service_client_ = std::make_unique<io_service_client>();
+  void initialize_virtual_hid_devices(void) {
+    for (const auto& d : all_devices) {
+      if (get_virtual_hid_device(d).get_initialized()) {
+        async_virtual_hid_device_initialize(d);
+      }
+    }
+  }
 
-    virtual_hid_keyboard_io_service_client_->opened.connect([this, country_code] {
-      virtual_hid_keyboard_io_service_client_->async_virtual_hid_keyboard_initialize(country_code);
-    });
+  // This method is executed in the dispatcher thread.
+  virtual_hid_device& get_virtual_hid_device(device d) {
+    switch (d) {
+      case device::virtual_hid_pointing:
+        return virtual_hid_pointing_;
+      case device::virtual_hid_absolute_pointing:
+        return virtual_hid_absolute_pointing_;
+      case device::virtual_hid_keyboard:
+      case device::end_:
+        break;
+    }
+    return virtual_hid_keyboard_;
+  }
+
+  static const char* get_virtual_hid_device_name(device d) {
+    switch (d) {
+      case device::virtual_hid_pointing:
+        return "virtual_hid_pointing";
+      case device::virtual_hid_absolute_pointing:
+        return "virtual_hid_absolute_pointing";
+      case device::virtual_hid_keyboard:
+      case device::end_:
+        break;
+    }
+    return "virtual_hid_keyboard";
+  }
 
-    virtual_hid_keyboard_io_service_client_->async_start();
+  // This method is executed in the dispatcher thread.
+  void async_virtual_hid_device_initialize(device d) {
+    switch (d) {
+      case device::virtual_hid_keyboard:
+        io_service_client_->async_virtual_hid_keyboard_initialize(virtual_hid_keyboard_country_code_);
+        break;
+      case device::virtual_hid_pointing:
+        io_service_client_->async_virtual_hid_pointing_initialize();
+        break;
+      case device::virtual_hid_absolute_pointing:
+        io_service_client_->async_virtual_hid_absolute_pointing_initialize();
+        break;
+      case device::end_:
+        break;
+    }
+  }
+
+  // This method is executed in the dispatcher thread.
+  void async_virtual_hid_device_terminate(device d) {
+    switch (d) {
+      case device::virtual_hid_keyboard:
+        io_service_client_->async_virtual_hid_keyboard_terminate();
+        break;
+      case device::virtual_hid_pointing:
+        io_service_client_->async_virtual_hid_pointing_terminate();
+        break;
+      case device::virtual_hid_absolute_pointing:
+        io_service_client_->async_virtual_hid_absolute_pointing_terminate();
+        break;
+      case device::end_:
+        break;
+    }
   }
 
   // This method is executed in the dispatcher thread.
-  void create_virtual_hid_pointing_io_service_client(void) {
-    virtual_hid_pointing_io_service_client_ = std::make_unique<io_service_client>();
+  void async_virtual_hid_device_ready(device d) {
+    switch (d) {
+      case device::virtual_hid_keyboard:
+        io_service_client_->async_virtual_hid_keyboard_ready();
+        break;
+      case device::virtual_hid_pointing:
+        io_service_client_->async_virtual_hid_pointing_ready();
+        break;
+      case device::virtual_hid_absolute_pointing:
+        io_service_client_->async_virtual_hid_absolute_pointing_ready();
+        break;
+      case device::end_:
+        break;
+    }
+  }
+
+  // This method is executed in the dispatcher thread.
+  // Returns std::nullopt if the virtual device is initialized and the state is unknown.
+  std::optional<bool> get_virtual_hid_device_ready(device d) {
+    if (!get_virtual_hid_device(d).get_initialized()) {
+      return false;
+    }
+
+    switch (d) {
+      case device::virtual_hid_keyboard:
+        return io_service_client_->get_virtual_hid_keyboard_ready();
+      case device::virtual_hid_pointing:
+        return io_service_client_->get_virtual_hid_pointing_ready();
+      case device::virtual_hid_absolute_pointing:
+        return io_service_client_->get_virtual_hid_absolute_pointing_ready();
+      case device::end_:
+        break;
+    }
+    return std::nullopt;
+  }
+
+  // This method is executed in the dispatcher thread.
+  void initialize_virtual_hid_device(device d) {
+    auto& v = get_virtual_hid_device(d);
+    if (!v.get_initialized()) {
+      async_virtual_hid_device_initialize(d);
+    }
 
-    virtual_hid_pointing_io_service_client_->opened.connect([this] {
-      virtual_hid_pointing_io_service_client_->async_virtual_hid_pointing_initialize();
+    v.initialize(std::chrono::steady_clock::now());
+  }
+
+  // This method is executed in the dispatcher thread.
+  // Held reports are discarded.
+  void terminate_virtual_hid_device(device d) {
+    if (d == device::virtual_hid_keyboard) {
+      stop_text_input();
+    } else if (d == device::virtual_hid_pointing) {
+      stop_pointing_motion();
+    }
+
+    auto& v = get_virtual_hid_device(d);
+    if (!v.get_initialized()) {
+      return;
+    }
+
+    std::vector<io_service_client::report_tag> tags;
+    v.terminate([&tags](auto&& r) {
+      tags.push_back(r.tag);
     });
+    complete_sequenced_reports(tags);
+
+    async_virtual_hid_device_terminate(d);
+  }
+
+  // This method is executed in the dispatcher thread.
+  // The virtual device is created by a report. (`device_lifecycle::options::lazy_creation`)
+  void create_virtual_hid_device(device d) {
+    logger::get_logger()->info("virtual_hid_device_service_server: {0} is created by a report",
+                               get_virtual_hid_device_name(d));
+
+    async_virtual_hid_device_initialize(d);
+    save_session_state();
+
+    // Held reports are posted when the virtual device becomes ready.
+    creation_timer_.start(
+        [this] {
+          post_pending_reports();
+        },
+        std::chrono::milliseconds(10));
+  }
+
+  // This method is executed in the dispatcher thread.
+  void post_pending_reports(void) {
+    bool creating = false;
+
+    for (const auto& d : all_devices) {
+      auto& v = get_virtual_hid_device(d);
+      if (!v.get_creating()) {
+        continue;
+      }
+
+      if (get_virtual_hid_device_ready(d) != true) {
+        creating = true;
+        async_virtual_hid_device_ready(d);
+        continue;
+      }
+
+      logger::get_logger()->info("virtual_hid_device_service_server: {0} is ready (pending reports: {1})",
+                                 get_virtual_hid_device_name(d),
+                                 v.get_pending_report_count());
+
+      std::vector<io_service_client::report_tag> dropped_tags;
+      v.ready([&dropped_tags](auto&& r) {
+        // The tag is completed by `reports_completed` if the report is posted.
+        if (!r.post(r.tag)) {
+          dropped_tags.push_back(r.tag);
+        }
+      });
+      complete_sequenced_reports(dropped_tags);
+
+      publish_device_ready();
+    }
+
+    if (!creating) {
+      creation_timer_.stop();
+    }
+  }
+
+  // This method is executed in the dispatcher thread.
+  // Virtual devices which receive no report for `device_lifecycle::options::idle_timeout` are terminated while no client is active.
+  // Clients which do not use the connection monitor are active while they send requests.
+  void terminate_idle_virtual_hid_devices(void) {
+    auto now = std::chrono::steady_clock::now();
+    bool terminated = false;
+
+    auto active_clients = server_metrics_.connected_clients + client_activity_.count(now);
+
+    for (const auto& d : all_devices) {
+      if (get_virtual_hid_device(d).idle(now, active_clients)) {
+        logger::get_logger()->info("virtual_hid_device_service_server: {0} is terminated by the idle timeout",
+                                   get_virtual_hid_device_name(d));
+
+        terminate_virtual_hid_device(d);
+        terminated = true;
+      }
+    }
+
+    if (terminated) {
+      save_session_state();
+    }
+  }
+
+  // This method is executed in the dispatcher thread.
+  // Virtual devices are created when `io_service_client_` is opened.
+  void restore_session_state(void) {
+    auto s = pqrs::karabiner::driverkit::virtual_hid_device_service::session_state::load(
+        pqrs::karabiner::driverkit::virtual_hid_device_service::constants::session_state_file_path);
+    if (!s) {
+      return;
+    }
+
+    saved_session_state_ = *s;
+
+    auto now = std::chrono::steady_clock::now();
+
+    if (s->virtual_hid_keyboard_country_code) {
+      virtual_hid_keyboard_country_code_ = pqrs::hid::country_code::value_t(*(s->virtual_hid_keyboard_country_code));
+      virtual_hid_keyboard_.initialize(now);
+
+      logger::get_logger()->info("virtual_hid_device_service_server: virtual_hid_keyboard is restored (country_code: {0})",
+                                 *(s->virtual_hid_keyboard_country_code));
+    }
+
+    if (s->virtual_hid_pointing_initialized) {
+      virtual_hid_pointing_.initialize(now);
+
+      logger::get_logger()->info("virtual_hid_device_service_server: virtual_hid_pointing is restored");
+    }
+
+    if (s->virtual_hid_absolute_pointing_initialized) {
+      virtual_hid_absolute_pointing_.initialize(now);
+
+      logger::get_logger()->info("virtual_hid_device_service_server: virtual_hid_absolute_pointing is restored");
+    }
+  }
+
+  // This method is executed in the dispatcher thread.
+  void save_session_state(void) {
+    pqrs::karabiner::driverkit::virtual_hid_device_service::session_state::state s;
+    if (virtual_hid_keyboard_.get_initialized()) {
+      s.virtual_hid_keyboard_country_code = type_safe::get(virtual_hid_keyboard_country_code_);
+    }
+    s.virtual_hid_pointing_initialized = virtual_hid_pointing_.get_initialized();
+    s.virtual_hid_absolute_pointing_initialized = virtual_hid_absolute_pointing_.get_initialized();
+
+    if (s == saved_session_state_) {
+      return;
+    }
+
+    if (auto error_code = pqrs::karabiner::driverkit::virtual_hid_device_service::session_state::save(
+            pqrs::karabiner::driverkit::virtual_hid_device_service::constants::session_state_file_path,
+            s)) {
+      logger::get_logger()->error("virtual_hid_device_service_server: session_state save error: {0}",
+                                  error_code.message());
+      return;
+    }
 
-    virtual_hid_pointing_io_service_client_->async_start();
+    saved_session_state_ = s;
   }
 
   // This method is executed in the dispatcher thread.
@@ -278,8 +683,8 @@ private:
     if (server_) {
       if (!endpoint->path().empty()) {
         bool driver_loaded = false;
-        if (nop_io_service_client_) {
-          driver_loaded = nop_io_service_client_->driver_loaded();
+        if (io_service_client_) {
+          driver_loaded = io_service_client_->driver_loaded();
         }
 
         auto response = pqrs::karabiner::driverkit::virtual_hid_device_service::response::driver_loaded_result;
@@ -288,7 +693,7 @@ private:
             driver_loaded,
         };
 
-        server_->async_send(buffer, sizeof(buffer), endpoint);
+        async_send_response(buffer, sizeof(buffer), endpoint);
       }
     }
   }
@@ -298,8 +703,8 @@ private:
     if (server_) {
       if (!endpoint->path().empty()) {
         bool driver_version_matched = false;
-        if (nop_io_service_client_) {
-          driver_version_matched = nop_io_service_client_->driver_version_matched();
+        if (io_service_client_) {
+          driver_version_matched = io_service_client_->driver_version_matched();
         }
 
         auto response = pqrs::karabiner::driverkit::virtual_hid_device_service::response::driver_version_matched_result;
@@ -308,7 +713,7 @@ private:
             driver_version_matched,
         };
 
-        server_->async_send(buffer, sizeof(buffer), endpoint);
+        async_send_response(buffer, sizeof(buffer), endpoint);
       }
     }
   }
@@ -324,32 +729,511 @@ private:
             ready ? *ready : false,
         };
 
-        server_->async_send(buffer, sizeof(buffer), endpoint);
+        async_send_response(buffer, sizeof(buffer), endpoint);
+      }
+    }
+  }
+
+  // This method is executed in the dispatcher thread.
+  void async_send_response(const uint8_t* buffer,
+                           size_t buffer_size,
+                           std::shared_ptr<asio::local::datagram_protocol::endpoint> endpoint) {
+    if (!correlation_id_) {
+      server_->async_send(buffer, buffer_size, endpoint);
+      return;
+    }
+
+    auto response = pqrs::karabiner::driverkit::virtual_hid_device_service::response::correlated_result;
+    std::vector<uint8_t> b(1 + sizeof(*correlation_id_) + buffer_size);
+    b[0] = static_cast<std::underlying_type<decltype(response)>::type>(response);
+    memcpy(&(b[1]), &(*correlation_id_), sizeof(*correlation_id_));
+    memcpy(&(b[1 + sizeof(*correlation_id_)]), buffer, buffer_size);
+
+    server_->async_send(b, endpoint);
+  }
+
+  // This method is executed in the dispatcher thread.
+  // A new motion supersedes the running one.
+  void start_pointing_motion(const pqrs::karabiner::driverkit::virtual_hid_device_service::pointing_motion& motion) {
+    pointing_motion_synthesizer_ = std::make_unique<pqrs::karabiner::driverkit::virtual_hid_device_service::motion_synthesizer>(motion);
+
+    pointing_motion_timer_.start(
+        [this] {
+          if (!pointing_motion_synthesizer_) {
+            return;
+          }
+
+          async_post_report(device::virtual_hid_pointing, pointing_motion_synthesizer_->next());
+
+          if (pointing_motion_synthesizer_->finished()) {
+            stop_pointing_motion();
+          }
+        },
+        std::chrono::milliseconds(pointing_motion_synthesizer_->get_interval_milliseconds()));
+  }
+
+  // This method is executed in the dispatcher thread.
+  void stop_pointing_motion(void) {
+    pointing_motion_timer_.stop();
+    pointing_motion_synthesizer_ = nullptr;
+  }
+
+  // This method is executed in the dispatcher thread.
+  // Texts are typed in the order of requests.
+  void start_text_input(const pqrs::karabiner::driverkit::virtual_hid_device_service::request_schema::text_payload& payload,
+                        std::shared_ptr<asio::local::datagram_protocol::endpoint> sender_endpoint) {
+    auto l = pqrs::karabiner::driverkit::virtual_hid_device_service::text_input::find_layout(virtual_hid_keyboard_country_code_);
+    auto s = std::make_unique<pqrs::karabiner::driverkit::virtual_hid_device_service::text_input::text_synthesizer>(
+        l,
+        std::string_view(payload.text, payload.text_size));
+
+    async_send_post_text_result(*s, sender_endpoint);
+
+    if (s->finished()) {
+      return;
+    }
+
+    // The text is typed after the keyboard becomes ready if it is created by the text.
+    switch (virtual_hid_keyboard_.receive_report(std::chrono::steady_clock::now())) {
+      case pqrs::karabiner::driverkit::virtual_hid_device_service::device_lifecycle::report_action::drop:
+        return;
+      case pqrs::karabiner::driverkit::virtual_hid_device_service::device_lifecycle::report_action::create:
+        create_virtual_hid_device(device::virtual_hid_keyboard);
+        break;
+      case pqrs::karabiner::driverkit::virtual_hid_device_service::device_lifecycle::report_action::hold:
+      case pqrs::karabiner::driverkit::virtual_hid_device_service::device_lifecycle::report_action::post:
+        break;
+    }
+
+    text_synthesizers_.push_back(std::move(s));
+
+    if (text_synthesizers_.size() == 1) {
+      text_input_timer_.start(
+          [this] {
+            post_text_input_reports();
+          },
+          std::chrono::milliseconds(1));
+    }
+  }
+
+  // This method is executed in the dispatcher thread.
+  // Posts reports while the report queue has space, and the timer continues the rest.
+  void post_text_input_reports(void) {
+    while (!text_synthesizers_.empty()) {
+      if (!virtual_hid_keyboard_.get_initialized()) {
+        stop_text_input();
+        return;
+      }
+
+      if (virtual_hid_keyboard_.get_creating()) {
+        return;
+      }
+
+      virtual_hid_keyboard_.touch(std::chrono::steady_clock::now());
+
+      auto& s = text_synthesizers_.front();
+      while (!s->finished()) {
+        if (io_service_client_->get_report_queue_size(device::virtual_hid_keyboard) >= io_service_client::report_queue_capacity()) {
+          return;
+        }
+
+        // Text reports are not tagged. (The ack of a sequenced `post_text` means the text is accepted.)
+        io_service_client_->async_post_report(s->next());
+      }
+
+      text_synthesizers_.pop_front();
+    }
+
+    text_input_timer_.stop();
+
+    std::vector<io_service_client::report_tag> dropped_tags;
+    for (auto&& r : text_input_held_reports_) {
+      // The tag is completed by `reports_completed` if the report is posted.
+      if (!r.post(r.tag)) {
+        dropped_tags.push_back(r.tag);
+      }
+    }
+    text_input_held_reports_.clear();
+    complete_sequenced_reports(dropped_tags);
+  }
+
+  // This method is executed in the dispatcher thread.
+  void stop_text_input(void) {
+    text_input_timer_.stop();
+    text_synthesizers_.clear();
+
+    std::vector<io_service_client::report_tag> tags;
+    for (auto&& r : text_input_held_reports_) {
+      tags.push_back(r.tag);
+    }
+    text_input_held_reports_.clear();
+    complete_sequenced_reports(tags);
+  }
+
+  // This method is executed in the dispatcher thread.
+  // `keyboard_input` reports are held until texts are typed
+  // because text reports replace the whole `keyboard_input` state.
+  void hold_keyboard_input_report(const pqrs::karabiner::driverkit::virtual_hid_device_driver::hid_report::keyboard_input& report) {
+    if (text_input_held_reports_.size() >= max_text_input_held_reports) {
+      // The tag is completed by `handle_sequenced_request`.
+      logger::get_rate_limited_logger()->warn("virtual_hid_device_service_server: keyboard_input reports held during post_text are full");
+      return;
+    }
+
+    auto tag = sequenced_report_tag_ ? *sequenced_report_tag_ : io_service_client::report_tag();
+    text_input_held_reports_.push_back(pending_report{
+        tag,
+        [this, report](auto&& t) {
+          return io_service_client_->async_post_report(report, t);
+        },
+    });
+
+    // The tag is completed when the report is posted.
+    sequenced_report_tag_ = std::nullopt;
+  }
+
+  // This method is executed in the dispatcher thread.
+  void async_send_post_text_result(const pqrs::karabiner::driverkit::virtual_hid_device_service::text_input::text_synthesizer& s,
+                                   std::shared_ptr<asio::local::datagram_protocol::endpoint> endpoint) {
+    if (server_) {
+      if (!endpoint->path().empty()) {
+        auto& unmapped_characters = s.get_unmapped_characters();
+
+        pqrs::karabiner::driverkit::virtual_hid_device_service::post_text_result_payload payload{
+            static_cast<uint32_t>(s.get_mapped_characters()),
+            static_cast<uint32_t>(unmapped_characters.size()),
+        };
+        auto count = std::min(unmapped_characters.size(),
+                              pqrs::karabiner::driverkit::virtual_hid_device_service::max_reported_unmapped_characters);
+
+        auto response = pqrs::karabiner::driverkit::virtual_hid_device_service::response::post_text_result;
+        std::vector<uint8_t> buffer(1 + sizeof(payload) + count * sizeof(unmapped_characters[0]));
+        buffer[0] = static_cast<std::underlying_type<decltype(response)>::type>(response);
+        memcpy(&(buffer[1]), &payload, sizeof(payload));
+        if (count > 0) {
+          memcpy(&(buffer[1 + sizeof(payload)]), unmapped_characters.data(), count * sizeof(unmapped_characters[0]));
+        }
+
+        async_send_response(buffer.data(), buffer.size(), endpoint);
       }
     }
   }
 
   // This method is executed in the dispatcher thread.
+  void start_request_trace(void) {
+    if (request_trace_writer_) {
+      return;
+    }
+
+    auto w = std::make_unique<pqrs::karabiner::driverkit::virtual_hid_device_service::request_trace::writer>();
+    auto file_path = pqrs::karabiner::driverkit::virtual_hid_device_service::constants::request_trace_file_path;
+    if (auto error_code = w->open(file_path)) {
+      logger::get_logger()->error("virtual_hid_device_service_server: request_trace open error: {0}",
+                                  error_code.message());
+      return;
+    }
+
+    request_trace_writer_ = std::move(w);
+
+    logger::get_logger()->info("virtual_hid_device_service_server: request_trace is started: {0}",
+                               file_path);
+  }
+
+  // This method is executed in the dispatcher thread.
+  void stop_request_trace(void) {
+    if (!request_trace_writer_) {
+      return;
+    }
+
+    request_trace_writer_ = nullptr;
+
+    logger::get_logger()->info("virtual_hid_device_service_server: request_trace is stopped");
+  }
+
+  // This method is executed in the dispatcher thread.
+  void append_request_trace(const std::vector<uint8_t>& buffer,
+                            std::shared_ptr<asio::local::datagram_protocol::endpoint> sender_endpoint) {
+    auto request = pqrs::karabiner::driverkit::virtual_hid_device_service::request(buffer[0]);
+    if (request == pqrs::karabiner::driverkit::virtual_hid_device_service::request::request_trace_start ||
+        request == pqrs::karabiner::driverkit::virtual_hid_device_service::request::request_trace_stop) {
+      return;
+    }
+
+    auto timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch());
+
+    if (auto error_code = request_trace_writer_->append(timestamp,
+                                                         sender_endpoint ? sender_endpoint->path() : "",
+                                                         buffer.data(),
+                                                         buffer.size())) {
+      logger::get_logger()->error("virtual_hid_device_service_server: request_trace append error: {0}",
+                                  error_code.message());
+      stop_request_trace();
+    }
+  }
+
+  // This method is executed in the dispatcher thread.
+  void update_received_metrics(uint8_t request,
+                               pqrs::karabiner::driverkit::virtual_hid_device_service::request_schema::decode_result result) {
+    static_assert(pqrs::karabiner::driverkit::virtual_hid_device_service::request_schema::request_count <=
+                      std::tuple_size<decltype(pqrs::karabiner::driverkit::virtual_hid_device_service::metrics::server_metrics::received_requests)>::value,
+                  "metrics::server_metrics::received_requests is too small");
+
+    if (request < server_metrics_.received_requests.size()) {
+      ++server_metrics_.received_requests[request];
+    }
+
+    if (result == pqrs::karabiner::driverkit::virtual_hid_device_service::request_schema::decode_result::unknown_request ||
+        result == pqrs::karabiner::driverkit::virtual_hid_device_service::request_schema::decode_result::size_mismatch) {
+      ++server_metrics_.parse_errors;
+    }
+
+    metrics_writer_.get_page().server.store(server_metrics_);
+  }
+
+  // This method is executed in the dispatcher thread.
+  void publish_device_ready(void) {
+    auto to_gauge = [](std::optional<bool> ready) -> int64_t {
+      return ready ? *ready : -1;
+    };
+
+    for (const auto& d : all_devices) {
+      server_metrics_.device_ready[static_cast<size_t>(d)] =
+          get_virtual_hid_device(d).get_initialized() ? to_gauge(get_virtual_hid_device_ready(d)) : -1;
+    }
+
+    metrics_writer_.get_page().server.store(server_metrics_);
+  }
+
+  // This method is executed in the dispatcher thread.
+  // The report is tagged with `sequenced_report_tag_` while a sequenced request is handled.
+  // The report is ignored if the virtual device is not initialized and `lazy_creation` is disabled.
   template <typename T>
-  void async_post_report(const std::unique_ptr<io_service_client>& io_service_client,
-                         const uint8_t* buffer,
-                         size_t buffer_size) {
-    if (io_service_client) {
-      if (sizeof(T) != buffer_size) {
-        logger::get_logger()->warn("virtual_hid_device_service_server: post_report buffer size error");
+  void async_post_report(device d,
+                         const T& report) {
+    if (!io_service_client_) {
+      return;
+    }
+
+    auto& v = get_virtual_hid_device(d);
+    auto tag = sequenced_report_tag_ ? *sequenced_report_tag_ : io_service_client::report_tag();
+
+    switch (v.receive_report(std::chrono::steady_clock::now())) {
+      case pqrs::karabiner::driverkit::virtual_hid_device_service::device_lifecycle::report_action::drop:
+        break;
+
+      case pqrs::karabiner::driverkit::virtual_hid_device_service::device_lifecycle::report_action::create:
+        create_virtual_hid_device(d);
+        [[fallthrough]];
+
+      case pqrs::karabiner::driverkit::virtual_hid_device_service::device_lifecycle::report_action::hold:
+        if (v.push_pending_report(pending_report{
+                tag,
+                [this, report](auto&& t) {
+                  return io_service_client_->async_post_report(report, t);
+                },
+            })) {
+          // The tag is completed when the report is posted.
+          sequenced_report_tag_ = std::nullopt;
+        } else {
+          logger::get_rate_limited_logger()->warn("virtual_hid_device_service_server: {0}: pending reports are full",
+                                                  get_virtual_hid_device_name(d));
+        }
+        break;
+
+      case pqrs::karabiner::driverkit::virtual_hid_device_service::device_lifecycle::report_action::post:
+        if (io_service_client_->async_post_report(report, tag)) {
+          // The tag is completed by `reports_completed`.
+          sequenced_report_tag_ = std::nullopt;
+        }
+        break;
+    }
+  }
+
+  // This method is executed in the dispatcher thread.
+  void handle_sequenced_request(const pqrs::karabiner::driverkit::virtual_hid_device_service::request_schema::sequenced_payload& payload,
+                                std::shared_ptr<asio::local::datagram_protocol::endpoint> sender_endpoint) {
+    // Acks cannot be sent to unbound clients.
+    if (sender_endpoint && !sender_endpoint->path().empty()) {
+      auto& sender = find_or_create_sequenced_sender(sender_endpoint);
+      if (!sender.tracker.receive(payload.sequence)) {
+        // Duplicated or outdated sequence.
         return;
       }
 
-      io_service_client->async_post_report(*(reinterpret_cast<const T*>(buffer)));
+      sequenced_report_tag_ = io_service_client::report_tag{sender.id, payload.sequence};
+    }
+
+    auto result = pqrs::karabiner::driverkit::virtual_hid_device_service::request_schema::decode(
+        payload.message,
+        payload.message_size,
+        [this, &sender_endpoint](auto r, auto&& p) {
+          // Nested wrapped requests are ignored.
+          if constexpr (!pqrs::karabiner::driverkit::virtual_hid_device_service::request_schema::is_wrapped<decltype(r)::value>) {
+            handle_request(r, p, sender_endpoint);
+          }
+        });
+
+    if (result != pqrs::karabiner::driverkit::virtual_hid_device_service::request_schema::decode_result::ok) {
+      ++server_metrics_.parse_errors;
+      metrics_writer_.get_page().server.store(server_metrics_);
+    }
+
+    // The wrapped request is not passed to the forwarding thread.
+    // (e.g., non-report requests, the virtual device is not initialized, the report queue is full, pending reports are full)
+    if (sequenced_report_tag_) {
+      auto tag = *sequenced_report_tag_;
+      sequenced_report_tag_ = std::nullopt;
+      complete_sequenced_reports({tag});
+    }
+  }
+
+  // This method is executed in the dispatcher thread.
+  // Responses of the wrapped request are wrapped with the correlation id.
+  void handle_correlated_request(const pqrs::karabiner::driverkit::virtual_hid_device_service::request_schema::correlated_payload& payload,
+                                 std::shared_ptr<asio::local::datagram_protocol::endpoint> sender_endpoint) {
+    correlation_id_ = payload.correlation_id;
+
+    auto result = pqrs::karabiner::driverkit::virtual_hid_device_service::request_schema::decode(
+        payload.message,
+        payload.message_size,
+        [this, &sender_endpoint](auto r, auto&& p) {
+          // Nested wrapped requests are ignored.
+          if constexpr (!pqrs::karabiner::driverkit::virtual_hid_device_service::request_schema::is_wrapped<decltype(r)::value>) {
+            handle_request(r, p, sender_endpoint);
+          }
+        });
+
+    if (result != pqrs::karabiner::driverkit::virtual_hid_device_service::request_schema::decode_result::ok) {
+      ++server_metrics_.parse_errors;
+      metrics_writer_.get_page().server.store(server_metrics_);
+    }
+
+    correlation_id_ = std::nullopt;
+  }
+
+  // This method is executed in the dispatcher thread.
+  sequenced_sender& find_or_create_sequenced_sender(std::shared_ptr<asio::local::datagram_protocol::endpoint> sender_endpoint) {
+    ++sequenced_sender_activity_;
+
+    auto it = sequenced_senders_.find(sender_endpoint->path());
+    if (it != std::end(sequenced_senders_)) {
+      it->second.activity = sequenced_sender_activity_;
+      return it->second;
+    }
+
+    // Forget the least recently active sender (e.g., terminated clients).
+    if (sequenced_senders_.size() >= max_sequenced_sender_count) {
+      auto oldest = std::min_element(std::begin(sequenced_senders_),
+                                     std::end(sequenced_senders_),
+                                     [](auto&& a, auto&& b) {
+                                       return a.second.activity < b.second.activity;
+                                     });
+      sequenced_sender_paths_.erase(oldest->second.id);
+      sequenced_senders_.erase(oldest);
+    }
+
+    // 0 is reserved for untagged reports.
+    if (++last_sequenced_sender_id_ == 0) {
+      ++last_sequenced_sender_id_;
+    }
+
+    sequenced_sender_paths_[last_sequenced_sender_id_] = sender_endpoint->path();
+
+    auto& sender = sequenced_senders_[sender_endpoint->path()];
+    sender.id = last_sequenced_sender_id_;
+    sender.endpoint = sender_endpoint;
+    sender.activity = sequenced_sender_activity_;
+    return sender;
+  }
+
+  // This method is executed in the dispatcher thread.
+  void complete_sequenced_reports(const std::vector<io_service_client::report_tag>& tags) {
+    std::vector<sequenced_sender*> advanced_senders;
+
+    for (const auto& tag : tags) {
+      auto path_it = sequenced_sender_paths_.find(tag.sender_id);
+      if (path_it == std::end(sequenced_sender_paths_)) {
+        continue;
+      }
+
+      auto& sender = sequenced_senders_[path_it->second];
+      if (sender.tracker.complete(tag.sequence)) {
+        if (std::find(std::begin(advanced_senders), std::end(advanced_senders), &sender) == std::end(advanced_senders)) {
+          advanced_senders.push_back(&sender);
+        }
+      }
+    }
+
+    if (advanced_senders.empty() || !server_) {
+      return;
+    }
+
+    // Credits reflect the most loaded report queue.
+    size_t queue_size = 0;
+    if (io_service_client_) {
+      for (const auto& d : all_devices) {
+        queue_size = std::max(queue_size, io_service_client_->get_report_queue_size(d));
+      }
+    }
+
+    auto credits = pqrs::karabiner::driverkit::virtual_hid_device_service::flow_control::make_credits(
+        io_service_client::report_queue_capacity(),
+        queue_size,
+        sequenced_senders_.size(),
+        pqrs::karabiner::driverkit::virtual_hid_device_service::constants::flow_control_max_credits);
+
+    for (const auto& sender : advanced_senders) {
+      auto response = pqrs::karabiner::driverkit::virtual_hid_device_service::response::report_ack;
+      pqrs::karabiner::driverkit::virtual_hid_device_service::report_ack_payload payload{
+          sender->tracker.get_completed_sequence(),
+          credits,
+      };
+
+      uint8_t buffer[1 + sizeof(payload)];
+      buffer[0] = static_cast<std::underlying_type<decltype(response)>::type>(response);
+      memcpy(buffer + 1, &payload, sizeof(payload));
+
+      server_->async_send(buffer, sizeof(buffer), sender->endpoint);
     }
   }
 
-  // `nop_io_service_client_` does not control virtual devices.
-  // It is used for `driver_loaded` and `driver_version_matched`.
-  std::unique_ptr<io_service_client> nop_io_service_client_;
-  std::unique_ptr<io_service_client> virtual_hid_keyboard_io_service_client_;
-  std::optional<pqrs::hid::country_code::value_t> virtual_hid_keyboard_country_code_;
-  std::unique_ptr<io_service_client> virtual_hid_pointing_io_service_client_;
+  // `metrics_writer_` has to be destructed after `io_service_client_`.
+  pqrs::karabiner::driverkit::virtual_hid_device_service::metrics::writer metrics_writer_;
+  // Forwarding threads have to be destructed after `io_service_client_`.
+  forwarding_thread virtual_hid_keyboard_forwarding_thread_;
+  forwarding_thread virtual_hid_pointing_forwarding_thread_;
+  forwarding_thread virtual_hid_absolute_pointing_forwarding_thread_;
+  // Each virtual device has its own connection to the driver.
+  std::unique_ptr<io_service_client> io_service_client_;
+  // The country code of the last `virtual_hid_keyboard_initialize`.
+  // (It is also used when the keyboard is created by a report.)
+  pqrs::hid::country_code::value_t virtual_hid_keyboard_country_code_;
+  virtual_hid_device virtual_hid_keyboard_;
+  virtual_hid_device virtual_hid_pointing_;
+  virtual_hid_device virtual_hid_absolute_pointing_;
+  // Clients which sent a request within `device_lifecycle::options::idle_timeout`.
+  pqrs::karabiner::driverkit::virtual_hid_device_service::device_lifecycle::client_activity client_activity_;
   std::unique_ptr<pqrs::local_datagram::server> server_;
+  std::unique_ptr<pqrs::karabiner::driverkit::virtual_hid_device_service::request_trace::writer> request_trace_writer_;
+  pqrs::karabiner::driverkit::virtual_hid_device_service::session_state::state saved_session_state_;
+  // Keyed by the endpoint path.
+  std::unordered_map<std::string, sequenced_sender> sequenced_senders_;
+  std::unordered_map<uint32_t, std::string> sequenced_sender_paths_;
+  uint32_t last_sequenced_sender_id_;
+  uint64_t sequenced_sender_activity_;
+  std::optional<io_service_client::report_tag> sequenced_report_tag_;
+  // The correlation id of the request which is being handled.
+  std::optional<uint64_t> correlation_id_;
+  pqrs::karabiner::driverkit::virtual_hid_device_service::metrics::server_metrics server_metrics_;
   pqrs::dispatcher::extra::timer ready_timer_;
+  // Polls virtual devices which are created by reports.
+  pqrs::dispatcher::extra::timer creation_timer_;
+  std::unique_ptr<pqrs::karabiner::driverkit::virtual_hid_device_service::motion_synthesizer> pointing_motion_synthesizer_;
+  pqrs::dispatcher::extra::timer pointing_motion_timer_;
+  // Texts which are being typed.
+  std::deque<std::unique_ptr<pqrs::karabiner::driverkit::virtual_hid_device_service::text_input::text_synthesizer>> text_synthesizers_;
+  // `post_keyboard_input_report` requests which are received while texts are typed.
+  std::deque<pending_report> text_input_held_reports_;
+  pqrs::dispatcher::extra::timer text_input_timer_;
 };
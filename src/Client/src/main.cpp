@@ -1,6 +1,8 @@
+#include "forwarding_thread.hpp"
 #include "io_service_client.hpp"
 #include "version.hpp"
 #include "virtual_hid_device_service_server.hpp"
+#include <algorithm>
 #include <chrono>
 #include <iostream>
 #include <memory>
@@ -8,13 +10,14 @@
 #include <pqrs/local_datagram.hpp>
 #include <pqrs/osx/iokit_return.hpp>
 #include <pqrs/osx/process_info.hpp>
+#include <string>
 #include <thread>
 
 namespace {
 auto global_wait = pqrs::make_thread_wait();
 }
 
-int main(void) {
+int main(int argc, const char* argv[]) {
   std::signal(SIGINT, [](int) {
     global_wait->notify();
   });
@@ -31,7 +34,44 @@ int main(void) {
 
   logger::get_logger()->info("version {0}", VERSION);
 
-  auto server = std::make_unique<virtual_hid_device_service_server>();
+  // Reports are forwarded in the dedicated threads for each virtual device.
+  forwarding_thread::options forwarding_thread_options;
+  forwarding_thread_options.qos_class = QOS_CLASS_USER_INTERACTIVE;
+  forwarding_thread_options.relative_priority = 0;
+
+  // Virtual devices are created by `virtual_hid_*_initialize` and kept until `virtual_hid_*_terminate` by default.
+  //
+  // --lazy-virtual-devices:
+  //   The first report creates the virtual device.
+  // --virtual-device-idle-timeout <milliseconds>:
+  //   The virtual device is terminated when it receives no report for the timeout while no client is connected or sending requests.
+  pqrs::karabiner::driverkit::virtual_hid_device_service::device_lifecycle::options device_lifecycle_options;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string arg(argv[i]);
+    if (arg == "--lazy-virtual-devices") {
+      device_lifecycle_options.lazy_creation = true;
+    } else if (arg == "--virtual-device-idle-timeout" && i + 1 < argc) {
+      try {
+        device_lifecycle_options.idle_timeout = std::chrono::milliseconds(std::max(std::stoi(argv[++i]), 0));
+      } catch (const std::exception& e) {
+        logger::get_logger()->error("invalid --virtual-device-idle-timeout: {0}", e.what());
+      }
+    } else {
+      logger::get_logger()->warn("unknown argument: {0}", arg);
+    }
+  }
+
+  if (device_lifecycle_options.lazy_creation) {
+    logger::get_logger()->info("virtual devices are created lazily");
+  }
+  if (device_lifecycle_options.idle_timeout > std::chrono::milliseconds(0)) {
+    logger::get_logger()->info("virtual devices are terminated after {0} ms idle",
+                               device_lifecycle_options.idle_timeout.count());
+  }
+
+  auto server = std::make_unique<virtual_hid_device_service_server>(forwarding_thread_options,
+                                                                    device_lifecycle_options);
 
   global_wait->wait_notice();
 
@@ -0,0 +1,196 @@
+#include "org_pqrs_Karabiner_DriverKit_VirtualHIDAbsolutePointing.h"
+#include "IOBufferMemoryDescriptorUtility.hpp"
+#include "org_pqrs_Karabiner_DriverKit_VirtualHIDDeviceUserClient.h"
+#include "pqrs/karabiner/driverkit/virtual_hid_device_driver.hpp"
+#include "version.hpp"
+#include <HIDDriverKit/IOHIDDeviceKeys.h>
+#include <HIDDriverKit/IOHIDUsageTables.h>
+#include <os/log.h>
+
+#define LOG_PREFIX "Karabiner-DriverKit-VirtualHIDAbsolutePointing " KARABINER_DRIVERKIT_VERSION
+
+namespace {
+// The descriptor is generated from `hid_report/absolute_pointing_report_descriptor.hpp`.
+constexpr const auto& reportDescriptor = pqrs::karabiner::driverkit::virtual_hid_device_driver::hid_report::absolute_pointing_report_descriptor;
+}
+
+struct org_pqrs_Karabiner_DriverKit_VirtualHIDAbsolutePointing_IVars {
+  org_pqrs_Karabiner_DriverKit_VirtualHIDDeviceUserClient* provider;
+  bool ready;
+  pqrs::karabiner::driverkit::virtual_hid_device_driver::hid_report::absolute_pointing_input lastReport;
+};
+
+bool org_pqrs_Karabiner_DriverKit_VirtualHIDAbsolutePointing::init() {
+  os_log(OS_LOG_DEFAULT, LOG_PREFIX " init");
+
+  if (!super::init()) {
+    return false;
+  }
+
+  ivars = IONewZero(org_pqrs_Karabiner_DriverKit_VirtualHIDAbsolutePointing_IVars, 1);
+  if (ivars == nullptr) {
+    return false;
+  }
+
+  return true;
+}
+
+void org_pqrs_Karabiner_DriverKit_VirtualHIDAbsolutePointing::free() {
+  os_log(OS_LOG_DEFAULT, LOG_PREFIX " free");
+
+  IOSafeDeleteNULL(ivars, org_pqrs_Karabiner_DriverKit_VirtualHIDAbsolutePointing_IVars, 1);
+
+  super::free();
+}
+
+bool org_pqrs_Karabiner_DriverKit_VirtualHIDAbsolutePointing::handleStart(IOService* provider) {
+  os_log(OS_LOG_DEFAULT, LOG_PREFIX " handleStart");
+
+  ivars->provider = OSDynamicCast(org_pqrs_Karabiner_DriverKit_VirtualHIDDeviceUserClient, provider);
+  if (!ivars->provider) {
+    os_log(OS_LOG_DEFAULT, LOG_PREFIX " provider is not org_pqrs_Karabiner_DriverKit_VirtualHIDDeviceUserClient");
+    return false;
+  }
+
+  if (!super::handleStart(provider)) {
+    os_log(OS_LOG_DEFAULT, LOG_PREFIX " super::handleStart failed");
+    return false;
+  }
+
+  ivars->ready = true;
+
+  return true;
+}
+
+kern_return_t IMPL(org_pqrs_Karabiner_DriverKit_VirtualHIDAbsolutePointing, Stop) {
+  os_log(OS_LOG_DEFAULT, LOG_PREFIX " Stop");
+
+  ivars->provider = nullptr;
+
+  return Stop(provider, SUPERDISPATCH);
+}
+
+OSDictionary* org_pqrs_Karabiner_DriverKit_VirtualHIDAbsolutePointing::newDeviceDescription(void) {
+  os_log(OS_LOG_DEFAULT, LOG_PREFIX " newDeviceDescription");
+
+  auto dictionary = OSDictionary::withCapacity(10);
+  if (!dictionary) {
+    os_log(OS_LOG_DEFAULT, LOG_PREFIX " OSDictionary::withCapacity failed");
+    return nullptr;
+  }
+
+  // Set kIOHIDRegisterServiceKey in order to call registerService in IOHIDDevice::start.
+  OSDictionarySetValue(dictionary, "RegisterService", kOSBooleanTrue);
+  OSDictionarySetValue(dictionary, "HIDDefaultBehavior", kOSBooleanTrue);
+
+  if (auto manufacturer = OSString::withCString("pqrs.org")) {
+    OSDictionarySetValue(dictionary, kIOHIDManufacturerKey, manufacturer);
+    manufacturer->release();
+  }
+
+  if (auto product = OSString::withCString("Karabiner DriverKit VirtualHIDAbsolutePointing " KARABINER_DRIVERKIT_VERSION)) {
+    OSDictionarySetValue(dictionary, kIOHIDProductKey, product);
+    product->release();
+  }
+
+  if (auto serialNumber = OSString::withCString("pqrs.org:Karabiner-DriverKit-VirtualHIDAbsolutePointing")) {
+    OSDictionarySetValue(dictionary, kIOHIDSerialNumberKey, serialNumber);
+    serialNumber->release();
+  }
+
+  if (auto vendorId = OSNumber::withNumber(static_cast<uint32_t>(0x16c0), 32)) {
+    OSDictionarySetValue(dictionary, kIOHIDVendorIDKey, vendorId);
+    vendorId->release();
+  }
+
+  if (auto productId = OSNumber::withNumber(static_cast<uint32_t>(0x27dc), 32)) {
+    OSDictionarySetValue(dictionary, kIOHIDProductIDKey, productId);
+    productId->release();
+  }
+
+  if (auto locationId = OSNumber::withNumber(static_cast<uint32_t>(0), 32)) {
+    OSDictionarySetValue(dictionary, kIOHIDLocationIDKey, locationId);
+    locationId->release();
+  }
+
+  if (auto usagePage = OSNumber::withNumber(static_cast<uint32_t>(kHIDPage_GenericDesktop), 32)) {
+    OSDictionarySetValue(dictionary, kIOHIDPrimaryUsagePageKey, usagePage);
+    usagePage->release();
+  }
+
+  if (auto usage = OSNumber::withNumber(static_cast<uint32_t>(kHIDUsage_GD_Mouse), 32)) {
+    OSDictionarySetValue(dictionary, kIOHIDPrimaryUsageKey, usage);
+    usage->release();
+  }
+
+  return dictionary;
+}
+
+OSData* org_pqrs_Karabiner_DriverKit_VirtualHIDAbsolutePointing::newReportDescriptor(void) {
+  os_log(OS_LOG_DEFAULT, LOG_PREFIX " newReportDescriptor");
+
+  return OSData::withBytes(reportDescriptor.data(), reportDescriptor.size());
+}
+
+kern_return_t IMPL(org_pqrs_Karabiner_DriverKit_VirtualHIDAbsolutePointing, postReport) {
+  if (!report) {
+    return kIOReturnBadArgument;
+  }
+
+  uint64_t address = 0;
+  uint64_t len = 0;
+  auto kr = report->Map(0, 0, 0, 0, &address, &len);
+  if (kr != kIOReturnSuccess) {
+    return kr;
+  }
+
+  if (len != sizeof(ivars->lastReport)) {
+    return kIOReturnBadArgument;
+  }
+
+  // Keep the position for `reset`.
+  memcpy(&(ivars->lastReport), reinterpret_cast<const void*>(address), sizeof(ivars->lastReport));
+
+  return handleReport(mach_absolute_time(),
+                      report,
+                      static_cast<uint32_t>(len),
+                      kIOHIDReportTypeInput,
+                      0);
+}
+
+kern_return_t IMPL(org_pqrs_Karabiner_DriverKit_VirtualHIDAbsolutePointing, reset) {
+  os_log(OS_LOG_DEFAULT, LOG_PREFIX " reset");
+
+  // Release buttons without moving the cursor.
+
+  auto absolute_pointing_input = ivars->lastReport;
+  absolute_pointing_input.buttons.clear();
+
+  struct input {
+    const void* address;
+    size_t length;
+  } inputs[] = {
+      {&absolute_pointing_input, sizeof(absolute_pointing_input)},
+  };
+
+  for (const auto& input : inputs) {
+    IOMemoryDescriptor* memory = nullptr;
+    auto kr = IOBufferMemoryDescriptorUtility::createWithBytes(input.address,
+                                                               input.length,
+                                                               &memory);
+    if (kr != kIOReturnSuccess) {
+      os_log(OS_LOG_DEFAULT, LOG_PREFIX " reset createWithBytes error: 0x%x", kr);
+      return kr;
+    }
+
+    postReport(memory);
+
+    OSSafeReleaseNULL(memory);
+  }
+
+  return kIOReturnSuccess;
+}
+
+bool IMPL(org_pqrs_Karabiner_DriverKit_VirtualHIDAbsolutePointing, getReady) {
+  return ivars->ready;
+}
@@ -1,5 +1,6 @@
 #include "org_pqrs_Karabiner_DriverKit_VirtualHIDDeviceUserClient.h"
 #include "IOBufferMemoryDescriptorUtility.hpp"
+#include "org_pqrs_Karabiner_DriverKit_VirtualHIDAbsolutePointing.h"
 #include "org_pqrs_Karabiner_DriverKit_VirtualHIDKeyboard.h"
 #include "org_pqrs_Karabiner_DriverKit_VirtualHIDPointing.h"
 #include "pqrs/karabiner/driverkit/virtual_hid_device_driver.hpp"
@@ -36,8 +37,79 @@ struct org_pqrs_Karabiner_DriverKit_VirtualHIDDeviceUserClient_IVars {
   uint32_t keyboardCountryCode;
   org_pqrs_Karabiner_DriverKit_VirtualHIDKeyboard* keyboard;
   org_pqrs_Karabiner_DriverKit_VirtualHIDPointing* pointing;
+  org_pqrs_Karabiner_DriverKit_VirtualHIDAbsolutePointing* absolutePointing;
+  IOBufferMemoryDescriptor* reportRingMemory;
+  pqrs::karabiner::driverkit::virtual_hid_device_driver::report_ring::consumer reportRingConsumer;
 };
 
+namespace {
+// Posts a report (or a reset) which is received via the report ring.
+kern_return_t postRingReport(org_pqrs_Karabiner_DriverKit_VirtualHIDDeviceUserClient_IVars* ivars,
+                             pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method method,
+                             const uint8_t* data,
+                             size_t size) {
+  switch (method) {
+    case pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method::virtual_hid_keyboard_reset:
+      return ivars->keyboard ? ivars->keyboard->reset() : kIOReturnError;
+
+    case pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method::virtual_hid_pointing_reset:
+      return ivars->pointing ? ivars->pointing->reset() : kIOReturnError;
+
+    case pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method::virtual_hid_absolute_pointing_reset:
+      return ivars->absolutePointing ? ivars->absolutePointing->reset() : kIOReturnError;
+
+    default:
+      break;
+  }
+
+  if (size == 0) {
+    return kIOReturnBadArgument;
+  }
+
+  IOMemoryDescriptor* memory = nullptr;
+  auto kr = kIOReturnBadArgument;
+
+  switch (method) {
+    case pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method::virtual_hid_keyboard_post_report:
+      if (!ivars->keyboard) {
+        return kIOReturnError;
+      }
+      kr = IOBufferMemoryDescriptorUtility::createWithBytes(data, size, &memory);
+      if (kr == kIOReturnSuccess) {
+        kr = ivars->keyboard->postReport(memory);
+      }
+      break;
+
+    case pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method::virtual_hid_pointing_post_report:
+      if (!ivars->pointing) {
+        return kIOReturnError;
+      }
+      kr = IOBufferMemoryDescriptorUtility::createWithBytes(data, size, &memory);
+      if (kr == kIOReturnSuccess) {
+        kr = ivars->pointing->postReport(memory);
+      }
+      break;
+
+    case pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method::virtual_hid_absolute_pointing_post_report:
+      if (!ivars->absolutePointing) {
+        return kIOReturnError;
+      }
+      kr = IOBufferMemoryDescriptorUtility::createWithBytes(data, size, &memory);
+      if (kr == kIOReturnSuccess) {
+        kr = ivars->absolutePointing->postReport(memory);
+      }
+      break;
+
+    default:
+      break;
+  }
+
+  OSSafeReleaseNULL(memory);
+
+  return kr;
+}
+} // namespace
+
 bool org_pqrs_Karabiner_DriverKit_VirtualHIDDeviceUserClient::init() {
   os_log(OS_LOG_DEFAULT, LOG_PREFIX " init");
 
@@ -58,6 +130,8 @@ void org_pqrs_Karabiner_DriverKit_VirtualHIDDeviceUserClient::free() {
 
   OSSafeReleaseNULL(ivars->keyboard);
   OSSafeReleaseNULL(ivars->pointing);
+  OSSafeReleaseNULL(ivars->absolutePointing);
+  OSSafeReleaseNULL(ivars->reportRingMemory);
 
   IOSafeDeleteNULL(ivars, org_pqrs_Karabiner_DriverKit_VirtualHIDDeviceUserClient_IVars, 1);
 
@@ -193,6 +267,89 @@ kern_return_t org_pqrs_Karabiner_DriverKit_VirtualHIDDeviceUserClient::ExternalM
       }
       return kIOReturnError;
 
+    case pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method::virtual_hid_absolute_pointing_initialize:
+      if (!ivars->absolutePointing) {
+        IOService* client;
+
+        auto kr = Create(this, "VirtualHIDAbsolutePointingProperties", &client);
+        if (kr != kIOReturnSuccess) {
+          os_log(OS_LOG_DEFAULT, LOG_PREFIX " IOService::Create failed: 0x%x", kr);
+          return kr;
+        }
+
+        ivars->absolutePointing = OSDynamicCast(org_pqrs_Karabiner_DriverKit_VirtualHIDAbsolutePointing, client);
+        if (!ivars->absolutePointing) {
+          os_log(OS_LOG_DEFAULT, LOG_PREFIX " OSDynamicCast failed");
+          client->release();
+          return kIOReturnError;
+        }
+      }
+      return kIOReturnSuccess;
+
+    case pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method::virtual_hid_absolute_pointing_ready:
+      if (arguments->scalarOutput && arguments->scalarOutputCount > 0) {
+        arguments->scalarOutput[0] = (ivars->absolutePointing && ivars->absolutePointing->getReady());
+        return kIOReturnSuccess;
+      }
+      return kIOReturnError;
+
+    case pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method::virtual_hid_absolute_pointing_post_report:
+      if (ivars->absolutePointing) {
+        IOMemoryDescriptor* memory = nullptr;
+
+        auto kr = createIOMemoryDescriptor(arguments, &memory);
+        if (kr == kIOReturnSuccess) {
+          kr = ivars->absolutePointing->postReport(memory);
+          OSSafeReleaseNULL(memory);
+        }
+
+        return kr;
+      }
+      return kIOReturnError;
+
+    case pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method::virtual_hid_absolute_pointing_reset:
+      if (ivars->absolutePointing) {
+        return ivars->absolutePointing->reset();
+      }
+      return kIOReturnError;
+
+    case pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method::report_ring_doorbell:
+      if (ivars->reportRingConsumer.is_attached()) {
+        auto count = ivars->reportRingConsumer.drain([this](auto&& method, auto&& data, auto&& size) {
+          return postRingReport(ivars,
+                                pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method(method),
+                                data,
+                                size) == kIOReturnSuccess;
+        });
+
+        if (arguments->scalarOutput && arguments->scalarOutputCount > 0) {
+          arguments->scalarOutput[0] = count;
+        }
+        return kIOReturnSuccess;
+      }
+      return kIOReturnNotReady;
+
+    case pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method::virtual_hid_keyboard_terminate:
+      if (ivars->keyboard) {
+        ivars->keyboard->Terminate(0);
+        OSSafeReleaseNULL(ivars->keyboard);
+      }
+      return kIOReturnSuccess;
+
+    case pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method::virtual_hid_pointing_terminate:
+      if (ivars->pointing) {
+        ivars->pointing->Terminate(0);
+        OSSafeReleaseNULL(ivars->pointing);
+      }
+      return kIOReturnSuccess;
+
+    case pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_method::virtual_hid_absolute_pointing_terminate:
+      if (ivars->absolutePointing) {
+        ivars->absolutePointing->Terminate(0);
+        OSSafeReleaseNULL(ivars->absolutePointing);
+      }
+      return kIOReturnSuccess;
+
     default:
       break;
   }
@@ -200,6 +357,54 @@ kern_return_t org_pqrs_Karabiner_DriverKit_VirtualHIDDeviceUserClient::ExternalM
   return kIOReturnBadArgument;
 }
 
+kern_return_t IMPL(org_pqrs_Karabiner_DriverKit_VirtualHIDDeviceUserClient, CopyClientMemoryForType) {
+  if (pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_memory_type(type) !=
+      pqrs::karabiner::driverkit::virtual_hid_device_driver::user_client_memory_type::report_ring) {
+    return kIOReturnBadArgument;
+  }
+
+  if (!memory) {
+    return kIOReturnBadArgument;
+  }
+
+  if (!ivars->reportRingMemory) {
+    using layout = pqrs::karabiner::driverkit::virtual_hid_device_driver::report_ring::layout;
+
+    IOBufferMemoryDescriptor* m = nullptr;
+    auto kr = IOBufferMemoryDescriptor::Create(kIOMemoryDirectionInOut, sizeof(layout), alignof(layout), &m);
+    if (kr != kIOReturnSuccess) {
+      os_log(OS_LOG_DEFAULT, LOG_PREFIX " IOBufferMemoryDescriptor::Create failed: 0x%x", kr);
+      return kr;
+    }
+
+    kr = m->SetLength(sizeof(layout));
+    if (kr != kIOReturnSuccess) {
+      OSSafeReleaseNULL(m);
+      return kr;
+    }
+
+    IOAddressSegment range;
+    kr = m->GetAddressRange(&range);
+    if (kr != kIOReturnSuccess || range.length < sizeof(layout)) {
+      OSSafeReleaseNULL(m);
+      return kr != kIOReturnSuccess ? kr : kIOReturnNoMemory;
+    }
+
+    ivars->reportRingConsumer.attach(layout::initialize(reinterpret_cast<void*>(range.address)));
+    ivars->reportRingMemory = m;
+  }
+
+  if (options) {
+    // Writable by the client.
+    *options = 0;
+  }
+
+  ivars->reportRingMemory->retain();
+  *memory = ivars->reportRingMemory;
+
+  return kIOReturnSuccess;
+}
+
 uint32_t IMPL(org_pqrs_Karabiner_DriverKit_VirtualHIDDeviceUserClient, getKeyboardCountryCode) {
   return ivars->keyboardCountryCode;
 }
@@ -10,106 +10,8 @@
 #define LOG_PREFIX "Karabiner-DriverKit-VirtualHIDKeyboard " KARABINER_DRIVERKIT_VERSION
 
 namespace {
-const uint8_t reportDescriptor[] = {
-    0x05, 0x01,       // Usage Page (Generic Desktop)
-    0x09, 0x06,       // Usage (Keyboard)
-    0xa1, 0x01,       // Collection (Application)
-    0x85, 0x01,       //   Report Id (1)
-    0x05, 0x07,       //   Usage Page (Keyboard/Keypad)
-    0x19, 0xe0,       //   Usage Minimum........... (224)
-    0x29, 0xe7,       //   Usage Maximum........... (231)
-    0x15, 0x00,       //   Logical Minimum......... (0)
-    0x25, 0x01,       //   Logical Maximum......... (1)
-    0x75, 0x01,       //   Report Size............. (1)
-    0x95, 0x08,       //   Report Count............ (8)
-    0x81, 0x02,       //   Input...................(Data, Variable, Absolute)
-                      //
-    0x95, 0x01,       //   Report Count............ (1)
-    0x75, 0x08,       //   Report Size............. (8)
-    0x81, 0x01,       //   Input...................(Constant)
-                      //
-    0x95, 0x20,       //   Report Count............ (32)
-    0x75, 0x08,       //   Report Size............. (8)
-    0x15, 0x00,       //   Logical Minimum......... (0)
-    0x26, 0xff, 0x00, //   Logical Maximum......... (255)
-    0x05, 0x07,       //   Usage Page (Keyboard/Keypad)
-    0x19, 0x00,       //   Usage Minimum........... (0)
-    0x29, 0xff,       //   Usage Maximum........... (255)
-    0x81, 0x00,       //   Input...................(Data, Array, Absolute)
-    0xc0,             // End Collection
-
-    0x05, 0x0c,       // Usage Page (Consumer)
-    0x09, 0x01,       // Usage 1 (kHIDUsage_Csmr_ConsumerControl)
-    0xa1, 0x01,       // Collection (Application)
-    0x85, 0x02,       //   Report Id (2)
-    0x05, 0x0c,       //   Usage Page (Consumer)
-    0x95, 0x20,       //   Report Count............ (32)
-    0x75, 0x08,       //   Report Size............. (8)
-    0x15, 0x00,       //   Logical Minimum......... (0)
-    0x26, 0xff, 0x00, //   Logical Maximum......... (255)
-    0x19, 0x00,       //   Usage Minimum........... (0)
-    0x29, 0xff,       //   Usage Maximum........... (255)
-    0x81, 0x00,       //   Input...................(Data, Array, Absolute)
-    0xc0,             // End Collection
-
-    0x06, 0x00, 0xff, // Usage Page (kHIDPage_AppleVendor)
-    0x09, 0x01,       // Usage 1 (kHIDUsage_AppleVendor_TopCase)
-    0xa1, 0x01,       // Collection (Application)
-    0x85, 0x03,       //   Report Id (3)
-    0x05, 0xff,       //   Usage Page (kHIDPage_AppleVendorTopCase)
-    0x95, 0x20,       //   Report Count............ (32)
-    0x75, 0x08,       //   Report Size............. (8)
-    0x15, 0x00,       //   Logical Minimum......... (0)
-    0x26, 0xff, 0x00, //   Logical Maximum......... (255)
-    0x19, 0x00,       //   Usage Minimum........... (0)
-    0x29, 0xff,       //   Usage Maximum........... (255)
-    0x81, 0x00,       //   Input...................(Data, Array, Absolute)
-    0xc0,             // End Collection
-
-    0x06, 0x00, 0xff, // Usage Page (kHIDPage_AppleVendor)
-    0x09, 0x06,       // Usage 6 (kHIDUsage_AppleVendor_Keyboard)
-    0xa1, 0x01,       // Collection (Application)
-    0x85, 0x04,       //   Report Id (4)
-    0x06, 0x01, 0xff, //   Usage Page (kHIDPage_AppleVendorKeyboard)
-    0x95, 0x20,       //   Report Count............ (32)
-    0x75, 0x08,       //   Report Size............. (8)
-    0x15, 0x00,       //   Logical Minimum......... (0)
-    0x26, 0xff, 0x00, //   Logical Maximum......... (255)
-    0x19, 0x00,       //   Usage Minimum........... (0)
-    0x29, 0xff,       //   Usage Maximum........... (255)
-    0x81, 0x00,       //   Input...................(Data, Array, Absolute)
-    0xc0,             // End Collection
-
-    0x05, 0x01, // Usage Page (Generic Desktop)
-    0x09, 0x06, // Usage (Keyboard)
-    0xa1, 0x01, // Collection (Application)
-    0x85, 0x05, //   Report Id (5)
-    0x05, 0x08, //   Usage Page (LED)
-    0x95, 0x02, //   Report Count............ (2)
-    0x75, 0x01, //   Report Size............. (1)
-    0x19, 0x01, //   Usage Minimum........... (1)
-    0x29, 0x02, //   Usage Maximum........... (2)
-    0x91, 0x02, //   Output..................(Data, Variable, Absolute)
-    0x95, 0x01, //   Report Count............ (1)
-    0x75, 0x06, //   Report Size............. (6)
-    0x91, 0x01, //   Output..................(Constant)
-    0xc0,       // End Collection
-
-    0x05, 0x01, // Usage Page (Generic Desktop)
-    0x09, 0x06, // Usage (Keyboard)
-    0xa1, 0x01, // Collection (Application)
-    0x85, 0x06, //   Report Id (6)
-    0x05, 0x08, //   Usage Page (LED)
-    0x95, 0x02, //   Report Count............ (2)
-    0x75, 0x01, //   Report Size............. (1)
-    0x19, 0x01, //   Usage Minimum........... (1)
-    0x29, 0x02, //   Usage Maximum........... (2)
-    0x81, 0x02, //   Input...................(Data, Variable, Absolute)
-    0x95, 0x01, //   Report Count............ (1)
-    0x75, 0x06, //   Report Size............. (6)
-    0x81, 0x01, //   Input...................(Constant)
-    0xc0,       // End Collection
-};
+// The descriptor is generated from `hid_report/keyboard_report_descriptor.hpp`.
+constexpr const auto& reportDescriptor = pqrs::karabiner::driverkit::virtual_hid_device_driver::hid_report::keyboard_report_descriptor;
 }
 
 struct org_pqrs_Karabiner_DriverKit_VirtualHIDKeyboard_IVars {
@@ -237,7 +139,7 @@ OSDictionary* org_pqrs_Karabiner_DriverKit_VirtualHIDKeyboard::newDeviceDescript
 OSData* org_pqrs_Karabiner_DriverKit_VirtualHIDKeyboard::newReportDescriptor(void) {
   os_log(OS_LOG_DEFAULT, LOG_PREFIX " newReportDescriptor");
 
-  return OSData::withBytes(reportDescriptor, sizeof(reportDescriptor));
+  return OSData::withBytes(reportDescriptor.data(), reportDescriptor.size());
 }
 
 kern_return_t org_pqrs_Karabiner_DriverKit_VirtualHIDKeyboard::setReport(IOMemoryDescriptor* report,
@@ -266,7 +168,7 @@ kern_return_t org_pqrs_Karabiner_DriverKit_VirtualHIDKeyboard::setReport(IOMemor
   // state bits: 0b000000(caps lock)(num lock)
   auto state = reinterpret_cast<uint8_t*>(address)[1];
 
-  if (reportId != 5) {
+  if (reportId != pqrs::karabiner::driverkit::virtual_hid_device_driver::hid_report::keyboard_report_id::led_output) {
     // Error unless LED report.
     return kIOReturnUnsupported;
   }
@@ -282,7 +184,12 @@ kern_return_t org_pqrs_Karabiner_DriverKit_VirtualHIDKeyboard::setReport(IOMemor
     uint8_t state;
   } ledReport;
 
-  ledReport.reportId = 6;
+  static_assert(pqrs::karabiner::driverkit::virtual_hid_device_driver::hid_descriptor::report_byte_size(
+                    reportDescriptor,
+                    pqrs::karabiner::driverkit::virtual_hid_device_driver::hid_descriptor::report_type::input,
+                    pqrs::karabiner::driverkit::virtual_hid_device_driver::hid_report::keyboard_report_id::led_input) == sizeof(ledReport));
+
+  ledReport.reportId = pqrs::karabiner::driverkit::virtual_hid_device_driver::hid_report::keyboard_report_id::led_input;
   ledReport.state = state;
 
   // Post LED report.
@@ -328,6 +235,7 @@ kern_return_t IMPL(org_pqrs_Karabiner_DriverKit_VirtualHIDKeyboard, reset) {
   // Post empty reports
 
   pqrs::karabiner::driverkit::virtual_hid_device_driver::hid_report::keyboard_input keyboard_input;
+  pqrs::karabiner::driverkit::virtual_hid_device_driver::hid_report::keyboard_bitmap_input keyboard_bitmap_input;
   pqrs::karabiner::driverkit::virtual_hid_device_driver::hid_report::consumer_input consumer_input;
   pqrs::karabiner::driverkit::virtual_hid_device_driver::hid_report::apple_vendor_keyboard_input apple_vendor_keyboard_input;
   pqrs::karabiner::driverkit::virtual_hid_device_driver::hid_report::apple_vendor_top_case_input apple_vendor_top_case_input;
@@ -337,6 +245,7 @@ kern_return_t IMPL(org_pqrs_Karabiner_DriverKit_VirtualHIDKeyboard, reset) {
     size_t length;
   } inputs[] = {
       {&keyboard_input, sizeof(keyboard_input)},
+      {&keyboard_bitmap_input, sizeof(keyboard_bitmap_input)},
       {&consumer_input, sizeof(consumer_input)},
       {&apple_vendor_keyboard_input, sizeof(apple_vendor_keyboard_input)},
       {&apple_vendor_top_case_input, sizeof(apple_vendor_top_case_input)},
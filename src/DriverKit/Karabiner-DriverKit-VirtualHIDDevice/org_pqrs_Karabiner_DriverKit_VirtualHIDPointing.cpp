@@ -10,79 +10,15 @@
 #define LOG_PREFIX "Karabiner-DriverKit-VirtualHIDPointing " KARABINER_DRIVERKIT_VERSION
 
 namespace {
-const uint8_t reportDescriptor[] = {
-    0x05, 0x01,        // USAGE_PAGE (Generic Desktop)
-    0x09, 0x02,        // USAGE (Mouse)
-    0xa1, 0x01,        // COLLECTION (Application)
-    0x09, 0x02,        //   USAGE (Mouse)
-    0xa1, 0x02,        //   COLLECTION (Logical)
-    0x09, 0x01,        //     USAGE (Pointer)
-    0xa1, 0x00,        //     COLLECTION (Physical)
-    /*              */ // ------------------------------ Buttons
-    0x05, 0x09,        //       USAGE_PAGE (Button)
-    0x19, 0x01,        //       USAGE_MINIMUM (Button 1)
-    0x29, 0x20,        //       USAGE_MAXIMUM (Button 32)
-    0x15, 0x00,        //       LOGICAL_MINIMUM (0)
-    0x25, 0x01,        //       LOGICAL_MAXIMUM (1)
-    0x75, 0x01,        //       REPORT_SIZE (1)
-    0x95, 0x20,        //       REPORT_COUNT (32 Buttons)
-    0x81, 0x02,        //       INPUT (Data,Var,Abs)
-    /*              */ // ------------------------------ X,Y position
-    0x05, 0x01,        //       USAGE_PAGE (Generic Desktop)
-    0x09, 0x30,        //       USAGE (X)
-    0x09, 0x31,        //       USAGE (Y)
-    0x15, 0x81,        //       LOGICAL_MINIMUM (-127)
-    0x25, 0x7f,        //       LOGICAL_MAXIMUM (127)
-    0x75, 0x08,        //       REPORT_SIZE (8)
-    0x95, 0x02,        //       REPORT_COUNT (2)
-    0x81, 0x06,        //       INPUT (Data,Var,Rel)
-    0xa1, 0x02,        //       COLLECTION (Logical)
-    /*              */ // ------------------------------ Vertical wheel res multiplier
-    0x09, 0x48,        //         USAGE (Resolution Multiplier)
-    0x15, 0x00,        //         LOGICAL_MINIMUM (0)
-    0x25, 0x01,        //         LOGICAL_MAXIMUM (1)
-    0x35, 0x01,        //         PHYSICAL_MINIMUM (1)
-    0x45, 0x04,        //         PHYSICAL_MAXIMUM (4)
-    0x75, 0x02,        //         REPORT_SIZE (2)
-    0x95, 0x01,        //         REPORT_COUNT (1)
-    0xa4,              //         PUSH
-    0xb1, 0x02,        //         FEATURE (Data,Var,Abs)
-    /*              */ // ------------------------------ Vertical wheel
-    0x09, 0x38,        //         USAGE (Wheel)
-    0x15, 0x81,        //         LOGICAL_MINIMUM (-127)
-    0x25, 0x7f,        //         LOGICAL_MAXIMUM (127)
-    0x35, 0x00,        //         PHYSICAL_MINIMUM (0)        - reset physical
-    0x45, 0x00,        //         PHYSICAL_MAXIMUM (0)
-    0x75, 0x08,        //         REPORT_SIZE (8)
-    0x81, 0x06,        //         INPUT (Data,Var,Rel)
-    0xc0,              //       END_COLLECTION
-    0xa1, 0x02,        //       COLLECTION (Logical)
-    /*              */ // ------------------------------ Horizontal wheel res multiplier
-    0x09, 0x48,        //         USAGE (Resolution Multiplier)
-    0xb4,              //         POP
-    0xb1, 0x02,        //         FEATURE (Data,Var,Abs)
-    /*              */ // ------------------------------ Padding for Feature report
-    0x35, 0x00,        //         PHYSICAL_MINIMUM (0)        - reset physical
-    0x45, 0x00,        //         PHYSICAL_MAXIMUM (0)
-    0x75, 0x04,        //         REPORT_SIZE (4)
-    0xb1, 0x03,        //         FEATURE (Cnst,Var,Abs)
-    /*              */ // ------------------------------ Horizontal wheel
-    0x05, 0x0c,        //         USAGE_PAGE (Consumer Devices)
-    0x0a, 0x38, 0x02,  //         USAGE (AC Pan)
-    0x15, 0x81,        //         LOGICAL_MINIMUM (-127)
-    0x25, 0x7f,        //         LOGICAL_MAXIMUM (127)
-    0x75, 0x08,        //         REPORT_SIZE (8)
-    0x81, 0x06,        //         INPUT (Data,Var,Rel)
-    0xc0,              //       END_COLLECTION
-    0xc0,              //     END_COLLECTION
-    0xc0,              //   END_COLLECTION
-    0xc0               // END_COLLECTION};
-};
+// The descriptor is generated from `hid_report/pointing_report_descriptor.hpp`.
+constexpr const auto& reportDescriptor = pqrs::karabiner::driverkit::virtual_hid_device_driver::hid_report::pointing_report_descriptor;
 }
 
 struct org_pqrs_Karabiner_DriverKit_VirtualHIDPointing_IVars {
   org_pqrs_Karabiner_DriverKit_VirtualHIDDeviceUserClient* provider;
   bool ready;
+  // The zero-initialized value is the initial state.
+  pqrs::karabiner::driverkit::virtual_hid_device_driver::hid_report::wheel_resolution wheelResolution;
 };
 
 bool org_pqrs_Karabiner_DriverKit_VirtualHIDPointing::init() {
@@ -194,7 +130,75 @@ OSDictionary* org_pqrs_Karabiner_DriverKit_VirtualHIDPointing::newDeviceDescript
 OSData* org_pqrs_Karabiner_DriverKit_VirtualHIDPointing::newReportDescriptor(void) {
   os_log(OS_LOG_DEFAULT, LOG_PREFIX " newReportDescriptor");
 
-  return OSData::withBytes(reportDescriptor, sizeof(reportDescriptor));
+  return OSData::withBytes(reportDescriptor.data(), reportDescriptor.size());
+}
+
+kern_return_t org_pqrs_Karabiner_DriverKit_VirtualHIDPointing::getReport(IOMemoryDescriptor* report,
+                                                                         IOHIDReportType reportType,
+                                                                         IOOptionBits options,
+                                                                         uint32_t completionTimeout,
+                                                                         OSAction* action) {
+  if (!report) {
+    return kIOReturnBadArgument;
+  }
+
+  if (reportType != kIOHIDReportTypeFeature) {
+    return kIOReturnUnsupported;
+  }
+
+  uint64_t address = 0;
+  uint64_t len = 0;
+  auto kr = report->Map(0, 0, 0, 0, &address, &len);
+  if (kr != kIOReturnSuccess) {
+    os_log(OS_LOG_DEFAULT, LOG_PREFIX " getReport Map error: 0x%x", kr);
+    return kr;
+  }
+
+  const auto& feature = ivars->wheelResolution.get_feature();
+  if (len < sizeof(feature)) {
+    return kIOReturnBadArgument;
+  }
+
+  memcpy(reinterpret_cast<void*>(address), &feature, sizeof(feature));
+
+  return kIOReturnSuccess;
+}
+
+kern_return_t org_pqrs_Karabiner_DriverKit_VirtualHIDPointing::setReport(IOMemoryDescriptor* report,
+                                                                         IOHIDReportType reportType,
+                                                                         IOOptionBits options,
+                                                                         uint32_t completionTimeout,
+                                                                         OSAction* action) {
+  if (!report) {
+    return kIOReturnBadArgument;
+  }
+
+  if (reportType != kIOHIDReportTypeFeature) {
+    return kIOReturnUnsupported;
+  }
+
+  uint64_t address = 0;
+  uint64_t len = 0;
+  auto kr = report->Map(0, 0, 0, 0, &address, &len);
+  if (kr != kIOReturnSuccess) {
+    os_log(OS_LOG_DEFAULT, LOG_PREFIX " setReport Map error: 0x%x", kr);
+    return kr;
+  }
+
+  pqrs::karabiner::driverkit::virtual_hid_device_driver::hid_report::wheel_resolution_multiplier_feature feature;
+  if (len != sizeof(feature)) {
+    return kIOReturnBadArgument;
+  }
+
+  memcpy(&feature, reinterpret_cast<const void*>(address), sizeof(feature));
+
+  os_log(OS_LOG_DEFAULT, LOG_PREFIX " resolution multiplier vertical:%d horizontal:%d",
+         feature.vertical_multiplier(),
+         feature.horizontal_multiplier());
+
+  ivars->wheelResolution.set_feature(feature);
+
+  return kIOReturnSuccess;
 }
 
 kern_return_t IMPL(org_pqrs_Karabiner_DriverKit_VirtualHIDPointing, postReport) {
@@ -202,17 +206,49 @@ kern_return_t IMPL(org_pqrs_Karabiner_DriverKit_VirtualHIDPointing, postReport)
     return kIOReturnBadArgument;
   }
 
-  uint64_t reportLength;
-  auto kr = report->GetLength(&reportLength);
+  uint64_t address = 0;
+  uint64_t len = 0;
+  auto kr = report->Map(0, 0, 0, 0, &address, &len);
   if (kr != kIOReturnSuccess) {
     return kr;
   }
 
-  return handleReport(mach_absolute_time(),
-                      report,
-                      static_cast<uint32_t>(reportLength),
-                      kIOHIDReportTypeInput,
-                      0);
+  // Convert `pointing_input` and `pointing_high_resolution_input` into the input report with the current resolution multiplier.
+
+  pqrs::karabiner::driverkit::virtual_hid_device_driver::hid_report::pointing_high_resolution_input input;
+
+  if (len == sizeof(pqrs::karabiner::driverkit::virtual_hid_device_driver::hid_report::pointing_input)) {
+    pqrs::karabiner::driverkit::virtual_hid_device_driver::hid_report::pointing_input pointing_input;
+    memcpy(&pointing_input, reinterpret_cast<const void*>(address), sizeof(pointing_input));
+    input = ivars->wheelResolution.convert(pointing_input);
+
+  } else if (len == sizeof(pqrs::karabiner::driverkit::virtual_hid_device_driver::hid_report::pointing_high_resolution_input)) {
+    pqrs::karabiner::driverkit::virtual_hid_device_driver::hid_report::pointing_high_resolution_input pointing_high_resolution_input;
+    memcpy(&pointing_high_resolution_input, reinterpret_cast<const void*>(address), sizeof(pointing_high_resolution_input));
+    input = ivars->wheelResolution.convert(pointing_high_resolution_input);
+
+  } else {
+    return kIOReturnBadArgument;
+  }
+
+  IOMemoryDescriptor* memory = nullptr;
+  kr = IOBufferMemoryDescriptorUtility::createWithBytes(&input,
+                                                        sizeof(input),
+                                                        &memory);
+  if (kr != kIOReturnSuccess) {
+    os_log(OS_LOG_DEFAULT, LOG_PREFIX " postReport createWithBytes error: 0x%x", kr);
+    return kr;
+  }
+
+  kr = handleReport(mach_absolute_time(),
+                    memory,
+                    static_cast<uint32_t>(sizeof(input)),
+                    kIOHIDReportTypeInput,
+                    0);
+
+  OSSafeReleaseNULL(memory);
+
+  return kr;
 }
 
 kern_return_t IMPL(org_pqrs_Karabiner_DriverKit_VirtualHIDPointing, reset) {
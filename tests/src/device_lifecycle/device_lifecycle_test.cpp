@@ -0,0 +1,192 @@
+#include <catch2/catch.hpp>
+
+#include <pqrs/karabiner/driverkit/virtual_hid_device_service/device_lifecycle.hpp>
+#include <vector>
+
+namespace {
+using namespace pqrs::karabiner::driverkit::virtual_hid_device_service;
+using namespace std::chrono_literals;
+
+using time_point = std::chrono::steady_clock::time_point;
+} // namespace
+
+TEST_CASE("device") {
+  time_point now;
+
+  // lazy_creation is disabled
+
+  {
+    device_lifecycle::device<int> d(device_lifecycle::options{});
+    REQUIRE(!d.get_initialized());
+    REQUIRE(d.receive_report(now) == device_lifecycle::report_action::drop);
+    REQUIRE(!d.get_initialized());
+
+    d.initialize(now);
+    REQUIRE(d.get_initialized());
+    REQUIRE(!d.get_creating());
+    REQUIRE(d.receive_report(now) == device_lifecycle::report_action::post);
+
+    d.terminate([](auto&&) {});
+    REQUIRE(!d.get_initialized());
+    REQUIRE(d.receive_report(now) == device_lifecycle::report_action::drop);
+  }
+
+  // lazy_creation is enabled
+
+  {
+    device_lifecycle::options o;
+    o.lazy_creation = true;
+    o.max_pending_reports = 3;
+    device_lifecycle::device<int> d(o);
+
+    REQUIRE(d.receive_report(now) == device_lifecycle::report_action::create);
+    REQUIRE(d.get_initialized());
+    REQUIRE(d.get_creating());
+    REQUIRE(d.push_pending_report(1));
+
+    REQUIRE(d.receive_report(now) == device_lifecycle::report_action::hold);
+    REQUIRE(d.push_pending_report(2));
+    REQUIRE(d.receive_report(now) == device_lifecycle::report_action::hold);
+    REQUIRE(d.push_pending_report(3));
+
+    // Full
+    REQUIRE(d.receive_report(now) == device_lifecycle::report_action::hold);
+    REQUIRE(!d.push_pending_report(4));
+    REQUIRE(d.get_pending_report_count() == 3);
+
+    // Reports are posted in order.
+    std::vector<int> posted;
+    d.ready([&](auto&& r) {
+      posted.push_back(r);
+    });
+    REQUIRE(posted == std::vector<int>{1, 2, 3});
+    REQUIRE(!d.get_creating());
+    REQUIRE(d.get_pending_report_count() == 0);
+    REQUIRE(d.receive_report(now) == device_lifecycle::report_action::post);
+
+    // `ready` is ignored after the device becomes ready.
+    d.ready([&](auto&& r) {
+      posted.push_back(r);
+    });
+    REQUIRE(posted.size() == 3);
+
+    // The device is created again after the termination.
+    d.terminate([](auto&&) {});
+    REQUIRE(d.receive_report(now) == device_lifecycle::report_action::create);
+  }
+
+  // Held reports are discarded by the termination.
+
+  {
+    device_lifecycle::options o;
+    o.lazy_creation = true;
+    device_lifecycle::device<int> d(o);
+
+    REQUIRE(d.receive_report(now) == device_lifecycle::report_action::create);
+    REQUIRE(d.push_pending_report(1));
+    REQUIRE(d.receive_report(now) == device_lifecycle::report_action::hold);
+    REQUIRE(d.push_pending_report(2));
+
+    std::vector<int> discarded;
+    d.terminate([&](auto&& r) {
+      discarded.push_back(r);
+    });
+    REQUIRE(discarded == std::vector<int>{1, 2});
+    REQUIRE(!d.get_initialized());
+    REQUIRE(!d.get_creating());
+    REQUIRE(d.get_pending_report_count() == 0);
+  }
+
+  // The initialization during the creation
+
+  {
+    device_lifecycle::options o;
+    o.lazy_creation = true;
+    device_lifecycle::device<int> d(o);
+
+    REQUIRE(d.receive_report(now) == device_lifecycle::report_action::create);
+    d.initialize(now);
+    REQUIRE(d.get_creating());
+    REQUIRE(d.receive_report(now) == device_lifecycle::report_action::hold);
+  }
+}
+
+TEST_CASE("device::idle") {
+  time_point now;
+
+  // idle_timeout is disabled
+
+  {
+    device_lifecycle::device<int> d(device_lifecycle::options{});
+    d.initialize(now);
+    REQUIRE(!d.idle(now + 24h, 0));
+  }
+
+  {
+    device_lifecycle::options o;
+    o.idle_timeout = 1000ms;
+    device_lifecycle::device<int> d(o);
+
+    // Not initialized
+    REQUIRE(!d.idle(now + 2000ms, 0));
+
+    d.initialize(now);
+    REQUIRE(!d.idle(now + 999ms, 0));
+    REQUIRE(d.idle(now + 1000ms, 0));
+
+    // Active clients
+    REQUIRE(!d.idle(now + 1000ms, 1));
+
+    // Reports
+    d.receive_report(now + 500ms);
+    REQUIRE(!d.idle(now + 1000ms, 0));
+    REQUIRE(d.idle(now + 1500ms, 0));
+
+    d.touch(now + 1500ms);
+    REQUIRE(!d.idle(now + 2000ms, 0));
+    REQUIRE(d.idle(now + 2500ms, 0));
+
+    d.terminate([](auto&&) {});
+    REQUIRE(!d.idle(now + 2500ms, 0));
+  }
+}
+
+TEST_CASE("client_activity") {
+  time_point now;
+
+  device_lifecycle::client_activity a(1000ms);
+  REQUIRE(a.count(now) == 0);
+
+  a.touch("/tmp/client1.sock", now);
+  a.touch("/tmp/client2.sock", now + 500ms);
+  REQUIRE(a.count(now + 500ms) == 2);
+
+  // The same client (updated)
+  a.touch("/tmp/client1.sock", now + 600ms);
+  REQUIRE(a.count(now + 600ms) == 2);
+
+  // The same client (skipped within a half of the timeout)
+  a.touch("/tmp/client1.sock", now + 1000ms);
+
+  // An unbound client
+  a.touch("", now + 700ms);
+  REQUIRE(a.count(now + 700ms) == 3);
+
+  REQUIRE(a.count(now + 1499ms) == 3);
+  REQUIRE(a.count(now + 1500ms) == 2);
+  REQUIRE(a.count(now + 1600ms) == 1);
+  REQUIRE(a.count(now + 1700ms) == 0);
+
+  a.touch("/tmp/client1.sock", now + 2000ms);
+  REQUIRE(a.count(now + 2000ms) == 1);
+}
+
+TEST_CASE("client_activity disabled") {
+  time_point now;
+
+  device_lifecycle::client_activity a(0ms);
+  REQUIRE(!a.enabled());
+
+  a.touch("/tmp/client1.sock", now);
+  REQUIRE(a.count(now) == 0);
+}
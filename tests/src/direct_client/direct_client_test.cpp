@@ -0,0 +1,258 @@
+#include <catch2/catch.hpp>
+
+#include <atomic>
+#include <filesystem>
+#include <iostream>
+#include <pqrs/karabiner/driverkit/virtual_hid_device_service/client.hpp>
+#include <pqrs/karabiner/driverkit/virtual_hid_device_service/direct_client.hpp>
+#include <thread>
+
+namespace {
+using namespace pqrs::karabiner::driverkit;
+using namespace pqrs::karabiner::driverkit::virtual_hid_device_service;
+
+const std::string server_socket_file_path("tmp/server.sock");
+const std::string client_socket_file_path("tmp/client.sock");
+
+constexpr uint8_t user_data_type = static_cast<uint8_t>(pqrs::local_datagram::impl::send_entry::type::user_data);
+
+// A plain datagram socket which stands in for the server.
+class receiver final {
+public:
+  receiver(void) {
+    std::filesystem::create_directories("tmp");
+    unlink(server_socket_file_path.c_str());
+
+    fd_ = socket(AF_UNIX, SOCK_DGRAM, 0);
+
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, server_socket_file_path.c_str());
+    bind(fd_, reinterpret_cast<const sockaddr*>(&address), sizeof(address));
+  }
+
+  ~receiver(void) {
+    close(fd_);
+    unlink(server_socket_file_path.c_str());
+  }
+
+  int get_fd(void) const {
+    return fd_;
+  }
+
+  // Returns the user data without the entry type.
+  std::vector<uint8_t> receive(void) {
+    std::vector<uint8_t> buffer(1024);
+    auto size = recv(fd_, buffer.data(), buffer.size(), 0);
+    buffer.resize(size > 0 ? size : 0);
+    REQUIRE(!buffer.empty());
+    REQUIRE(buffer[0] == user_data_type);
+    buffer.erase(std::begin(buffer));
+    return buffer;
+  }
+
+  void send_to_client(std::vector<uint8_t> buffer) {
+    buffer.insert(std::begin(buffer), user_data_type);
+
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, client_socket_file_path.c_str());
+    sendto(fd_, buffer.data(), buffer.size(), 0, reinterpret_cast<const sockaddr*>(&address), sizeof(address));
+  }
+
+private:
+  int fd_;
+};
+
+std::vector<uint8_t> make_correlated_result(uint64_t correlation_id, response r, bool value) {
+  std::vector<uint8_t> buffer(1 + sizeof(correlation_id) + 2);
+  buffer[0] = static_cast<uint8_t>(response::correlated_result);
+  memcpy(&(buffer[1]), &correlation_id, sizeof(correlation_id));
+  buffer[1 + sizeof(correlation_id)] = static_cast<uint8_t>(r);
+  buffer[1 + sizeof(correlation_id) + 1] = value;
+  return buffer;
+}
+
+std::vector<std::chrono::nanoseconds>::value_type percentile(std::vector<std::chrono::nanoseconds> values, double p) {
+  std::sort(std::begin(values), std::end(values));
+  return values[static_cast<size_t>(p * (values.size() - 1))];
+}
+} // namespace
+
+TEST_CASE("direct_client") {
+  receiver r;
+  direct_client c("", server_socket_file_path);
+
+  REQUIRE(!c.is_open());
+
+  // The wire format is the same as `client`.
+
+  {
+    virtual_hid_device_driver::hid_report::keyboard_input report;
+    report.keys.insert(4);
+
+    REQUIRE(!c.post_report(report));
+    REQUIRE(c.is_open());
+    REQUIRE(r.receive() == request_schema::encode<request::post_keyboard_input_report>(report));
+  }
+  {
+    REQUIRE(!c.virtual_hid_keyboard_initialize(pqrs::hid::country_code::us));
+    REQUIRE(r.receive() == request_schema::encode<request::virtual_hid_keyboard_initialize>(type_safe::get(pqrs::hid::country_code::us)));
+  }
+  {
+    REQUIRE(!c.virtual_hid_pointing_reset());
+    REQUIRE(r.receive() == request_schema::encode<request::virtual_hid_pointing_reset>());
+  }
+}
+
+TEST_CASE("direct_client reconnect") {
+  direct_client c("", server_socket_file_path);
+
+  {
+    receiver r;
+    REQUIRE(!c.virtual_hid_keyboard_reset());
+    REQUIRE(r.receive() == request_schema::encode<request::virtual_hid_keyboard_reset>());
+  }
+
+  // The server is not running.
+
+  REQUIRE(c.virtual_hid_keyboard_reset());
+
+  // The server is restarted.
+
+  {
+    receiver r;
+    REQUIRE(!c.virtual_hid_keyboard_reset());
+    REQUIRE(r.receive() == request_schema::encode<request::virtual_hid_keyboard_reset>());
+  }
+}
+
+TEST_CASE("direct_client queries") {
+  receiver r;
+  direct_client c(client_socket_file_path, server_socket_file_path);
+
+  std::thread server([&r] {
+    auto buffer = r.receive();
+    REQUIRE(buffer.size() == request_schema::correlated_header_size + 1);
+    REQUIRE(buffer[0] == static_cast<uint8_t>(request::correlated_request));
+    REQUIRE(buffer[request_schema::correlated_header_size] == static_cast<uint8_t>(request::virtual_hid_keyboard_ready));
+
+    uint64_t correlation_id;
+    memcpy(&correlation_id, &(buffer[1]), sizeof(correlation_id));
+
+    // Responses of other requests are ignored.
+    r.send_to_client(make_correlated_result(correlation_id + 1, response::virtual_hid_keyboard_ready_result, false));
+    r.send_to_client(make_correlated_result(correlation_id, response::virtual_hid_pointing_ready_result, false));
+    r.send_to_client(make_correlated_result(correlation_id, response::virtual_hid_keyboard_ready_result, true));
+  });
+
+  auto ready = c.virtual_hid_keyboard_ready(std::chrono::milliseconds(5000));
+  REQUIRE(ready);
+  REQUIRE(*ready);
+
+  server.join();
+
+  // Timeout
+
+  {
+    auto start = std::chrono::steady_clock::now();
+    REQUIRE(!c.driver_loaded(std::chrono::milliseconds(100)));
+    REQUIRE(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(100));
+  }
+
+  // Queries require `client_socket_file_path`.
+
+  {
+    direct_client c2("", server_socket_file_path);
+    REQUIRE(!c2.driver_loaded(std::chrono::milliseconds(100)));
+  }
+}
+
+TEST_CASE("direct_client benchmark", "[.benchmark]") {
+  // The latency from `async_post_report` (`post_report`) to the server.
+
+  constexpr int count = 10000;
+
+  pqrs::dispatcher::extra::initialize_shared_dispatcher();
+
+  std::filesystem::create_directories("tmp");
+
+  std::atomic<bool> bound(false);
+  std::atomic<int> received_count(0);
+
+  auto server = std::make_unique<pqrs::local_datagram::server>(pqrs::dispatcher::extra::get_shared_dispatcher(),
+                                                               server_socket_file_path,
+                                                               constants::local_datagram_buffer_size);
+  server->set_connection_monitor_enabled(true);
+  server->bound.connect([&bound] {
+    bound = true;
+  });
+  server->received.connect([&received_count](auto&& buffer, auto&& sender_endpoint) {
+    ++received_count;
+  });
+  server->async_start();
+
+  auto wait = [](auto&& predicate) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (!predicate()) {
+      if (std::chrono::steady_clock::now() > deadline) {
+        return false;
+      }
+      std::this_thread::yield();
+    }
+    return true;
+  };
+
+  REQUIRE(wait([&bound] { return bound.load(); }));
+
+  auto measure = [&](auto&& post) {
+    std::vector<std::chrono::nanoseconds> latencies;
+    latencies.reserve(count);
+
+    for (int i = 0; i < count; ++i) {
+      auto expected = received_count + 1;
+      auto start = std::chrono::steady_clock::now();
+      post();
+      REQUIRE(wait([&] { return received_count >= expected; }));
+      latencies.push_back(std::chrono::steady_clock::now() - start);
+    }
+
+    return latencies;
+  };
+
+  virtual_hid_device_driver::hid_report::keyboard_input report;
+
+  {
+    client c(client_socket_file_path, server_socket_file_path);
+    std::atomic<bool> connected(false);
+    c.connected.connect([&connected] {
+      connected = true;
+    });
+    c.async_start();
+    REQUIRE(wait([&connected] { return connected.load(); }));
+
+    auto latencies = measure([&] {
+      c.async_post_report(report);
+    });
+    std::cout << "client:        p50 " << percentile(latencies, 0.5).count() << " ns"
+              << ", p99 " << percentile(latencies, 0.99).count() << " ns" << std::endl;
+  }
+
+  {
+    direct_client c("", server_socket_file_path);
+
+    auto latencies = measure([&] {
+      c.post_report(report);
+    });
+    std::cout << "direct_client: p50 " << percentile(latencies, 0.5).count() << " ns"
+              << ", p99 " << percentile(latencies, 0.99).count() << " ns" << std::endl;
+  }
+
+  REQUIRE(received_count == count * 2);
+
+  server = nullptr;
+
+  pqrs::dispatcher::extra::terminate_shared_dispatcher();
+}
@@ -0,0 +1,285 @@
+#include <catch2/catch.hpp>
+
+#include <atomic>
+#include <iostream>
+#include <pqrs/dispatcher.hpp>
+#include <vector>
+
+namespace {
+class test_client final {
+public:
+  test_client(std::shared_ptr<pqrs::dispatcher::dispatcher> dispatcher) : dispatcher_(dispatcher),
+                                                                          object_id_(pqrs::dispatcher::make_new_object_id()) {
+    dispatcher_->attach(object_id_);
+  }
+
+  ~test_client(void) {
+    dispatcher_->detach(object_id_);
+  }
+
+  template <typename Function>
+  void enqueue(Function&& function,
+               pqrs::dispatcher::time_point when = pqrs::dispatcher::dispatcher::when_immediately()) {
+    dispatcher_->enqueue(object_id_, std::forward<Function>(function), when);
+  }
+
+  void detach(void) {
+    dispatcher_->detach(object_id_);
+  }
+
+private:
+  std::shared_ptr<pqrs::dispatcher::dispatcher> dispatcher_;
+  pqrs::dispatcher::object_id object_id_;
+};
+
+void wait_until(const std::function<bool(void)>& predicate) {
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (!predicate() && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+}
+} // namespace
+
+TEST_CASE("dispatcher single worker") {
+  // Functions of all object_ids are executed in the enqueued order.
+
+  auto time_source = std::make_shared<pqrs::dispatcher::hardware_time_source>();
+  auto dispatcher = std::make_shared<pqrs::dispatcher::dispatcher>(time_source);
+
+  REQUIRE(dispatcher->worker_count() == 1);
+
+  std::mutex mutex;
+  std::vector<std::string> actual;
+
+  {
+    test_client a(dispatcher);
+    test_client b(dispatcher);
+
+    auto w = pqrs::make_thread_wait();
+    a.enqueue([&] {
+      // Block until all functions are enqueued.
+      w->wait_notice();
+    });
+
+    for (const auto& [client, name] : std::vector<std::pair<test_client*, std::string>>{
+             {&a, "a1"},
+             {&a, "a2"},
+             {&b, "b1"},
+             {&a, "a3"},
+             {&b, "b2"},
+         }) {
+      auto n = name;
+      client->enqueue([&, n] {
+        std::lock_guard<std::mutex> lock(mutex);
+        actual.push_back(n);
+      });
+    }
+
+    w->notify();
+
+    wait_until([&] {
+      std::lock_guard<std::mutex> lock(mutex);
+      return actual.size() == 5;
+    });
+  }
+
+  REQUIRE(actual == std::vector<std::string>{"a1", "a2", "b1", "a3", "b2"});
+
+  dispatcher->terminate();
+}
+
+TEST_CASE("dispatcher strands") {
+  // Functions of an object_id are executed serially and in order.
+
+  constexpr size_t client_count = 8;
+  constexpr int function_count = 2000;
+
+  auto time_source = std::make_shared<pqrs::dispatcher::hardware_time_source>();
+  auto dispatcher = std::make_shared<pqrs::dispatcher::dispatcher>(time_source, 4);
+
+  REQUIRE(dispatcher->worker_count() == 4);
+
+  struct state final {
+    std::atomic<bool> running{false};
+    std::atomic<int> next{0};
+    std::atomic<bool> error{false};
+  };
+  std::vector<state> states(client_count);
+
+  {
+    std::vector<std::unique_ptr<test_client>> clients;
+    for (size_t i = 0; i < client_count; ++i) {
+      clients.push_back(std::make_unique<test_client>(dispatcher));
+    }
+
+    for (int n = 0; n < function_count; ++n) {
+      for (size_t i = 0; i < client_count; ++i) {
+        auto& s = states[i];
+        clients[i]->enqueue([&s, n] {
+          if (s.running.exchange(true)) {
+            s.error = true;
+          }
+          if (s.next != n) {
+            s.error = true;
+          }
+          ++s.next;
+          s.running = false;
+        });
+      }
+    }
+
+    wait_until([&] {
+      for (const auto& s : states) {
+        if (s.next != function_count) {
+          return false;
+        }
+      }
+      return true;
+    });
+  }
+
+  for (const auto& s : states) {
+    REQUIRE(s.next == function_count);
+    REQUIRE(!s.error);
+  }
+
+  dispatcher->terminate();
+}
+
+TEST_CASE("dispatcher detach") {
+  auto time_source = std::make_shared<pqrs::dispatcher::hardware_time_source>();
+  auto dispatcher = std::make_shared<pqrs::dispatcher::dispatcher>(time_source, 4);
+
+  // `detach` waits the running function in another worker.
+
+  {
+    std::atomic<bool> started(false);
+    std::atomic<bool> finished(false);
+
+    test_client a(dispatcher);
+    a.enqueue([&] {
+      started = true;
+      std::this_thread::sleep_for(std::chrono::milliseconds(50));
+      finished = true;
+    });
+
+    wait_until([&] {
+      return started.load();
+    });
+
+    a.detach();
+    REQUIRE(finished);
+  }
+
+  // `detach` in the own function does not wait itself.
+
+  {
+    std::atomic<bool> finished(false);
+
+    test_client a(dispatcher);
+    a.enqueue([&] {
+      a.detach();
+      finished = true;
+    });
+
+    wait_until([&] {
+      return finished.load();
+    });
+    REQUIRE(finished);
+  }
+
+  // Functions of detached object_ids are not executed.
+
+  {
+    std::atomic<int> count(0);
+
+    test_client a(dispatcher);
+    a.enqueue(
+        [&] {
+          ++count;
+        },
+        time_source->now() + std::chrono::milliseconds(100));
+    a.detach();
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    REQUIRE(count == 0);
+  }
+
+  dispatcher->terminate();
+}
+
+TEST_CASE("dispatcher when") {
+  auto time_source = std::make_shared<pqrs::dispatcher::hardware_time_source>();
+  auto dispatcher = std::make_shared<pqrs::dispatcher::dispatcher>(time_source, 2);
+
+  std::mutex mutex;
+  std::vector<int> actual;
+
+  {
+    test_client a(dispatcher);
+    test_client b(dispatcher);
+
+    auto now = time_source->now();
+    a.enqueue(
+        [&] {
+          std::lock_guard<std::mutex> lock(mutex);
+          actual.push_back(2);
+        },
+        now + std::chrono::milliseconds(100));
+    b.enqueue(
+        [&] {
+          std::lock_guard<std::mutex> lock(mutex);
+          actual.push_back(1);
+        },
+        now + std::chrono::milliseconds(50));
+
+    wait_until([&] {
+      std::lock_guard<std::mutex> lock(mutex);
+      return actual.size() == 2;
+    });
+  }
+
+  REQUIRE(actual == std::vector<int>{1, 2});
+
+  dispatcher->terminate();
+}
+
+TEST_CASE("dispatcher benchmark", "[.benchmark]") {
+  // The cost of enqueue and execution per function.
+
+  constexpr int function_count = 1000000;
+
+  for (size_t worker_count : {1, 4}) {
+    auto time_source = std::make_shared<pqrs::dispatcher::hardware_time_source>();
+    auto dispatcher = std::make_shared<pqrs::dispatcher::dispatcher>(time_source, worker_count);
+
+    {
+      std::vector<std::unique_ptr<test_client>> clients;
+      for (size_t i = 0; i < 4; ++i) {
+        clients.push_back(std::make_unique<test_client>(dispatcher));
+      }
+
+      std::atomic<int> count(0);
+      auto start = std::chrono::steady_clock::now();
+
+      for (int i = 0; i < function_count; ++i) {
+        clients[i % clients.size()]->enqueue([&count] {
+          ++count;
+        });
+      }
+
+      wait_until([&] {
+        return count == function_count;
+      });
+
+      auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+      std::cout << "workers: " << worker_count
+                << ", " << elapsed / function_count << " ns/function" << std::endl;
+
+      REQUIRE(count == function_count);
+    }
+
+    dispatcher->terminate();
+  }
+}
@@ -0,0 +1,108 @@
+#include <catch2/catch.hpp>
+
+#include <pqrs/karabiner/driverkit/virtual_hid_device_service/flow_control.hpp>
+
+namespace {
+using namespace pqrs::karabiner::driverkit::virtual_hid_device_service;
+} // namespace
+
+TEST_CASE("completion_tracker") {
+  flow_control::completion_tracker t;
+  REQUIRE(t.get_completed_sequence() == 0);
+
+  REQUIRE(t.receive(1));
+  REQUIRE(t.receive(2));
+  REQUIRE(t.receive(3));
+  REQUIRE(!t.receive(3));
+  REQUIRE(t.get_completed_sequence() == 0);
+  REQUIRE(t.get_pending_count() == 3);
+
+  // Out of order
+
+  REQUIRE(!t.complete(2));
+  REQUIRE(!t.complete(3));
+  REQUIRE(t.get_completed_sequence() == 0);
+
+  REQUIRE(t.complete(1));
+  REQUIRE(t.get_completed_sequence() == 3);
+  REQUIRE(t.get_pending_count() == 0);
+
+  // Duplicated completion
+
+  REQUIRE(!t.complete(1));
+  REQUIRE(t.get_completed_sequence() == 3);
+
+  // Sequences which are not received are treated as completed.
+
+  REQUIRE(t.receive(10));
+  REQUIRE(t.get_completed_sequence() == 9);
+  REQUIRE(t.complete(10));
+  REQUIRE(t.get_completed_sequence() == 10);
+}
+
+TEST_CASE("make_credits") {
+  REQUIRE(flow_control::make_credits(256, 0, 1, 1024) == 256);
+  REQUIRE(flow_control::make_credits(256, 0, 1, 32) == 32);
+  REQUIRE(flow_control::make_credits(256, 56, 4, 1024) == 50);
+  REQUIRE(flow_control::make_credits(256, 0, 0, 1024) == 256);
+
+  // At least one credit is granted.
+
+  REQUIRE(flow_control::make_credits(256, 256, 1, 1024) == 1);
+  REQUIRE(flow_control::make_credits(256, 300, 1, 1024) == 1);
+  REQUIRE(flow_control::make_credits(256, 250, 10, 1024) == 1);
+  REQUIRE(flow_control::make_credits(256, 0, 1, 0) == 1);
+}
+
+TEST_CASE("window") {
+  flow_control::window w(2);
+
+  REQUIRE(!w.acquire());
+
+  REQUIRE(w.make_sequence() == 1);
+  REQUIRE(w.make_sequence() == 2);
+  REQUIRE(w.make_sequence() == 3);
+
+  // Credits
+
+  REQUIRE(w.acquire());
+  REQUIRE(w.acquire());
+  REQUIRE(!w.acquire());
+  REQUIRE(w.get_sent_sequence() == 2);
+  REQUIRE(w.get_in_flight() == 2);
+
+  REQUIRE(w.ack(1, 3));
+  REQUIRE(w.get_completed_sequence() == 1);
+  REQUIRE(w.get_credit_limit() == 4);
+  REQUIRE(w.get_in_flight() == 1);
+
+  REQUIRE(w.acquire());
+  REQUIRE(!w.acquire());
+  REQUIRE(w.get_sent_sequence() == 3);
+
+  // Acks of reports which are not sent are ignored.
+
+  REQUIRE(!w.ack(4, 100));
+  REQUIRE(w.get_completed_sequence() == 1);
+  REQUIRE(w.get_credit_limit() == 4);
+
+  // Credits are updated by duplicated acks.
+
+  REQUIRE(!w.ack(1, 1));
+  REQUIRE(w.get_credit_limit() == 2);
+
+  REQUIRE(w.ack(3, 1));
+  REQUIRE(w.get_in_flight() == 0);
+  REQUIRE(w.get_credit_limit() == 4);
+
+  // Restart
+
+  REQUIRE(w.make_sequence() == 4);
+  REQUIRE(w.acquire());
+  REQUIRE(w.get_in_flight() == 1);
+
+  REQUIRE(w.restart(2));
+  REQUIRE(w.get_completed_sequence() == 4);
+  REQUIRE(w.get_credit_limit() == 6);
+  REQUIRE(!w.restart(2));
+}
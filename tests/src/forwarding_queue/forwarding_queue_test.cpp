@@ -0,0 +1,219 @@
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <pqrs/karabiner/driverkit/virtual_hid_device_service/forwarding_queue.hpp>
+#include <thread>
+#include <vector>
+
+namespace {
+using namespace pqrs::karabiner::driverkit::virtual_hid_device_service;
+
+// A minimal serial executor (like `pqrs::dispatcher::dispatcher`).
+class executor final {
+public:
+  executor(void) : exit_(false) {
+    thread_ = std::thread([this] {
+      while (true) {
+        std::function<void(void)> function;
+
+        {
+          std::unique_lock<std::mutex> lock(mutex_);
+          cv_.wait(lock, [this] {
+            return exit_ || !queue_.empty();
+          });
+
+          if (queue_.empty()) {
+            return;
+          }
+
+          function = queue_.front();
+          queue_.pop_front();
+        }
+
+        function();
+      }
+    });
+  }
+
+  ~executor(void) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      exit_ = true;
+    }
+    cv_.notify_one();
+    thread_.join();
+  }
+
+  void enqueue(const std::function<void(void)>& function) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      queue_.push_back(function);
+    }
+    cv_.notify_one();
+  }
+
+private:
+  std::thread thread_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<std::function<void(void)>> queue_;
+  bool exit_;
+};
+
+struct timestamped_report final {
+  std::chrono::steady_clock::time_point time;
+};
+
+template <typename T, size_t Capacity, typename Function>
+void push(forwarding_queue<T, Capacity>& queue, executor& executor, const T& value, Function function) {
+  while (true) {
+    switch (queue.push(value)) {
+      case push_result::pushed:
+        return;
+      case push_result::pushed_and_wake:
+        executor.enqueue([&queue, function] {
+          queue.drain(function);
+        });
+        return;
+      case push_result::full:
+        std::this_thread::yield();
+        break;
+    }
+  }
+}
+} // namespace
+
+TEST_CASE("forwarding_queue") {
+  forwarding_queue<int, 4> queue;
+
+  REQUIRE(queue.capacity() == 4);
+  REQUIRE(queue.size() == 0);
+
+  REQUIRE(queue.push(1) == push_result::pushed_and_wake);
+  REQUIRE(queue.push(2) == push_result::pushed);
+  REQUIRE(queue.push(3) == push_result::pushed);
+  REQUIRE(queue.push(4) == push_result::pushed);
+  REQUIRE(queue.push(5) == push_result::full);
+  REQUIRE(queue.size() == 4);
+
+  std::vector<int> actual;
+  REQUIRE(queue.drain([&](auto&& v) { actual.push_back(v); }) == 4);
+  REQUIRE(actual == std::vector<int>{1, 2, 3, 4});
+  REQUIRE(queue.size() == 0);
+
+  // The next push wakes the consumer again.
+  REQUIRE(queue.push(6) == push_result::pushed_and_wake);
+  REQUIRE(queue.push(7) == push_result::pushed);
+
+  // A drain without values clears the flag too.
+  actual.clear();
+  REQUIRE(queue.drain([&](auto&& v) { actual.push_back(v); }) == 2);
+  REQUIRE(actual == std::vector<int>{6, 7});
+  REQUIRE(queue.drain([&](auto&& v) { actual.push_back(v); }) == 0);
+  REQUIRE(queue.push(8) == push_result::pushed_and_wake);
+}
+
+TEST_CASE("forwarding_queue threads") {
+  // Every value is delivered in order without lost wake-ups.
+
+  constexpr int count = 1000000;
+
+  forwarding_queue<int, 64> queue;
+  std::atomic<int> received(0);
+  std::atomic<bool> ordered(true);
+
+  {
+    executor consumer;
+
+    for (int i = 0; i < count; ++i) {
+      push(queue, consumer, i, [&](auto&& v) {
+        if (v != received) {
+          ordered = false;
+        }
+        ++received;
+      });
+    }
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (received != count && std::chrono::steady_clock::now() < deadline) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }
+
+  REQUIRE(received == count);
+  REQUIRE(ordered);
+}
+
+TEST_CASE("forwarding_queue isolation", "[.benchmark]") {
+  // Keyboard reports (1 per millisecond) and pointing reports (8 per millisecond) are sent from a producer thread.
+  // Posting a pointing report takes 100 microseconds (a slow IOKit call).
+  //
+  // shared: Both devices are forwarded in a thread.
+  // dedicated: Each device is forwarded in its own thread.
+
+  using clock = std::chrono::steady_clock;
+
+  auto slow_call = [] {
+    auto end = clock::now() + std::chrono::microseconds(100);
+    while (clock::now() < end) {
+    }
+  };
+
+  auto run = [&](bool dedicated) {
+    forwarding_queue<timestamped_report, 4096> keyboard_queue;
+    forwarding_queue<timestamped_report, 4096> pointing_queue;
+    std::vector<double> keyboard_latencies;
+    keyboard_latencies.reserve(1000);
+    std::atomic<size_t> keyboard_count(0);
+
+    {
+      executor keyboard_executor;
+      executor pointing_executor;
+      auto& e = dedicated ? keyboard_executor : pointing_executor;
+
+      auto keyboard_sink = [&](auto&& r) {
+        keyboard_latencies.push_back(std::chrono::duration<double, std::micro>(clock::now() - r.time).count());
+        ++keyboard_count;
+      };
+      auto pointing_sink = [&](auto&&) {
+        slow_call();
+      };
+
+      auto start = clock::now();
+      for (int ms = 0; ms < 1000; ++ms) {
+        auto tick = start + std::chrono::milliseconds(ms);
+        std::this_thread::sleep_until(tick);
+
+        push(keyboard_queue, e, timestamped_report{clock::now()}, keyboard_sink);
+        for (int i = 0; i < 8; ++i) {
+          push(pointing_queue, pointing_executor, timestamped_report{clock::now()}, pointing_sink);
+        }
+      }
+
+      while (keyboard_count < 1000) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+    }
+
+    std::sort(std::begin(keyboard_latencies), std::end(keyboard_latencies));
+    auto p50 = keyboard_latencies[keyboard_latencies.size() / 2];
+    auto p99 = keyboard_latencies[keyboard_latencies.size() * 99 / 100];
+
+    std::cout << (dedicated ? "dedicated" : "shared   ")
+              << " keyboard latency p50: " << p50 << " us, p99: " << p99 << " us" << std::endl;
+
+    return p99;
+  };
+
+  auto shared_p99 = run(false);
+  auto dedicated_p99 = run(true);
+
+  REQUIRE(dedicated_p99 < shared_p99);
+}
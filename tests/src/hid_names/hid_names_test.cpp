@@ -0,0 +1,154 @@
+#include <catch2/catch.hpp>
+
+#include <chrono>
+#include <iostream>
+#include <pqrs/karabiner/driverkit/virtual_hid_device_service/hid_names.hpp>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+using namespace pqrs::karabiner::driverkit;
+using namespace pqrs::karabiner::driverkit::virtual_hid_device_service;
+
+// Lookups are available at compile time.
+static_assert(*hid_names::find_usage_page("keyboard_or_keypad") == pqrs::hid::usage_page::keyboard_or_keypad);
+static_assert(*hid_names::find_usage(pqrs::hid::usage_page::keyboard_or_keypad, "keyboard_up_arrow") == pqrs::hid::usage::keyboard_or_keypad::keyboard_up_arrow);
+static_assert(*hid_names::find_modifier("left_control") == virtual_hid_device_driver::hid_report::modifier::left_control);
+static_assert(*hid_names::find_modifier_name(virtual_hid_device_driver::hid_report::modifier::right_command) == "right_command");
+} // namespace
+
+TEST_CASE("usage_page") {
+  for (const auto& e : hid_names::usage_page_name_entries) {
+    REQUIRE(hid_names::find_usage_page(e.name) == e.usage_page);
+    REQUIRE(hid_names::find_usage_page_name(e.usage_page) == e.name);
+  }
+
+  REQUIRE(hid_names::find_usage_page("generic_desktop") == pqrs::hid::usage_page::generic_desktop);
+  REQUIRE(hid_names::find_usage_page_name(pqrs::hid::usage_page::apple_vendor_top_case) == "apple_vendor_top_case");
+
+  REQUIRE(hid_names::find_usage_page("") == std::nullopt);
+  REQUIRE(hid_names::find_usage_page("generic_desktop_") == std::nullopt);
+  REQUIRE(hid_names::find_usage_page_name(pqrs::hid::usage_page::value_t(0x1234)) == std::nullopt);
+}
+
+TEST_CASE("usage") {
+  for (const auto& e : hid_names::usage_name_entries) {
+    REQUIRE(hid_names::find_usage(e.usage_page, e.name) == e.usage);
+    REQUIRE(hid_names::find_usage_name(e.usage_page, e.usage) == e.name);
+  }
+
+  REQUIRE(hid_names::find_usage(pqrs::hid::usage_page::keyboard_or_keypad, "keyboard_a") == pqrs::hid::usage::keyboard_or_keypad::keyboard_a);
+  REQUIRE(hid_names::find_usage(pqrs::hid::usage_page::consumer, "mute") == pqrs::hid::usage::consumer::mute);
+  REQUIRE(hid_names::find_usage(pqrs::hid::usage_page::leds, "caps_lock") == pqrs::hid::usage::led::caps_lock);
+  REQUIRE(hid_names::find_usage_name(pqrs::hid::usage_page::button, pqrs::hid::usage::button::button_3) == "button_3");
+
+  // Names are unique within a usage page.
+
+  REQUIRE(hid_names::find_usage(pqrs::hid::usage_page::generic_desktop, "undefined") == pqrs::hid::usage::generic_desktop::undefined);
+  REQUIRE(hid_names::find_usage(pqrs::hid::usage_page::leds, "undefined") == pqrs::hid::usage::led::undefined);
+  REQUIRE(hid_names::find_usage(pqrs::hid::usage_page::consumer, "keyboard_a") == std::nullopt);
+
+  REQUIRE(hid_names::find_usage(pqrs::hid::usage_page::keyboard_or_keypad, "") == std::nullopt);
+  REQUIRE(hid_names::find_usage(pqrs::hid::usage_page::keyboard_or_keypad, "keyboard_") == std::nullopt);
+  REQUIRE(hid_names::find_usage_name(pqrs::hid::usage_page::keyboard_or_keypad, pqrs::hid::usage::value_t(0xe8)) == std::nullopt);
+  REQUIRE(hid_names::find_usage_name(pqrs::hid::usage_page::value_t(0x1234), pqrs::hid::usage::value_t(0x04)) == std::nullopt);
+}
+
+TEST_CASE("modifier") {
+  for (const auto& e : hid_names::modifier_name_entries) {
+    REQUIRE(hid_names::find_modifier(e.name) == e.modifier);
+    REQUIRE(hid_names::find_modifier_name(e.modifier) == e.name);
+  }
+
+  REQUIRE(hid_names::modifier_name_entries.size() == 8);
+  REQUIRE(hid_names::find_modifier("left_shift") == virtual_hid_device_driver::hid_report::modifier::left_shift);
+  REQUIRE(hid_names::find_modifier("fn") == std::nullopt);
+  REQUIRE(hid_names::find_modifier_name(virtual_hid_device_driver::hid_report::modifier(0)) == std::nullopt);
+}
+
+TEST_CASE("hid_names benchmark", "[.benchmark]") {
+  constexpr int iterations = 1000;
+
+  // The lookup keys are copied into std::string as a config loader does.
+  std::vector<std::pair<pqrs::hid::usage_page::value_t, std::string>> names;
+  for (const auto& e : hid_names::usage_name_entries) {
+    names.emplace_back(e.usage_page, std::string(e.name));
+  }
+
+  auto start = std::chrono::steady_clock::now();
+
+  std::unordered_map<std::string, pqrs::hid::usage::value_t> map;
+  for (const auto& e : hid_names::usage_name_entries) {
+    map.emplace(std::to_string(type_safe::get(e.usage_page)) + ":" + std::string(e.name), e.usage);
+  }
+
+  auto construction = std::chrono::steady_clock::now() - start;
+
+  int32_t sum1 = 0;
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; ++i) {
+    for (const auto& [usage_page, name] : names) {
+      auto it = map.find(std::to_string(type_safe::get(usage_page)) + ":" + name);
+      sum1 += type_safe::get(it->second);
+    }
+  }
+  auto unordered_map_elapsed = std::chrono::steady_clock::now() - start;
+
+  int32_t sum2 = 0;
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; ++i) {
+    for (const auto& [usage_page, name] : names) {
+      sum2 += type_safe::get(*hid_names::find_usage(usage_page, name));
+    }
+  }
+  auto perfect_hash_elapsed = std::chrono::steady_clock::now() - start;
+
+  // Without the key concatenation.
+
+  std::unordered_map<std::string, pqrs::hid::usage::value_t> keyboard_map;
+  for (const auto& e : hid_names::usage_name_entries) {
+    if (e.usage_page == pqrs::hid::usage_page::keyboard_or_keypad) {
+      keyboard_map.emplace(std::string(e.name), e.usage);
+    }
+  }
+
+  int32_t sum3 = 0;
+  int32_t sum4 = 0;
+  std::chrono::nanoseconds keyboard_unordered_map_elapsed(0);
+  std::chrono::nanoseconds keyboard_perfect_hash_elapsed(0);
+  size_t keyboard_count = 0;
+  for (int i = 0; i < iterations; ++i) {
+    start = std::chrono::steady_clock::now();
+    for (const auto& [usage_page, name] : names) {
+      if (usage_page == pqrs::hid::usage_page::keyboard_or_keypad) {
+        sum3 += type_safe::get(keyboard_map.find(name)->second);
+      }
+    }
+    keyboard_unordered_map_elapsed += std::chrono::steady_clock::now() - start;
+
+    start = std::chrono::steady_clock::now();
+    for (const auto& [usage_page, name] : names) {
+      if (usage_page == pqrs::hid::usage_page::keyboard_or_keypad) {
+        sum4 += type_safe::get(*hid_names::find_usage(usage_page, name));
+        ++keyboard_count;
+      }
+    }
+    keyboard_perfect_hash_elapsed += std::chrono::steady_clock::now() - start;
+  }
+
+  REQUIRE(sum1 == sum2);
+  REQUIRE(sum3 == sum4);
+
+  auto lookups = iterations * names.size();
+  std::cout << "std::unordered_map construction: "
+            << std::chrono::duration_cast<std::chrono::nanoseconds>(construction).count() << " ns" << std::endl;
+  std::cout << "std::unordered_map (usage_page:name): "
+            << std::chrono::duration_cast<std::chrono::nanoseconds>(unordered_map_elapsed).count() / lookups << " ns/lookup" << std::endl;
+  std::cout << "hid_names::find_usage: "
+            << std::chrono::duration_cast<std::chrono::nanoseconds>(perfect_hash_elapsed).count() / lookups << " ns/lookup" << std::endl;
+  std::cout << "std::unordered_map (keyboard_or_keypad name): "
+            << keyboard_unordered_map_elapsed.count() / keyboard_count << " ns/lookup" << std::endl;
+  std::cout << "hid_names::find_usage (keyboard_or_keypad): "
+            << keyboard_perfect_hash_elapsed.count() / keyboard_count << " ns/lookup" << std::endl;
+}
@@ -0,0 +1,305 @@
+#include <catch2/catch.hpp>
+
+#include <pqrs/karabiner/driverkit/virtual_hid_device_driver.hpp>
+#include <vector>
+
+namespace {
+// The hand-written descriptors which were used before `hid_descriptor`.
+// (keyboard_bitmap_input is appended after that, and the pointing wheels are widened to 16 bits.)
+const uint8_t expected_keyboard_report_descriptor[] = {
+    0x05, 0x01,       // Usage Page (Generic Desktop)
+    0x09, 0x06,       // Usage (Keyboard)
+    0xa1, 0x01,       // Collection (Application)
+    0x85, 0x01,       //   Report Id (1)
+    0x05, 0x07,       //   Usage Page (Keyboard/Keypad)
+    0x19, 0xe0,       //   Usage Minimum........... (224)
+    0x29, 0xe7,       //   Usage Maximum........... (231)
+    0x15, 0x00,       //   Logical Minimum......... (0)
+    0x25, 0x01,       //   Logical Maximum......... (1)
+    0x75, 0x01,       //   Report Size............. (1)
+    0x95, 0x08,       //   Report Count............ (8)
+    0x81, 0x02,       //   Input...................(Data, Variable, Absolute)
+                      //
+    0x95, 0x01,       //   Report Count............ (1)
+    0x75, 0x08,       //   Report Size............. (8)
+    0x81, 0x01,       //   Input...................(Constant)
+                      //
+    0x95, 0x20,       //   Report Count............ (32)
+    0x75, 0x08,       //   Report Size............. (8)
+    0x15, 0x00,       //   Logical Minimum......... (0)
+    0x26, 0xff, 0x00, //   Logical Maximum......... (255)
+    0x05, 0x07,       //   Usage Page (Keyboard/Keypad)
+    0x19, 0x00,       //   Usage Minimum........... (0)
+    0x29, 0xff,       //   Usage Maximum........... (255)
+    0x81, 0x00,       //   Input...................(Data, Array, Absolute)
+    0xc0,             // End Collection
+
+    0x05, 0x0c,       // Usage Page (Consumer)
+    0x09, 0x01,       // Usage 1 (kHIDUsage_Csmr_ConsumerControl)
+    0xa1, 0x01,       // Collection (Application)
+    0x85, 0x02,       //   Report Id (2)
+    0x05, 0x0c,       //   Usage Page (Consumer)
+    0x95, 0x20,       //   Report Count............ (32)
+    0x75, 0x08,       //   Report Size............. (8)
+    0x15, 0x00,       //   Logical Minimum......... (0)
+    0x26, 0xff, 0x00, //   Logical Maximum......... (255)
+    0x19, 0x00,       //   Usage Minimum........... (0)
+    0x29, 0xff,       //   Usage Maximum........... (255)
+    0x81, 0x00,       //   Input...................(Data, Array, Absolute)
+    0xc0,             // End Collection
+
+    0x06, 0x00, 0xff, // Usage Page (kHIDPage_AppleVendor)
+    0x09, 0x01,       // Usage 1 (kHIDUsage_AppleVendor_TopCase)
+    0xa1, 0x01,       // Collection (Application)
+    0x85, 0x03,       //   Report Id (3)
+    0x05, 0xff,       //   Usage Page (kHIDPage_AppleVendorTopCase)
+    0x95, 0x20,       //   Report Count............ (32)
+    0x75, 0x08,       //   Report Size............. (8)
+    0x15, 0x00,       //   Logical Minimum......... (0)
+    0x26, 0xff, 0x00, //   Logical Maximum......... (255)
+    0x19, 0x00,       //   Usage Minimum........... (0)
+    0x29, 0xff,       //   Usage Maximum........... (255)
+    0x81, 0x00,       //   Input...................(Data, Array, Absolute)
+    0xc0,             // End Collection
+
+    0x06, 0x00, 0xff, // Usage Page (kHIDPage_AppleVendor)
+    0x09, 0x06,       // Usage 6 (kHIDUsage_AppleVendor_Keyboard)
+    0xa1, 0x01,       // Collection (Application)
+    0x85, 0x04,       //   Report Id (4)
+    0x06, 0x01, 0xff, //   Usage Page (kHIDPage_AppleVendorKeyboard)
+    0x95, 0x20,       //   Report Count............ (32)
+    0x75, 0x08,       //   Report Size............. (8)
+    0x15, 0x00,       //   Logical Minimum......... (0)
+    0x26, 0xff, 0x00, //   Logical Maximum......... (255)
+    0x19, 0x00,       //   Usage Minimum........... (0)
+    0x29, 0xff,       //   Usage Maximum........... (255)
+    0x81, 0x00,       //   Input...................(Data, Array, Absolute)
+    0xc0,             // End Collection
+
+    0x05, 0x01, // Usage Page (Generic Desktop)
+    0x09, 0x06, // Usage (Keyboard)
+    0xa1, 0x01, // Collection (Application)
+    0x85, 0x05, //   Report Id (5)
+    0x05, 0x08, //   Usage Page (LED)
+    0x95, 0x02, //   Report Count............ (2)
+    0x75, 0x01, //   Report Size............. (1)
+    0x19, 0x01, //   Usage Minimum........... (1)
+    0x29, 0x02, //   Usage Maximum........... (2)
+    0x91, 0x02, //   Output..................(Data, Variable, Absolute)
+    0x95, 0x01, //   Report Count............ (1)
+    0x75, 0x06, //   Report Size............. (6)
+    0x91, 0x01, //   Output..................(Constant)
+    0xc0,       // End Collection
+
+    0x05, 0x01, // Usage Page (Generic Desktop)
+    0x09, 0x06, // Usage (Keyboard)
+    0xa1, 0x01, // Collection (Application)
+    0x85, 0x06, //   Report Id (6)
+    0x05, 0x08, //   Usage Page (LED)
+    0x95, 0x02, //   Report Count............ (2)
+    0x75, 0x01, //   Report Size............. (1)
+    0x19, 0x01, //   Usage Minimum........... (1)
+    0x29, 0x02, //   Usage Maximum........... (2)
+    0x81, 0x02, //   Input...................(Data, Variable, Absolute)
+    0x95, 0x01, //   Report Count............ (1)
+    0x75, 0x06, //   Report Size............. (6)
+    0x81, 0x01, //   Input...................(Constant)
+    0xc0,       // End Collection
+
+    0x05, 0x01,       // Usage Page (Generic Desktop)
+    0x09, 0x06,       // Usage (Keyboard)
+    0xa1, 0x01,       // Collection (Application)
+    0x85, 0x07,       //   Report Id (7)
+    0x05, 0x07,       //   Usage Page (Keyboard/Keypad)
+    0x19, 0xe0,       //   Usage Minimum........... (224)
+    0x29, 0xe7,       //   Usage Maximum........... (231)
+    0x15, 0x00,       //   Logical Minimum......... (0)
+    0x25, 0x01,       //   Logical Maximum......... (1)
+    0x75, 0x01,       //   Report Size............. (1)
+    0x95, 0x08,       //   Report Count............ (8)
+    0x81, 0x02,       //   Input...................(Data, Variable, Absolute)
+    0x19, 0x00,       //   Usage Minimum........... (0)
+    0x29, 0xff,       //   Usage Maximum........... (255)
+    0x96, 0x00, 0x01, //   Report Count............ (256)
+    0x81, 0x02,       //   Input...................(Data, Variable, Absolute)
+    0xc0,             // End Collection
+};
+
+const uint8_t expected_pointing_report_descriptor[] = {
+    0x05, 0x01,        // USAGE_PAGE (Generic Desktop)
+    0x09, 0x02,        // USAGE (Mouse)
+    0xa1, 0x01,        // COLLECTION (Application)
+    0x09, 0x02,        //   USAGE (Mouse)
+    0xa1, 0x02,        //   COLLECTION (Logical)
+    0x09, 0x01,        //     USAGE (Pointer)
+    0xa1, 0x00,        //     COLLECTION (Physical)
+    /*              */ // ------------------------------ Buttons
+    0x05, 0x09,        //       USAGE_PAGE (Button)
+    0x19, 0x01,        //       USAGE_MINIMUM (Button 1)
+    0x29, 0x20,        //       USAGE_MAXIMUM (Button 32)
+    0x15, 0x00,        //       LOGICAL_MINIMUM (0)
+    0x25, 0x01,        //       LOGICAL_MAXIMUM (1)
+    0x75, 0x01,        //       REPORT_SIZE (1)
+    0x95, 0x20,        //       REPORT_COUNT (32 Buttons)
+    0x81, 0x02,        //       INPUT (Data,Var,Abs)
+    /*              */ // ------------------------------ X,Y position
+    0x05, 0x01,        //       USAGE_PAGE (Generic Desktop)
+    0x09, 0x30,        //       USAGE (X)
+    0x09, 0x31,        //       USAGE (Y)
+    0x15, 0x81,        //       LOGICAL_MINIMUM (-127)
+    0x25, 0x7f,        //       LOGICAL_MAXIMUM (127)
+    0x75, 0x08,        //       REPORT_SIZE (8)
+    0x95, 0x02,        //       REPORT_COUNT (2)
+    0x81, 0x06,        //       INPUT (Data,Var,Rel)
+    0xa1, 0x02,        //       COLLECTION (Logical)
+    /*              */ // ------------------------------ Vertical wheel res multiplier
+    0x09, 0x48,        //         USAGE (Resolution Multiplier)
+    0x15, 0x00,        //         LOGICAL_MINIMUM (0)
+    0x25, 0x01,        //         LOGICAL_MAXIMUM (1)
+    0x35, 0x01,        //         PHYSICAL_MINIMUM (1)
+    0x45, 0x04,        //         PHYSICAL_MAXIMUM (4)
+    0x75, 0x02,        //         REPORT_SIZE (2)
+    0x95, 0x01,        //         REPORT_COUNT (1)
+    0xa4,              //         PUSH
+    0xb1, 0x02,        //         FEATURE (Data,Var,Abs)
+    /*              */ // ------------------------------ Vertical wheel
+    0x09, 0x38,        //         USAGE (Wheel)
+    0x16, 0x01, 0x80,  //         LOGICAL_MINIMUM (-32767)
+    0x26, 0xff, 0x7f,  //         LOGICAL_MAXIMUM (32767)
+    0x35, 0x00,        //         PHYSICAL_MINIMUM (0)        - reset physical
+    0x45, 0x00,        //         PHYSICAL_MAXIMUM (0)
+    0x75, 0x10,        //         REPORT_SIZE (16)
+    0x81, 0x06,        //         INPUT (Data,Var,Rel)
+    0xc0,              //       END_COLLECTION
+    0xa1, 0x02,        //       COLLECTION (Logical)
+    /*              */ // ------------------------------ Horizontal wheel res multiplier
+    0x09, 0x48,        //         USAGE (Resolution Multiplier)
+    0xb4,              //         POP
+    0xb1, 0x02,        //         FEATURE (Data,Var,Abs)
+    /*              */ // ------------------------------ Padding for Feature report
+    0x35, 0x00,        //         PHYSICAL_MINIMUM (0)        - reset physical
+    0x45, 0x00,        //         PHYSICAL_MAXIMUM (0)
+    0x75, 0x04,        //         REPORT_SIZE (4)
+    0xb1, 0x03,        //         FEATURE (Cnst,Var,Abs)
+    /*              */ // ------------------------------ Horizontal wheel
+    0x05, 0x0c,        //         USAGE_PAGE (Consumer Devices)
+    0x0a, 0x38, 0x02,  //         USAGE (AC Pan)
+    0x16, 0x01, 0x80,  //         LOGICAL_MINIMUM (-32767)
+    0x26, 0xff, 0x7f,  //         LOGICAL_MAXIMUM (32767)
+    0x75, 0x10,        //         REPORT_SIZE (16)
+    0x81, 0x06,        //         INPUT (Data,Var,Rel)
+    0xc0,              //       END_COLLECTION
+    0xc0,              //     END_COLLECTION
+    0xc0,              //   END_COLLECTION
+    0xc0,              // END_COLLECTION
+};
+
+template <size_t Capacity>
+std::vector<uint8_t> to_vector(const pqrs::karabiner::driverkit::virtual_hid_device_driver::hid_descriptor::descriptor<Capacity>& d) {
+  return std::vector<uint8_t>(d.data(), d.data() + d.size());
+}
+} // namespace
+
+TEST_CASE("keyboard_report_descriptor") {
+  using namespace pqrs::karabiner::driverkit::virtual_hid_device_driver;
+
+  REQUIRE(to_vector(hid_report::keyboard_report_descriptor) ==
+          std::vector<uint8_t>(std::begin(expected_keyboard_report_descriptor),
+                               std::end(expected_keyboard_report_descriptor)));
+
+  auto data = expected_keyboard_report_descriptor;
+  auto size = sizeof(expected_keyboard_report_descriptor);
+  REQUIRE(hid_descriptor::report_byte_size(data, size, hid_descriptor::report_type::input, 1) == sizeof(hid_report::keyboard_input));
+  REQUIRE(hid_descriptor::report_byte_size(data, size, hid_descriptor::report_type::input, 2) == sizeof(hid_report::consumer_input));
+  REQUIRE(hid_descriptor::report_byte_size(data, size, hid_descriptor::report_type::input, 3) == sizeof(hid_report::apple_vendor_top_case_input));
+  REQUIRE(hid_descriptor::report_byte_size(data, size, hid_descriptor::report_type::input, 4) == sizeof(hid_report::apple_vendor_keyboard_input));
+  REQUIRE(hid_descriptor::report_byte_size(data, size, hid_descriptor::report_type::output, 5) == 2);
+  REQUIRE(hid_descriptor::report_byte_size(data, size, hid_descriptor::report_type::input, 5) == 0);
+  REQUIRE(hid_descriptor::report_byte_size(data, size, hid_descriptor::report_type::input, 6) == 2);
+  REQUIRE(hid_descriptor::report_byte_size(data, size, hid_descriptor::report_type::input, 7) == sizeof(hid_report::keyboard_bitmap_input));
+  REQUIRE(hid_descriptor::report_byte_size(data, size, hid_descriptor::report_type::input, 8) == 0);
+}
+
+TEST_CASE("pointing_report_descriptor") {
+  using namespace pqrs::karabiner::driverkit::virtual_hid_device_driver;
+
+  REQUIRE(to_vector(hid_report::pointing_report_descriptor) ==
+          std::vector<uint8_t>(std::begin(expected_pointing_report_descriptor),
+                               std::end(expected_pointing_report_descriptor)));
+
+  auto data = expected_pointing_report_descriptor;
+  auto size = sizeof(expected_pointing_report_descriptor);
+  REQUIRE(hid_descriptor::report_byte_size(data, size, hid_descriptor::report_type::input, 0) == sizeof(hid_report::pointing_high_resolution_input));
+  // 2 resolution multipliers (2 bits) and padding (4 bits)
+  REQUIRE(hid_descriptor::report_byte_size(data, size, hid_descriptor::report_type::feature, 0) == sizeof(hid_report::wheel_resolution_multiplier_feature));
+  REQUIRE(hid_descriptor::report_byte_size(data, size, hid_descriptor::report_type::output, 0) == 0);
+}
+
+TEST_CASE("absolute_pointing_report_descriptor") {
+  using namespace pqrs::karabiner::driverkit::virtual_hid_device_driver;
+
+  const uint8_t expected[] = {
+      0x05, 0x01,       // USAGE_PAGE (Generic Desktop)
+      0x09, 0x02,       // USAGE (Mouse)
+      0xa1, 0x01,       // COLLECTION (Application)
+      0x09, 0x01,       //   USAGE (Pointer)
+      0xa1, 0x00,       //   COLLECTION (Physical)
+      0x05, 0x09,       //     USAGE_PAGE (Button)
+      0x19, 0x01,       //     USAGE_MINIMUM (Button 1)
+      0x29, 0x20,       //     USAGE_MAXIMUM (Button 32)
+      0x15, 0x00,       //     LOGICAL_MINIMUM (0)
+      0x25, 0x01,       //     LOGICAL_MAXIMUM (1)
+      0x75, 0x01,       //     REPORT_SIZE (1)
+      0x95, 0x20,       //     REPORT_COUNT (32)
+      0x81, 0x02,       //     INPUT (Data,Var,Abs)
+      0x05, 0x01,       //     USAGE_PAGE (Generic Desktop)
+      0x09, 0x30,       //     USAGE (X)
+      0x09, 0x31,       //     USAGE (Y)
+      0x15, 0x00,       //     LOGICAL_MINIMUM (0)
+      0x26, 0xff, 0x7f, //     LOGICAL_MAXIMUM (32767)
+      0x75, 0x10,       //     REPORT_SIZE (16)
+      0x95, 0x02,       //     REPORT_COUNT (2)
+      0x81, 0x02,       //     INPUT (Data,Var,Abs)
+      0xc0,             //   END_COLLECTION
+      0xc0,             // END_COLLECTION
+  };
+
+  REQUIRE(to_vector(hid_report::absolute_pointing_report_descriptor) ==
+          std::vector<uint8_t>(std::begin(expected),
+                               std::end(expected)));
+
+  auto& d = hid_report::absolute_pointing_report_descriptor;
+  REQUIRE(hid_descriptor::report_byte_size(d, hid_descriptor::report_type::input, 0) == sizeof(hid_report::absolute_pointing_input));
+  REQUIRE(hid_descriptor::report_byte_size(d, hid_descriptor::report_type::feature, 0) == 0);
+  REQUIRE(hid_descriptor::report_byte_size(d, hid_descriptor::report_type::output, 0) == 0);
+}
+
+TEST_CASE("hid_descriptor") {
+  using namespace pqrs::karabiner::driverkit::virtual_hid_device_driver;
+
+  constexpr auto d = [] {
+    hid_descriptor::descriptor<32> d;
+    d.usage(0x1)
+        .usage(0x238)
+        .usage(0x12345)
+        .logical_minimum(-1)
+        .logical_maximum(255)
+        .logical_minimum(-32769)
+        .push()
+        .pop()
+        .end_collection();
+    return d;
+  }();
+
+  REQUIRE(to_vector(d) == std::vector<uint8_t>{
+                              0x09, 0x01,
+                              0x0a, 0x38, 0x02,
+                              0x0b, 0x45, 0x23, 0x01, 0x00,
+                              0x15, 0xff,
+                              0x26, 0xff, 0x00,
+                              0x17, 0xff, 0x7f, 0xff, 0xff,
+                              0xa4,
+                              0xb4,
+                              0xc0,
+                          });
+}
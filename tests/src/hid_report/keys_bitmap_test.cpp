@@ -0,0 +1,97 @@
+#include <catch2/catch.hpp>
+
+#include <pqrs/karabiner/driverkit/virtual_hid_device_driver.hpp>
+
+TEST_CASE("keys_bitmap") {
+  using namespace pqrs::karabiner::driverkit::virtual_hid_device_driver;
+
+  {
+    hid_report::keys_bitmap keys;
+    uint8_t expected[32];
+
+    REQUIRE(keys.count() == 0);
+    REQUIRE(keys.empty());
+    memset(expected, 0, sizeof(expected));
+    REQUIRE(memcmp(keys.get_raw_value(), expected, sizeof(expected)) == 0);
+
+    keys.insert(0x04);
+    REQUIRE(keys.count() == 1);
+    REQUIRE(!keys.empty());
+    REQUIRE(keys.exists(0x04));
+    REQUIRE(!keys.exists(0x05));
+    expected[0] = 0x10;
+    REQUIRE(memcmp(keys.get_raw_value(), expected, sizeof(expected)) == 0);
+
+    keys.insert(0x04);
+    REQUIRE(keys.count() == 1);
+
+    keys.insert(0xff);
+    REQUIRE(keys.count() == 2);
+    REQUIRE(keys.exists(0xff));
+    expected[31] = 0x80;
+    REQUIRE(memcmp(keys.get_raw_value(), expected, sizeof(expected)) == 0);
+
+    keys.erase(0x04);
+    REQUIRE(keys.count() == 1);
+    REQUIRE(!keys.exists(0x04));
+    expected[0] = 0;
+    REQUIRE(memcmp(keys.get_raw_value(), expected, sizeof(expected)) == 0);
+
+    keys.erase(0x04);
+    REQUIRE(keys.count() == 1);
+
+    keys.clear();
+    REQUIRE(keys.count() == 0);
+    REQUIRE(keys.empty());
+  }
+
+  {
+    // Usage 0 is ignored.
+
+    hid_report::keys_bitmap keys;
+    keys.insert(0);
+    REQUIRE(keys.empty());
+    REQUIRE(!keys.exists(0));
+  }
+
+  {
+    // No limit
+
+    hid_report::keys_bitmap keys;
+
+    for (int i = 1; i < 256; ++i) {
+      keys.insert(i);
+      REQUIRE(keys.count() == static_cast<size_t>(i));
+    }
+
+    for (int i = 1; i < 256; ++i) {
+      REQUIRE(keys.exists(i));
+    }
+
+    hid_report::keys_bitmap other;
+    REQUIRE(keys != other);
+    for (int i = 1; i < 256; ++i) {
+      other.insert(i);
+    }
+    REQUIRE(keys == other);
+  }
+
+  {
+    // includes
+
+    hid_report::keys_bitmap keys1;
+    hid_report::keys_bitmap keys2;
+    REQUIRE(keys1.includes(keys2));
+
+    keys1.insert(10);
+    keys1.insert(200);
+    REQUIRE(keys1.includes(keys2));
+    REQUIRE(!keys2.includes(keys1));
+
+    keys2.insert(200);
+    REQUIRE(keys1.includes(keys2));
+
+    keys2.insert(11);
+    REQUIRE(!keys1.includes(keys2));
+  }
+}
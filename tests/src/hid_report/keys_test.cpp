@@ -80,4 +80,28 @@ TEST_CASE("keys") {
     keys.insert(20);
     REQUIRE(keys.count() == 32);
   }
+
+  {
+    // includes
+
+    hid_report::keys keys1;
+    hid_report::keys keys2;
+    REQUIRE(keys1.includes(keys2));
+
+    keys1.insert(10);
+    keys1.insert(20);
+    REQUIRE(keys1.includes(keys2));
+    REQUIRE(!keys2.includes(keys1));
+
+    keys2.insert(20);
+    REQUIRE(keys1.includes(keys2));
+
+    keys2.insert(30);
+    REQUIRE(!keys1.includes(keys2));
+
+    keys2.erase(30);
+    keys2.insert(10);
+    REQUIRE(keys1.includes(keys2));
+    REQUIRE(keys2.includes(keys1));
+  }
 }
@@ -78,4 +78,23 @@ TEST_CASE("modifiers") {
     REQUIRE(!modifiers.exists(hid_report::modifier::right_option));
     REQUIRE(!modifiers.exists(hid_report::modifier::right_command));
   }
+
+  {
+    // includes
+
+    hid_report::modifiers modifiers1;
+    hid_report::modifiers modifiers2;
+    REQUIRE(modifiers1.includes(modifiers2));
+
+    modifiers1.insert(hid_report::modifier::left_shift);
+    modifiers1.insert(hid_report::modifier::right_command);
+    REQUIRE(modifiers1.includes(modifiers2));
+    REQUIRE(!modifiers2.includes(modifiers1));
+
+    modifiers2.insert(hid_report::modifier::right_command);
+    REQUIRE(modifiers1.includes(modifiers2));
+
+    modifiers2.insert(hid_report::modifier::left_option);
+    REQUIRE(!modifiers1.includes(modifiers2));
+  }
 }
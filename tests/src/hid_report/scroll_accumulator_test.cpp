@@ -0,0 +1,72 @@
+#include <catch2/catch.hpp>
+
+#include <pqrs/karabiner/driverkit/virtual_hid_device_driver.hpp>
+
+TEST_CASE("scroll_accumulator") {
+  using namespace pqrs::karabiner::driverkit::virtual_hid_device_driver;
+
+  constexpr int16_t unit = hid_report::pointing_high_resolution_input::wheel_unit;
+
+  {
+    hid_report::scroll_accumulator accumulator;
+    hid_report::pointing_high_resolution_input report;
+
+    REQUIRE(!accumulator.apply(report));
+
+    accumulator.add(1.0, -0.5);
+    REQUIRE(accumulator.apply(report));
+    REQUIRE(report.vertical_wheel == unit);
+    REQUIRE(report.horizontal_wheel == -unit / 2);
+
+    REQUIRE(!accumulator.apply(report));
+    REQUIRE(report.vertical_wheel == 0);
+    REQUIRE(report.horizontal_wheel == 0);
+  }
+
+  {
+    // Fractions are carried.
+
+    hid_report::scroll_accumulator accumulator;
+    hid_report::pointing_high_resolution_input report;
+
+    int vertical = 0;
+    int horizontal = 0;
+    for (int i = 0; i < 1000; ++i) {
+      accumulator.add(0.001, -0.0001);
+      accumulator.apply(report);
+      vertical += report.vertical_wheel;
+      horizontal += report.horizontal_wheel;
+    }
+    accumulator.add(0.000001, -0.000001);
+    accumulator.apply(report);
+    vertical += report.vertical_wheel;
+    horizontal += report.horizontal_wheel;
+
+    REQUIRE(vertical == unit);
+    REQUIRE(horizontal == -unit / 10);
+  }
+
+  {
+    // Large values are split into multiple reports.
+
+    hid_report::scroll_accumulator accumulator;
+    hid_report::pointing_high_resolution_input report;
+
+    accumulator.add(300.0, 0.0);
+
+    REQUIRE(accumulator.apply(report));
+    REQUIRE(report.vertical_wheel == 32767);
+    REQUIRE(accumulator.apply(report));
+    REQUIRE(report.vertical_wheel == 300 * unit - 32767);
+    REQUIRE(!accumulator.apply(report));
+  }
+
+  {
+    hid_report::scroll_accumulator accumulator;
+    hid_report::pointing_high_resolution_input report;
+
+    accumulator.add(0.5, 0.5);
+    accumulator.clear();
+    REQUIRE(!accumulator.apply(report));
+  }
+}
@@ -5,9 +5,13 @@
 TEST_CASE("sizeof") {
   using namespace pqrs::karabiner::driverkit::virtual_hid_device_driver;
 
+  REQUIRE(sizeof(hid_report::absolute_pointing_input) == 8);
   REQUIRE(sizeof(hid_report::apple_vendor_keyboard_input) == 33);
   REQUIRE(sizeof(hid_report::apple_vendor_top_case_input) == 33);
   REQUIRE(sizeof(hid_report::consumer_input) == 33);
+  REQUIRE(sizeof(hid_report::keyboard_bitmap_input) == 34);
   REQUIRE(sizeof(hid_report::keyboard_input) == 35);
+  REQUIRE(sizeof(hid_report::pointing_high_resolution_input) == 10);
   REQUIRE(sizeof(hid_report::pointing_input) == 8);
+  REQUIRE(sizeof(hid_report::wheel_resolution_multiplier_feature) == 1);
 }
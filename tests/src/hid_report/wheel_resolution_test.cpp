@@ -0,0 +1,111 @@
+#include <catch2/catch.hpp>
+
+#include <pqrs/karabiner/driverkit/virtual_hid_device_driver.hpp>
+
+TEST_CASE("wheel_resolution_multiplier_feature") {
+  using namespace pqrs::karabiner::driverkit::virtual_hid_device_driver;
+
+  REQUIRE(hid_report::wheel_resolution_multiplier_feature().vertical_multiplier() == 1);
+  REQUIRE(hid_report::wheel_resolution_multiplier_feature().horizontal_multiplier() == 1);
+
+  REQUIRE(hid_report::wheel_resolution_multiplier_feature(0b0001).vertical_multiplier() == 4);
+  REQUIRE(hid_report::wheel_resolution_multiplier_feature(0b0001).horizontal_multiplier() == 1);
+
+  REQUIRE(hid_report::wheel_resolution_multiplier_feature(0b0100).vertical_multiplier() == 1);
+  REQUIRE(hid_report::wheel_resolution_multiplier_feature(0b0100).horizontal_multiplier() == 4);
+}
+
+TEST_CASE("wheel_resolution") {
+  using namespace pqrs::karabiner::driverkit::virtual_hid_device_driver;
+
+  constexpr int16_t unit = hid_report::pointing_high_resolution_input::wheel_unit;
+
+  //
+  // pointing_input
+  //
+
+  {
+    hid_report::wheel_resolution wheel_resolution;
+
+    hid_report::pointing_input report;
+    report.buttons.insert(1);
+    report.x = 10;
+    report.y = static_cast<uint8_t>(-10);
+    report.vertical_wheel = 1;
+    report.horizontal_wheel = static_cast<uint8_t>(-2);
+
+    auto actual = wheel_resolution.convert(report);
+    REQUIRE(actual.buttons == report.buttons);
+    REQUIRE(actual.x == 10);
+    REQUIRE(actual.y == static_cast<uint8_t>(-10));
+    REQUIRE(actual.vertical_wheel == 1);
+    REQUIRE(actual.horizontal_wheel == -2);
+
+    wheel_resolution.set_feature(hid_report::wheel_resolution_multiplier_feature(0b0101));
+
+    actual = wheel_resolution.convert(report);
+    REQUIRE(actual.vertical_wheel == 4);
+    REQUIRE(actual.horizontal_wheel == -8);
+  }
+
+  //
+  // pointing_high_resolution_input
+  //
+
+  {
+    hid_report::wheel_resolution wheel_resolution;
+    wheel_resolution.set_feature(hid_report::wheel_resolution_multiplier_feature(0b0001));
+
+    hid_report::pointing_high_resolution_input report;
+    report.x = 1;
+    report.vertical_wheel = unit * 3;
+    report.horizontal_wheel = -unit * 3;
+
+    auto actual = wheel_resolution.convert(report);
+    REQUIRE(actual.x == 1);
+    REQUIRE(actual.vertical_wheel == 12);
+    REQUIRE(actual.horizontal_wheel == -3);
+  }
+
+  {
+    // The fraction is carried to the next report.
+
+    hid_report::wheel_resolution wheel_resolution;
+    wheel_resolution.set_feature(hid_report::wheel_resolution_multiplier_feature(0b0001));
+
+    hid_report::pointing_high_resolution_input report;
+    report.vertical_wheel = unit / 8;
+    report.horizontal_wheel = -unit / 8;
+
+    int vertical = 0;
+    int horizontal = 0;
+    for (int i = 0; i < 8; ++i) {
+      auto actual = wheel_resolution.convert(report);
+      vertical += actual.vertical_wheel;
+      horizontal += actual.horizontal_wheel;
+    }
+    REQUIRE(vertical == 4);
+    REQUIRE(horizontal == -1);
+
+    // set_feature resets the fraction.
+
+    wheel_resolution.convert(report);
+    wheel_resolution.set_feature(hid_report::wheel_resolution_multiplier_feature(0b0001));
+    REQUIRE(wheel_resolution.convert(report).vertical_wheel == 0);
+  }
+
+  {
+    // Large values
+
+    hid_report::wheel_resolution wheel_resolution;
+    wheel_resolution.set_feature(hid_report::wheel_resolution_multiplier_feature(0b0101));
+
+    hid_report::pointing_high_resolution_input report;
+    report.vertical_wheel = 32767;
+    report.horizontal_wheel = -32767;
+
+    auto actual = wheel_resolution.convert(report);
+    REQUIRE(actual.vertical_wheel == 1092);
+    REQUIRE(actual.horizontal_wheel == -1092);
+  }
+}
@@ -0,0 +1,168 @@
+#include <catch2/catch.hpp>
+
+#include <atomic>
+#include <fstream>
+#include <pqrs/karabiner/driverkit/virtual_hid_device_service/metrics.hpp>
+#include <thread>
+
+namespace {
+using namespace pqrs::karabiner::driverkit::virtual_hid_device_service;
+
+const std::filesystem::path file_path("tmp/metrics.bin");
+} // namespace
+
+TEST_CASE("seqlock") {
+  metrics::seqlock<metrics::forwarding_metrics> s;
+
+  auto v = s.load();
+  REQUIRE(v);
+  REQUIRE(v->forwarded_reports == 0);
+  REQUIRE(v->max_queue_depth == 0);
+
+  metrics::forwarding_metrics m{};
+  m.forwarded_reports = 10;
+  m.backend_errors = 2;
+  m.queue_depth = 3;
+  m.max_queue_depth = 4;
+  m.last_backend_call_latency_nanoseconds = 5000;
+  s.store(m);
+
+  v = s.load();
+  REQUIRE(v);
+  REQUIRE(v->forwarded_reports == 10);
+  REQUIRE(v->backend_errors == 2);
+  REQUIRE(v->queue_depth == 3);
+  REQUIRE(v->max_queue_depth == 4);
+  REQUIRE(v->last_backend_call_latency_nanoseconds == 5000);
+}
+
+TEST_CASE("seqlock threads") {
+  // The reader never observes a partially written value.
+  // The writer stores values whose fields are all the same.
+
+  metrics::seqlock<metrics::server_metrics> s;
+  std::atomic<bool> exit(false);
+  std::atomic<bool> consistent(true);
+  std::atomic<uint64_t> read_count(0);
+
+  std::thread reader([&] {
+    uint64_t previous = 0;
+    while (!exit) {
+      if (auto v = s.load()) {
+        auto n = v->parse_errors;
+        for (const auto& c : v->received_requests) {
+          if (c != n) {
+            consistent = false;
+          }
+        }
+        if (v->connected_clients != n || n < previous) {
+          consistent = false;
+        }
+        previous = n;
+        ++read_count;
+      }
+    }
+  });
+
+  metrics::server_metrics m{};
+  for (uint64_t i = 1; i <= 200000; ++i) {
+    m.received_requests.fill(i);
+    m.parse_errors = i;
+    m.connected_clients = i;
+    s.store(m);
+  }
+
+  exit = true;
+  reader.join();
+
+  REQUIRE(consistent);
+  REQUIRE(read_count > 0);
+  REQUIRE(s.load()->parse_errors == 200000);
+}
+
+TEST_CASE("writer and reader") {
+  std::filesystem::create_directories(file_path.parent_path());
+
+  metrics::writer w;
+  REQUIRE(!w.is_open());
+
+  // `get_page` returns an in-process page before `open`.
+  w.get_page().server.store(metrics::server_metrics{});
+
+  REQUIRE(!w.open(file_path));
+  REQUIRE(w.is_open());
+
+  // Readable by non-owner tools, writable only by the owner.
+  {
+    auto perms = std::filesystem::status(file_path).permissions();
+    REQUIRE((perms & std::filesystem::perms::others_read) != std::filesystem::perms::none);
+    REQUIRE((perms & std::filesystem::perms::group_write) == std::filesystem::perms::none);
+    REQUIRE((perms & std::filesystem::perms::others_write) == std::filesystem::perms::none);
+  }
+
+  {
+    metrics::server_metrics m{};
+    m.received_requests[11] = 100;
+    m.parse_errors = 1;
+    m.connected_clients = 2;
+    m.device_ready.fill(-1);
+    m.device_ready[static_cast<size_t>(metrics::device::virtual_hid_pointing)] = 1;
+    w.get_page().server.store(m);
+
+    metrics::report_queue_metrics r{};
+    r.queued_reports = 100;
+    r.dropped_reports = 3;
+    w.get_page().get_device_metrics(metrics::device::virtual_hid_keyboard).report_queue.store(r);
+
+    metrics::forwarding_metrics f{};
+    f.forwarded_reports = 97;
+    w.get_page().get_device_metrics(metrics::device::virtual_hid_keyboard).forwarding.store(f);
+  }
+
+  {
+    metrics::reader r;
+    REQUIRE(!r.open(file_path));
+
+    auto& page = r.get_page();
+    REQUIRE(page.pid == static_cast<uint64_t>(getpid()));
+
+    auto server = page.server.load();
+    REQUIRE(server);
+    REQUIRE(server->received_requests[11] == 100);
+    REQUIRE(server->parse_errors == 1);
+    REQUIRE(server->connected_clients == 2);
+    REQUIRE(server->device_ready[static_cast<size_t>(metrics::device::virtual_hid_keyboard)] == -1);
+    REQUIRE(server->device_ready[static_cast<size_t>(metrics::device::virtual_hid_pointing)] == 1);
+
+    auto& keyboard = page.get_device_metrics(metrics::device::virtual_hid_keyboard);
+    REQUIRE(keyboard.report_queue.load()->queued_reports == 100);
+    REQUIRE(keyboard.report_queue.load()->dropped_reports == 3);
+    REQUIRE(keyboard.forwarding.load()->forwarded_reports == 97);
+
+    auto& pointing = page.get_device_metrics(metrics::device::virtual_hid_pointing);
+    REQUIRE(pointing.report_queue.load()->queued_reports == 0);
+
+    // The reader sees values which are written after `open`.
+    metrics::forwarding_metrics f{};
+    f.forwarded_reports = 100;
+    w.get_page().get_device_metrics(metrics::device::virtual_hid_keyboard).forwarding.store(f);
+    REQUIRE(keyboard.forwarding.load()->forwarded_reports == 100);
+  }
+
+  w.close();
+  REQUIRE(!w.is_open());
+
+  // Broken files
+
+  {
+    std::ofstream(file_path, std::ios::binary | std::ios::trunc) << "KVHDMTRC";
+
+    metrics::reader r;
+    REQUIRE(r.open(file_path) == std::errc::invalid_argument);
+  }
+
+  {
+    metrics::reader r;
+    REQUIRE(r.open("tmp/not_found.bin") == std::errc::no_such_file_or_directory);
+  }
+}
@@ -0,0 +1,99 @@
+#include <catch2/catch.hpp>
+
+#include <pqrs/karabiner/driverkit/virtual_hid_device_service/pointing_motion.hpp>
+
+namespace {
+struct totals final {
+  int64_t x = 0;
+  int64_t y = 0;
+  int64_t vertical_wheel = 0;
+  int64_t horizontal_wheel = 0;
+  uint32_t reports = 0;
+};
+
+totals run(const pqrs::karabiner::driverkit::virtual_hid_device_service::pointing_motion& motion) {
+  pqrs::karabiner::driverkit::virtual_hid_device_service::motion_synthesizer synthesizer(motion);
+  totals t;
+  while (!synthesizer.finished()) {
+    auto report = synthesizer.next();
+    t.x += static_cast<int8_t>(report.x);
+    t.y += static_cast<int8_t>(report.y);
+    t.vertical_wheel += report.vertical_wheel;
+    t.horizontal_wheel += report.horizontal_wheel;
+    ++t.reports;
+    REQUIRE(t.reports < 10000);
+  }
+  return t;
+}
+} // namespace
+
+TEST_CASE("motion_synthesizer") {
+  using namespace pqrs::karabiner::driverkit::virtual_hid_device_service;
+
+  for (auto easing : {motion_easing::linear,
+                      motion_easing::ease_in,
+                      motion_easing::ease_out,
+                      motion_easing::ease_in_out}) {
+    pointing_motion motion;
+    motion.x = 300;
+    motion.y = -123;
+    motion.vertical_wheel = -1234;
+    motion.horizontal_wheel = 77;
+    motion.duration_milliseconds = 200;
+    motion.interval_milliseconds = 8;
+    motion.easing = easing;
+
+    REQUIRE(motion_synthesizer(motion).get_steps() == 25);
+
+    auto t = run(motion);
+    REQUIRE(t.x == 300);
+    REQUIRE(t.y == -123);
+    REQUIRE(t.vertical_wheel == -1234);
+    REQUIRE(t.horizontal_wheel == 77);
+    REQUIRE(t.reports == 25);
+  }
+
+  // Overflow of the int8 range
+  {
+    pointing_motion motion;
+    motion.x = 1000;
+    motion.y = -1000;
+    motion.duration_milliseconds = 16;
+    motion.interval_milliseconds = 8;
+
+    auto t = run(motion);
+    REQUIRE(t.x == 1000);
+    REQUIRE(t.y == -1000);
+    REQUIRE(t.reports == 8);
+  }
+
+  // Zero duration and zero interval
+  {
+    pointing_motion motion;
+    motion.x = 10;
+    motion.duration_milliseconds = 0;
+    motion.interval_milliseconds = 0;
+
+    motion_synthesizer synthesizer(motion);
+    REQUIRE(synthesizer.get_interval_milliseconds() == 1);
+    REQUIRE(synthesizer.get_steps() == 1);
+
+    auto t = run(motion);
+    REQUIRE(t.x == 10);
+    REQUIRE(t.reports == 1);
+  }
+
+  // Buttons
+  {
+    pointing_motion motion;
+    motion.buttons.insert(1);
+    motion.duration_milliseconds = 24;
+
+    motion_synthesizer synthesizer(motion);
+    REQUIRE(synthesizer.next().buttons == motion.buttons);
+    REQUIRE(!synthesizer.finished());
+    synthesizer.next();
+    synthesizer.next();
+    REQUIRE(synthesizer.finished());
+  }
+}
@@ -0,0 +1,143 @@
+#include <catch2/catch.hpp>
+
+#include "rate_limited_logger.hpp"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <spdlog/sinks/null_sink.h>
+#include <spdlog/sinks/ostream_sink.h>
+#include <sstream>
+#include <thread>
+
+namespace {
+std::vector<std::string> split_lines(const std::string& s) {
+  std::vector<std::string> result;
+  std::istringstream stream(s);
+  std::string line;
+  while (std::getline(stream, line)) {
+    result.push_back(line);
+  }
+  return result;
+}
+} // namespace
+
+TEST_CASE("rate_limited_logger") {
+  pqrs::dispatcher::extra::initialize_shared_dispatcher();
+
+  {
+    std::ostringstream stream;
+    auto sink = std::make_shared<spdlog::sinks::ostream_sink_mt>(stream);
+    auto l = std::make_shared<spdlog::logger>("test", sink);
+    l->set_pattern("[%l] %v");
+
+    {
+      rate_limited_logger logger(l, std::chrono::milliseconds(100));
+
+      // The first occurrence of each call site is logged.
+      for (int i = 0; i < 10; ++i) {
+        logger.error("error {0}: {1}", i, "report queue is full");
+      }
+      for (int i = 0; i < 3; ++i) {
+        logger.warn("warn {0}", i);
+      }
+
+      // The same format string from another call site.
+      logger.warn("warn {0}", 100);
+
+      REQUIRE(split_lines(stream.str()) == std::vector<std::string>{
+                                               "[error] error 0: report queue is full",
+                                               "[warning] warn 0",
+                                               "[warning] warn 100",
+                                           });
+
+      // Summaries are emitted after the interval.
+      std::this_thread::sleep_for(std::chrono::milliseconds(150));
+      logger.flush();
+
+      auto lines = split_lines(stream.str());
+      REQUIRE(lines.size() == 5);
+      std::sort(std::begin(lines) + 3, std::end(lines));
+      REQUIRE(lines[3] == "[error] 9 similar messages suppressed: error 0: report queue is full");
+      REQUIRE(lines[4] == "[warning] 2 similar messages suppressed: warn 0");
+
+      // The interval is restarted.
+      logger.error("error {0}: {1}", 10, "report queue is full");
+      REQUIRE(split_lines(stream.str()).back() == "[error] error 10: report queue is full");
+    }
+  }
+
+  {
+    // Overflow
+
+    std::ostringstream stream;
+    auto sink = std::make_shared<spdlog::sinks::ostream_sink_mt>(stream);
+    auto l = std::make_shared<spdlog::logger>("test", sink);
+    l->set_pattern("[%l] %v");
+
+    {
+      rate_limited_logger logger(l, std::chrono::milliseconds(100), 1);
+
+      logger.error("error 1");
+      logger.error("error 2");
+      logger.error("error 3");
+
+      std::this_thread::sleep_for(std::chrono::milliseconds(150));
+      logger.flush();
+
+      REQUIRE(split_lines(stream.str()) == std::vector<std::string>{
+                                               "[error] error 1",
+                                               "[warning] 2 messages suppressed",
+                                           });
+    }
+  }
+
+  pqrs::dispatcher::extra::terminate_shared_dispatcher();
+}
+
+TEST_CASE("rate_limited_logger error storm", "[.benchmark]") {
+  // 10 messages per millisecond (10,000 messages per second) are logged from a call site for a second.
+  //
+  // eager: Messages are formatted before `rate_limited_logger` (the caller calls `fmt::format`).
+  // lazy: Arguments are passed to `rate_limited_logger` and only the first occurrence is formatted.
+
+  pqrs::dispatcher::extra::initialize_shared_dispatcher();
+
+  using clock = std::chrono::steady_clock;
+
+  auto run = [](bool lazy) {
+    auto l = std::make_shared<spdlog::logger>("benchmark", std::make_shared<spdlog::sinks::null_sink_mt>());
+    rate_limited_logger logger(l);
+
+    clock::duration elapsed(0);
+    size_t count = 0;
+
+    auto start = clock::now();
+    for (int ms = 0; ms < 1000; ++ms) {
+      std::this_thread::sleep_until(start + std::chrono::milliseconds(ms));
+
+      auto s = clock::now();
+      for (int i = 0; i < 10; ++i) {
+        if (lazy) {
+          logger.error("{0} error: {1} (sequence: {2})", "virtual_hid_keyboard", "report queue is full", ms * 10 + i);
+        } else {
+          logger.error("{0}", fmt::format("{0} error: {1} (sequence: {2})", "virtual_hid_keyboard", "report queue is full", ms * 10 + i));
+        }
+        ++count;
+      }
+      elapsed += clock::now() - s;
+    }
+
+    auto ns = std::chrono::duration<double, std::nano>(elapsed).count() / count;
+    std::cout << (lazy ? "lazy " : "eager")
+              << " " << count << " messages, " << ns << " ns/message" << std::endl;
+
+    return ns;
+  };
+
+  auto eager_ns = run(false);
+  auto lazy_ns = run(true);
+
+  REQUIRE(lazy_ns < eager_ns);
+
+  pqrs::dispatcher::extra::terminate_shared_dispatcher();
+}
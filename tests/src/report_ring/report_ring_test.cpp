@@ -0,0 +1,328 @@
+#include <catch2/catch.hpp>
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <pqrs/karabiner/driverkit/virtual_hid_device_driver/report_ring.hpp>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+using namespace pqrs::karabiner::driverkit::virtual_hid_device_driver;
+
+// The ring in memory which is shared with child processes.
+class shared_ring final {
+public:
+  shared_ring(void) {
+    address_ = mmap(nullptr, sizeof(report_ring::layout), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    REQUIRE(address_ != MAP_FAILED);
+    layout_ = report_ring::layout::initialize(address_);
+  }
+
+  ~shared_ring(void) {
+    layout_->~layout();
+    munmap(address_, sizeof(report_ring::layout));
+  }
+
+  void* get_address(void) const {
+    return address_;
+  }
+
+  report_ring::layout* get_layout(void) const {
+    return layout_;
+  }
+
+private:
+  void* address_;
+  report_ring::layout* layout_;
+};
+
+// The consumer process which drains the ring on each doorbell, and replies when the drain is finished.
+// Reports must have sequential `uint64_t` values from 1.
+class consumer_process final {
+public:
+  consumer_process(report_ring::layout* layout) {
+    REQUIRE(pipe(doorbell_pipe_) == 0);
+    REQUIRE(pipe(reply_pipe_) == 0);
+
+    pid_ = fork();
+    REQUIRE(pid_ >= 0);
+
+    if (pid_ == 0) {
+      ::close(doorbell_pipe_[1]);
+      ::close(reply_pipe_[0]);
+
+      report_ring::consumer c;
+      c.attach(layout);
+
+      uint64_t expected = 1;
+      bool error = false;
+
+      uint8_t b;
+      while (read(doorbell_pipe_[0], &b, 1) == 1) {
+        c.drain([&](auto&& method, auto&& data, auto&& size) {
+          uint64_t value;
+          if (size != sizeof(value)) {
+            error = true;
+            return false;
+          }
+          memcpy(&value, data, sizeof(value));
+          if (value != expected) {
+            error = true;
+          }
+          ++expected;
+          return true;
+        });
+
+        if (write(reply_pipe_[1], &b, 1) != 1) {
+          break;
+        }
+      }
+
+      _exit(error ? 1 : 0);
+    }
+
+    ::close(doorbell_pipe_[0]);
+    ::close(reply_pipe_[1]);
+  }
+
+  // Returns the exit status of the consumer process.
+  int wait(void) {
+    ::close(doorbell_pipe_[1]);
+    ::close(reply_pipe_[0]);
+
+    int status = 0;
+    waitpid(pid_, &status, 0);
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+  }
+
+  // A synchronous doorbell.
+  bool ring(void) {
+    uint8_t b = 0;
+    return write(doorbell_pipe_[1], &b, 1) == 1 &&
+           read(reply_pipe_[0], &b, 1) == 1;
+  }
+
+private:
+  pid_t pid_;
+  int doorbell_pipe_[2];
+  int reply_pipe_[2];
+};
+} // namespace
+
+TEST_CASE("report_ring") {
+  auto storage = std::make_unique<report_ring::layout>();
+  auto l = report_ring::layout::initialize(storage.get());
+
+  REQUIRE(report_ring::layout::validate(storage.get(), sizeof(report_ring::layout)) == l);
+  REQUIRE(report_ring::layout::validate(storage.get(), sizeof(report_ring::layout) - 1) == nullptr);
+  REQUIRE(report_ring::layout::validate(nullptr, sizeof(report_ring::layout)) == nullptr);
+
+  report_ring::producer p;
+  p.attach(l);
+
+  report_ring::consumer c{};
+  REQUIRE(!c.is_attached());
+  c.attach(l);
+
+  std::vector<std::pair<uint32_t, std::vector<uint8_t>>> consumed;
+  auto function = [&](auto&& method, auto&& data, auto&& size) {
+    consumed.emplace_back(method, std::vector<uint8_t>(data, data + size));
+    return method != 99;
+  };
+
+  // Reports are not visible before `publish`.
+
+  uint8_t report[] = {1, 2, 3};
+  REQUIRE(p.push(2, report, sizeof(report)) == report_ring::push_result::pushed);
+  REQUIRE(p.push(3, nullptr, 0) == report_ring::push_result::pushed);
+  REQUIRE(c.drain(function) == 0);
+
+  // The doorbell is required once until the consumer drains.
+
+  REQUIRE(p.publish());
+  REQUIRE(!p.publish());
+
+  REQUIRE(c.drain(function) == 2);
+  REQUIRE(consumed.size() == 2);
+  REQUIRE(consumed[0].first == 2);
+  REQUIRE(consumed[0].second == std::vector<uint8_t>({1, 2, 3}));
+  REQUIRE(consumed[1].first == 3);
+  REQUIRE(consumed[1].second.empty());
+  REQUIRE(l->consumed_reports == 2);
+  REQUIRE(l->failed_reports == 0);
+
+  REQUIRE(p.publish());
+
+  // Invalid size
+
+  uint8_t large_report[report_ring::max_report_size + 1] = {};
+  REQUIRE(p.push(2, large_report, sizeof(large_report)) == report_ring::push_result::invalid_size);
+
+  // Full
+
+  for (uint32_t i = 0; i < report_ring::capacity; ++i) {
+    REQUIRE(p.push(2, report, sizeof(report)) == report_ring::push_result::pushed);
+  }
+  REQUIRE(p.push(2, report, sizeof(report)) == report_ring::push_result::full);
+
+  p.publish();
+  REQUIRE(c.drain(function) == report_ring::capacity);
+  REQUIRE(p.push(2, report, sizeof(report)) == report_ring::push_result::pushed);
+
+  // Failed reports
+
+  REQUIRE(p.push(99, report, sizeof(report)) == report_ring::push_result::pushed);
+  p.publish();
+  REQUIRE(c.drain(function) == 2);
+  REQUIRE(l->failed_reports == 1);
+}
+
+TEST_CASE("report_ring overflow policy") {
+  auto storage = std::make_unique<report_ring::layout>();
+  auto l = report_ring::layout::initialize(storage.get());
+
+  report_ring::producer p;
+  p.attach(l);
+
+  report_ring::consumer c{};
+  c.attach(l);
+
+  size_t consumed = 0;
+  int doorbell_count = 0;
+  bool doorbell_result = true;
+  auto doorbell = [&] {
+    ++doorbell_count;
+    if (doorbell_result) {
+      consumed += c.drain([](auto&&, auto&&, auto&&) { return true; });
+    }
+    return doorbell_result;
+  };
+
+  // The doorbell drains the full ring.
+
+  uint8_t report[] = {1};
+  for (uint32_t i = 0; i < report_ring::capacity * 2; ++i) {
+    REQUIRE(p.push(2, report, sizeof(report), doorbell) == report_ring::push_result::pushed);
+  }
+  REQUIRE(doorbell_count == 1);
+
+  REQUIRE(p.flush(doorbell));
+  REQUIRE(doorbell_count == 2);
+  REQUIRE(consumed == report_ring::capacity * 2);
+  REQUIRE(l->dropped_reports == 0);
+
+  // The report is dropped if the doorbell is failed.
+
+  doorbell_result = false;
+  doorbell_count = 0;
+
+  for (uint32_t i = 0; i < report_ring::capacity; ++i) {
+    REQUIRE(p.push(2, report, sizeof(report), doorbell) == report_ring::push_result::pushed);
+  }
+  REQUIRE(p.push(2, report, sizeof(report), doorbell) == report_ring::push_result::full);
+  REQUIRE(doorbell_count == 1);
+  REQUIRE(l->dropped_reports == 1);
+
+  // The doorbell is rung again after the failure.
+
+  doorbell_result = true;
+  REQUIRE(p.flush(doorbell));
+  REQUIRE(doorbell_count == 2);
+  REQUIRE(consumed == report_ring::capacity * 3);
+}
+
+TEST_CASE("report_ring invalid tail") {
+  auto storage = std::make_unique<report_ring::layout>();
+  auto l = report_ring::layout::initialize(storage.get());
+
+  report_ring::consumer c{};
+  c.attach(l);
+
+  l->tail = report_ring::capacity + 1;
+
+  size_t called = 0;
+  REQUIRE(c.drain([&](auto&&, auto&&, auto&&) {
+    ++called;
+    return true;
+  }) == 0);
+  REQUIRE(called == 0);
+  REQUIRE(l->head == report_ring::capacity + 1);
+  REQUIRE(l->failed_reports == 1);
+
+  // Entries with an invalid size are skipped.
+
+  l->entries[l->tail & (report_ring::capacity - 1)].size = report_ring::max_report_size + 1;
+  l->tail = l->tail + 1;
+
+  REQUIRE(c.drain([&](auto&&, auto&&, auto&&) {
+    ++called;
+    return true;
+  }) == 1);
+  REQUIRE(called == 0);
+  REQUIRE(l->failed_reports == 2);
+}
+
+TEST_CASE("report_ring two processes") {
+  constexpr uint64_t count = 100000;
+
+  shared_ring r;
+  consumer_process consumer(r.get_layout());
+
+  report_ring::producer p;
+  p.attach(report_ring::layout::validate(r.get_address(), sizeof(report_ring::layout)));
+  REQUIRE(p.is_attached());
+
+  auto doorbell = [&consumer] {
+    return consumer.ring();
+  };
+
+  for (uint64_t i = 1; i <= count; ++i) {
+    REQUIRE(p.push(2, &i, sizeof(i), doorbell) == report_ring::push_result::pushed);
+    if (i % 100 == 0) {
+      REQUIRE(p.flush(doorbell));
+    }
+  }
+  REQUIRE(p.flush(doorbell));
+
+  REQUIRE(consumer.wait() == 0);
+  REQUIRE(r.get_layout()->consumed_reports == count);
+  REQUIRE(r.get_layout()->dropped_reports == 0);
+  REQUIRE(r.get_layout()->failed_reports == 0);
+}
+
+TEST_CASE("report_ring benchmark", "[.benchmark]") {
+  constexpr uint64_t count = 200000;
+
+  for (uint64_t batch : {1, 8, 64}) {
+    shared_ring r;
+    consumer_process consumer(r.get_layout());
+
+    report_ring::producer p;
+    p.attach(r.get_layout());
+
+    auto doorbell = [&consumer] {
+      return consumer.ring();
+    };
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (uint64_t i = 1; i <= count; ++i) {
+      p.push(2, &i, sizeof(i), doorbell);
+      if (i % batch == 0) {
+        p.flush(doorbell);
+      }
+    }
+    p.flush(doorbell);
+
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    REQUIRE(consumer.wait() == 0);
+    REQUIRE(r.get_layout()->consumed_reports == count);
+
+    std::cout << "batch " << batch << ": "
+              << std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() / count << " ns/report" << std::endl;
+  }
+}
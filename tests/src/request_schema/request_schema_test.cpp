@@ -0,0 +1,254 @@
+#include <catch2/catch.hpp>
+
+#include <pqrs/karabiner/driverkit/virtual_hid_device_service/request_schema.hpp>
+
+namespace {
+using namespace pqrs::karabiner::driverkit::virtual_hid_device_service;
+
+struct recorder final {
+  template <request R>
+  void operator()(std::integral_constant<request, R>, const request_schema::payload_t<R>& payload) {
+    requests.push_back(R);
+
+    if constexpr (request_schema::has_payload<R>) {
+      payloads.emplace_back(reinterpret_cast<const uint8_t*>(&payload),
+                            reinterpret_cast<const uint8_t*>(&payload) + sizeof(payload));
+    } else if constexpr (request_schema::is_sequenced<R>) {
+      // The wrapped message
+      payloads.emplace_back(payload.message, payload.message + payload.message_size);
+      sequences.push_back(payload.sequence);
+    } else if constexpr (request_schema::is_correlated<R>) {
+      // The wrapped message
+      payloads.emplace_back(payload.message, payload.message + payload.message_size);
+      correlation_ids.push_back(payload.correlation_id);
+    } else if constexpr (request_schema::is_text<R>) {
+      payloads.emplace_back(payload.text, payload.text + payload.text_size);
+    } else {
+      payloads.emplace_back();
+    }
+  }
+
+  std::vector<request> requests;
+  std::vector<std::vector<uint8_t>> payloads;
+  std::vector<uint64_t> sequences;
+  std::vector<uint64_t> correlation_ids;
+};
+} // namespace
+
+TEST_CASE("payload_size") {
+  using namespace pqrs::karabiner::driverkit;
+
+  REQUIRE(virtual_hid_device_service::request_schema::payload_size<virtual_hid_device_service::request::none> == 0);
+  REQUIRE(virtual_hid_device_service::request_schema::payload_size<virtual_hid_device_service::request::driver_loaded> == 0);
+  REQUIRE(virtual_hid_device_service::request_schema::payload_size<virtual_hid_device_service::request::virtual_hid_keyboard_initialize> == 8);
+  REQUIRE(virtual_hid_device_service::request_schema::payload_size<virtual_hid_device_service::request::post_keyboard_input_report> == sizeof(virtual_hid_device_driver::hid_report::keyboard_input));
+  REQUIRE(virtual_hid_device_service::request_schema::payload_size<virtual_hid_device_service::request::post_pointing_input_report> == sizeof(virtual_hid_device_driver::hid_report::pointing_input));
+  REQUIRE(virtual_hid_device_service::request_schema::payload_size<virtual_hid_device_service::request::post_keyboard_bitmap_input_report> == sizeof(virtual_hid_device_driver::hid_report::keyboard_bitmap_input));
+  REQUIRE(virtual_hid_device_service::request_schema::payload_size<virtual_hid_device_service::request::post_pointing_high_resolution_input_report> == sizeof(virtual_hid_device_driver::hid_report::pointing_high_resolution_input));
+  REQUIRE(virtual_hid_device_service::request_schema::payload_size<virtual_hid_device_service::request::post_absolute_pointing_input_report> == sizeof(virtual_hid_device_driver::hid_report::absolute_pointing_input));
+  REQUIRE(virtual_hid_device_service::request_schema::payload_size<virtual_hid_device_service::request::post_pointing_motion> == sizeof(virtual_hid_device_service::pointing_motion));
+  REQUIRE(virtual_hid_device_service::request_schema::payload_size<virtual_hid_device_service::request::cancel_pointing_motion> == 0);
+  REQUIRE(virtual_hid_device_service::request_schema::payload_size<virtual_hid_device_service::request::sequenced_request> == 0);
+  REQUIRE(virtual_hid_device_service::request_schema::payload_size<virtual_hid_device_service::request::correlated_request> == 0);
+  REQUIRE(virtual_hid_device_service::request_schema::payload_size<virtual_hid_device_service::request::post_text> == 0);
+  REQUIRE(virtual_hid_device_service::request_schema::message_size<virtual_hid_device_service::request::post_pointing_input_report> == 9);
+}
+
+TEST_CASE("encode") {
+  {
+    auto actual = request_schema::encode<request::driver_loaded>();
+    REQUIRE(actual == std::vector<uint8_t>{static_cast<uint8_t>(request::driver_loaded)});
+  }
+  {
+    auto actual = request_schema::encode<request::virtual_hid_keyboard_initialize>(0x0102030405060708);
+    REQUIRE(actual == std::vector<uint8_t>{
+                          static_cast<uint8_t>(request::virtual_hid_keyboard_initialize),
+                          0x08, 0x07, 0x06, 0x05, 0x04, 0x03, 0x02, 0x01,
+                      });
+  }
+  {
+    pqrs::karabiner::driverkit::virtual_hid_device_driver::hid_report::pointing_input report;
+    report.buttons.insert(1);
+    report.x = 0xff;
+    auto actual = request_schema::encode<request::post_pointing_input_report>(report);
+    REQUIRE(actual == std::vector<uint8_t>{
+                          static_cast<uint8_t>(request::post_pointing_input_report),
+                          0x01, 0x00, 0x00, 0x00, 0xff, 0x00, 0x00, 0x00,
+                      });
+  }
+}
+
+TEST_CASE("decode") {
+  recorder r;
+
+  // Round trip
+
+  {
+    pqrs::karabiner::driverkit::virtual_hid_device_driver::hid_report::keyboard_input report;
+    report.keys.insert(4);
+
+    auto buffer = request_schema::encode<request::post_keyboard_input_report>(report);
+    REQUIRE(request_schema::decode(buffer.data(), buffer.size(), r) == request_schema::decode_result::ok);
+    REQUIRE(r.requests.back() == request::post_keyboard_input_report);
+    REQUIRE(r.payloads.back() == std::vector<uint8_t>(std::begin(buffer) + 1, std::end(buffer)));
+  }
+  {
+    auto buffer = request_schema::encode<request::virtual_hid_pointing_reset>();
+    REQUIRE(request_schema::decode(buffer.data(), buffer.size(), r) == request_schema::decode_result::ok);
+    REQUIRE(r.requests.back() == request::virtual_hid_pointing_reset);
+    REQUIRE(r.payloads.back().empty());
+  }
+  {
+    auto buffer = request_schema::encode<request::request_trace_stop>();
+    REQUIRE(request_schema::decode(buffer.data(), buffer.size(), r) == request_schema::decode_result::ok);
+    REQUIRE(r.requests.back() == request::request_trace_stop);
+  }
+
+  // `request::none` ignores the payload.
+
+  {
+    std::vector<uint8_t> buffer{static_cast<uint8_t>(request::none), 'K', 'V', 'H', 'D'};
+    REQUIRE(request_schema::decode(buffer.data(), buffer.size(), r) == request_schema::decode_result::ok);
+    REQUIRE(r.requests.back() == request::none);
+  }
+
+  // Errors
+
+  auto count = r.requests.size();
+
+  {
+    REQUIRE(request_schema::decode(nullptr, 0, r) == request_schema::decode_result::empty);
+  }
+  {
+    std::vector<uint8_t> buffer{static_cast<uint8_t>(request_schema::request_count)};
+    REQUIRE(request_schema::decode(buffer.data(), buffer.size(), r) == request_schema::decode_result::unknown_request);
+  }
+  {
+    std::vector<uint8_t> buffer{static_cast<uint8_t>(request::virtual_hid_keyboard_initialize), 0};
+    REQUIRE(request_schema::decode(buffer.data(), buffer.size(), r) == request_schema::decode_result::size_mismatch);
+  }
+  {
+    std::vector<uint8_t> buffer{static_cast<uint8_t>(request::driver_loaded), 0};
+    REQUIRE(request_schema::decode(buffer.data(), buffer.size(), r) == request_schema::decode_result::size_mismatch);
+  }
+  {
+    auto buffer = request_schema::encode<request::post_pointing_input_report>({});
+    buffer.pop_back();
+    REQUIRE(request_schema::decode(buffer.data(), buffer.size(), r) == request_schema::decode_result::size_mismatch);
+  }
+
+  REQUIRE(r.requests.size() == count);
+}
+
+TEST_CASE("encode_sequenced") {
+  recorder r;
+
+  {
+    pqrs::karabiner::driverkit::virtual_hid_device_driver::hid_report::pointing_input report;
+    report.x = 0xff;
+
+    auto buffer = request_schema::encode_sequenced<request::post_pointing_input_report>(0x0102030405060708, report);
+    auto message = request_schema::encode<request::post_pointing_input_report>(report);
+    REQUIRE(buffer.size() == request_schema::sequenced_header_size + message.size());
+    REQUIRE(buffer[0] == static_cast<uint8_t>(request::sequenced_request));
+    REQUIRE(std::vector<uint8_t>(std::begin(buffer) + 1, std::begin(buffer) + 9) ==
+            std::vector<uint8_t>{0x08, 0x07, 0x06, 0x05, 0x04, 0x03, 0x02, 0x01});
+
+    REQUIRE(request_schema::decode(buffer.data(), buffer.size(), r) == request_schema::decode_result::ok);
+    REQUIRE(r.requests.back() == request::sequenced_request);
+    REQUIRE(r.sequences.back() == 0x0102030405060708);
+    REQUIRE(r.payloads.back() == message);
+  }
+  {
+    auto buffer = request_schema::encode_sequenced<request::virtual_hid_keyboard_reset>(1);
+    REQUIRE(request_schema::decode(buffer.data(), buffer.size(), r) == request_schema::decode_result::ok);
+    REQUIRE(r.sequences.back() == 1);
+    REQUIRE(r.payloads.back() == request_schema::encode<request::virtual_hid_keyboard_reset>());
+  }
+
+  // The wrapped message is required.
+
+  auto count = r.requests.size();
+
+  {
+    auto buffer = request_schema::encode_sequenced<request::virtual_hid_keyboard_reset>(1);
+    buffer.pop_back();
+    REQUIRE(request_schema::decode(buffer.data(), buffer.size(), r) == request_schema::decode_result::size_mismatch);
+  }
+
+  REQUIRE(r.requests.size() == count);
+}
+
+TEST_CASE("encode_correlated") {
+  recorder r;
+
+  {
+    auto buffer = request_schema::encode_correlated<request::virtual_hid_keyboard_ready>(0x0102030405060708);
+    REQUIRE(buffer == std::vector<uint8_t>{
+                          static_cast<uint8_t>(request::correlated_request),
+                          0x08, 0x07, 0x06, 0x05, 0x04, 0x03, 0x02, 0x01,
+                          static_cast<uint8_t>(request::virtual_hid_keyboard_ready),
+                      });
+
+    REQUIRE(request_schema::decode(buffer.data(), buffer.size(), r) == request_schema::decode_result::ok);
+    REQUIRE(r.requests.back() == request::correlated_request);
+    REQUIRE(r.correlation_ids.back() == 0x0102030405060708);
+    REQUIRE(r.payloads.back() == request_schema::encode<request::virtual_hid_keyboard_ready>());
+  }
+
+  // The wrapped message is required.
+
+  auto count = r.requests.size();
+
+  {
+    auto buffer = request_schema::encode_correlated<request::driver_loaded>(1);
+    buffer.pop_back();
+    REQUIRE(request_schema::decode(buffer.data(), buffer.size(), r) == request_schema::decode_result::size_mismatch);
+  }
+
+  REQUIRE(r.requests.size() == count);
+}
+
+TEST_CASE("encode_text") {
+  recorder r;
+
+  {
+    auto buffer = request_schema::encode_text<request::post_text>("a\xc3\xa4");
+    REQUIRE(buffer == std::vector<uint8_t>{
+                          static_cast<uint8_t>(request::post_text),
+                          'a', 0xc3, 0xa4,
+                      });
+
+    REQUIRE(request_schema::decode(buffer.data(), buffer.size(), r) == request_schema::decode_result::ok);
+    REQUIRE(r.requests.back() == request::post_text);
+    REQUIRE(r.payloads.back() == std::vector<uint8_t>{'a', 0xc3, 0xa4});
+  }
+  {
+    auto buffer = request_schema::encode_text<request::post_text>("");
+    REQUIRE(request_schema::decode(buffer.data(), buffer.size(), r) == request_schema::decode_result::ok);
+    REQUIRE(r.payloads.back().empty());
+  }
+
+  // The text fits a sequenced message.
+
+  {
+    auto message = request_schema::encode_text<request::post_text>(std::string(request_schema::max_text_size, 'a'));
+    auto buffer = request_schema::encode_sequenced_message(1, message);
+    REQUIRE(buffer.size() == constants::local_datagram_buffer_size);
+
+    REQUIRE(request_schema::decode(buffer.data(), buffer.size(), r) == request_schema::decode_result::ok);
+    REQUIRE(r.requests.back() == request::sequenced_request);
+    REQUIRE(r.payloads.back() == message);
+  }
+
+  // Too long
+
+  auto count = r.requests.size();
+
+  {
+    auto buffer = request_schema::encode_text<request::post_text>(std::string(request_schema::max_text_size + 1, 'a'));
+    REQUIRE(request_schema::decode(buffer.data(), buffer.size(), r) == request_schema::decode_result::size_mismatch);
+  }
+
+  REQUIRE(r.requests.size() == count);
+}
@@ -0,0 +1,87 @@
+#include <catch2/catch.hpp>
+
+#include <fstream>
+#include <pqrs/karabiner/driverkit/virtual_hid_device_service/request_trace.hpp>
+
+namespace {
+const std::filesystem::path file_path("tmp/request_trace.bin");
+} // namespace
+
+TEST_CASE("request_trace") {
+  using namespace pqrs::karabiner::driverkit::virtual_hid_device_service;
+
+  std::filesystem::create_directories(file_path.parent_path());
+
+  {
+    // Use a small chunk size in order to test remapping.
+    request_trace::writer w(64);
+    REQUIRE(!w.is_open());
+    REQUIRE(w.append(std::chrono::nanoseconds(0), "", nullptr, 0) == std::errc::bad_file_descriptor);
+
+    REQUIRE(!w.open(file_path));
+    REQUIRE(w.is_open());
+
+    for (int i = 0; i < 100; ++i) {
+      std::vector<uint8_t> buffer(i % 40, static_cast<uint8_t>(i));
+      REQUIRE(!w.append(std::chrono::nanoseconds(1000 + i),
+                        i % 3 == 0 ? "/tmp/client_a" : "/tmp/client_b",
+                        buffer.data(),
+                        buffer.size()));
+    }
+
+    REQUIRE(!w.append(std::chrono::nanoseconds(2000), "", nullptr, 0));
+
+    w.close();
+    REQUIRE(!w.is_open());
+  }
+
+  {
+    request_trace::reader r;
+    REQUIRE(!r.open(file_path));
+
+    auto& records = r.get_records();
+    REQUIRE(records.size() == 101);
+    REQUIRE(r.sender_count() == 3);
+
+    for (int i = 0; i < 100; ++i) {
+      auto& record = records[i];
+      REQUIRE(record.timestamp == std::chrono::nanoseconds(1000 + i));
+      REQUIRE(record.sender_id == (i % 3 == 0 ? 0 : 1));
+      REQUIRE(record.size == static_cast<size_t>(i % 40));
+      REQUIRE(std::all_of(record.data,
+                          record.data + record.size,
+                          [i](auto&& v) { return v == i; }));
+    }
+
+    REQUIRE(records[100].timestamp == std::chrono::nanoseconds(2000));
+    REQUIRE(records[100].sender_id == 2);
+    REQUIRE(records[100].size == 0);
+  }
+
+  // The preallocated space is removed by `close`.
+  {
+    size_t expected = sizeof(request_trace::file_header) + sizeof(request_trace::record_header) * 101;
+    for (int i = 0; i < 100; ++i) {
+      expected += i % 40;
+    }
+    REQUIRE(std::filesystem::file_size(file_path) == expected);
+  }
+
+  // Broken file
+  {
+    {
+      std::ofstream stream(file_path, std::ios::trunc);
+      stream << "broken";
+    }
+
+    request_trace::reader r;
+    REQUIRE(r.open(file_path) == std::errc::invalid_argument);
+    REQUIRE(r.get_records().empty());
+  }
+
+  // Missing file
+  {
+    request_trace::reader r;
+    REQUIRE(r.open("tmp/not_found.bin") == std::errc::no_such_file_or_directory);
+  }
+}
@@ -0,0 +1,81 @@
+#include <catch2/catch.hpp>
+
+#include <fstream>
+#include <pqrs/karabiner/driverkit/virtual_hid_device_service/session_state.hpp>
+
+namespace {
+const std::filesystem::path file_path("tmp/session_state.bin");
+} // namespace
+
+TEST_CASE("session_state") {
+  using namespace pqrs::karabiner::driverkit::virtual_hid_device_service;
+
+  std::filesystem::create_directories(file_path.parent_path());
+  std::filesystem::remove(file_path);
+
+  REQUIRE(session_state::load(file_path) == std::nullopt);
+
+  {
+    session_state::state s;
+    REQUIRE(!session_state::save(file_path, s));
+    REQUIRE(session_state::load(file_path) == s);
+  }
+
+  {
+    session_state::state s;
+    s.virtual_hid_keyboard_country_code = 0;
+    REQUIRE(!session_state::save(file_path, s));
+
+    auto actual = session_state::load(file_path);
+    REQUIRE(actual);
+    REQUIRE(actual->virtual_hid_keyboard_country_code == 0);
+    REQUIRE(actual->virtual_hid_pointing_initialized == false);
+    REQUIRE(actual->virtual_hid_absolute_pointing_initialized == false);
+  }
+
+  {
+    session_state::state s;
+    s.virtual_hid_keyboard_country_code = 33;
+    s.virtual_hid_pointing_initialized = true;
+    REQUIRE(!session_state::save(file_path, s));
+    REQUIRE(session_state::load(file_path) == s);
+
+    s.virtual_hid_absolute_pointing_initialized = true;
+    REQUIRE(session_state::load(file_path) != s);
+    REQUIRE(!session_state::save(file_path, s));
+    REQUIRE(session_state::load(file_path) == s);
+
+    // The temporary file is removed by rename.
+    REQUIRE(!std::filesystem::exists("tmp/session_state.bin.tmp"));
+    REQUIRE(std::filesystem::file_size(file_path) == sizeof(session_state::file_body));
+  }
+
+  // Broken files
+
+  {
+    std::ofstream(file_path, std::ios::trunc) << "KVHD";
+    REQUIRE(session_state::load(file_path) == std::nullopt);
+  }
+
+  {
+    session_state::state s;
+    s.virtual_hid_pointing_initialized = true;
+    REQUIRE(!session_state::save(file_path, s));
+
+    std::fstream f(file_path, std::ios::in | std::ios::out | std::ios::binary);
+    f.seekp(offsetof(session_state::file_body, version));
+    uint32_t v = session_state::version + 1;
+    f.write(reinterpret_cast<const char*>(&v), sizeof(v));
+    f.close();
+
+    REQUIRE(session_state::load(file_path) == std::nullopt);
+  }
+
+  // Save error
+
+  {
+    session_state::state s;
+    REQUIRE(session_state::save("tmp/not_found/session_state.bin", s));
+    REQUIRE(!std::filesystem::exists("tmp/not_found"));
+  }
+}
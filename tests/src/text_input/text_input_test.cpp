@@ -0,0 +1,217 @@
+#include <catch2/catch.hpp>
+
+#include <pqrs/karabiner/driverkit/virtual_hid_device_service/text_input.hpp>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+using namespace pqrs::karabiner::driverkit;
+using namespace pqrs::karabiner::driverkit::virtual_hid_device_service;
+
+// Lookups are available at compile time.
+static_assert(text_input::find_character(text_input::layout::us, U'A')->modifiers ==
+              static_cast<uint8_t>(virtual_hid_device_driver::hid_report::modifier::left_shift));
+static_assert(text_input::find_character(text_input::layout::us, U'ä') == nullptr);
+
+constexpr uint8_t shift = static_cast<uint8_t>(virtual_hid_device_driver::hid_report::modifier::left_shift);
+
+// (modifiers, usage)
+using report_t = std::pair<uint8_t, uint8_t>;
+
+std::vector<report_t> synthesize(text_input::text_synthesizer& s) {
+  std::vector<report_t> reports;
+  while (!s.finished()) {
+    auto report = s.next();
+    REQUIRE(report.keys.count() <= 1);
+    reports.emplace_back(report.modifiers.get_raw_value(), report.keys.get_raw_value()[0]);
+  }
+  return reports;
+}
+
+std::vector<std::pair<char32_t, size_t>> decode(std::string_view text) {
+  std::vector<std::pair<char32_t, size_t>> characters;
+  text_input::decode_utf8(text, [&](auto&& character, auto&& offset) {
+    characters.emplace_back(character, offset);
+  });
+  return characters;
+}
+} // namespace
+
+TEST_CASE("find_layout") {
+  REQUIRE(text_input::find_layout(pqrs::hid::country_code::not_supported) == text_input::layout::us);
+  REQUIRE(text_input::find_layout(pqrs::hid::country_code::us) == text_input::layout::us);
+  REQUIRE(text_input::find_layout(pqrs::hid::country_code::german) == text_input::layout::german);
+  REQUIRE(text_input::find_layout(pqrs::hid::country_code::japan) == text_input::layout::japanese);
+}
+
+TEST_CASE("find_character") {
+  for (const auto& [l, entries] : {
+           std::make_pair(text_input::layout::us, std::vector<text_input::character_entry>(std::begin(text_input::impl::us_entries), std::end(text_input::impl::us_entries))),
+           std::make_pair(text_input::layout::german, std::vector<text_input::character_entry>(std::begin(text_input::impl::german_entries), std::end(text_input::impl::german_entries))),
+           std::make_pair(text_input::layout::japanese, std::vector<text_input::character_entry>(std::begin(text_input::impl::japanese_entries), std::end(text_input::impl::japanese_entries))),
+       }) {
+    for (const auto& e : entries) {
+      auto actual = text_input::find_character(l, e.character);
+      REQUIRE(actual != nullptr);
+      REQUIRE(actual->usage == e.usage);
+      REQUIRE(actual->modifiers == e.modifiers);
+    }
+
+    // All printable ASCII characters are mapped except some symbols.
+    size_t count = 0;
+    for (char32_t c = 0x20; c < 0x7f; ++c) {
+      if (text_input::find_character(l, c)) {
+        ++count;
+      }
+    }
+    REQUIRE(count >= 88);
+  }
+
+  auto us_y = text_input::find_character(text_input::layout::us, U'y');
+  auto german_y = text_input::find_character(text_input::layout::german, U'y');
+  REQUIRE(us_y->usage == 0x1c);
+  REQUIRE(german_y->usage == 0x1d);
+
+  REQUIRE(text_input::find_character(text_input::layout::us, U'0')->usage == 0x27);
+  REQUIRE(text_input::find_character(text_input::layout::us, U'\n')->usage == 0x28);
+  REQUIRE(text_input::find_character(text_input::layout::german, U'ß')->usage == 0x2d);
+  REQUIRE(text_input::find_character(text_input::layout::japanese, U'@')->usage == 0x2f);
+  REQUIRE(text_input::find_character(text_input::layout::japanese, U'@')->modifiers == 0);
+
+  REQUIRE(text_input::find_character(text_input::layout::us, U'\r') == nullptr);
+  REQUIRE(text_input::find_character(text_input::layout::us, U'あ') == nullptr);
+  REQUIRE(text_input::find_character(text_input::layout::japanese, U'あ') == nullptr);
+}
+
+TEST_CASE("decode_utf8") {
+  using v = std::vector<std::pair<char32_t, size_t>>;
+
+  REQUIRE(decode("") == v{});
+  REQUIRE(decode("ab") == v{{U'a', 0}, {U'b', 1}});
+  REQUIRE(decode("a\xc3\xa4z") == v{{U'a', 0}, {U'ä', 1}, {U'z', 3}});
+  REQUIRE(decode("\xe2\x82\xac") == v{{U'€', 0}});
+  REQUIRE(decode("\xf0\x9f\x98\x80!") == v{{U'\U0001f600', 0}, {U'!', 4}});
+
+  // Invalid sequences
+
+  auto r = text_input::replacement_character;
+
+  // A continuation byte without a leading byte
+  REQUIRE(decode("\x80"
+                 "a") == v{{r, 0}, {U'a', 1}});
+  // Truncated
+  REQUIRE(decode("\xe2\x82") == v{{r, 0}, {r, 1}});
+  // Overlong
+  REQUIRE(decode("\xc0\xaf") == v{{r, 0}, {r, 1}});
+  // Surrogate
+  REQUIRE(decode("\xed\xa0\x80") == v{{r, 0}, {r, 1}, {r, 2}});
+  // Out of range
+  REQUIRE(decode("\xf4\x90\x80\x80") == v{{r, 0}, {r, 1}, {r, 2}, {r, 3}});
+  REQUIRE(decode("\xff") == v{{r, 0}});
+}
+
+TEST_CASE("text_synthesizer") {
+  {
+    text_input::text_synthesizer s(text_input::layout::us, "");
+    REQUIRE(s.finished());
+    REQUIRE(s.get_mapped_characters() == 0);
+  }
+
+  // Modifiers are kept while the following characters use the same modifiers.
+  // A modifier change is sent before the key down.
+
+  {
+    text_input::text_synthesizer s(text_input::layout::us, "aAB!b");
+    REQUIRE(s.get_mapped_characters() == 5);
+    REQUIRE(s.get_unmapped_characters().empty());
+
+    REQUIRE(synthesize(s) == std::vector<report_t>{
+                                 {0, 0x04},
+                                 {0, 0},
+                                 {shift, 0},
+                                 {shift, 0x04},
+                                 {shift, 0},
+                                 {shift, 0x05},
+                                 {shift, 0},
+                                 {shift, 0x1e},
+                                 {shift, 0},
+                                 {0, 0},
+                                 {0, 0x05},
+                                 {0, 0},
+                             });
+  }
+
+  // Modifiers are released by the last report.
+
+  {
+    text_input::text_synthesizer s(text_input::layout::us, "a?");
+    REQUIRE(synthesize(s) == std::vector<report_t>{
+                                 {0, 0x04},
+                                 {0, 0},
+                                 {shift, 0},
+                                 {shift, 0x38},
+                                 {shift, 0},
+                                 {0, 0},
+                             });
+  }
+
+  // The first character with modifiers
+
+  {
+    text_input::text_synthesizer s(text_input::layout::us, "A");
+    REQUIRE(synthesize(s) == std::vector<report_t>{
+                                 {shift, 0},
+                                 {shift, 0x04},
+                                 {shift, 0},
+                                 {0, 0},
+                             });
+  }
+
+  // Repeated characters
+
+  {
+    text_input::text_synthesizer s(text_input::layout::us, "ll");
+    REQUIRE(synthesize(s) == std::vector<report_t>{
+                                 {0, 0x0f},
+                                 {0, 0},
+                                 {0, 0x0f},
+                                 {0, 0},
+                             });
+  }
+
+  // Unmapped characters
+
+  {
+    text_input::text_synthesizer s(text_input::layout::us, "a\xc3\xa4\r\n\xff");
+    REQUIRE(s.get_mapped_characters() == 2);
+
+    auto& unmapped = s.get_unmapped_characters();
+    REQUIRE(unmapped.size() == 3);
+    REQUIRE(unmapped[0].offset == 1);
+    REQUIRE(unmapped[0].character == 0xe4);
+    REQUIRE(unmapped[1].offset == 3);
+    REQUIRE(unmapped[1].character == '\r');
+    REQUIRE(unmapped[2].offset == 5);
+    REQUIRE(unmapped[2].character == 0xfffd);
+
+    REQUIRE(synthesize(s).size() == 4);
+  }
+
+  // Layouts
+
+  {
+    text_input::text_synthesizer s(text_input::layout::german, "\xc3\xa4@");
+    REQUIRE(s.get_mapped_characters() == 2);
+
+    constexpr uint8_t option = static_cast<uint8_t>(virtual_hid_device_driver::hid_report::modifier::left_option);
+    REQUIRE(synthesize(s) == std::vector<report_t>{
+                                 {0, 0x34},
+                                 {0, 0},
+                                 {option, 0},
+                                 {option, 0x0f},
+                                 {option, 0},
+                                 {0, 0},
+                             });
+  }
+}